@@ -0,0 +1,113 @@
+#include "AppendOnlyFile.h"
+#include "../utils/Checksum.h"
+#include <cstdio>
+#include <fstream>
+
+AppendOnlyFile::AppendOnlyFile(const std::string& path, const std::string& header)
+    : path(path), header(header), validBytes(0), damaged(false) {
+}
+
+void AppendOnlyFile::clear() {
+    validBytes = 0;
+    damaged = false;
+    stamp = FileStamp();
+}
+
+bool AppendOnlyFile::catchUp(const std::function<void()>& onRestart, const OnLine& onLine, std::string& error) {
+    FileStamp current = FileManager::getFileStamp(path);
+    if (current == stamp) {
+        return !damaged;
+    }
+    error.clear();
+    if (current.size < validBytes) {
+        clear(); // Replaced, e.g. by a restore
+    }
+    if (validBytes == 0) {
+        onRestart();
+    }
+    stamp = current;
+    if (current.size < 0) {
+        return true; // Nothing appended yet
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot read " + path + ".";
+        return false;
+    }
+
+    std::string line;
+    if (validBytes == 0) {
+        if (!std::getline(file, line) || file.eof()) {
+            return true; // Torn header; rewritten by the next append
+        }
+        validBytes = static_cast<long long>(line.size()) + 1;
+    }
+    file.seekg(validBytes);
+
+    long long offset = validBytes;
+    while (std::getline(file, line)) {
+        if (file.eof()) {
+            break; // No newline: an append that did not finish
+        }
+        if (!onLine(line, offset)) {
+            // Only a bad final line can be a torn append; anything after it means damage
+            if (std::getline(file, line)) {
+                damaged = true;
+                error = path + " is damaged at byte " + std::to_string(offset) + ".";
+            }
+            break;
+        }
+        offset += static_cast<long long>(line.size()) + 1;
+    }
+    validBytes = offset;
+    return !damaged;
+}
+
+bool AppendOnlyFile::append(const std::string& lines, bool sync, long long& firstOffset, std::string& error) {
+    // Cut off a torn final line (or header) before appending after it
+    bool needsHeader = validBytes == 0;
+    if (stamp.size > validBytes && !FileManager::truncateFile(path, validBytes)) {
+        error = "Cannot repair the end of " + path + ".";
+        return false;
+    }
+
+    std::string text = needsHeader ? header + "\n" + lines : lines;
+    std::FILE* file = std::fopen(path.c_str(), "ab");
+    bool ok = file && std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = file && std::fclose(file) == 0 && ok;
+    ok = ok && (!sync || FileManager::syncFile(path));
+    if (!ok) {
+        FileManager::truncateFile(path, validBytes);
+        clear(); // Re-read from the start next time
+        error = "Failed to write " + path + ".";
+        return false;
+    }
+
+    firstOffset = validBytes + static_cast<long long>(text.size() - lines.size());
+    validBytes += static_cast<long long>(text.size());
+    FileManager::markFileWritten(path);
+    stamp = FileManager::getFileStamp(path);
+    return true;
+}
+
+const std::string& AppendOnlyFile::getPath() const {
+    return path;
+}
+
+long long AppendOnlyFile::getValidBytes() const {
+    return validBytes;
+}
+
+std::string AppendOnlyFile::withChecksum(const std::string& body, char separator) {
+    return body + separator + Checksum::toHex(Checksum::crc32(body.data(), body.size())) + "\n";
+}
+
+size_t AppendOnlyFile::checkedLength(const std::string& line, char separator) {
+    size_t crcStart = line.rfind(separator);
+    if (crcStart == std::string::npos ||
+        Checksum::toHex(Checksum::crc32(line.data(), crcStart)) != line.substr(crcStart + 1)) {
+        return std::string::npos;
+    }
+    return crcStart;
+}
@@ -0,0 +1,51 @@
+#ifndef APPENDONLYFILE_H
+#define APPENDONLYFILE_H
+
+#include "FileManager.h"
+#include <functional>
+#include <string>
+
+// A file of records that are only ever appended, one line each, ending in a
+// CRC-32 of the rest of the line. Shared by the payment ledger and the
+// change log; the owner parses the lines and keeps its own indexes.
+//
+// catchUp() reads only what was appended since the last call. A torn final
+// line (a crash mid-append, or no newline yet) is left unread and cut off
+// before the next append; a bad line with more after it marks the file
+// damaged, and appends are refused. A file that shrank was replaced, e.g. by
+// a restore, and is read again from the start, as is the file after a failed
+// append. Calls are not synchronized; the owner serializes them.
+class AppendOnlyFile {
+private:
+    std::string path;
+    std::string header;         // First line, written with the first append
+    long long validBytes;       // End of the last complete line
+    bool damaged;
+    FileStamp stamp;
+
+public:
+    // Gets each new line and its offset; false when the line is not valid
+    using OnLine = std::function<bool(const std::string& line, long long offset)>;
+
+    AppendOnlyFile(const std::string& path, const std::string& header);
+
+    // Forgets what was read, so the next catchUp() starts over
+    void clear();
+    // onRestart is called whenever the file is read from the start, so the
+    // owner drops its indexes. error is cleared when there is anything new.
+    bool catchUp(const std::function<void()>& onRestart, const OnLine& onLine, std::string& error);
+    // Appends complete lines in one write, after the header when the file is
+    // new. firstOffset is where the first line starts. A failed write is cut
+    // back off and the file is read again from the start.
+    bool append(const std::string& lines, bool sync, long long& firstOffset, std::string& error);
+
+    const std::string& getPath() const;
+    long long getValidBytes() const;
+
+    // Line format: body, separator, CRC-32 of the body in hex, newline
+    static std::string withChecksum(const std::string& body, char separator);
+    // Length of the body when the line's checksum matches, otherwise npos
+    static size_t checkedLength(const std::string& line, char separator);
+};
+
+#endif // APPENDONLYFILE_H
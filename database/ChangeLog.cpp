@@ -0,0 +1,383 @@
+#include "ChangeLog.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/TimeUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const std::string HEADER = "Sequence\tTime\tEntity\tID\tType\tBefore\tAfter\tCRC";
+const long long CHECKPOINT_INTERVAL = 256;
+
+// Rows may hold any text; tabs, line breaks and backslashes are escaped
+void appendEscaped(std::string& out, const std::string& text) {
+    for (char c : text) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c;
+        }
+    }
+}
+
+std::string unescape(const std::string& text, size_t start, size_t end) {
+    std::string out;
+    out.reserve(end - start);
+    for (size_t i = start; i < end; i++) {
+        if (text[i] != '\\' || i + 1 == end) {
+            out += text[i];
+            continue;
+        }
+        char next = text[++i];
+        out += next == 't' ? '\t' : next == 'n' ? '\n' : next == 'r' ? '\r' : next;
+    }
+    return out;
+}
+
+} // namespace
+
+ChangeLog::ChangeLog(const std::string& dataDirectory)
+    : file(dataDirectory + "/changes.log", HEADER), cursorFile(dataDirectory + "/change_cursors.csv"),
+      firstSequence(0), lastSequence(0), failedAppends(0) {
+}
+
+bool ChangeLog::load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.clear();
+    return catchUp();
+}
+
+void ChangeLog::clear() {
+    checkpoints.clear();
+    firstSequence = 0;
+    lastSequence = 0;
+}
+
+// Reads whatever was appended since the last call; the caller holds the mutex
+bool ChangeLog::catchUp() {
+    ChangeEvent event;
+    return file.catchUp([this]() { clear(); }, [this, &event](const std::string& line, long long offset) {
+        if (!parseLine(line, event) || event.sequence <= lastSequence) {
+            return false;
+        }
+        index(event.sequence, offset);
+        return true;
+    }, lastError);
+}
+
+void ChangeLog::index(long long sequence, long long offset) {
+    if (checkpoints.empty()) {
+        firstSequence = sequence;
+    }
+    if (checkpoints.empty() || sequence - checkpoints.back().first >= CHECKPOINT_INTERVAL) {
+        checkpoints.emplace_back(sequence, offset);
+    }
+    lastSequence = sequence;
+}
+
+bool ChangeLog::append(std::vector<ChangeEvent>& events) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!catchUp()) {
+        failedAppends++;
+        return false;
+    }
+    if (events.empty()) {
+        return true;
+    }
+
+    std::string timestamp = TimeUtils::currentTimestamp();
+    std::string text;
+    std::vector<long long> offsets;
+    offsets.reserve(events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        events[i].sequence = lastSequence + 1 + static_cast<long long>(i);
+        events[i].timestamp = timestamp;
+        offsets.push_back(static_cast<long long>(text.size()));
+        text += toLine(events[i]);
+    }
+
+    long long firstOffset = 0;
+    if (!file.append(text, false, firstOffset, lastError)) {
+        failedAppends++;
+        for (auto& event : events) {
+            event.sequence = 0;
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < events.size(); i++) {
+        index(events[i].sequence, firstOffset + offsets[i]);
+    }
+    appended.notify_all();
+    return true;
+}
+
+bool ChangeLog::read(long long fromSequence, size_t maxEvents, std::vector<ChangeEvent>& events) {
+    long long offset = 0;
+    return readFrom(fromSequence, maxEvents, events, offset);
+}
+
+// Starts at offset when it is set, otherwise at the nearest checkpoint at or
+// before fromSequence; on return offset is where the next read continues.
+// The file is read without the lock: bytes before the valid end never change.
+bool ChangeLog::readFrom(long long fromSequence, size_t maxEvents, std::vector<ChangeEvent>& events,
+                         long long& offset) {
+    events.clear();
+    for (int attempt = 0; attempt < 2; attempt++) {
+        long long end;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            catchUp();
+            if (checkpoints.empty() || fromSequence > lastSequence) {
+                return true;
+            }
+            end = file.getValidBytes();
+            if (offset <= 0 || offset >= end) {
+                auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), fromSequence,
+                    [](long long sequence, const std::pair<long long, long long>& checkpoint) {
+                        return sequence < checkpoint.first;
+                    });
+                offset = it == checkpoints.begin() ? checkpoints.front().second : std::prev(it)->second;
+            }
+        }
+
+        std::ifstream input(file.getPath(), std::ios::binary);
+        if (!input.is_open() || !input.seekg(offset)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastError = "Cannot read " + file.getPath() + ".";
+            return false;
+        }
+        bool bad = false;
+        std::string line;
+        ChangeEvent event;
+        while (offset < end && events.size() < maxEvents && std::getline(input, line)) {
+            if (!parseLine(line, event)) {
+                bad = true;
+                break;
+            }
+            offset += static_cast<long long>(line.size()) + 1;
+            if (event.sequence >= fromSequence) {
+                events.push_back(event);
+            }
+        }
+        if (!bad) {
+            return true;
+        }
+        // A stale offset, e.g. from before the log was replaced: retry from the index
+        events.clear();
+        offset = 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    lastError = "Cannot read the changes from " + std::to_string(fromSequence) + " in " + file.getPath() + ".";
+    return false;
+}
+
+long long ChangeLog::getFirstSequence() {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    return firstSequence;
+}
+
+long long ChangeLog::getLastSequence() {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    return lastSequence;
+}
+
+bool ChangeLog::waitForAppend(long long afterSequence, int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return appended.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+                             [this, afterSequence]() { return lastSequence > afterSequence; });
+}
+
+size_t ChangeLog::getFailedAppends() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return failedAppends;
+}
+
+// 1, the start of the log, for a consumer that never committed
+long long ChangeLog::loadCursor(const std::string& consumer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ifstream file(cursorFile);
+    std::string line;
+    std::vector<std::string> fields;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() == 2 && fields[0] == consumer) {
+            return std::max(1LL, std::atoll(fields[1].c_str()));
+        }
+    }
+    return 1;
+}
+
+// Written to a temp file and renamed, so a crash leaves the old positions
+bool ChangeLog::saveCursor(const std::string& consumer, long long nextSequence) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (consumer.empty() || consumer.find_first_of(",\r\n") != std::string::npos) {
+        lastError = "A consumer name may not be empty or contain commas or line breaks.";
+        return false;
+    }
+
+    std::vector<std::pair<std::string, std::string>> cursors;
+    {
+        std::ifstream file(cursorFile);
+        std::string line;
+        std::vector<std::string> fields;
+        std::getline(file, line);
+        while (std::getline(file, line)) {
+            CsvUtils::splitLine(line, fields);
+            if (fields.size() == 2 && fields[0] != consumer) {
+                cursors.emplace_back(fields[0], fields[1]);
+            }
+        }
+    }
+    cursors.emplace_back(consumer, std::to_string(nextSequence));
+
+    std::string tempFile = cursorFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) {
+        lastError = "Cannot write " + tempFile + ".";
+        return false;
+    }
+    file << "Consumer,NextSequence\n";
+    for (const auto& cursor : cursors) {
+        file << cursor.first << "," << cursor.second << "\n";
+    }
+    file.close();
+
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, cursorFile)) {
+        std::remove(tempFile.c_str());
+        lastError = "Failed to write " + cursorFile + ".";
+        return false;
+    }
+    return true;
+}
+
+const std::string& ChangeLog::getLogFile() const {
+    return file.getPath();
+}
+
+std::string ChangeLog::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
+
+ChangeEvent ChangeLog::makeEvent(ChangeEntity entity, int entityId, const std::string& before,
+                                 const std::string& after) {
+    ChangeEvent event;
+    event.entity = entity;
+    event.entityId = entityId;
+    event.type = before.empty() ? ChangeType::INSERTED : after.empty() ? ChangeType::DELETED : ChangeType::UPDATED;
+    event.before = before;
+    event.after = after;
+    return event;
+}
+
+std::string ChangeLog::entityToString(ChangeEntity entity) {
+    switch (entity) {
+        case ChangeEntity::CAR: return "Car";
+        case ChangeEntity::CUSTOMER: return "Customer";
+        case ChangeEntity::BOOKING: return "Booking";
+        default: return "Unknown";
+    }
+}
+
+std::string ChangeLog::typeToString(ChangeType type) {
+    switch (type) {
+        case ChangeType::INSERTED: return "Insert";
+        case ChangeType::UPDATED: return "Update";
+        case ChangeType::DELETED: return "Delete";
+        default: return "Unknown";
+    }
+}
+
+std::string ChangeLog::toLine(const ChangeEvent& event) {
+    std::string body = std::to_string(event.sequence) + "\t" + event.timestamp + "\t" +
+                       entityToString(event.entity) + "\t" + std::to_string(event.entityId) + "\t" +
+                       typeToString(event.type) + "\t";
+    appendEscaped(body, event.before);
+    body += '\t';
+    appendEscaped(body, event.after);
+    return AppendOnlyFile::withChecksum(body, '\t');
+}
+
+bool ChangeLog::parseLine(const std::string& line, ChangeEvent& event) {
+    size_t crcStart = AppendOnlyFile::checkedLength(line, '\t');
+    if (crcStart == std::string::npos) {
+        return false;
+    }
+    size_t starts[8];
+    size_t fieldCount = 0;
+    for (size_t start = 0; fieldCount < 8;) {
+        starts[fieldCount++] = start;
+        size_t tab = line.find('\t', start);
+        if (tab == std::string::npos) break;
+        start = tab + 1;
+    }
+    if (fieldCount != 8 || starts[7] != crcStart + 1) {
+        return false;
+    }
+    auto field = [&](int i) { return line.substr(starts[i], starts[i + 1] - 1 - starts[i]); };
+
+    std::string entity = field(2);
+    std::string type = field(4);
+    if (entity == "Car") event.entity = ChangeEntity::CAR;
+    else if (entity == "Customer") event.entity = ChangeEntity::CUSTOMER;
+    else if (entity == "Booking") event.entity = ChangeEntity::BOOKING;
+    else return false;
+    if (type == "Insert") event.type = ChangeType::INSERTED;
+    else if (type == "Update") event.type = ChangeType::UPDATED;
+    else if (type == "Delete") event.type = ChangeType::DELETED;
+    else return false;
+
+    event.sequence = std::atoll(field(0).c_str());
+    event.timestamp = field(1);
+    event.entityId = std::atoi(field(3).c_str());
+    event.before = unescape(line, starts[5], starts[6] - 1);
+    event.after = unescape(line, starts[6], starts[7] - 1);
+    return event.sequence > 0;
+}
+
+ChangeCursor::ChangeCursor(ChangeLog& log, long long fromSequence)
+    : log(log), nextSequence(std::max(1LL, fromSequence)), offset(0) {
+}
+
+ChangeCursor::ChangeCursor(ChangeLog& log, const std::string& consumer)
+    : log(log), consumer(consumer), nextSequence(log.loadCursor(consumer)), offset(0) {
+}
+
+bool ChangeCursor::poll(std::vector<ChangeEvent>& events, size_t maxEvents) {
+    if (!log.readFrom(nextSequence, maxEvents, events, offset)) {
+        offset = 0;
+        return false;
+    }
+    if (!events.empty()) {
+        nextSequence = events.back().sequence + 1;
+    }
+    return true;
+}
+
+bool ChangeCursor::commit() {
+    return log.saveCursor(consumer, nextSequence);
+}
+
+void ChangeCursor::seek(long long sequence) {
+    nextSequence = std::max(1LL, sequence);
+    offset = 0;
+}
+
+long long ChangeCursor::getNextSequence() const {
+    return nextSequence;
+}
+
+long long ChangeCursor::getLag() {
+    return std::max(0LL, log.getLastSequence() - nextSequence + 1);
+}
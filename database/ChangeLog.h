@@ -0,0 +1,121 @@
+#ifndef CHANGELOG_H
+#define CHANGELOG_H
+
+#include "AppendOnlyFile.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class ChangeEntity {
+    CAR,
+    CUSTOMER,
+    BOOKING
+};
+
+enum class ChangeType {
+    INSERTED,
+    UPDATED,
+    DELETED
+};
+
+// One mutation of one row. The rows are the entity's data file lines, so a
+// consumer parses them with the owning service's parse function.
+struct ChangeEvent {
+    long long sequence;         // Assigned by the log, starting at 1
+    std::string timestamp;
+    ChangeEntity entity;
+    int entityId;
+    ChangeType type;
+    std::string before;         // Empty for an insert
+    std::string after;          // Empty for a delete
+
+    ChangeEvent() : sequence(0), entity(ChangeEntity::CAR), entityId(0), type(ChangeType::INSERTED) {}
+};
+
+// Append-only stream of every change made through the car, customer and
+// booking services, in data/changes.log.
+//
+// Each event is one tab-separated line ending in a CRC-32, appended and
+// flushed to the operating system before the mutation returns; torn appends
+// are handled by AppendOnlyFile, as for the payment ledger. Sequence
+// numbers are assigned in append order across all three entities. The file
+// offset of every 256th event is kept in memory, so reading from a sequence
+// number seeks close to it and scans at most 255 lines, whatever the size of
+// the log. Events appended by another process are picked up by reading the
+// new tail.
+class ChangeLog {
+private:
+    friend class ChangeCursor;
+
+    AppendOnlyFile file;
+    std::string cursorFile;
+    mutable std::mutex mutex;
+    std::condition_variable appended;
+    std::string lastError;
+
+    std::vector<std::pair<long long, long long>> checkpoints;   // (sequence, offset), ascending
+    long long firstSequence;
+    long long lastSequence;
+    size_t failedAppends;
+
+    void clear();
+    bool catchUp();
+    void index(long long sequence, long long offset);
+    bool readFrom(long long fromSequence, size_t maxEvents, std::vector<ChangeEvent>& events, long long& offset);
+
+public:
+    explicit ChangeLog(const std::string& dataDirectory = "data");
+
+    bool load();
+    // Assigns the next sequence numbers to the events and appends them in one write
+    bool append(std::vector<ChangeEvent>& events);
+    // Reads up to maxEvents events, starting with the first whose sequence is at least fromSequence
+    bool read(long long fromSequence, size_t maxEvents, std::vector<ChangeEvent>& events);
+    long long getFirstSequence();
+    long long getLastSequence();    // 0 while the log is empty
+    // Waits up to timeoutMs for this process to append an event after afterSequence
+    bool waitForAppend(long long afterSequence, int timeoutMs);
+    size_t getFailedAppends() const;
+
+    // Where each named consumer has read up to, in data/change_cursors.csv
+    long long loadCursor(const std::string& consumer);
+    bool saveCursor(const std::string& consumer, long long nextSequence);
+
+    const std::string& getLogFile() const;
+    std::string getLastError() const;
+
+    static ChangeEvent makeEvent(ChangeEntity entity, int entityId, const std::string& before,
+                                 const std::string& after);
+    static std::string entityToString(ChangeEntity entity);
+    static std::string typeToString(ChangeType type);
+    static std::string toLine(const ChangeEvent& event);
+    static bool parseLine(const std::string& line, ChangeEvent& event);
+};
+
+// Tails the change log for one consumer. Each poll continues at the byte
+// where the previous one stopped, so following the log never rescans it.
+class ChangeCursor {
+private:
+    ChangeLog& log;
+    std::string consumer;
+    long long nextSequence;
+    long long offset;           // Of nextSequence when known, otherwise 0
+
+public:
+    ChangeCursor(ChangeLog& log, long long fromSequence);
+    // Resumes after the last position the consumer committed
+    ChangeCursor(ChangeLog& log, const std::string& consumer);
+
+    // The next events in sequence order; empty once the cursor has caught up
+    bool poll(std::vector<ChangeEvent>& events, size_t maxEvents = 1000);
+    // Saves the position for the named consumer
+    bool commit();
+    void seek(long long sequence);
+    long long getNextSequence() const;
+    // Events appended after the cursor's position
+    long long getLag();
+};
+
+#endif // CHANGELOG_H
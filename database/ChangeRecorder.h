@@ -0,0 +1,100 @@
+#ifndef CHANGERECORDER_H
+#define CHANGERECORDER_H
+
+#include "ChangeLog.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Collects the changes one service mutation makes and appends them to the
+// change log once the mutation is written, so the log never holds a change
+// the data file does not.
+//
+// Rows are serialized as they are recorded, since the stored record is about
+// to be overwritten or erased. A mutation ends with publish() once its write
+// succeeded or discard() when it failed and was rolled back. Changes the log
+// refuses are kept and appended ahead of the next ones, so the log still gets
+// every change in order once it accepts writes again. Nothing is collected
+// while no log is set.
+template <typename Record>
+class ChangeRecorder {
+public:
+    using ToLine = std::function<std::string(const Record& record)>;
+    using IdOf = std::function<int(const Record& record)>;
+
+private:
+    ChangeEntity entity;
+    ToLine toLine;
+    IdOf idOf;
+    ChangeLog* log;
+    std::vector<ChangeEvent> pending;       // Of the mutation in progress
+    std::vector<ChangeEvent> unpublished;   // Written, but refused by the log so far
+
+public:
+    ChangeRecorder(ChangeEntity entity, ToLine toLine, IdOf idOf)
+        : entity(entity), toLine(std::move(toLine)), idOf(std::move(idOf)), log(nullptr) {}
+
+    void setLog(ChangeLog* changeLog) {
+        log = changeLog;
+    }
+
+    bool isEnabled() const {
+        return log != nullptr;
+    }
+
+    // before is null for an insert, after for a delete
+    void record(const Record* before, const Record* after) {
+        if (log) {
+            pending.push_back(ChangeLog::makeEvent(entity, idOf(after ? *after : *before),
+                                                   before ? toLine(*before) : "",
+                                                   after ? toLine(*after) : ""));
+        }
+    }
+
+    // A wholesale replacement of the store, recorded as the difference from
+    // the current records: deletes, inserts and the rows that changed
+    void recordReplacement(const std::map<int, Record>& current, const std::vector<Record>& records) {
+        if (!log) {
+            return;
+        }
+        std::map<int, const Record*> replacements;
+        for (const auto& record : records) {
+            replacements[idOf(record)] = &record;
+        }
+        for (const auto& entry : current) {
+            if (replacements.find(entry.first) == replacements.end()) {
+                record(&entry.second, nullptr);
+            }
+        }
+        for (const auto& entry : replacements) {
+            auto it = current.find(entry.first);
+            if (it == current.end()) {
+                record(nullptr, entry.second);
+            } else if (toLine(it->second) != toLine(*entry.second)) {
+                record(&it->second, entry.second);
+            }
+        }
+    }
+
+    // Appends the recorded changes after any refused earlier. If the log
+    // refuses them, error says so and they are kept for the next publish; the
+    // data file already holds them, so the mutation itself has succeeded.
+    bool publish(std::string& error) {
+        unpublished.insert(unpublished.end(), pending.begin(), pending.end());
+        pending.clear();
+        if (unpublished.empty() || log->append(unpublished)) {
+            unpublished.clear();
+            return true;
+        }
+        error = "Saved, but not yet added to the change log (retried with the next change): " + log->getLastError();
+        return false;
+    }
+
+    // Drops the recorded changes of a mutation that was not written
+    void discard() {
+        pending.clear();
+    }
+};
+
+#endif // CHANGERECORDER_H
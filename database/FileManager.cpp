@@ -1,17 +1,40 @@
 #include "FileManager.h"
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include "../utils/CsvUtils.h"
+#include <vector>
+#include <cstdio>
+#include <map>
+#include <mutex>
 #include <sys/stat.h>
 
 #ifdef _WIN32
 #include <direct.h>
+#include <io.h>
+#include <fcntl.h>
 #define MKDIR(path) _mkdir(path.c_str())
 #else
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #define MKDIR(path) mkdir(path.c_str(), 0755)
 #endif
 
-FileManager::FileManager() : dataDirectory("data") {
+namespace {
+
+// Bumped on every in-process write so that two writes within the
+// file system's timestamp resolution are still told apart
+std::map<std::string, unsigned long>& writeGenerations() {
+    static std::map<std::string, unsigned long> generations;
+    return generations;
+}
+
+std::mutex generationMutex;
+
+}
+
+FileManager::FileManager(const std::string& dataDirectory) : dataDirectory(dataDirectory) {
 }
 
 bool FileManager::initializeDataDirectory() {
@@ -65,7 +88,7 @@ bool FileManager::createDataFile(const std::string& filename) {
     if (filename.find("cars.csv") != std::string::npos) {
         file << "ID,Make,Model,Year,Color,LicensePlate,DailyRate,Status,Mileage,FuelType,Transmission,Seats\n";
     } else if (filename.find("customers.csv") != std::string::npos) {
-        file << "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry\n";
+        file << "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry,Status\n";
     } else if (filename.find("bookings.csv") != std::string::npos) {
         file << "ID,CustomerID,CarID,StartDate,EndDate,TotalCost,Status,Notes\n";
     }
@@ -91,3 +114,117 @@ bool FileManager::createDirectory(const std::string& path) {
     
     return MKDIR(path) == 0;
 }
+
+bool FileManager::replaceFile(const std::string& source, const std::string& target) {
+#ifdef _WIN32
+    // rename() does not overwrite an existing file on Windows
+    std::remove(target.c_str());
+#endif
+    return std::rename(source.c_str(), target.c_str()) == 0;
+}
+
+bool FileManager::syncFile(const std::string& filename) {
+#ifdef _WIN32
+    int fd = _open(filename.c_str(), _O_RDWR);
+    if (fd < 0) return false;
+    bool synced = _commit(fd) == 0;
+    _close(fd);
+#else
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    close(fd);
+#endif
+    return synced;
+}
+
+bool FileManager::truncateFile(const std::string& filename, long long size) {
+#ifdef _WIN32
+    int fd = _open(filename.c_str(), _O_RDWR);
+    if (fd < 0) return false;
+    bool truncated = _chsize_s(fd, size) == 0;
+    _close(fd);
+    return truncated;
+#else
+    return truncate(filename.c_str(), static_cast<off_t>(size)) == 0;
+#endif
+}
+
+FileStamp FileManager::getFileStamp(const std::string& filename) {
+    FileStamp stamp;
+    struct stat buffer;
+    if (stat(filename.c_str(), &buffer) == 0) {
+        stamp.size = static_cast<long long>(buffer.st_size);
+#if defined(__linux__)
+        stamp.modifiedNs = static_cast<long long>(buffer.st_mtim.tv_sec) * 1000000000LL + buffer.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+        stamp.modifiedNs = static_cast<long long>(buffer.st_mtimespec.tv_sec) * 1000000000LL + buffer.st_mtimespec.tv_nsec;
+#else
+        stamp.modifiedNs = static_cast<long long>(buffer.st_mtime) * 1000000000LL;
+#endif
+    }
+    
+    std::lock_guard<std::mutex> lock(generationMutex);
+    auto it = writeGenerations().find(filename);
+    if (it != writeGenerations().end()) {
+        stamp.generation = it->second;
+    }
+    return stamp;
+}
+
+void FileManager::markFileWritten(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(generationMutex);
+    writeGenerations()[filename]++;
+}
+
+bool FileManager::loadPartitionCatalog(const std::string& path, std::vector<PartitionInfo>& partitions) {
+    partitions.clear();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    
+    std::string line;
+    std::vector<std::string> fields;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() < 10) continue;
+        PartitionInfo partition;
+        partition.key = fields[0];
+        partition.file = fields[1];
+        partition.rows = std::atoll(fields[2].c_str());
+        partition.openRows = std::atoll(fields[3].c_str());
+        partition.firstDay = std::atoi(fields[4].c_str());
+        partition.lastDay = std::atoi(fields[5].c_str());
+        partition.minId = std::atoi(fields[6].c_str());
+        partition.maxId = std::atoi(fields[7].c_str());
+        partition.stamp.size = std::atoll(fields[8].c_str());
+        partition.stamp.modifiedNs = std::atoll(fields[9].c_str());
+        partitions.push_back(partition);
+    }
+    return true;
+}
+
+// Written to a temp file and renamed, so the catalog is replaced in one step
+bool FileManager::savePartitionCatalog(const std::string& path, const std::vector<PartitionInfo>& partitions) {
+    std::string tempFile = path + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+    
+    file << "Key,File,Rows,OpenRows,FirstDay,LastDay,MinId,MaxId,Size,ModifiedNs\n";
+    for (const auto& partition : partitions) {
+        file << partition.key << "," << partition.file << "," << partition.rows << "," << partition.openRows << ","
+             << partition.firstDay << "," << partition.lastDay << "," << partition.minId << "," << partition.maxId
+             << "," << partition.stamp.size << "," << partition.stamp.modifiedNs << "\n";
+    }
+    file.close();
+    
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, path)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    markFileWritten(path);
+    return true;
+}
@@ -2,19 +2,64 @@
 #define FILEMANAGER_H
 
 #include <string>
+#include <vector>
+
+// Identifies one version of a data file. Services compare stamps to decide
+// whether their in-memory copy is still current.
+struct FileStamp {
+    long long size;
+    long long modifiedNs;
+    unsigned long generation;
+    
+    FileStamp() : size(-1), modifiedNs(0), generation(0) {}
+    bool operator==(const FileStamp& other) const {
+        return size == other.size && modifiedNs == other.modifiedNs && generation == other.generation;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+// One line of a partition catalog: a data file holding the rows of one time
+// period, with enough of a summary to decide whether it has to be read
+struct PartitionInfo {
+    std::string key;        // Period, e.g. YYYY-MM
+    std::string file;       // Relative to the catalog's directory
+    long long rows;
+    long long openRows;     // Rows that are not finished yet
+    int firstDay;           // Earliest and latest day any row covers, in days since 1970-01-01
+    int lastDay;
+    int minId;
+    int maxId;
+    FileStamp stamp;        // Size and modification time of the file when the catalog was written
+    
+    PartitionInfo() : rows(0), openRows(0), firstDay(0), lastDay(0), minId(0), maxId(0) {}
+};
 
 class FileManager {
 public:
-    FileManager();
+    explicit FileManager(const std::string& dataDirectory = "data");
     
     bool initializeDataDirectory();
     bool createDataFile(const std::string& filename);
     bool fileExists(const std::string& filename);
     std::string getDataDirectory();
+    bool replaceFile(const std::string& source, const std::string& target);
+    bool createDirectory(const std::string& path);
+    
+    // Forces the file's contents to disk
+    static bool syncFile(const std::string& filename);
+    // Cuts the file back to its first size bytes, e.g. to drop a torn final record
+    static bool truncateFile(const std::string& filename, long long size);
+    
+    // Change detection for cached data files
+    static FileStamp getFileStamp(const std::string& filename);
+    static void markFileWritten(const std::string& filename);
+    
+    // Partition catalogs, kept in key order
+    static bool loadPartitionCatalog(const std::string& path, std::vector<PartitionInfo>& partitions);
+    static bool savePartitionCatalog(const std::string& path, const std::vector<PartitionInfo>& partitions);
     
 private:
     std::string dataDirectory;
-    bool createDirectory(const std::string& path);
 };
 
 #endif // FILEMANAGER_H
@@ -0,0 +1,307 @@
+#include "PartitionedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// The base name with the version after the one in current, e.g.
+// bookings-2024-05.csv and bookings-2024-05.v2.csv give bookings-2024-05.v3.csv
+std::string nextVersion(const std::string& base, const std::string& current) {
+    size_t dot = base.rfind('.');
+    std::string stem = base.substr(0, dot);
+    std::string extension = dot == std::string::npos ? std::string() : base.substr(dot);
+    std::string prefix = stem + ".v";
+    long version = 0;
+    if (current.compare(0, prefix.size(), prefix) == 0) {
+        version = std::atol(current.c_str() + prefix.size());
+    }
+    return prefix + std::to_string(version + 1) + extension;
+}
+
+} // namespace
+
+PartitionedFile::PartitionedFile(const std::string& directory, const std::string& header)
+    : directory(directory), catalogFile(directory + "/partitions.csv"), header(header) {
+}
+
+bool PartitionedFile::exists() const {
+    return FileManager::getFileStamp(catalogFile).size >= 0;
+}
+
+void PartitionedFile::reset() {
+    stamp = FileManager::getFileStamp(catalogFile);
+    FileManager::loadPartitionCatalog(catalogFile, partitions);
+    loaded.clear();
+    staged.clear();
+}
+
+const FileStamp& PartitionedFile::getStamp() const {
+    return stamp;
+}
+
+FileStamp PartitionedFile::getCatalogStamp() const {
+    return FileManager::getFileStamp(catalogFile);
+}
+
+const std::vector<PartitionInfo>& PartitionedFile::getPartitions() const {
+    return partitions;
+}
+
+bool PartitionedFile::isLoaded(const std::string& key) const {
+    return loaded.count(key) > 0;
+}
+
+bool PartitionedFile::isFullyLoaded() const {
+    for (const auto& partition : partitions) {
+        if (!loaded.count(partition.key)) return false;
+    }
+    return true;
+}
+
+void PartitionedFile::summarizeColumns(const std::vector<size_t>& columns) {
+    summaryColumns = columns;
+    std::sort(summaryColumns.begin(), summaryColumns.end());
+    summaries.clear();
+}
+
+bool PartitionedFile::mayContain(const PartitionInfo& partition, size_t column, int id) {
+    const Summary* summary = findSummary(partition);
+    if (!summary) {
+        return true;
+    }
+    auto found = summary->ids.find(column);
+    return found == summary->ids.end() || std::binary_search(found->second.begin(), found->second.end(), id);
+}
+
+size_t PartitionedFile::load(const std::function<bool(const PartitionInfo&)>& filter,
+                             const std::function<void(const std::string& row)>& onRow) {
+    size_t count = 0;
+    std::string line;
+    for (const auto& partition : partitions) {
+        if (loaded.count(partition.key) || (filter && !filter(partition))) {
+            continue;
+        }
+        std::string path = directory + "/" + partition.file;
+        bool summarize = !summaryColumns.empty() && !findSummary(partition);
+        FileStamp fileStamp = summarize ? FileManager::getFileStamp(path) : FileStamp();
+        std::map<size_t, std::set<int>> ids;
+        std::ifstream file(path);
+        std::getline(file, line); // Header
+        while (std::getline(file, line)) {
+            if (!line.empty() && line != "\r") {
+                onRow(line);
+                if (summarize) summarizeRow(line, ids);
+            }
+        }
+        if (summarize) {
+            saveSummary(partition, fileStamp, ids);
+        }
+        loaded.insert(partition.key);
+        count++;
+    }
+    return count;
+}
+
+bool PartitionedFile::writePartition(const PartitionInfo& partition, const std::string& rows) {
+    PartitionInfo written = partition;
+    if (partition.rows > 0) {
+        std::string current;
+        for (const auto& existing : partitions) {
+            if (existing.key == partition.key) current = existing.file;
+        }
+        written.file = nextVersion(partition.file, current);
+        FileManager fileManager;
+        std::string path = directory + "/" + written.file;
+        std::string tempFile = path + ".tmp";
+        bool saved = false;
+        if (fileManager.createDirectory(directory)) {
+            std::ofstream file(tempFile);
+            if (file.is_open()) {
+                file << header << "\n" << rows;
+                file.close();
+                saved = !file.fail();
+            }
+        }
+        // A version left by an earlier failed write is not in the catalog and is overwritten
+        if (!saved || !fileManager.replaceFile(tempFile, path)) {
+            std::remove(tempFile.c_str());
+            discardStaged();
+            return false;
+        }
+        FileManager::markFileWritten(path);
+        written.stamp = FileManager::getFileStamp(path);
+        if (!summaryColumns.empty()) {
+            std::map<size_t, std::set<int>> ids;
+            std::istringstream lines(rows);
+            std::string line;
+            while (std::getline(lines, line)) {
+                summarizeRow(line, ids);
+            }
+            saveSummary(written, written.stamp, ids);
+        }
+    } else {
+        summaries.erase(partition.key);
+    }
+    staged[partition.key] = written;
+    loaded.insert(partition.key);
+    return true;
+}
+
+bool PartitionedFile::commit() {
+    if (staged.empty()) {
+        return true;
+    }
+
+    std::map<std::string, PartitionInfo> catalog;
+    for (const auto& partition : partitions) {
+        catalog[partition.key] = partition;
+    }
+    std::vector<std::string> replaced;
+    for (const auto& entry : staged) {
+        auto found = catalog.find(entry.first);
+        if (found != catalog.end()) {
+            replaced.push_back(found->second.file);
+        }
+        if (entry.second.rows > 0) {
+            catalog[entry.first] = entry.second;
+        } else if (found != catalog.end()) {
+            catalog.erase(found);
+        }
+    }
+
+    std::vector<PartitionInfo> updated;
+    for (const auto& entry : catalog) {
+        updated.push_back(entry.second);
+    }
+    FileManager fileManager;
+    if (!fileManager.createDirectory(directory) || !FileManager::savePartitionCatalog(catalogFile, updated)) {
+        discardStaged();
+        return false;
+    }
+    staged.clear();
+    // Only the catalog refers to these versions, so they go once it no longer does
+    for (const auto& file : replaced) {
+        removeFile(file);
+    }
+    partitions.swap(updated);
+    stamp = FileManager::getFileStamp(catalogFile);
+    return true;
+}
+
+std::vector<std::string> PartitionedFile::getFiles() const {
+    std::vector<std::string> files;
+    for (const auto& partition : partitions) {
+        files.push_back(directory + "/" + partition.file);
+    }
+    if (exists()) {
+        files.push_back(catalogFile);
+    }
+    return files;
+}
+
+std::string PartitionedFile::summaryPath(const std::string& file) const {
+    return directory + "/" + file + ".ids";
+}
+
+void PartitionedFile::removeFile(const std::string& file) {
+    std::remove((directory + "/" + file).c_str());
+    std::remove(summaryPath(file).c_str());
+}
+
+// Removes the versions written since the last commit; the catalog still names
+// the ones before them. Loaded partitions are kept, as the caller reloads
+// from the catalog after a failed write.
+void PartitionedFile::discardStaged() {
+    for (const auto& entry : staged) {
+        if (entry.second.rows > 0) {
+            removeFile(entry.second.file);
+        }
+        summaries.erase(entry.first);
+    }
+    staged.clear();
+}
+
+void PartitionedFile::summarizeRow(const std::string& row, std::map<size_t, std::set<int>>& ids) const {
+    size_t column = 0;
+    size_t start = 0;
+    for (size_t wanted : summaryColumns) {
+        for (; column < wanted; column++) {
+            start = row.find(',', start);
+            if (start == std::string::npos) return;
+            start++;
+        }
+        ids[wanted].insert(std::atoi(row.c_str() + start));
+    }
+}
+
+// Format: the partition file's size and modification time, then one line per
+// column with its IDs separated by spaces. Written to a temp file and renamed
+// so a torn summary is never read as a complete one.
+void PartitionedFile::saveSummary(const PartitionInfo& partition, const FileStamp& fileStamp,
+                                  const std::map<size_t, std::set<int>>& ids) {
+    Summary& summary = summaries[partition.key];
+    summary.stamp = fileStamp;
+    summary.ids.clear();
+    for (const auto& entry : ids) {
+        summary.ids[entry.first].assign(entry.second.begin(), entry.second.end());
+    }
+
+    std::string path = summaryPath(partition.file);
+    std::string tempFile = path + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return;
+    file << fileStamp.size << "," << fileStamp.modifiedNs << "\n";
+    for (const auto& entry : summary.ids) {
+        file << entry.first << ",";
+        for (size_t i = 0; i < entry.second.size(); i++) {
+            file << (i > 0 ? " " : "") << entry.second[i];
+        }
+        file << "\n";
+    }
+    file.close();
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, path)) {
+        std::remove(tempFile.c_str()); // Rebuilt the next time the partition is loaded
+    }
+}
+
+// The summary of the partition as the catalog describes it, or null if there
+// is none on file or it was built from another version of the partition
+const PartitionedFile::Summary* PartitionedFile::findSummary(const PartitionInfo& partition) {
+    auto matches = [&partition](const Summary& summary) {
+        return summary.stamp.size == partition.stamp.size && summary.stamp.modifiedNs == partition.stamp.modifiedNs;
+    };
+    auto cached = summaries.find(partition.key);
+    if (cached != summaries.end() && matches(cached->second)) {
+        return &cached->second;
+    }
+
+    std::ifstream file(summaryPath(partition.file));
+    std::string line;
+    if (!std::getline(file, line)) {
+        return nullptr;
+    }
+    Summary summary;
+    summary.stamp.size = std::atoll(line.c_str());
+    size_t comma = line.find(',');
+    summary.stamp.modifiedNs = comma == std::string::npos ? 0 : std::atoll(line.c_str() + comma + 1);
+    if (!matches(summary)) {
+        return nullptr;
+    }
+    while (std::getline(file, line)) {
+        comma = line.find(',');
+        if (comma == std::string::npos) continue;
+        std::vector<int>& ids = summary.ids[static_cast<size_t>(std::atoll(line.c_str()))];
+        std::istringstream values(line.substr(comma + 1));
+        int id;
+        while (values >> id) {
+            ids.push_back(id);
+        }
+    }
+    Summary& stored = summaries[partition.key];
+    stored = std::move(summary);
+    return &stored;
+}
@@ -0,0 +1,93 @@
+#ifndef PARTITIONEDFILE_H
+#define PARTITIONEDFILE_H
+
+#include "FileManager.h"
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// A data set split into one CSV file per time period, listed in a catalog.
+//
+// Each partition is an ordinary CSV file with a header. The catalog records
+// every partition's row counts, day span, ID range and file stamp, so callers
+// can decide which partitions to read without opening them. Partitions are
+// loaded on demand and only the ones a change touches are rewritten. The
+// catalog is the only commit point: a partition is rewritten to a new
+// versioned file (bookings-2024-05.v3.csv) that nothing reads until the
+// catalog names it, and the version it replaced is removed only afterwards.
+// A write that fails, or a crash before the catalog is saved, leaves the
+// catalog and the files it names as they were.
+//
+// Optionally each partition also gets a summary of the distinct IDs in some of
+// its columns (e.g. the cars a month's bookings refer to), kept in a ".ids"
+// file beside it with the stamp of the partition it describes. mayContain()
+// rules a partition out from its summary without reading the partition; a
+// missing or stale summary means it may contain anything. Summaries are
+// written with their partition and rebuilt when a partition without one is
+// loaded.
+class PartitionedFile {
+private:
+    std::string directory;
+    std::string catalogFile;
+    std::string header;
+    std::vector<PartitionInfo> partitions;      // Key order
+    std::set<std::string> loaded;
+    std::map<std::string, PartitionInfo> staged; // Written but not yet in the catalog, by key
+    FileStamp stamp;
+    
+    struct Summary {
+        FileStamp stamp;                           // Of the partition file it was built from
+        std::map<size_t, std::vector<int>> ids;    // Sorted distinct IDs by column
+    };
+    std::vector<size_t> summaryColumns;            // Ascending
+    std::map<std::string, Summary> summaries;      // Read or built so far, by key
+    
+    std::string summaryPath(const std::string& file) const;
+    void removeFile(const std::string& file);
+    void discardStaged();
+    void summarizeRow(const std::string& row, std::map<size_t, std::set<int>>& ids) const;
+    void saveSummary(const PartitionInfo& partition, const FileStamp& fileStamp,
+                     const std::map<size_t, std::set<int>>& ids);
+    const Summary* findSummary(const PartitionInfo& partition);
+
+public:
+    PartitionedFile(const std::string& directory, const std::string& header);
+
+    // True once a catalog has been written
+    bool exists() const;
+    // Re-reads the catalog and forgets which partitions were loaded
+    void reset();
+    // Stamp of the catalog as of the last reset() or commit()
+    const FileStamp& getStamp() const;
+    FileStamp getCatalogStamp() const;
+
+    const std::vector<PartitionInfo>& getPartitions() const;
+    bool isLoaded(const std::string& key) const;
+    bool isFullyLoaded() const;
+    
+    // Columns (0-based, integer IDs) to keep per-partition summaries of; set
+    // before the first load or write
+    void summarizeColumns(const std::vector<size_t>& columns);
+    // False only when the partition's summary shows no row with this ID in the column
+    bool mayContain(const PartitionInfo& partition, size_t column, int id);
+
+    // Reads every partition not loaded yet that the filter accepts (all when
+    // unset); onRow gets each data row. Returns the number of partitions read.
+    size_t load(const std::function<bool(const PartitionInfo&)>& filter,
+                const std::function<void(const std::string& row)>& onRow);
+
+    // Replaces one partition's file with the given rows (no header); a
+    // partition with no rows is dropped. partition.file is the base name the
+    // version is added to. Takes effect at commit().
+    bool writePartition(const PartitionInfo& partition, const std::string& rows);
+    // Saves the catalog with the written partitions. If this or any
+    // writePartition() since the last commit fails, all of them are discarded.
+    bool commit();
+
+    // Paths of the catalog and every partition file, for backups
+    std::vector<std::string> getFiles() const;
+};
+
+#endif // PARTITIONEDFILE_H
@@ -0,0 +1,303 @@
+#include "PersistenceQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <unordered_set>
+
+namespace {
+
+const int FIRST_RETRY_MS = 100;
+const int MAX_RETRY_MS = 5000;
+
+} // namespace
+
+WriteTracker::WriteTracker() : pending(0), hasStamp(false), lastOk(true) {
+}
+
+bool WriteTracker::isBusy() const {
+    return pending.load() > 0;
+}
+
+bool WriteTracker::takeStamp(FileStamp& stamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasStamp) {
+        return false;
+    }
+    stamp = this->stamp;
+    hasStamp = false;
+    return true;
+}
+
+bool WriteTracker::lastWriteSucceeded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastOk;
+}
+
+void WriteTracker::begin() {
+    pending++;
+}
+
+void WriteTracker::finish(bool ok, const FileStamp& stamp) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastOk = ok;
+        hasStamp = ok;
+        if (ok) {
+            this->stamp = stamp;
+        }
+    }
+    pending--;
+}
+
+void WriteTracker::skip() {
+    pending--;
+}
+
+void WriteTracker::markQueued(FileStamp& stamp) {
+    stamp.size = -1;
+    stamp.generation++;
+}
+
+PersistenceQueue::PersistenceQueue(Durability durability, size_t capacity, int groupWindowMs)
+    : durability(durability), groupWindowMs(groupWindowMs), mask(0), head(0), tail(0),
+      writerWaiting(false), stopping(false), flushWaiters(0), failedWrites(0), filesWritten(0), retryingCount(0),
+      retryPasses(0), abandonedWrites(0) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    ring.resize(size);
+    mask = size - 1;
+    writer = std::thread(&PersistenceQueue::writerLoop, this);
+}
+
+PersistenceQueue::~PersistenceQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWriter.notify_one();
+    writer.join(); // The writer drains the ring before it exits
+}
+
+bool PersistenceQueue::submit(const std::string& file, std::function<std::string()> render,
+                              const std::shared_ptr<WriteTracker>& tracker,
+                              std::function<void(const FileStamp&)> afterWrite) {
+    tracker->begin();
+
+    size_t position = tail.load(std::memory_order_relaxed);
+    if (position - head.load(std::memory_order_acquire) > mask) {
+        // Full: wait for the writer to free a slot
+        std::unique_lock<std::mutex> lock(mutex);
+        jobsDone.wait(lock, [&]() { return position - head.load(std::memory_order_acquire) <= mask; });
+    }
+
+    Job& job = ring[position & mask];
+    job.file = file;
+    job.render = std::move(render);
+    job.tracker = tracker;
+    job.afterWrite = std::move(afterWrite);
+    tail.store(position + 1);
+
+    if (writerWaiting.load()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        wakeWriter.notify_one();
+    }
+
+    if (durability == Durability::SYNC) {
+        flush();
+        return tracker->lastWriteSucceeded();
+    }
+    return true;
+}
+
+void PersistenceQueue::flush() {
+    size_t target = tail.load();
+    unsigned long passes = retryPasses.load();
+    flushWaiters++;
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeWriter.notify_one(); // Cut a group commit window or a retry pause short
+    jobsDone.wait(lock, [&]() {
+        return head.load(std::memory_order_acquire) >= target &&
+               (retryingCount.load() == 0 || retryPasses.load() > passes);
+    });
+    flushWaiters--;
+}
+
+Durability PersistenceQueue::getDurability() const {
+    return durability;
+}
+
+size_t PersistenceQueue::getQueuedCount() const {
+    return tail.load() - head.load();
+}
+
+size_t PersistenceQueue::getFilesWritten() const {
+    return filesWritten.load();
+}
+
+size_t PersistenceQueue::getFailedWrites() const {
+    return failedWrites.load();
+}
+
+size_t PersistenceQueue::getRetryingCount() const {
+    return retryingCount.load();
+}
+
+size_t PersistenceQueue::getAbandonedWrites() const {
+    return abandonedWrites.load();
+}
+
+std::string PersistenceQueue::getLastError() {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
+
+Durability PersistenceQueue::parseDurability(const std::string& name, Durability fallback) {
+    if (name == "sync") return Durability::SYNC;
+    if (name == "group") return Durability::GROUP_COMMIT;
+    if (name == "async") return Durability::ASYNC;
+    return fallback;
+}
+
+std::string PersistenceQueue::durabilityToString(Durability durability) {
+    switch (durability) {
+        case Durability::SYNC: return "sync";
+        case Durability::GROUP_COMMIT: return "group";
+        case Durability::ASYNC: return "async";
+        default: return "unknown";
+    }
+}
+
+void PersistenceQueue::writerLoop() {
+    std::vector<Job> batch;
+    int retryDelayMs = FIRST_RETRY_MS;
+    while (true) {
+        size_t first = head.load(std::memory_order_relaxed);
+        size_t end = tail.load();
+        if (first == end && retries.empty()) {
+            if (stopping.load()) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            writerWaiting = true;
+            wakeWriter.wait_for(lock, std::chrono::milliseconds(100),
+                                [&]() { return stopping.load() || tail.load() != first; });
+            writerWaiting = false;
+            continue;
+        }
+
+        if (first == end) {
+            // Only failed writes are left: pause before trying them again
+            if (!stopping.load() && flushWaiters.load() == 0) {
+                std::unique_lock<std::mutex> lock(mutex);
+                writerWaiting = true;
+                wakeWriter.wait_for(lock, std::chrono::milliseconds(retryDelayMs), [&]() {
+                    return stopping.load() || flushWaiters.load() > 0 || tail.load() != first;
+                });
+                writerWaiting = false;
+            }
+            end = tail.load();
+        } else if (durability == Durability::GROUP_COMMIT && !stopping.load() && flushWaiters.load() == 0) {
+            // Let more changes join this commit
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWriter.wait_for(lock, std::chrono::milliseconds(groupWindowMs),
+                                [&]() { return stopping.load() || flushWaiters.load() > 0; });
+            end = tail.load();
+        }
+
+        // Retried jobs go first, so a newer job for the same file supersedes them
+        bool retrying = !retries.empty();
+        batch.clear();
+        for (auto& job : retries) {
+            batch.push_back(std::move(job));
+        }
+        retries.clear();
+        for (size_t i = first; i != end; i++) {
+            batch.push_back(std::move(ring[i & mask]));
+            ring[i & mask] = Job();
+        }
+        writeBatch(batch);
+
+        if (retries.empty()) {
+            retryDelayMs = FIRST_RETRY_MS;
+        } else if (retrying) {
+            retryDelayMs = std::min(retryDelayMs * 2, MAX_RETRY_MS);
+        }
+        if (stopping.load() && end == tail.load() && !retries.empty()) {
+            abandonRetries(); // That was the last attempt
+        }
+        retryingCount.store(retries.size());
+        if (retrying) {
+            retryPasses++;
+        }
+
+        head.store(end, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mutex);
+        jobsDone.notify_all();
+    }
+}
+
+// Writes the newest job for each file; older ones for the same file are skipped
+void PersistenceQueue::writeBatch(std::vector<Job>& batch) {
+    std::vector<bool> newest(batch.size(), false);
+    std::unordered_set<std::string> seen;
+    for (size_t i = batch.size(); i-- > 0;) {
+        newest[i] = seen.insert(batch[i].file).second;
+    }
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!newest[i]) {
+            batch[i].tracker->skip();
+            continue;
+        }
+        FileStamp stamp;
+        if (writeFile(batch[i], stamp)) {
+            batch[i].tracker->finish(true, stamp);
+        } else if (durability == Durability::SYNC) {
+            batch[i].tracker->finish(false, stamp);
+        } else {
+            retries.push_back(std::move(batch[i])); // Still pending for its tracker
+        }
+    }
+}
+
+void PersistenceQueue::abandonRetries() {
+    for (auto& job : retries) {
+        job.tracker->finish(false, FileStamp());
+        abandonedWrites++;
+    }
+    retries.clear();
+}
+
+bool PersistenceQueue::writeFile(const Job& job, FileStamp& stamp) {
+    std::string tempFile = job.file + ".pending";
+    std::string contents = job.render();
+    std::ofstream out(tempFile);
+    bool ok = out.is_open();
+    if (ok) {
+        out.write(contents.data(), contents.size());
+        out.close();
+        ok = static_cast<bool>(out);
+    }
+    if (ok && durability != Durability::ASYNC) {
+        ok = FileManager::syncFile(tempFile);
+    }
+    FileManager fileManager;
+    if (!ok || !fileManager.replaceFile(tempFile, job.file)) {
+        std::remove(tempFile.c_str());
+        failedWrites++;
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = "Failed to write " + job.file + ".";
+        return false;
+    }
+
+    FileManager::markFileWritten(job.file);
+    stamp = FileManager::getFileStamp(job.file);
+    if (job.afterWrite) {
+        job.afterWrite(stamp);
+    }
+    filesWritten++;
+    return true;
+}
@@ -0,0 +1,141 @@
+#ifndef PERSISTENCEQUEUE_H
+#define PERSISTENCEQUEUE_H
+
+#include "FileManager.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Durability {
+    SYNC,           // The caller waits until its write is on disk
+    GROUP_COMMIT,   // Writes are gathered for a short window, then written and synced together
+    ASYNC           // Written as soon as possible without a sync; lost if the process dies first
+};
+
+// Progress of the queued writes of one data file, shared by the owning service
+// and the writer thread
+class WriteTracker {
+private:
+    std::atomic<int> pending;
+    mutable std::mutex mutex;
+    bool hasStamp;
+    FileStamp stamp;
+    bool lastOk;
+
+public:
+    WriteTracker();
+
+    // True while writes submitted for the file have not finished. The owning
+    // service's store is then ahead of the file and must not be reloaded from it.
+    bool isBusy() const;
+    // Stamp left by the latest successful write; handed out once
+    bool takeStamp(FileStamp& stamp);
+    bool lastWriteSucceeded() const;
+
+    void begin();
+    void finish(bool ok, const FileStamp& stamp);
+    void skip();    // Superseded by a newer write of the same file
+    
+    // Gives a service's store stamp a value no file has, for the time its
+    // write is queued; the stamp left by the write replaces it once it lands
+    static void markQueued(FileStamp& stamp);
+};
+
+// Writes whole data files on a single background thread.
+//
+// Services submit a copy of their store together with a function that renders
+// it as the file's contents. Rendering and writing both happen on the writer
+// thread, so submit() costs the caller little more than the copy. Jobs
+// sit in a fixed-size ring with atomic head and tail indexes: the submitting
+// thread is the only producer and the writer thread the only consumer, and the
+// mutex is only taken to sleep and wake. When the ring is full submit() waits
+// for the writer (back-pressure) rather than growing without bound.
+//
+// Each job replaces the whole file, so when several jobs for the same file are
+// waiting only the newest one is written. Files are written to a temp file and
+// renamed into place; in SYNC and GROUP_COMMIT modes they are synced first.
+//
+// In GROUP_COMMIT and ASYNC modes the caller was told the change succeeded
+// before it was written, so a failed write is not dropped: the job is kept
+// and tried again, after a growing pause, until it lands or a newer job for
+// the same file replaces it. Its file stays busy meanwhile, so the service
+// keeps its in-memory rows instead of reloading the older file. Only when the
+// queue is destroyed with a write still failing is it given up. In SYNC mode
+// the caller sees the failure and undoes the change itself.
+class PersistenceQueue {
+private:
+    struct Job {
+        std::string file;
+        std::function<std::string()> render;
+        std::shared_ptr<WriteTracker> tracker;
+        std::function<void(const FileStamp&)> afterWrite;
+    };
+
+    Durability durability;
+    int groupWindowMs;
+    std::vector<Job> ring;
+    size_t mask;
+    std::atomic<size_t> head;   // Next job to write; advanced by the writer
+    std::atomic<size_t> tail;   // Next free slot; advanced by submit()
+    std::atomic<bool> writerWaiting;
+    std::atomic<bool> stopping;
+    std::atomic<int> flushWaiters;
+
+    std::mutex mutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable jobsDone;
+
+    std::mutex errorMutex;
+    std::string lastError;
+    std::atomic<size_t> failedWrites;
+    std::atomic<size_t> filesWritten;
+
+    std::vector<Job> retries;               // Failed writes; only touched by the writer
+    std::atomic<size_t> retryingCount;
+    std::atomic<unsigned long> retryPasses;
+    std::atomic<size_t> abandonedWrites;
+
+    std::thread writer;
+
+    void writerLoop();
+    void writeBatch(std::vector<Job>& batch);
+    void abandonRetries();
+    bool writeFile(const Job& job, FileStamp& stamp);
+
+public:
+    explicit PersistenceQueue(Durability durability = Durability::GROUP_COMMIT, size_t capacity = 16,
+                              int groupWindowMs = 20);
+    ~PersistenceQueue();
+
+    PersistenceQueue(const PersistenceQueue&) = delete;
+    PersistenceQueue& operator=(const PersistenceQueue&) = delete;
+
+    // Queues a write of the whole file; render must only use data it owns.
+    // afterWrite runs on the writer thread once the file is in place. In SYNC
+    // mode this waits for the write and returns whether it succeeded.
+    bool submit(const std::string& file, std::function<std::string()> render,
+                const std::shared_ptr<WriteTracker>& tracker,
+                std::function<void(const FileStamp&)> afterWrite = nullptr);
+
+    // Waits until every job submitted so far has been attempted, and failed
+    // writes waiting to be retried have been tried once more
+    void flush();
+
+    Durability getDurability() const;
+    size_t getQueuedCount() const;
+    size_t getFilesWritten() const;
+    size_t getFailedWrites() const;         // Failed attempts, including ones retried since
+    size_t getRetryingCount() const;        // Files whose latest write has not landed yet
+    size_t getAbandonedWrites() const;      // Given up at shutdown
+    std::string getLastError();
+
+    static Durability parseDurability(const std::string& name, Durability fallback);
+    static std::string durabilityToString(Durability durability);
+};
+
+#endif // PERSISTENCEQUEUE_H
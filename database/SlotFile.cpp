@@ -0,0 +1,311 @@
+#include "SlotFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+const size_t SlotFile::COMPACT_MIN_FREE = 1024;
+
+namespace {
+
+// Spare bytes per slot so that a row can grow a little (a longer status or
+// note) without forcing a full rewrite; widths are rounded up to this too
+const size_t SLOT_HEADROOM = 16;
+
+const std::string TOMBSTONE = "#";
+
+void appendSlot(std::string& buffer, const std::string& row, size_t width) {
+    buffer += row;
+    buffer.append(width - 1 - row.size(), ' ');
+    buffer += '\n';
+}
+
+} // namespace
+
+SlotFile::SlotFile(const std::string& path)
+    : path(path), mode(StorageMode::CSV), slotted(false), width(0), slotCount(0) {
+}
+
+SlotFile::~SlotFile() {
+    if (compaction.valid()) {
+        Compaction result = compaction.get();
+        if (!result.tempFile.empty()) {
+            std::remove(result.tempFile.c_str());
+        }
+    }
+}
+
+void SlotFile::setMode(StorageMode mode) {
+    this->mode = mode;
+}
+
+StorageMode SlotFile::getMode() const {
+    return mode;
+}
+
+void SlotFile::load(const std::function<void(const std::string& row)>& onRow) {
+    bool tracking = mode == StorageMode::SLOTTED;
+    slotted = false;
+    width = 0;
+    slotCount = 0;
+    slotOf.clear();
+    freeSlots.clear();
+    pending.clear();
+    stamp = FileManager::getFileStamp(path);
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return;
+    }
+
+    std::string line;
+    size_t lineWidth = 0;
+    bool uniform = true;
+    while (std::getline(file, line)) {
+        size_t slot = slotCount++;
+        if (slot == 0) {
+            lineWidth = line.size() + 1;
+            continue; // Header
+        }
+        if (line.size() + 1 != lineWidth) {
+            uniform = false;
+        }
+
+        size_t end = line.find_last_not_of(' ');
+        line.erase(end == std::string::npos ? 0 : end + 1);
+        if (line.empty() || line[0] == '#') {
+            if (tracking) freeSlots.push_back(slot);
+            continue;
+        }
+        if (tracking) {
+            slotOf[std::atoi(line.c_str())] = slot;
+        }
+        onRow(line);
+    }
+
+    // A missing final newline also rules out the slotted layout
+    slotted = tracking && uniform && slotCount > 0 &&
+              stamp.size == static_cast<long long>(slotCount * lineWidth);
+    if (slotted) {
+        width = lineWidth;
+    } else {
+        slotOf.clear();
+        freeSlots.clear();
+    }
+}
+
+bool SlotFile::rewrite(const std::string& header, const std::vector<std::pair<int, std::string>>& rows) {
+    pending.clear();
+
+    size_t longest = header.size();
+    for (const auto& row : rows) {
+        longest = std::max(longest, row.second.size());
+    }
+    size_t newWidth = (longest + 1 + SLOT_HEADROOM + SLOT_HEADROOM - 1) / SLOT_HEADROOM * SLOT_HEADROOM;
+
+    std::string tempFile = path + ".tmp";
+    std::ofstream file(tempFile, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::string buffer;
+    appendSlot(buffer, header, newWidth);
+    for (const auto& row : rows) {
+        appendSlot(buffer, row.second, newWidth);
+        if (buffer.size() >= 1 << 16) {
+            file.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    file.write(buffer.data(), buffer.size());
+    file.close();
+
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, path)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+
+    slotted = true;
+    width = newWidth;
+    slotCount = rows.size() + 1;
+    slotOf.clear();
+    freeSlots.clear();
+    for (size_t i = 0; i < rows.size(); i++) {
+        slotOf[rows[i].first] = i + 1;
+    }
+    writtenNow();
+    return true;
+}
+
+void SlotFile::put(int id, const std::string& row) {
+    pending[id] = row;
+}
+
+void SlotFile::remove(int id) {
+    pending[id].clear();
+}
+
+bool SlotFile::commit() {
+    std::map<int, std::string> changes;
+    changes.swap(pending);
+    if (changes.empty()) {
+        return true;
+    }
+    if (!slotted) {
+        return false;
+    }
+    for (const auto& change : changes) {
+        if (change.second.size() + 1 > width) {
+            return false;
+        }
+    }
+
+    // Slots freed by this commit are only reused by later ones, so no slot is
+    // written twice below
+    std::vector<std::pair<size_t, const std::string*>> writes;
+    std::vector<size_t> freed;
+    for (const auto& change : changes) {
+        auto it = slotOf.find(change.first);
+        if (change.second.empty()) {
+            if (it == slotOf.end()) continue;
+            writes.emplace_back(it->second, &TOMBSTONE);
+            freed.push_back(it->second);
+            slotOf.erase(it);
+        } else if (it != slotOf.end()) {
+            writes.emplace_back(it->second, &change.second);
+        } else {
+            size_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slot = slotCount++;
+            }
+            slotOf[change.first] = slot;
+            writes.emplace_back(slot, &change.second);
+        }
+    }
+    freeSlots.insert(freeSlots.end(), freed.begin(), freed.end());
+    std::sort(writes.begin(), writes.end(),
+              [](const std::pair<size_t, const std::string*>& a, const std::pair<size_t, const std::string*>& b) {
+                  return a.first < b.first;
+              });
+
+    FILE* file = std::fopen(path.c_str(), "r+b");
+    if (!file) {
+        slotted = false;
+        return false;
+    }
+
+    // Adjacent slots go out in one write; new rows past the end extend the file
+    bool ok = true;
+    std::string buffer;
+    for (size_t i = 0; i < writes.size() && ok;) {
+        size_t first = writes[i].first;
+        buffer.clear();
+        size_t j = i;
+        while (j < writes.size() && writes[j].first == first + (j - i)) {
+            appendSlot(buffer, *writes[j].second, width);
+            j++;
+        }
+        ok = std::fseek(file, static_cast<long>(first * width), SEEK_SET) == 0 &&
+             std::fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+        i = j;
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        // The slot map no longer matches the file; only a rewrite recovers it
+        slotted = false;
+        return false;
+    }
+
+    writtenNow();
+    if (!compaction.valid() && freeSlots.size() >= COMPACT_MIN_FREE && freeSlots.size() * 4 >= slotCount) {
+        startCompaction();
+    }
+    return true;
+}
+
+bool SlotFile::poll() {
+    if (!compaction.valid() ||
+        compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+    }
+
+    Compaction result = compaction.get();
+    if (!result.ok || !slotted || stamp != compactionBase ||
+        FileManager::getFileStamp(path) != compactionBase) {
+        // Written since the compaction started; the next commit may try again
+        std::remove(result.tempFile.c_str());
+        return false;
+    }
+
+    FileManager fileManager;
+    if (!fileManager.replaceFile(result.tempFile, path)) {
+        std::remove(result.tempFile.c_str());
+        return false;
+    }
+
+    slotOf.clear();
+    for (const auto& entry : result.slots) {
+        slotOf[entry.first] = entry.second;
+    }
+    freeSlots.clear();
+    slotCount = result.slotCount;
+    writtenNow();
+    return true;
+}
+
+const FileStamp& SlotFile::getStamp() const {
+    return stamp;
+}
+
+size_t SlotFile::getFreeSlotCount() const {
+    return freeSlots.size();
+}
+
+size_t SlotFile::getSlotWidth() const {
+    return width;
+}
+
+void SlotFile::writtenNow() {
+    FileManager::markFileWritten(path);
+    stamp = FileManager::getFileStamp(path);
+}
+
+void SlotFile::startCompaction() {
+    compactionBase = stamp;
+    compaction = std::async(std::launch::async, compact, path, width);
+}
+
+// Copies the header and live rows, in file order, into a new file with the same width
+SlotFile::Compaction SlotFile::compact(const std::string& path, size_t width) {
+    Compaction result;
+    result.tempFile = path + ".compact";
+
+    std::ifstream source(path, std::ios::binary);
+    std::ofstream target(result.tempFile, std::ios::binary);
+    if (!source.is_open() || !target.is_open()) {
+        return result;
+    }
+
+    std::string slot(width, ' ');
+    size_t index = 0;
+    while (source.read(&slot[0], width)) {
+        if (slot[width - 1] != '\n') {
+            return result; // Not the layout this compaction was started for
+        }
+        if (index > 0) {
+            if (slot[0] == '#' || slot[0] == ' ' || slot[0] == '\n') continue;
+            result.slots.emplace_back(std::atoi(slot.c_str()), index);
+        }
+        target.write(slot.data(), width);
+        index++;
+    }
+
+    target.close();
+    result.slotCount = index;
+    result.ok = index > 0 && static_cast<bool>(target);
+    return result;
+}
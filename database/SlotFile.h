@@ -0,0 +1,99 @@
+#ifndef SLOTFILE_H
+#define SLOTFILE_H
+
+#include "FileManager.h"
+#include <functional>
+#include <future>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// How a service writes its data file back after a change
+enum class StorageMode {
+    CSV,        // The whole file is rewritten on every change
+    SLOTTED     // Only the slots of the changed rows are rewritten
+};
+
+// Fixed-width row storage for a CSV data file.
+//
+// In the slotted layout the header and every row are padded with spaces to the
+// same width, so row k lives at byte k * width and the file is still a valid
+// CSV for any other reader. Updating a row overwrites just its slot; deleting
+// one writes a '#' tombstone and puts the slot on a free list that later
+// inserts reuse before the file grows. Once enough of the file is tombstones a
+// background thread writes a compacted copy, which is swapped in by poll() only
+// if the data file has not been written since the compaction started.
+//
+// A file that is not in the slotted layout (e.g. after an import appended rows)
+// still loads normally; commit() then fails and the owning service falls back
+// to rewrite(), which converts the file.
+class SlotFile {
+private:
+    struct Compaction {
+        bool ok;
+        std::string tempFile;
+        std::vector<std::pair<int, size_t>> slots;
+        size_t slotCount;
+
+        Compaction() : ok(false), slotCount(0) {}
+    };
+
+    std::string path;
+    StorageMode mode;
+
+    // Slot layout of the file as last loaded or written; slot 0 is the header
+    bool slotted;
+    size_t width;
+    size_t slotCount;
+    std::unordered_map<int, size_t> slotOf;
+    std::vector<size_t> freeSlots;
+    FileStamp stamp;
+
+    // Rows changed since the last commit; an empty string marks a delete
+    std::map<int, std::string> pending;
+
+    std::future<Compaction> compaction;
+    FileStamp compactionBase;
+
+    void writtenNow();
+    void startCompaction();
+    static Compaction compact(const std::string& path, size_t width);
+
+public:
+    explicit SlotFile(const std::string& path);
+    ~SlotFile();
+
+    void setMode(StorageMode mode);
+    StorageMode getMode() const;
+
+    // Reads the file and passes every live row, padding removed, to onRow.
+    // The header line, tombstones and blank rows are skipped.
+    void load(const std::function<void(const std::string& row)>& onRow);
+
+    // Writes the whole file in the slotted layout, rows in the given order
+    bool rewrite(const std::string& header, const std::vector<std::pair<int, std::string>>& rows);
+
+    // Stage a changed or deleted row for the next commit()
+    void put(int id, const std::string& row);
+    void remove(int id);
+
+    // Writes the staged rows into their slots. Returns false, leaving the file
+    // untouched, when the file is not slotted or a row no longer fits its slot;
+    // the caller must then rewrite() the file.
+    bool commit();
+
+    // Adopts a finished background compaction; returns true if the file changed
+    bool poll();
+
+    // Stamp of the file after this object last wrote it
+    const FileStamp& getStamp() const;
+    size_t getFreeSlotCount() const;
+    size_t getSlotWidth() const;
+
+    // Compaction starts once at least this many slots, and a quarter of the file, are free
+    static const size_t COMPACT_MIN_FREE;
+};
+
+#endif // SLOTFILE_H
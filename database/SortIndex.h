@@ -0,0 +1,91 @@
+#ifndef SORTINDEX_H
+#define SORTINDEX_H
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Secondary orderings over an ID-ordered record store, kept in step with it.
+//
+// Each ordering holds pointers into the store sorted by (sort key, ID). It is
+// built the first time that key is requested and from then on every insert
+// and erase moves one pointer into place by binary search, so a listing after
+// a write never sorts again. A sorted vector rather than a tree keeps a page at
+// any offset one index away. Pointers into a std::map stay valid while other
+// records come and go, but a record has to be erased before its sort fields
+// change and inserted again afterwards. clear() drops everything, e.g. when the
+// store is reloaded.
+template <typename Record, typename Key>
+class SortIndex {
+public:
+    using Less = std::function<bool(Key key, const Record& a, const Record& b)>;
+    using IdOf = std::function<int(const Record& record)>;
+
+private:
+    Less less;
+    IdOf idOf;
+    std::map<Key, std::vector<const Record*>> indexes;
+
+    bool before(Key key, const Record* a, const Record* b) const {
+        if (less(key, *a, *b)) return true;
+        if (less(key, *b, *a)) return false;
+        return idOf(*a) < idOf(*b);
+    }
+
+    typename std::vector<const Record*>::iterator find(Key key, std::vector<const Record*>& ordered,
+                                                       const Record& record) const {
+        return std::lower_bound(ordered.begin(), ordered.end(), &record,
+            [this, key](const Record* a, const Record* b) { return before(key, a, b); });
+    }
+
+public:
+    SortIndex(Less less, IdOf idOf) : less(std::move(less)), idOf(std::move(idOf)) {}
+
+    void clear() {
+        indexes.clear();
+    }
+
+    const std::vector<const Record*>& get(Key key, const std::map<int, Record>& store) {
+        auto it = indexes.find(key);
+        if (it != indexes.end()) {
+            return it->second;
+        }
+
+        std::vector<const Record*> ordered;
+        ordered.reserve(store.size());
+        for (const auto& entry : store) {
+            ordered.push_back(&entry.second);
+        }
+        // The store is in ID order, so a stable sort on the key alone gives (key, ID) order
+        std::stable_sort(ordered.begin(), ordered.end(),
+            [this, key](const Record* a, const Record* b) { return less(key, *a, *b); });
+        return indexes.emplace(key, std::move(ordered)).first->second;
+    }
+
+    // record must be the store's own copy, already in place
+    void insert(const Record& record) {
+        for (auto& entry : indexes) {
+            entry.second.insert(find(entry.first, entry.second, record), &record);
+        }
+    }
+
+    // Call while the record still has the sort fields it was inserted with
+    void erase(const Record& record) {
+        for (auto& entry : indexes) {
+            auto pos = find(entry.first, entry.second, record);
+            if (pos != entry.second.end() && *pos == &record) {
+                entry.second.erase(pos);
+            }
+        }
+    }
+
+    // Position of the record in the key's order; the record must be in the store
+    size_t position(Key key, const std::map<int, Record>& store, const Record& record) {
+        get(key, store);
+        std::vector<const Record*>& ordered = indexes[key];
+        return static_cast<size_t>(find(key, ordered, record) - ordered.begin());
+    }
+};
+
+#endif // SORTINDEX_H
@@ -0,0 +1,81 @@
+#ifndef UNIQUEINDEX_H
+#define UNIQUEINDEX_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// Hash index from a normalized key to the single record ID that owns it.
+//
+// Built lazily from the ID-ordered store, then kept up to date by the owning
+// service on every insert, update and delete so each uniqueness check is one
+// hash lookup. Empty keys are not indexed. If the data file already holds a
+// duplicate, the lowest ID keeps the key.
+template <typename Record>
+class UniqueIndex {
+private:
+    std::function<std::string(const Record&)> keyOf;
+    std::unordered_map<std::string, int> ids;
+    bool valid;
+
+public:
+    explicit UniqueIndex(std::function<std::string(const Record&)> keyOf)
+        : keyOf(std::move(keyOf)), valid(false) {
+    }
+
+    // Drop the index; the next ensure() rebuilds it
+    void clear() {
+        ids.clear();
+        valid = false;
+    }
+
+    void ensure(const std::map<int, Record>& store) {
+        if (valid) {
+            return;
+        }
+        ids.clear();
+        ids.reserve(store.size());
+        for (const auto& entry : store) {
+            std::string key = keyOf(entry.second);
+            if (!key.empty()) {
+                ids.emplace(key, entry.first);
+            }
+        }
+        valid = true;
+    }
+
+    // ID owning the normalized key, or 0
+    int find(const std::string& key) const {
+        auto it = ids.find(key);
+        return it == ids.end() ? 0 : it->second;
+    }
+
+    // True when another record already owns this record's key
+    bool conflicts(const Record& record, int recordId) const {
+        std::string key = keyOf(record);
+        if (key.empty()) {
+            return false;
+        }
+        int owner = find(key);
+        return owner != 0 && owner != recordId;
+    }
+
+    void insert(const Record& record, int recordId) {
+        if (!valid) return;
+        std::string key = keyOf(record);
+        if (!key.empty()) {
+            ids[key] = recordId;
+        }
+    }
+
+    void erase(const Record& record, int recordId) {
+        if (!valid) return;
+        auto it = ids.find(keyOf(record));
+        if (it != ids.end() && it->second == recordId) {
+            ids.erase(it);
+        }
+    }
+};
+
+#endif // UNIQUEINDEX_H
@@ -1,22 +1,92 @@
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <thread>
 #include "database/FileManager.h"
+#include "database/PersistenceQueue.h"
+#include "database/ChangeLog.h"
+#include "services/CarService.h"
+#include "services/CustomerService.h"
+#include "services/BookingService.h"
+#include "services/LifecycleScheduler.h"
+#include "services/IntegrityService.h"
+#include "services/BranchNetwork.h"
+#include "services/PricingEngine.h"
+#include "services/PaymentLedger.h"
+#include "services/PaymentClient.h"
+#include "services/LogShipper.h"
+#include "services/ReadReplica.h"
+#include "services/ApiServer.h"
 #include "ui/Menu.h"
 #include "ui/CarUI.h"
 #include "ui/CustomerUI.h"
 #include "ui/BookingUI.h"
+#include "ui/ReportUI.h"
+#include "ui/BackupUI.h"
+#include "ui/BranchUI.h"
+#include "ui/PaymentUI.h"
+#include "ui/ReplicaUI.h"
+
+namespace {
+
+// Set by Ctrl+C or SIGTERM to end server mode
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+} // namespace
 
 class CarRentalSystem {
 private:
+    StorageMode storageMode;
+    Durability durability;
+    bool partitionBookings;
+    bool serveReplicas;
+    int serverPort;             // 0: console menus instead of the HTTP API
+    std::string branch;         // Empty: the single-site data directory
+    std::string dataDirectory;
+    
+    // Owns the writer thread; declared first so it outlives the services
+    std::unique_ptr<PersistenceQueue> persistence;
+    // Written to by the services, so it also outlives them
+    std::unique_ptr<ChangeLog> changeLog;
+    std::unique_ptr<LogShipper> shipper;
+    
+    // Shared by every screen so they all see one copy of the data
+    std::unique_ptr<CarService> carService;
+    std::unique_ptr<CustomerService> customerService;
+    std::unique_ptr<BookingService> bookingService;
+    std::unique_ptr<IntegrityService> integrityService;
+    std::unique_ptr<LifecycleScheduler> scheduler;
+    std::unique_ptr<PricingEngine> pricing;
+    std::unique_ptr<PaymentLedger> ledger;
+    std::unique_ptr<PaymentGateway> gateway;
+    std::unique_ptr<PaymentClient> paymentClient;   // Declared after what it uses, so destroyed first
+    LifecycleTickResult lastTick;
+    BranchNetwork network;
+    
     std::unique_ptr<CarUI> carUI;
     std::unique_ptr<CustomerUI> customerUI;
     std::unique_ptr<BookingUI> bookingUI;
+    std::unique_ptr<PaymentUI> paymentUI;
+    std::unique_ptr<ReportUI> reportUI;
+    std::unique_ptr<BackupUI> backupUI;
+    std::unique_ptr<BranchUI> branchUI;
 
 public:
-    CarRentalSystem() 
-        : carUI(std::make_unique<CarUI>())
-        , customerUI(std::make_unique<CustomerUI>())
-        , bookingUI(std::make_unique<BookingUI>()) {
+    explicit CarRentalSystem(StorageMode storageMode = StorageMode::CSV,
+                             Durability durability = Durability::GROUP_COMMIT, bool partitionBookings = false,
+                             const std::string& branch = "", bool serveReplicas = false, int serverPort = 0)
+        : storageMode(storageMode), durability(durability), partitionBookings(partitionBookings),
+          serveReplicas(serveReplicas), serverPort(serverPort), branch(branch), dataDirectory("data") {
+        if (!branch.empty()) {
+            dataDirectory = network.branchDirectory(branch);
+        }
     }
 
     void run() {
@@ -27,8 +97,83 @@ public:
             return;
         }
 
-        // Show main menu
-        showMainMenu();
+        carService = std::make_unique<CarService>(dataDirectory);
+        customerService = std::make_unique<CustomerService>(dataDirectory);
+        bookingService = std::make_unique<BookingService>(dataDirectory);
+        persistence = std::make_unique<PersistenceQueue>(durability);
+        carService->setPersistenceQueue(persistence.get());
+        customerService->setPersistenceQueue(persistence.get());
+        bookingService->setPersistenceQueue(persistence.get());
+        changeLog = std::make_unique<ChangeLog>(dataDirectory);
+        if (!changeLog->load()) {
+            std::cout << "Change log: " << changeLog->getLastError() << std::endl;
+        }
+        carService->setChangeLog(changeLog.get());
+        customerService->setChangeLog(changeLog.get());
+        bookingService->setChangeLog(changeLog.get());
+        shipper = std::make_unique<LogShipper>(*changeLog, dataDirectory + "/replication.sock");
+        if (serveReplicas && !shipper->start()) {
+            std::cout << "Replicas cannot connect: " << shipper->getLastError() << std::endl;
+        }
+        if (storageMode == StorageMode::SLOTTED) {
+            carService->setStorageMode(storageMode);
+            customerService->setStorageMode(storageMode);
+            bookingService->setStorageMode(storageMode);
+        }
+        if (partitionBookings && !bookingService->enablePartitions()) {
+            std::cout << "Bookings stay in one file: " << bookingService->getLastError() << std::endl;
+        }
+        integrityService = std::make_unique<IntegrityService>(*carService, *customerService, *bookingService);
+        scheduler = std::make_unique<LifecycleScheduler>(*bookingService, *carService);
+        pricing = std::make_unique<PricingEngine>(dataDirectory + "/pricing.csv");
+        if (!pricing->load()) {
+            std::cout << "Using default pricing rules: " << pricing->getLastError() << std::endl;
+        }
+        ledger = std::make_unique<PaymentLedger>(dataDirectory);
+        if (!ledger->load()) {
+            std::cout << "Payment ledger: " << ledger->getLastError() << std::endl;
+        }
+        gateway = std::make_unique<SimulatedGateway>();
+        paymentClient = std::make_unique<PaymentClient>(*gateway, *ledger);
+        carUI = std::make_unique<CarUI>(*carService, *integrityService);
+        customerUI = std::make_unique<CustomerUI>(*customerService, *integrityService);
+        bookingUI = std::make_unique<BookingUI>(*bookingService, *carService, *customerService, *scheduler,
+                                                *pricing);
+        paymentUI = std::make_unique<PaymentUI>(*ledger, *paymentClient, *bookingService);
+        reportUI = std::make_unique<ReportUI>(*bookingService, *carService, *customerService);
+        backupUI = std::make_unique<BackupUI>(*carService, *customerService, *bookingService,
+                                              dataDirectory + "/backups");
+        if (!branch.empty()) {
+            network.attach(branch, *carService, *customerService, *bookingService);
+        }
+        branchUI = std::make_unique<BranchUI>(network, branch);
+
+        if (serverPort > 0) {
+            runServer();
+        } else {
+            // Bring booking and car statuses up to date whenever a menu is shown
+            Menu::setTickHook([this]() {
+                LifecycleTickResult result = scheduler->tick();
+                if (result.hasChanges()) {
+                    lastTick = result;
+                }
+            });
+
+            // Show main menu
+            showMainMenu();
+            Menu::setTickHook(nullptr);
+        }
+        
+        // Nothing may still be queued when the process exits
+        std::cout << "Saving data..." << std::endl;
+        persistence->flush();
+        if (persistence->getRetryingCount() > 0) {
+            std::cout << persistence->getRetryingCount() << " file(s) could not be written and their latest "
+                      << "changes are lost. Last error: " << persistence->getLastError() << std::endl;
+        } else if (persistence->getFailedWrites() > 0) {
+            std::cout << persistence->getFailedWrites() << " write attempt(s) failed; every file was written "
+                      << "in the end." << std::endl;
+        }
     }
 
 private:
@@ -41,6 +186,15 @@ private:
                 return false;
             }
             
+            network.load();
+            if (!branch.empty() && !network.hasBranch(branch) && !network.addBranch(branch, branch)) {
+                std::cout << network.getLastError() << std::endl;
+                return false;
+            }
+            if (!branch.empty()) {
+                std::cout << "Working in branch " << branch << " (" << dataDirectory << ")" << std::endl;
+            }
+            
             std::cout << "File system initialized successfully!" << std::endl;
             return true;
         } catch (const std::exception& e) {
@@ -49,12 +203,47 @@ private:
         }
     }
 
+    // Serves the HTTP API on the loopback interface until Ctrl+C or SIGTERM
+    void runServer() {
+        ApiServer server(*carService, *customerService, *bookingService, *integrityService, *scheduler, *pricing);
+        server.tick();
+        if (!server.start("127.0.0.1", serverPort)) {
+            std::cout << "Cannot start the API server: " << server.getLastError() << std::endl;
+            return;
+        }
+        std::cout << "Serving the API on http://127.0.0.1:" << server.getHttpServer().getPort()
+                  << " with " << dataDirectory << " (Ctrl+C to stop)" << std::endl;
+
+        stopRequested = 0;
+        std::signal(SIGINT, requestStop);
+        std::signal(SIGTERM, requestStop);
+        auto lastTick = std::chrono::steady_clock::now();
+        while (!stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            // Statuses follow the calendar without a menu to trigger the update
+            if (std::chrono::steady_clock::now() - lastTick >= std::chrono::minutes(1)) {
+                server.tick();
+                lastTick = std::chrono::steady_clock::now();
+            }
+        }
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+
+        std::cout << "Stopping the API server..." << std::endl;
+        server.stop();
+        std::cout << server.getHttpServer().getRequestsServed() << " request(s) served." << std::endl;
+    }
+
     void showMainMenu() {
         Menu menu("Car Rental Management System");
         
         menu.addOption("Car Management", [this]() { carUI->showMainMenu(); });
         menu.addOption("Customer Management", [this]() { customerUI->showMainMenu(); });
         menu.addOption("Booking Management", [this]() { bookingUI->showMainMenu(); });
+        menu.addOption("Payments", [this]() { paymentUI->showMainMenu(); });
+        menu.addOption("Revenue Reports", [this]() { reportUI->showMainMenu(); });
+        menu.addOption("Backup & Restore", [this]() { backupUI->showMainMenu(); });
+        menu.addOption("Branch Network", [this]() { branchUI->showMainMenu(); });
         menu.addOption("System Information", [this]() { showSystemInfo(); });
         menu.addOption("Exit", [this, &menu]() { menu.stop(); });
         
@@ -66,24 +255,126 @@ private:
         
         std::cout << "=== Car Rental Management System ===" << std::endl;
         std::cout << "Version: 1.0.0 (Simplified)" << std::endl;
-        std::cout << "Storage: File-based (CSV)" << std::endl;
+        std::cout << "Data directory: " << dataDirectory
+                  << (branch.empty() ? "" : " (branch " + branch + ")") << std::endl;
+        std::cout << "Storage: File-based (CSV"
+                  << (storageMode == StorageMode::SLOTTED ? ", fixed-width slots" : "") << ")" << std::endl;
+        if (bookingService->isPartitioned()) {
+            std::cout << "Bookings: " << bookingService->getPartitionCount() << " monthly partition(s)" << std::endl;
+        }
         std::cout << "Features:" << std::endl;
         std::cout << "- Complete CRUD operations for Cars, Customers, and Bookings" << std::endl;
         std::cout << "- File-based data storage with CSV format" << std::endl;
         std::cout << "- Object-oriented design" << std::endl;
         std::cout << "- Simple and easy to use interface" << std::endl;
         std::cout << "- No external dependencies required" << std::endl;
+        std::cout << std::endl;
+        std::cout << "Durability: " << PersistenceQueue::durabilityToString(persistence->getDurability())
+                  << " (" << persistence->getQueuedCount() << " write(s) queued, "
+                  << persistence->getFilesWritten() << " written, "
+                  << persistence->getFailedWrites() << " failed, "
+                  << persistence->getRetryingCount() << " being retried)" << std::endl;
+        if (persistence->getFailedWrites() > 0) {
+            std::cout << "Last write error: " << persistence->getLastError() << std::endl;
+        }
+        std::cout << "Change log: last sequence " << changeLog->getLastSequence();
+        if (changeLog->getFailedAppends() > 0) {
+            std::cout << " (" << changeLog->getFailedAppends() << " failed append(s): "
+                      << changeLog->getLastError() << ")";
+        }
+        std::cout << std::endl;
+        if (shipper->isRunning()) {
+            std::cout << "Replication: " << shipper->getReplicaCount() << " replica(s) on "
+                      << shipper->getSocketPath() << ", slowest has sequence "
+                      << shipper->getSlowestSentSequence() << std::endl;
+        }
+        std::cout << "Payment ledger: " << ledger->getEntryCount() << " entries" << std::endl;
+        std::cout << "Payment gateway: " << gateway->getName() << ", up to "
+                  << paymentClient->getOptions().maxInFlight << " authorizations in flight" << std::endl;
+        std::cout << "Scheduled lifecycle events: " << scheduler->getPendingEvents() << std::endl;
+        std::cout << "Last status update: " << lastTick.started << " started, "
+                  << lastTick.completed << " completed, " << lastTick.overdue << " overdue, "
+                  << lastTick.carsUpdated << " car(s) updated" << std::endl;
+        if (!scheduler->getLastError().empty()) {
+            std::cout << "Scheduler error: " << scheduler->getLastError() << std::endl;
+        }
         
         Menu::pause();
     }
 };
 
-int main() {
+// Read-only console fed by a primary started with --serve-replicas
+void runReplica(const std::string& primaryDirectory) {
+    ReadReplica replica(primaryDirectory, primaryDirectory + "/replica", primaryDirectory + "/replication.sock");
+    std::cout << "Preparing the replica in " << primaryDirectory << "/replica..." << std::endl;
+    if (!replica.start()) {
+        std::cout << "Cannot start the replica: " << replica.getStatus().lastError << std::endl;
+        Menu::pause();
+        return;
+    }
+    
+    // Queries only ever see whole batches: received changes are applied before each menu
+    Menu::setTickHook([&replica]() { replica.applyPending(); });
+    ReplicaUI replicaUI(replica);
+    replicaUI.showMainMenu();
+    Menu::setTickHook(nullptr);
+    
+    std::cout << "Saving data..." << std::endl;
+    replica.stop();
+}
+
+int main(int argc, char* argv[]) {
     try {
         std::cout << "Starting Car Rental Management System..." << std::endl;
         
-        CarRentalSystem system;
-        system.run();
+        // --slotted-storage: rewrite only the changed rows of each data file
+        // --durability=sync|group|async: how queued writes reach the disk
+        // --partitioned-bookings: move bookings into monthly partition files; the
+        //   partitions are always written directly and in full, without the write
+        //   queue or slotted rows, so --durability and --slotted-storage do not
+        //   apply to bookings
+        // --branch=CODE: work in one branch's data directory (data/branches/CODE)
+        // --serve-replicas: stream the change log to replicas over data/replication.sock
+        // --replica: run as a read-only replica of the primary using the same data directory
+        // --server[=PORT]: serve the JSON API on 127.0.0.1 (port 8080 by default) instead of the menus
+        StorageMode storageMode = StorageMode::CSV;
+        Durability durability = Durability::GROUP_COMMIT;
+        bool partitionBookings = false;
+        bool serveReplicas = false;
+        bool replica = false;
+        int serverPort = 0;
+        std::string branch;
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--slotted-storage") {
+                storageMode = StorageMode::SLOTTED;
+            } else if (arg.compare(0, 13, "--durability=") == 0) {
+                durability = PersistenceQueue::parseDurability(arg.substr(13), durability);
+            } else if (arg == "--partitioned-bookings") {
+                partitionBookings = true;
+            } else if (arg.compare(0, 9, "--branch=") == 0) {
+                branch = arg.substr(9);
+            } else if (arg == "--serve-replicas") {
+                serveReplicas = true;
+            } else if (arg == "--replica") {
+                replica = true;
+            } else if (arg == "--server") {
+                serverPort = 8080;
+            } else if (arg.compare(0, 9, "--server=") == 0) {
+                serverPort = std::atoi(arg.c_str() + 9);
+                if (serverPort <= 0 || serverPort > 65535) {
+                    std::cout << "Invalid server port: " << arg.substr(9) << std::endl;
+                    return 1;
+                }
+            }
+        }
+        
+        if (replica) {
+            runReplica(branch.empty() ? "data" : BranchNetwork().branchDirectory(branch));
+        } else {
+            CarRentalSystem system(storageMode, durability, partitionBookings, branch, serveReplicas, serverPort);
+            system.run();
+        }
         
         std::cout << "Thank you for using Car Rental Management System!" << std::endl;
         return 0;
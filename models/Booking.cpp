@@ -1,4 +1,5 @@
 #include "Booking.h"
+#include "../utils/TimeUtils.h"
 #include <sstream>
 #include <regex>
 #include <ctime>
@@ -50,6 +51,15 @@ bool Booking::isCancelled() const {
     return status == "Cancelled";
 }
 
+bool Booking::isOverdue() const {
+    return status == "Overdue";
+}
+
+// Cancelled and completed bookings no longer hold the car
+bool Booking::occupiesCar() const {
+    return !isCancelled() && !isCompleted();
+}
+
 double Booking::calculateCost(double dailyRate) const {
     return getDuration() * dailyRate;
 }
@@ -95,7 +105,7 @@ std::string Booking::getValidationErrors() const {
 
 // Static utility methods
 bool Booking::isValidDate(const std::string& date) {
-    std::regex dateRegex(R"(\d{4}-\d{2}-\d{2})");
+    static const std::regex dateRegex(R"(\d{4}-\d{2}-\d{2})");
     if (!std::regex_match(date, dateRegex)) return false;
     
     int year, month, day;
@@ -125,13 +135,44 @@ bool Booking::isDateAfter(const std::string& date1, const std::string& date2) {
 }
 
 int Booking::daysBetween(const std::string& startDate, const std::string& endDate) {
-    int year1, month1, day1, year2, month2, day2;
-    sscanf(startDate.c_str(), "%d-%d-%d", &year1, &month1, &day1);
-    sscanf(endDate.c_str(), "%d-%d-%d", &year2, &month2, &day2);
+    return dateToDays(endDate) - dateToDays(startDate);
+}
+
+// Days since 1970-01-01 for a YYYY-MM-DD date (proleptic Gregorian calendar)
+int Booking::dateToDays(const std::string& date) {
+    int year = 1970, month = 1, day = 1;
+    sscanf(date.c_str(), "%d-%d-%d", &year, &month, &day);
     
-    // Simple calculation - in a real application, you'd use a proper date library
-    int days1 = year1 * 365 + month1 * 30 + day1;
-    int days2 = year2 * 365 + month2 * 30 + day2;
+    year -= month <= 2 ? 1 : 0;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+std::string Booking::daysToDate(int days) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    int day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    int month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    int year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
     
-    return days2 - days1;
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, day);
+    return buffer;
+}
+
+// Local calendar date as days since 1970-01-01
+int Booking::today() {
+    std::tm timeinfo{};
+    TimeUtils::localTime(time(nullptr), timeinfo);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d",
+             1900 + timeinfo.tm_year, 1 + timeinfo.tm_mon, timeinfo.tm_mday);
+    return dateToDays(buffer);
 }
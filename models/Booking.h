@@ -46,6 +46,8 @@ public:
     bool isActive() const;
     bool isCompleted() const;
     bool isCancelled() const;
+    bool isOverdue() const;
+    bool occupiesCar() const;
     double calculateCost(double dailyRate) const;
     
     // Display methods
@@ -60,6 +62,9 @@ public:
     static bool isValidDate(const std::string& date);
     static bool isDateAfter(const std::string& date1, const std::string& date2);
     static int daysBetween(const std::string& startDate, const std::string& endDate);
+    static int dateToDays(const std::string& date);
+    static std::string daysToDate(int days);
+    static int today();
 };
 
 #endif // BOOKING_H
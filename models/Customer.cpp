@@ -1,10 +1,11 @@
 #include "Customer.h"
+#include "../utils/TimeUtils.h"
 #include <sstream>
 #include <regex>
 #include <ctime>
 
 // Constructors
-Customer::Customer() : customerId(0) {
+Customer::Customer() : customerId(0), active(true) {
 }
 
 Customer::Customer(const std::string& firstName, const std::string& lastName, 
@@ -12,7 +13,8 @@ Customer::Customer(const std::string& firstName, const std::string& lastName,
                    const std::string& address, const std::string& licenseNumber, 
                    const std::string& licenseExpiry)
     : customerId(0), firstName(firstName), lastName(lastName), email(email), 
-      phone(phone), address(address), licenseNumber(licenseNumber), licenseExpiry(licenseExpiry) {
+      phone(phone), address(address), licenseNumber(licenseNumber), licenseExpiry(licenseExpiry),
+      active(true) {
 }
 
 // Getters
@@ -24,6 +26,7 @@ const std::string& Customer::getPhone() const { return phone; }
 const std::string& Customer::getAddress() const { return address; }
 const std::string& Customer::getLicenseNumber() const { return licenseNumber; }
 const std::string& Customer::getLicenseExpiry() const { return licenseExpiry; }
+bool Customer::isActive() const { return active; }
 
 // Setters
 void Customer::setCustomerId(int customerId) { this->customerId = customerId; }
@@ -34,6 +37,7 @@ void Customer::setPhone(const std::string& phone) { this->phone = phone; }
 void Customer::setAddress(const std::string& address) { this->address = address; }
 void Customer::setLicenseNumber(const std::string& licenseNumber) { this->licenseNumber = licenseNumber; }
 void Customer::setLicenseExpiry(const std::string& licenseExpiry) { this->licenseExpiry = licenseExpiry; }
+void Customer::setActive(bool active) { this->active = active; }
 
 // Utility methods
 std::string Customer::getFullName() const {
@@ -44,15 +48,15 @@ bool Customer::isLicenseValid() const {
     if (licenseExpiry.empty()) return false;
     
     // Simple date validation (assuming format YYYY-MM-DD)
-    std::regex dateRegex(R"(\d{4}-\d{2}-\d{2})");
+    static const std::regex dateRegex(R"(\d{4}-\d{2}-\d{2})");
     if (!std::regex_match(licenseExpiry, dateRegex)) return false;
     
     // Check if license is not expired
-    time_t now = time(0);
-    struct tm* timeinfo = localtime(&now);
-    int currentYear = 1900 + timeinfo->tm_year;
-    int currentMonth = 1 + timeinfo->tm_mon;
-    int currentDay = timeinfo->tm_mday;
+    std::tm timeinfo{};
+    TimeUtils::localTime(time(nullptr), timeinfo);
+    int currentYear = 1900 + timeinfo.tm_year;
+    int currentMonth = 1 + timeinfo.tm_mon;
+    int currentDay = timeinfo.tm_mday;
     
     int year, month, day;
     sscanf(licenseExpiry.c_str(), "%d-%d-%d", &year, &month, &day);
@@ -75,11 +79,13 @@ void Customer::display() const {
     std::cout << "License Number: " << licenseNumber << std::endl;
     std::cout << "License Expiry: " << licenseExpiry << std::endl;
     std::cout << "License Valid: " << (isLicenseValid() ? "Yes" : "No") << std::endl;
+    std::cout << "Status: " << (active ? "Active" : "Inactive") << std::endl;
 }
 
 void Customer::displaySummary() const {
     std::cout << "[" << customerId << "] " << getFullName() 
-              << " - " << email << " - License: " << (isLicenseValid() ? "Valid" : "Invalid") << std::endl;
+              << " - " << email << " - License: " << (isLicenseValid() ? "Valid" : "Invalid")
+              << (active ? "" : " - Inactive") << std::endl;
 }
 
 // Validation methods
@@ -103,7 +109,8 @@ std::string Customer::getValidationErrors() const {
 
 // Static utility methods
 bool Customer::isValidEmail(const std::string& email) {
-    std::regex emailRegex(R"([a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,})");
+    // Compiled once; matching against a const regex is safe from several threads
+    static const std::regex emailRegex(R"([a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,})");
     return std::regex_match(email, emailRegex);
 }
 
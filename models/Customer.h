@@ -14,6 +14,7 @@ private:
     std::string address;
     std::string licenseNumber;
     std::string licenseExpiry;
+    bool active;
 
 public:
     // Constructors
@@ -32,6 +33,7 @@ public:
     const std::string& getAddress() const;
     const std::string& getLicenseNumber() const;
     const std::string& getLicenseExpiry() const;
+    bool isActive() const;
     
     // Setters
     void setCustomerId(int customerId);
@@ -42,6 +44,7 @@ public:
     void setAddress(const std::string& address);
     void setLicenseNumber(const std::string& licenseNumber);
     void setLicenseExpiry(const std::string& licenseExpiry);
+    void setActive(bool active);
     
     // Utility methods
     std::string getFullName() const;
@@ -0,0 +1,174 @@
+#include "AnalyticsService.h"
+#include "../utils/ScanKernels.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+void BookingColumns::clear() {
+    bookingId.clear();
+    startDay.clear();
+    endDay.clear();
+    carId.clear();
+    customerId.clear();
+    costCents.clear();
+    status.clear();
+}
+
+void BookingColumns::append(const Booking& booking) {
+    bookingId.push_back(booking.getBookingId());
+    startDay.push_back(Booking::dateToDays(booking.getStartDate()));
+    endDay.push_back(Booking::dateToDays(booking.getEndDate()));
+    carId.push_back(booking.getCarId());
+    customerId.push_back(booking.getCustomerId());
+    costCents.push_back(std::llround(booking.getTotalCost() * 100.0));
+    status.push_back(statusCode(booking.getStatus()));
+}
+
+uint8_t BookingColumns::statusCode(const std::string& status) {
+    if (status == "Active") return STATUS_ACTIVE;
+    if (status == "Completed") return STATUS_COMPLETED;
+    if (status == "Cancelled") return STATUS_CANCELLED;
+    if (status == "Overdue") return STATUS_OVERDUE;
+    return STATUS_OTHER;
+}
+
+std::string BookingColumns::statusName(uint8_t code) {
+    switch (code) {
+        case STATUS_ACTIVE: return "Active";
+        case STATUS_COMPLETED: return "Completed";
+        case STATUS_CANCELLED: return "Cancelled";
+        case STATUS_OVERDUE: return "Overdue";
+        default: return "Other";
+    }
+}
+
+AnalyticsService::AnalyticsService(BookingService& bookingService, CarService& carService)
+    : bookingService(bookingService), carService(carService), columnsArchiveVersion(0) {
+}
+
+const BookingColumns& AnalyticsService::getColumns() {
+    refreshColumns();
+    return columns;
+}
+
+void AnalyticsService::refreshColumns() {
+    FileStamp stamp = bookingService.getStoreStamp();
+    unsigned long archiveVersion = bookingService.getArchiveVersion();
+    if (stamp == columnsStamp && archiveVersion == columnsArchiveVersion) {
+        return;
+    }
+
+    columns.clear();
+    size_t count = bookingService.getBookingCount();
+    columns.bookingId.reserve(count);
+    columns.startDay.reserve(count);
+    columns.endDay.reserve(count);
+    columns.carId.reserve(count);
+    columns.customerId.reserve(count);
+    columns.costCents.reserve(count);
+    columns.status.reserve(count);
+    bookingService.forEachBooking(nullptr, [this](const Booking& booking) { columns.append(booking); });
+    bookingService.forEachArchivedBooking(ArchiveFilter(), [this](const Booking& booking) { columns.append(booking); });
+    columnsStamp = stamp;
+    columnsArchiveVersion = archiveVersion;
+}
+
+AnalyticsResult AnalyticsService::run(const AnalyticsQuery& query) {
+    refreshColumns();
+
+    // Car attribute tables indexed by car ID; unknown cars map to 0xFF
+    const uint8_t unknown = 0xFF;
+    bool needsFuel = query.fuelType.has_value() || query.groupBy == AnalyticsGroupBy::FUEL_TYPE;
+    bool needsTransmission = query.transmission.has_value() || query.groupBy == AnalyticsGroupBy::TRANSMISSION;
+    std::vector<uint8_t> carFuel, carTransmission;
+    if (needsFuel || needsTransmission) {
+        carService.forEachCar(nullptr, [&](const Car& car) {
+            size_t id = static_cast<size_t>(car.getCarId());
+            if (id >= carFuel.size()) {
+                carFuel.resize(id + 1, unknown);
+                carTransmission.resize(id + 1, unknown);
+            }
+            carFuel[id] = static_cast<uint8_t>(car.getFuelType());
+            carTransmission[id] = static_cast<uint8_t>(car.getTransmission());
+        });
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    size_t rows = columns.size();
+    std::vector<uint8_t> mask(rows);
+    ScanKernels::fillMask(mask.data(), rows);
+
+    if (!query.startFrom.empty() || !query.startTo.empty()) {
+        int32_t from = query.startFrom.empty() ? std::numeric_limits<int32_t>::min() + 1
+                                               : Booking::dateToDays(query.startFrom);
+        int32_t to = query.startTo.empty() ? std::numeric_limits<int32_t>::max() - 1
+                                           : Booking::dateToDays(query.startTo);
+        ScanKernels::filterRange(columns.startDay.data(), rows, from, to, mask.data());
+    }
+    if (query.minDays > 0 || query.maxDays > 0) {
+        int32_t maxDays = query.maxDays > 0 ? query.maxDays : std::numeric_limits<int32_t>::max();
+        ScanKernels::filterDifference(columns.startDay.data(), columns.endDay.data(), rows,
+                                      query.minDays, maxDays, mask.data());
+    }
+    if ((query.statuses & 0x1F) != 0x1F) {
+        ScanKernels::filterInSet(columns.status.data(), rows, query.statuses, mask.data());
+    }
+    if (query.fuelType.has_value()) {
+        std::vector<uint8_t> wanted(carFuel.size());
+        for (size_t id = 0; id < carFuel.size(); id++) {
+            wanted[id] = carFuel[id] == static_cast<uint8_t>(*query.fuelType);
+        }
+        ScanKernels::filterLookup(columns.carId.data(), rows, wanted.data(), wanted.size(), mask.data());
+    }
+    if (query.transmission.has_value()) {
+        std::vector<uint8_t> wanted(carTransmission.size());
+        for (size_t id = 0; id < carTransmission.size(); id++) {
+            wanted[id] = carTransmission[id] == static_cast<uint8_t>(*query.transmission);
+        }
+        ScanKernels::filterLookup(columns.carId.data(), rows, wanted.data(), wanted.size(), mask.data());
+    }
+
+    AnalyticsResult result;
+    result.rowsScanned = rows;
+    result.bookings = static_cast<long long>(ScanKernels::countMasked(mask.data(), rows));
+    result.revenueCents = ScanKernels::sumMasked(columns.costCents.data(), mask.data(), rows);
+    int64_t extreme = 0;
+    if (ScanKernels::minMasked(columns.costCents.data(), mask.data(), rows, extreme)) result.minCents = extreme;
+    if (ScanKernels::maxMasked(columns.costCents.data(), mask.data(), rows, extreme)) result.maxCents = extreme;
+
+    if (query.groupBy != AnalyticsGroupBy::NONE) {
+        const uint8_t* keys = columns.status.data();
+        std::vector<uint8_t> gathered;
+        if (query.groupBy != AnalyticsGroupBy::STATUS) {
+            const std::vector<uint8_t>& table =
+                query.groupBy == AnalyticsGroupBy::FUEL_TYPE ? carFuel : carTransmission;
+            gathered.resize(rows);
+            ScanKernels::gatherBytes(columns.carId.data(), rows, table.data(), table.size(), unknown,
+                                     gathered.data());
+            keys = gathered.data();
+        }
+
+        int64_t sums[256] = {};
+        int64_t counts[256] = {};
+        ScanKernels::groupSum(keys, columns.costCents.data(), mask.data(), rows, sums, counts, 256);
+        for (int key = 0; key < 256; key++) {
+            if (counts[key] == 0) continue;
+            AnalyticsGroup group;
+            if (key == unknown) {
+                group.label = "(deleted car)";
+            } else if (query.groupBy == AnalyticsGroupBy::STATUS) {
+                group.label = BookingColumns::statusName(static_cast<uint8_t>(key));
+            } else if (query.groupBy == AnalyticsGroupBy::FUEL_TYPE) {
+                group.label = Car::fuelTypeToString(static_cast<FuelType>(key));
+            } else {
+                group.label = Car::transmissionToString(static_cast<Transmission>(key));
+            }
+            group.bookings = counts[key];
+            group.revenueCents = sums[key];
+            result.groups.push_back(group);
+        }
+    }
+
+    result.scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return result;
+}
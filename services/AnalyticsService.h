@@ -0,0 +1,98 @@
+#ifndef ANALYTICSSERVICE_H
+#define ANALYTICSSERVICE_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Column-per-field copy of the booking store, one row per booking in ID order
+struct BookingColumns {
+    std::vector<int32_t> bookingId;
+    std::vector<int32_t> startDay;      // days since 1970-01-01
+    std::vector<int32_t> endDay;
+    std::vector<int32_t> carId;
+    std::vector<int32_t> customerId;
+    std::vector<int64_t> costCents;
+    std::vector<uint8_t> status;        // BookingColumns::STATUS_*
+
+    static const uint8_t STATUS_ACTIVE = 0;
+    static const uint8_t STATUS_COMPLETED = 1;
+    static const uint8_t STATUS_CANCELLED = 2;
+    static const uint8_t STATUS_OVERDUE = 3;
+    static const uint8_t STATUS_OTHER = 4;
+    static const uint8_t STATUS_COUNT = 5;
+
+    size_t size() const { return bookingId.size(); }
+    void clear();
+    void append(const Booking& booking);
+
+    static uint8_t statusCode(const std::string& status);
+    static std::string statusName(uint8_t code);
+};
+
+enum class AnalyticsGroupBy {
+    NONE,
+    STATUS,
+    FUEL_TYPE,
+    TRANSMISSION
+};
+
+struct AnalyticsQuery {
+    std::string startFrom;              // start date range, empty bounds are open
+    std::string startTo;
+    int minDays;                        // rental length range, 0 means no limit
+    int maxDays;
+    uint32_t statuses;                  // bit per BookingColumns::STATUS_* code
+    std::optional<FuelType> fuelType;
+    std::optional<Transmission> transmission;
+    AnalyticsGroupBy groupBy;
+
+    AnalyticsQuery() : minDays(0), maxDays(0), statuses(0x1F), groupBy(AnalyticsGroupBy::NONE) {}
+};
+
+struct AnalyticsGroup {
+    std::string label;
+    long long bookings;
+    long long revenueCents;
+};
+
+struct AnalyticsResult {
+    size_t rowsScanned;
+    long long bookings;
+    long long revenueCents;
+    long long minCents;
+    long long maxCents;
+    std::vector<AnalyticsGroup> groups;
+    double scanSeconds;
+
+    AnalyticsResult() : rowsScanned(0), bookings(0), revenueCents(0), minCents(0), maxCents(0), scanSeconds(0.0) {}
+};
+
+// Ad-hoc aggregate queries over the full booking history.
+//
+// The booking store, archived bookings included, is copied into BookingColumns
+// once per change of the data file or archive, and each query runs as a chain of ScanKernels filters over the columns
+// followed by one aggregate pass. Car attributes (fuel type, transmission) are
+// joined through a small table indexed by car ID.
+class AnalyticsService {
+private:
+    BookingService& bookingService;
+    CarService& carService;
+    BookingColumns columns;
+    FileStamp columnsStamp;
+    unsigned long columnsArchiveVersion;
+
+public:
+    AnalyticsService(BookingService& bookingService, CarService& carService);
+
+    const BookingColumns& getColumns();
+    AnalyticsResult run(const AnalyticsQuery& query);
+
+private:
+    void refreshColumns();
+};
+
+#endif // ANALYTICSSERVICE_H
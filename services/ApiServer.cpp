@@ -0,0 +1,873 @@
+#include "ApiServer.h"
+#include "ExportService.h"
+#include "../utils/JsonReader.h"
+#include "../utils/JsonWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+
+const size_t DEFAULT_PAGE = 50;
+const size_t MAX_PAGE = 1000;
+const size_t DEFAULT_AVAILABLE = 100;
+const size_t MAX_BATCH = 100;
+
+using Fields = std::map<std::string, std::string>;
+
+void setError(HttpResponse& response, int status, const std::string& message) {
+    response.status = status;
+    response.body.clear();
+    JsonWriter json(response.body);
+    json.beginObject().key("error").value(message).endObject();
+}
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno != 0 || parsed < -2147483647L || parsed > 2147483647L) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseDouble(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+// Car::stringTo* fall back to a default for unknown names; requests must name a real one
+bool parseFuelType(const std::string& text, FuelType& fuelType) {
+    fuelType = Car::stringToFuelType(text);
+    return toLower(Car::fuelTypeToString(fuelType)) == toLower(text);
+}
+
+bool parseTransmission(const std::string& text, Transmission& transmission) {
+    transmission = Car::stringToTransmission(text);
+    return toLower(Car::transmissionToString(transmission)) == toLower(text);
+}
+
+bool parseCarStatus(const std::string& text, CarStatus& status) {
+    status = Car::stringToStatus(text);
+    return toLower(Car::statusToString(status)) == toLower(text);
+}
+
+bool parseDeletePolicy(const std::string& text, DeletePolicy& policy) {
+    std::string lower = toLower(text);
+    if (lower.empty() || lower == "restrict") {
+        policy = DeletePolicy::RESTRICT;
+    } else if (lower == "cascade") {
+        policy = DeletePolicy::CASCADE;
+    } else if (lower == "retire") {
+        policy = DeletePolicy::SOFT_DELETE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool readPage(const HttpRequest& request, size_t& offset, size_t& limit, std::string& error) {
+    int value = 0;
+    offset = 0;
+    limit = DEFAULT_PAGE;
+    std::string text = request.getQuery("offset");
+    if (!text.empty()) {
+        if (!parseInt(text, value) || value < 0) {
+            error = "offset must be a non-negative number.";
+            return false;
+        }
+        offset = static_cast<size_t>(value);
+    }
+    text = request.getQuery("limit");
+    if (!text.empty()) {
+        if (!parseInt(text, value) || value < 1) {
+            error = "limit must be a positive number.";
+            return false;
+        }
+        limit = std::min(static_cast<size_t>(value), MAX_PAGE);
+    }
+    return true;
+}
+
+bool readBody(const HttpRequest& request, Fields& fields, HttpResponse& response) {
+    std::string error;
+    if (!JsonReader::parseObject(request.body, fields, error)) {
+        setError(response, 400, error);
+        return false;
+    }
+    return true;
+}
+
+// A batch body holds one flat JSON object per line
+bool readBatch(const HttpRequest& request, std::vector<Fields>& batch, HttpResponse& response) {
+    std::istringstream lines(request.body);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        Fields fields;
+        std::string error;
+        if (!JsonReader::parseObject(line, fields, error)) {
+            setError(response, 400, "Booking " + std::to_string(batch.size() + 1) + ": " + error);
+            return false;
+        }
+        batch.push_back(std::move(fields));
+    }
+    if (batch.empty() || batch.size() > MAX_BATCH) {
+        setError(response, 400, "Send 1 to " + std::to_string(MAX_BATCH) + " bookings, one JSON object per line.");
+        return false;
+    }
+    return true;
+}
+
+// A new active booking from the request fields; false with an error when they are unusable
+bool readBooking(const Fields& fields, Booking& booking, int& status, std::string& error) {
+    auto field = [&fields](const std::string& name) {
+        auto found = fields.find(name);
+        return found == fields.end() ? std::string() : found->second;
+    };
+    int customerId = 0;
+    int carId = 0;
+    if (!parseInt(field("customerId"), customerId) || !parseInt(field("carId"), carId)) {
+        status = 400;
+        error = "customerId and carId are required numbers.";
+        return false;
+    }
+    booking.setCustomerId(customerId);
+    booking.setCarId(carId);
+    booking.setStartDate(field("startDate"));
+    booking.setEndDate(field("endDate"));
+    booking.setNotes(field("notes"));
+    booking.setStatus("Active");
+    if (!booking.isValid()) {
+        status = 422;
+        error = booking.getValidationErrors();
+        return false;
+    }
+    return true;
+}
+
+// Overwrites the fields present in the request; false with an error for a malformed value
+bool applyCarFields(const Fields& fields, Car& car, std::string& error) {
+    for (const auto& field : fields) {
+        const std::string& name = field.first;
+        const std::string& text = field.second;
+        int number = 0;
+        double amount = 0;
+        if (name == "make") {
+            car.setMake(text);
+        } else if (name == "model") {
+            car.setModel(text);
+        } else if (name == "color") {
+            car.setColor(text);
+        } else if (name == "licensePlate") {
+            car.setLicensePlate(text);
+        } else if (name == "year" && parseInt(text, number)) {
+            car.setYear(number);
+        } else if (name == "mileage" && parseInt(text, number) && number >= 0) {
+            car.setMileage(number);
+        } else if (name == "seats" && parseInt(text, number)) {
+            car.setSeats(number);
+        } else if (name == "dailyRate" && parseDouble(text, amount)) {
+            car.setDailyRate(amount);
+        } else if (name == "fuelType") {
+            FuelType fuelType;
+            if (!parseFuelType(text, fuelType)) {
+                error = "Unknown fuelType \"" + text + "\".";
+                return false;
+            }
+            car.setFuelType(fuelType);
+        } else if (name == "transmission") {
+            Transmission transmission;
+            if (!parseTransmission(text, transmission)) {
+                error = "Unknown transmission \"" + text + "\".";
+                return false;
+            }
+            car.setTransmission(transmission);
+        } else if (name == "status") {
+            CarStatus status;
+            if (!parseCarStatus(text, status)) {
+                error = "Unknown status \"" + text + "\".";
+                return false;
+            }
+            car.setStatus(status);
+        } else if (name != "id") {
+            error = "Unknown or malformed field \"" + name + "\".";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool applyCustomerFields(const Fields& fields, Customer& customer, std::string& error) {
+    for (const auto& field : fields) {
+        const std::string& name = field.first;
+        const std::string& text = field.second;
+        if (name == "firstName") {
+            customer.setFirstName(text);
+        } else if (name == "lastName") {
+            customer.setLastName(text);
+        } else if (name == "email") {
+            customer.setEmail(text);
+        } else if (name == "phone") {
+            customer.setPhone(text);
+        } else if (name == "address") {
+            customer.setAddress(text);
+        } else if (name == "licenseNumber") {
+            customer.setLicenseNumber(text);
+        } else if (name == "licenseExpiry") {
+            customer.setLicenseExpiry(text);
+        } else if (name == "active" && (text == "true" || text == "false")) {
+            customer.setActive(text == "true");
+        } else if (name != "id") {
+            error = "Unknown or malformed field \"" + name + "\".";
+            return false;
+        }
+    }
+    return true;
+}
+
+void writeCars(HttpResponse& response, const std::vector<Car>& cars, long long total, size_t offset) {
+    JsonWriter json(response.body);
+    json.beginObject();
+    if (total >= 0) {
+        json.key("total").value(total).key("offset").value(static_cast<long long>(offset));
+    }
+    json.key("cars").beginArray();
+    for (const auto& car : cars) {
+        ExportService::writeCarJson(json, car);
+    }
+    json.endArray().endObject();
+}
+
+void writeCustomers(HttpResponse& response, const std::vector<Customer>& customers, long long total,
+                    size_t offset) {
+    JsonWriter json(response.body);
+    json.beginObject();
+    if (total >= 0) {
+        json.key("total").value(total).key("offset").value(static_cast<long long>(offset));
+    }
+    json.key("customers").beginArray();
+    for (const auto& customer : customers) {
+        ExportService::writeCustomerJson(json, customer);
+    }
+    json.endArray().endObject();
+}
+
+void writeBookings(HttpResponse& response, const std::vector<Booking>& bookings, long long total,
+                   size_t offset) {
+    JsonWriter json(response.body);
+    json.beginObject();
+    if (total >= 0) {
+        json.key("total").value(total).key("offset").value(static_cast<long long>(offset));
+    }
+    json.key("bookings").beginArray();
+    for (const auto& booking : bookings) {
+        ExportService::writeBookingJson(json, booking);
+    }
+    json.endArray().endObject();
+}
+
+} // namespace
+
+ApiServer::ApiServer(CarService& carService, CustomerService& customerService, BookingService& bookingService,
+                     IntegrityService& integrityService, LifecycleScheduler& scheduler, const PricingEngine& pricing,
+                     size_t workerCount)
+    : carService(carService), customerService(customerService), bookingService(bookingService),
+      integrityService(integrityService), scheduler(scheduler), pricing(pricing),
+      availabilityService(carService, bookingService),
+      http([this](const HttpRequest& request, HttpResponse& response) { handle(request, response); }, workerCount) {
+}
+
+ApiServer::~ApiServer() {
+    stop();
+}
+
+bool ApiServer::start(const std::string& host, int port) {
+    return http.start(host, port);
+}
+
+void ApiServer::stop() {
+    http.stop();
+}
+
+LifecycleTickResult ApiServer::tick() {
+    std::lock_guard<std::mutex> lock(storeMutex);
+    return scheduler.tick();
+}
+
+const HttpServer& ApiServer::getHttpServer() const {
+    return http;
+}
+
+std::string ApiServer::getLastError() const {
+    return http.getLastError();
+}
+
+void ApiServer::handle(const HttpRequest& request, HttpResponse& response) {
+    response = HttpResponse();
+    route(request, response);
+}
+
+void ApiServer::route(const HttpRequest& request, HttpResponse& response) {
+    // /collection[/id[/action]]
+    std::vector<std::string> parts;
+    size_t pos = 0;
+    while (pos < request.path.size()) {
+        size_t end = request.path.find('/', pos);
+        if (end == std::string::npos) end = request.path.size();
+        if (end > pos) parts.push_back(request.path.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    if (parts.empty() || parts.size() > 3) {
+        setError(response, 404, "No such resource.");
+        return;
+    }
+    const std::string& collection = parts[0];
+    std::string id = parts.size() > 1 ? parts[1] : "";
+    std::string action = parts.size() > 2 ? parts[2] : "";
+
+    if (parts.size() == 1 && (collection == "health" || collection == "availability" || collection == "quote")) {
+        if (request.method != "GET") {
+            setError(response, 405, "Use GET.");
+        } else if (collection == "health") {
+            health(response);
+        } else if (collection == "availability") {
+            availability(request, response);
+        } else {
+            quote(request, response);
+        }
+    } else if (collection == "cars") {
+        cars(request, id, action, response);
+    } else if (collection == "customers") {
+        customers(request, id, action, response);
+    } else if (collection == "bookings") {
+        bookings(request, id, action, response);
+    } else {
+        setError(response, 404, "No such resource.");
+    }
+}
+
+void ApiServer::health(HttpResponse& response) {
+    size_t carCount, customerCount, bookingCount;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        carCount = carService.getCarCount();
+        customerCount = customerService.getCustomerCount();
+        bookingCount = bookingService.getBookingCount();
+    }
+    JsonWriter json(response.body);
+    json.beginObject()
+        .key("status").value("ok")
+        .key("cars").value(static_cast<long long>(carCount))
+        .key("customers").value(static_cast<long long>(customerCount))
+        .key("bookings").value(static_cast<long long>(bookingCount))
+        .key("requestsServed").value(static_cast<long long>(http.getRequestsServed()))
+        .key("openConnections").value(static_cast<long long>(http.getOpenConnections()))
+        .endObject();
+}
+
+void ApiServer::availability(const HttpRequest& request, HttpResponse& response) {
+    AvailabilityQuery query;
+    query.startDate = request.getQuery("start");
+    query.endDate = request.getQuery("end");
+    if (!Booking::isValidDate(query.startDate) || !Booking::isValidDate(query.endDate) ||
+        !Booking::isDateAfter(query.endDate, query.startDate)) {
+        setError(response, 400, "start and end must be dates (YYYY-MM-DD) with end after start.");
+        return;
+    }
+    std::string text = request.getQuery("fuel");
+    if (!text.empty()) {
+        FuelType fuelType;
+        if (!parseFuelType(text, fuelType)) {
+            setError(response, 400, "Unknown fuel \"" + text + "\".");
+            return;
+        }
+        query.filter.fuelType = fuelType;
+    }
+    text = request.getQuery("transmission");
+    if (!text.empty()) {
+        Transmission transmission;
+        if (!parseTransmission(text, transmission)) {
+            setError(response, 400, "Unknown transmission \"" + text + "\".");
+            return;
+        }
+        query.filter.transmission = transmission;
+    }
+    text = request.getQuery("seats");
+    if (!text.empty() && !parseInt(text, query.filter.minSeats)) {
+        setError(response, 400, "seats must be a number.");
+        return;
+    }
+    text = request.getQuery("maxRate");
+    if (!text.empty() && !parseDouble(text, query.filter.maxDailyRate)) {
+        setError(response, 400, "maxRate must be a number.");
+        return;
+    }
+    int limit = static_cast<int>(DEFAULT_AVAILABLE);
+    text = request.getQuery("limit");
+    if (!text.empty() && (!parseInt(text, limit) || limit < 1)) {
+        setError(response, 400, "limit must be a positive number.");
+        return;
+    }
+    query.limit = std::min(static_cast<size_t>(limit), MAX_PAGE);
+
+    std::vector<Car> cars;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        cars = availabilityService.findAvailableCars(query);
+    }
+    std::vector<double> quotes = pricing.quoteAll(cars, query.startDate, query.endDate);
+
+    JsonWriter json(response.body);
+    json.beginObject()
+        .key("startDate").value(query.startDate)
+        .key("endDate").value(query.endDate)
+        .key("cars").beginArray();
+    for (size_t i = 0; i < cars.size(); i++) {
+        json.beginObject().key("car");
+        ExportService::writeCarJson(json, cars[i]);
+        json.key("quote").value(quotes[i]).endObject();
+    }
+    json.endArray().endObject();
+}
+
+void ApiServer::quote(const HttpRequest& request, HttpResponse& response) {
+    int carId = 0;
+    std::string startDate = request.getQuery("start");
+    std::string endDate = request.getQuery("end");
+    if (!parseInt(request.getQuery("carId"), carId)) {
+        setError(response, 400, "carId is required.");
+        return;
+    }
+    if (!Booking::isValidDate(startDate) || !Booking::isValidDate(endDate) ||
+        !Booking::isDateAfter(endDate, startDate)) {
+        setError(response, 400, "start and end must be dates (YYYY-MM-DD) with end after start.");
+        return;
+    }
+    Car car;
+    bool available = false;
+    {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        car = carService.getCarById(carId);
+        available = car.getCarId() != 0 && bookingService.isCarAvailable(carId, startDate, endDate);
+    }
+    if (car.getCarId() == 0) {
+        setError(response, 404, "Car not found.");
+        return;
+    }
+    JsonWriter json(response.body);
+    json.beginObject()
+        .key("carId").value(carId)
+        .key("startDate").value(startDate)
+        .key("endDate").value(endDate)
+        .key("days").value(Booking::daysBetween(startDate, endDate))
+        .key("quote").value(pricing.quote(car, startDate, endDate))
+        .key("available").value(available)
+        .endObject();
+}
+
+void ApiServer::cars(const HttpRequest& request, const std::string& id, const std::string& action,
+                     HttpResponse& response) {
+    std::string error;
+    if (id.empty()) {
+        if (request.method == "GET") {
+            std::vector<Car> cars;
+            long long total = -1;
+            size_t offset = 0, limit = 0;
+            std::string plate = request.getQuery("plate");
+            if (!request.getQuery("q").empty()) {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                cars = carService.searchCars(request.getQuery("q"));
+            } else if (!plate.empty()) {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                Car car = carService.findCarByPlate(plate);
+                if (car.getCarId() != 0) cars.push_back(car);
+            } else {
+                if (!readPage(request, offset, limit, error)) {
+                    setError(response, 400, error);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(storeMutex);
+                total = static_cast<long long>(carService.getCarCount());
+                cars = carService.getCarsPage(CarSortKey::ID, offset, limit);
+            }
+            writeCars(response, cars, total, offset);
+        } else if (request.method == "POST") {
+            Fields fields;
+            if (!readBody(request, fields, response)) return;
+            Car car;
+            if (!applyCarFields(fields, car, error)) {
+                setError(response, 400, error);
+                return;
+            }
+            if (!car.isValid()) {
+                setError(response, 422, car.getValidationErrors());
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                int carId = carService.getNextId();
+                if (!carService.addCar(car)) {
+                    setError(response, 409, carService.getLastError());
+                    return;
+                }
+                car = carService.getCarById(carId);
+            }
+            response.status = 201;
+            ExportService::writeCarJson(response.body, car);
+        } else {
+            setError(response, 405, "Use GET or POST.");
+        }
+        return;
+    }
+
+    int carId = 0;
+    if (!action.empty() || !parseInt(id, carId)) {
+        setError(response, 404, "No such resource.");
+        return;
+    }
+    Car car;
+    if (request.method == "GET") {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        car = carService.getCarById(carId);
+    } else if (request.method == "PUT") {
+        Fields fields;
+        if (!readBody(request, fields, response)) return;
+        std::lock_guard<std::mutex> lock(storeMutex);
+        car = carService.getCarById(carId);
+        if (car.getCarId() != 0) {
+            if (!applyCarFields(fields, car, error)) {
+                setError(response, 400, error);
+                return;
+            }
+            if (!car.isValid()) {
+                setError(response, 422, car.getValidationErrors());
+                return;
+            }
+            if (!carService.updateCar(car)) {
+                setError(response, 409, carService.getLastError());
+                return;
+            }
+        }
+    } else if (request.method == "DELETE") {
+        DeletePolicy policy;
+        if (!parseDeletePolicy(request.getQuery("policy"), policy)) {
+            setError(response, 400, "policy must be restrict, cascade or retire.");
+            return;
+        }
+        std::lock_guard<std::mutex> lock(storeMutex);
+        car = carService.getCarById(carId);
+        if (car.getCarId() != 0 && !integrityService.deleteCar(carId, policy)) {
+            setError(response, 409, integrityService.getLastError());
+            return;
+        }
+        if (policy == DeletePolicy::SOFT_DELETE) {
+            car = carService.getCarById(carId);
+        }
+    } else {
+        setError(response, 405, "Use GET, PUT or DELETE.");
+        return;
+    }
+    if (car.getCarId() == 0) {
+        setError(response, 404, "Car not found.");
+        return;
+    }
+    ExportService::writeCarJson(response.body, car);
+}
+
+void ApiServer::customers(const HttpRequest& request, const std::string& id, const std::string& action,
+                          HttpResponse& response) {
+    std::string error;
+    if (id.empty()) {
+        if (request.method == "GET") {
+            std::vector<Customer> customers;
+            long long total = -1;
+            size_t offset = 0, limit = 0;
+            std::string email = request.getQuery("email");
+            std::string license = request.getQuery("license");
+            if (!request.getQuery("q").empty()) {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                customers = customerService.searchCustomers(request.getQuery("q"));
+            } else if (!email.empty() || !license.empty()) {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                Customer customer = email.empty() ? customerService.findCustomerByLicense(license)
+                                                  : customerService.findCustomerByEmail(email);
+                if (customer.getCustomerId() != 0) customers.push_back(customer);
+            } else {
+                if (!readPage(request, offset, limit, error)) {
+                    setError(response, 400, error);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(storeMutex);
+                total = static_cast<long long>(customerService.getCustomerCount());
+                customers = customerService.getCustomersPage(CustomerSortKey::ID, offset, limit);
+            }
+            writeCustomers(response, customers, total, offset);
+        } else if (request.method == "POST") {
+            Fields fields;
+            if (!readBody(request, fields, response)) return;
+            Customer customer;
+            if (!applyCustomerFields(fields, customer, error)) {
+                setError(response, 400, error);
+                return;
+            }
+            if (!customer.isValid()) {
+                setError(response, 422, customer.getValidationErrors());
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(storeMutex);
+                int customerId = customerService.getNextId();
+                if (!customerService.addCustomer(customer)) {
+                    setError(response, 409, customerService.getLastError());
+                    return;
+                }
+                customer = customerService.getCustomerById(customerId);
+            }
+            response.status = 201;
+            ExportService::writeCustomerJson(response.body, customer);
+        } else {
+            setError(response, 405, "Use GET or POST.");
+        }
+        return;
+    }
+
+    int customerId = 0;
+    if (!action.empty() || !parseInt(id, customerId)) {
+        setError(response, 404, "No such resource.");
+        return;
+    }
+    Customer customer;
+    if (request.method == "GET") {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        customer = customerService.getCustomerById(customerId);
+    } else if (request.method == "PUT") {
+        Fields fields;
+        if (!readBody(request, fields, response)) return;
+        std::lock_guard<std::mutex> lock(storeMutex);
+        customer = customerService.getCustomerById(customerId);
+        if (customer.getCustomerId() != 0) {
+            if (!applyCustomerFields(fields, customer, error)) {
+                setError(response, 400, error);
+                return;
+            }
+            if (!customer.isValid()) {
+                setError(response, 422, customer.getValidationErrors());
+                return;
+            }
+            if (!customerService.updateCustomer(customer)) {
+                setError(response, 409, customerService.getLastError());
+                return;
+            }
+        }
+    } else if (request.method == "DELETE") {
+        DeletePolicy policy;
+        if (!parseDeletePolicy(request.getQuery("policy"), policy)) {
+            setError(response, 400, "policy must be restrict, cascade or retire.");
+            return;
+        }
+        std::lock_guard<std::mutex> lock(storeMutex);
+        customer = customerService.getCustomerById(customerId);
+        if (customer.getCustomerId() != 0 && !integrityService.deleteCustomer(customerId, policy)) {
+            setError(response, 409, integrityService.getLastError());
+            return;
+        }
+        if (policy == DeletePolicy::SOFT_DELETE) {
+            customer = customerService.getCustomerById(customerId);
+        }
+    } else {
+        setError(response, 405, "Use GET, PUT or DELETE.");
+        return;
+    }
+    if (customer.getCustomerId() == 0) {
+        setError(response, 404, "Customer not found.");
+        return;
+    }
+    ExportService::writeCustomerJson(response.body, customer);
+}
+
+void ApiServer::bookings(const HttpRequest& request, const std::string& id, const std::string& action,
+                         HttpResponse& response) {
+    std::string error;
+    int status = 200;
+    if (id.empty()) {
+        if (request.method == "GET") {
+            std::vector<Booking> bookings;
+            long long total = -1;
+            size_t offset = 0, limit = 0;
+            int ownerId = 0;
+            std::string customerId = request.getQuery("customerId");
+            std::string carId = request.getQuery("carId");
+            if (!customerId.empty() || !carId.empty()) {
+                if (!parseInt(customerId.empty() ? carId : customerId, ownerId)) {
+                    setError(response, 400, "customerId and carId must be numbers.");
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(storeMutex);
+                bookings = customerId.empty() ? bookingService.getBookingsByCarId(ownerId)
+                                              : bookingService.getBookingsByCustomerId(ownerId);
+            } else {
+                if (!readPage(request, offset, limit, error)) {
+                    setError(response, 400, error);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(storeMutex);
+                total = static_cast<long long>(bookingService.getBookingCount());
+                bookings = bookingService.getBookingsPage(BookingSortKey::ID, offset, limit);
+            }
+            writeBookings(response, bookings, total, offset);
+        } else if (request.method == "POST") {
+            Fields fields;
+            if (!readBody(request, fields, response)) return;
+            std::vector<Booking> added;
+            if (!addBookings(std::vector<Fields>(1, fields), added, status, error)) {
+                setError(response, status, error);
+                return;
+            }
+            response.status = 201;
+            ExportService::writeBookingJson(response.body, added.front());
+        } else {
+            setError(response, 405, "Use GET or POST.");
+        }
+        return;
+    }
+    if (id == "batch" && action.empty()) {
+        if (request.method != "POST") {
+            setError(response, 405, "Use POST.");
+            return;
+        }
+        std::vector<Fields> batch;
+        if (!readBatch(request, batch, response)) return;
+        std::vector<Booking> added;
+        if (!addBookings(batch, added, status, error)) {
+            setError(response, status, error);
+            return;
+        }
+        response.status = 201;
+        writeBookings(response, added, -1, 0);
+        return;
+    }
+
+    int bookingId = 0;
+    if (!parseInt(id, bookingId) || (!action.empty() && action != "cancel" && action != "return")) {
+        setError(response, 404, "No such resource.");
+        return;
+    }
+    Booking booking;
+    if (!action.empty()) {
+        if (request.method != "POST") {
+            setError(response, 405, "Use POST.");
+            return;
+        }
+        std::lock_guard<std::mutex> lock(storeMutex);
+        if (action == "cancel") {
+            if (!cancelBooking(bookingId, booking, status, error)) {
+                setError(response, status, error);
+                return;
+            }
+        } else {
+            if (!scheduler.returnCar(bookingId)) {
+                error = scheduler.getLastError();
+                setError(response, error == "Booking not found." ? 404 : 409, error);
+                return;
+            }
+            booking = bookingService.getBookingById(bookingId);
+        }
+    } else if (request.method == "GET") {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        booking = bookingService.getBookingById(bookingId);
+    } else if (request.method == "DELETE") {
+        std::lock_guard<std::mutex> lock(storeMutex);
+        booking = bookingService.getBookingById(bookingId);
+        if (booking.getBookingId() != 0 && !bookingService.deleteBooking(bookingId)) {
+            setError(response, 409, bookingService.getLastError());
+            return;
+        }
+    } else {
+        setError(response, 405, "Use GET or DELETE.");
+        return;
+    }
+    if (booking.getBookingId() == 0) {
+        setError(response, 404, "Booking not found.");
+        return;
+    }
+    ExportService::writeBookingJson(response.body, booking);
+}
+
+// Prices the bookings and adds them all if every car is free, or none of them.
+// The checks and the insert happen under one lock; a single booking is a batch of one.
+bool ApiServer::addBookings(const std::vector<Fields>& batch, std::vector<Booking>& bookings, int& status,
+                            std::string& error) {
+    bookings.assign(batch.size(), Booking());
+    auto label = [&batch](size_t index) {
+        return batch.size() > 1 ? "Booking " + std::to_string(index + 1) + ": " : std::string();
+    };
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (!readBooking(batch[i], bookings[i], status, error)) {
+            error = label(i) + error;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(storeMutex);
+    for (size_t i = 0; i < bookings.size(); i++) {
+        Booking& booking = bookings[i];
+        Car car = carService.getCarById(booking.getCarId());
+        if (car.getCarId() == 0) {
+            status = 422;
+            error = label(i) + "Car " + std::to_string(booking.getCarId()) + " does not exist.";
+            return false;
+        }
+        if (!bookingService.isCarAvailable(booking.getCarId(), booking.getStartDate(), booking.getEndDate())) {
+            status = 409;
+            error = label(i) + "Car " + std::to_string(booking.getCarId()) + " is already booked for these dates.";
+            return false;
+        }
+        booking.setTotalCost(pricing.quote(car, booking.getStartDate(), booking.getEndDate()));
+    }
+    // Checks the batch against itself (overlaps) and against the customers, then writes once
+    if (!bookingService.addBookings(bookings)) {
+        status = 422;
+        error = bookingService.getLastError();
+        return false;
+    }
+    return true;
+}
+
+// Called with the store lock held. Frees the car if this booking was what held it today.
+bool ApiServer::cancelBooking(int bookingId, Booking& booking, int& status, std::string& error) {
+    booking = bookingService.getBookingById(bookingId);
+    if (booking.getBookingId() == 0) {
+        status = 404;
+        error = "Booking not found.";
+        return false;
+    }
+    if (!booking.isActive()) {
+        status = 409;
+        error = "Only active bookings can be cancelled.";
+        return false;
+    }
+    booking.setStatus("Cancelled");
+    if (!bookingService.updateBooking(booking)) {
+        status = 409;
+        error = bookingService.getLastError();
+        return false;
+    }
+    Car car = carService.getCarById(booking.getCarId());
+    int today = Booking::today();
+    if (car.getCarId() != 0 && car.getStatus() == CarStatus::RENTED &&
+        bookingService.isCarAvailable(car.getCarId(), today, today + 1)) {
+        car.setStatus(CarStatus::AVAILABLE);
+        carService.updateCar(car);
+    }
+    return true;
+}
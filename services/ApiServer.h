@@ -0,0 +1,94 @@
+#ifndef APISERVER_H
+#define APISERVER_H
+
+#include "CarService.h"
+#include "CustomerService.h"
+#include "BookingService.h"
+#include "AvailabilityService.h"
+#include "IntegrityService.h"
+#include "LifecycleScheduler.h"
+#include "PricingEngine.h"
+#include "../utils/HttpServer.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// JSON-over-HTTP access to the cars, customers and bookings for the web
+// booking site and other local programs:
+//
+//   GET    /health
+//   GET    /availability?start=&end=[&fuel=&transmission=&seats=&maxRate=&limit=]
+//   GET    /quote?carId=&start=&end=
+//   GET    /cars[?q=|plate=|offset=&limit=]         POST /cars
+//   GET    /cars/{id}                               PUT/DELETE /cars/{id}[?policy=]
+//   GET    /customers[?q=|email=|license=|offset=&limit=]   POST /customers
+//   GET    /customers/{id}                          PUT/DELETE /customers/{id}[?policy=]
+//   GET    /bookings[?customerId=|carId=|offset=&limit=]    POST /bookings
+//   GET    /bookings/{id}                           DELETE /bookings/{id}
+//   POST   /bookings/batch
+//   POST   /bookings/{id}/cancel, /bookings/{id}/return
+//
+// Request bodies are flat JSON objects using the field names of the
+// responses; a batch of bookings has one per line and is added all or nothing. Errors are answered as {"error": "..."} with a 4xx status.
+// Deleting a car or customer that has bookings is refused unless policy is
+// "cascade" (delete the bookings too) or "retire" (keep it, retired or
+// deactivated), as in the console.
+//
+// Requests are parsed and answered by an HttpServer's event loop and handled
+// on its workers. The services are not thread-safe, so each request holds
+// one store lock only while it calls them and copies the results out; the
+// JSON is written after the lock is released. Store calls therefore run one
+// at a time: the workers overlap parsing, JSON and network I/O, not the
+// lookups themselves. A reader/writer lock would not help, because reads
+// change the services too (reloading a changed file, building sort orders,
+// calendars and reference indexes on first use, reading partitions).
+class ApiServer {
+private:
+    CarService& carService;
+    CustomerService& customerService;
+    BookingService& bookingService;
+    IntegrityService& integrityService;
+    LifecycleScheduler& scheduler;
+    const PricingEngine& pricing;
+    AvailabilityService availabilityService;
+    std::mutex storeMutex;
+    HttpServer http;
+
+    using Fields = std::map<std::string, std::string>;
+
+    void route(const HttpRequest& request, HttpResponse& response);
+    void health(HttpResponse& response);
+    void availability(const HttpRequest& request, HttpResponse& response);
+    void quote(const HttpRequest& request, HttpResponse& response);
+    void cars(const HttpRequest& request, const std::string& id, const std::string& action, HttpResponse& response);
+    void customers(const HttpRequest& request, const std::string& id, const std::string& action,
+                   HttpResponse& response);
+    void bookings(const HttpRequest& request, const std::string& id, const std::string& action,
+                  HttpResponse& response);
+    bool addBookings(const std::vector<Fields>& batch, std::vector<Booking>& bookings, int& status,
+                     std::string& error);
+    bool cancelBooking(int bookingId, Booking& booking, int& status, std::string& error);
+
+public:
+    // A worker count of 0 uses the number of hardware threads
+    ApiServer(CarService& carService, CustomerService& customerService, BookingService& bookingService,
+              IntegrityService& integrityService, LifecycleScheduler& scheduler, const PricingEngine& pricing,
+              size_t workerCount = 0);
+    ~ApiServer();
+
+    ApiServer(const ApiServer&) = delete;
+    ApiServer& operator=(const ApiServer&) = delete;
+
+    bool start(const std::string& host, int port);
+    void stop();
+    // Answers one request without the network, e.g. for in-process load tests
+    void handle(const HttpRequest& request, HttpResponse& response);
+    // Brings booking and car statuses up to date; call it now and then
+    LifecycleTickResult tick();
+
+    const HttpServer& getHttpServer() const;
+    std::string getLastError() const;
+};
+
+#endif // APISERVER_H
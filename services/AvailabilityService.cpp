@@ -0,0 +1,30 @@
+#include "AvailabilityService.h"
+
+AvailabilityService::AvailabilityService(CarService& carService, BookingService& bookingService)
+    : carService(carService), bookingService(bookingService) {
+}
+
+std::vector<Car> AvailabilityService::findAvailableCars(const AvailabilityQuery& query) {
+    std::vector<Car> results;
+    if (!Booking::isValidDate(query.startDate) || !Booking::isValidDate(query.endDate) ||
+        !Booking::isDateAfter(query.endDate, query.startDate)) {
+        return results;
+    }
+
+    int startDay = Booking::dateToDays(query.startDate);
+    int endDay = Booking::dateToDays(query.endDate);
+
+    carService.forEachCarByRate(query.filter, [&](const Car& car) {
+        if (isBookable(car) && bookingService.isCarAvailable(car.getCarId(), startDay, endDay)) {
+            results.push_back(car);
+        }
+        return query.limit == 0 || results.size() < query.limit;
+    });
+    return results;
+}
+
+// Current rental status is not checked: a car that is out today can still be
+// booked for later dates, which the calendar decides
+bool AvailabilityService::isBookable(const Car& car) const {
+    return car.getStatus() != CarStatus::MAINTENANCE && car.getStatus() != CarStatus::RETIRED;
+}
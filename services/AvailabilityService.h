@@ -0,0 +1,33 @@
+#ifndef AVAILABILITYSERVICE_H
+#define AVAILABILITYSERVICE_H
+
+#include "CarService.h"
+#include "BookingService.h"
+#include <string>
+#include <vector>
+
+struct AvailabilityQuery {
+    std::string startDate;
+    std::string endDate;
+    CarFilter filter;
+    size_t limit;    // 0 means no limit
+
+    AvailabilityQuery() : limit(0) {}
+};
+
+// Answers "which cars are free for these dates" by walking the car service's
+// rate-ordered attribute index and checking each candidate against the
+// booking calendar, so results come out sorted by daily rate.
+class AvailabilityService {
+private:
+    CarService& carService;
+    BookingService& bookingService;
+
+public:
+    AvailabilityService(CarService& carService, BookingService& bookingService);
+
+    std::vector<Car> findAvailableCars(const AvailabilityQuery& query);
+    bool isBookable(const Car& car) const;
+};
+
+#endif // AVAILABILITYSERVICE_H
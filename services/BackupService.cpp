@@ -0,0 +1,413 @@
+#include "BackupService.h"
+#include "../database/FileManager.h"
+#include "../utils/Checksum.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/TimeUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+const size_t BackupService::MIN_CHUNK = 2048;
+const size_t BackupService::MAX_CHUNK = 65536;
+
+namespace {
+
+// A cut point is where the top 13 bits of the rolling hash are zero (1 in 8192).
+// The top bits mix in the last 64 bytes; the low bits only the last few.
+const uint64_t CUT_MASK = ((1ull << 13) - 1) << 51;
+
+// Timestamps within this window of the backup may still change without the
+// file system noticing, so such files are re-read by the next backup
+const long long RACY_NS = 2000000000LL;
+
+struct GearTable {
+    uint64_t entries[256];
+
+    GearTable() {
+        uint64_t state = 0x2545F4914F6CDD1Dull;
+        for (int i = 0; i < 256; i++) {
+            state += 0x9E3779B97F4A7C15ull;
+            uint64_t value = state;
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+            entries[i] = value ^ (value >> 31);
+        }
+    }
+};
+
+const GearTable gear;
+
+// Length of the next chunk at the start of data. The gear hash shifts one bit
+// per byte, so it only depends on the last 64 bytes and the boundaries
+// resynchronize shortly after an edit.
+size_t nextCut(const char* data, size_t size) {
+    if (size <= BackupService::MIN_CHUNK) {
+        return size;
+    }
+    size_t limit = std::min(size, BackupService::MAX_CHUNK);
+    uint64_t hash = 0;
+    for (size_t i = BackupService::MIN_CHUNK; i < limit; i++) {
+        hash = (hash << 1) + gear.entries[static_cast<unsigned char>(data[i])];
+        if ((hash & CUT_MASK) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+bool readFile(const std::string& path, std::string& contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+bool writeFileAtomically(const std::string& path, const char* data, size_t size) {
+    std::string tempFile = path + ".tmp";
+    std::ofstream file(tempFile, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(data, size);
+    file.close();
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, path)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+BackupService::BackupService(CarService& carService, CustomerService& customerService,
+                             BookingService& bookingService, const std::string& backupDirectory)
+    : carService(carService), customerService(customerService), bookingService(bookingService),
+      backupDirectory(backupDirectory) {
+}
+
+BackupResult BackupService::createBackup() {
+    BackupResult result;
+    flushWrites();
+
+    FileManager fileManager;
+    if (!fileManager.createDirectory(backupDirectory) ||
+        !fileManager.createDirectory(backupDirectory + "/chunks") ||
+        !fileManager.createDirectory(backupDirectory + "/snapshots")) {
+        result.error = "Cannot create backup directory: " + backupDirectory;
+        return result;
+    }
+
+    std::vector<BackupInfo> existing = listBackups();
+    std::vector<ManifestFile> previous;
+    int backupId = 1;
+    if (!existing.empty()) {
+        backupId = existing.back().backupId + 1;
+        std::string ignored;
+        loadManifest(existing.back().backupId, previous, ignored); // A missing manifest just means a full read
+    }
+
+    long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    BackupInfo& info = result.info;
+    std::vector<ManifestFile> files;
+    for (const std::string& path : dataFiles()) {
+        FileStamp stamp = FileManager::getFileStamp(path);
+        if (stamp.size < 0) {
+            continue; // Not created yet
+        }
+
+        auto prior = std::find_if(previous.begin(), previous.end(),
+                                  [&path](const ManifestFile& file) { return file.path == path; });
+        ManifestFile entry;
+        if (prior != previous.end() && !prior->racy && prior->size == stamp.size &&
+            prior->modifiedNs == stamp.modifiedNs) {
+            entry = *prior;
+            result.filesUnchanged++;
+        } else {
+            std::string contents;
+            if (!readFile(path, contents)) {
+                result.error = "Cannot read " + path;
+                return result;
+            }
+            entry.path = path;
+            entry.size = static_cast<long long>(contents.size());
+            entry.modifiedNs = stamp.modifiedNs;
+            entry.crc = Checksum::crc32(contents.data(), contents.size());
+
+            for (size_t offset = 0; offset < contents.size();) {
+                size_t length = nextCut(contents.data() + offset, contents.size() - offset);
+                std::string hash = Checksum::contentHash(contents.data() + offset, length);
+                bool stored = false;
+                if (!storeChunk(hash, contents.data() + offset, length, stored)) {
+                    result.error = "Cannot write chunk " + hash;
+                    return result;
+                }
+                if (stored) {
+                    info.newChunks++;
+                    info.newBytes += static_cast<long long>(length);
+                }
+                entry.chunks.push_back({hash, static_cast<uint32_t>(length)});
+                offset += length;
+            }
+        }
+        entry.racy = entry.modifiedNs + RACY_NS > nowNs;
+
+        info.files++;
+        info.totalBytes += entry.size;
+        files.push_back(std::move(entry));
+    }
+
+    info.backupId = backupId;
+    info.created = TimeUtils::currentTimestamp();
+    if (!saveManifest(backupId, files) || !appendCatalog(info)) {
+        result.error = "Cannot write backup " + std::to_string(backupId);
+        return result;
+    }
+
+    result.success = true;
+    return result;
+}
+
+std::vector<BackupInfo> BackupService::listBackups() {
+    std::vector<BackupInfo> backups;
+    std::ifstream catalog(backupDirectory + "/catalog.csv");
+    if (!catalog.is_open()) {
+        return backups;
+    }
+
+    std::string line;
+    std::vector<std::string> fields;
+    std::getline(catalog, line); // Header
+    while (std::getline(catalog, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() < 6) continue;
+        BackupInfo info;
+        info.backupId = std::atoi(fields[0].c_str());
+        info.created = fields[1];
+        info.files = std::atoi(fields[2].c_str());
+        info.totalBytes = std::atoll(fields[3].c_str());
+        info.newChunks = std::atoi(fields[4].c_str());
+        info.newBytes = std::atoll(fields[5].c_str());
+        if (info.backupId > 0) {
+            backups.push_back(info);
+        }
+    }
+    std::sort(backups.begin(), backups.end(),
+              [](const BackupInfo& a, const BackupInfo& b) { return a.backupId < b.backupId; });
+    return backups;
+}
+
+VerifyResult BackupService::verifyBackup(int backupId) {
+    VerifyResult result;
+    std::vector<ManifestFile> files;
+    if (!loadManifest(backupId, files, result.error)) {
+        return result;
+    }
+
+    std::set<std::string> checked;
+    std::string data, error;
+    for (const ManifestFile& file : files) {
+        uint32_t crc = 0;
+        long long size = 0;
+        bool complete = true;
+        for (const auto& chunk : file.chunks) {
+            if (!readChunk(chunk.first, chunk.second, data, error)) {
+                result.problems.push_back(file.path + ": " + error);
+                complete = false;
+                break;
+            }
+            if (checked.insert(chunk.first).second) {
+                result.chunksChecked++;
+            }
+            result.bytesChecked += static_cast<long long>(data.size());
+            crc = Checksum::crc32(data.data(), data.size(), crc);
+            size += static_cast<long long>(data.size());
+        }
+        if (complete && (crc != file.crc || size != file.size)) {
+            result.problems.push_back(file.path + ": checksum mismatch");
+        }
+    }
+
+    result.success = result.problems.empty();
+    return result;
+}
+
+bool BackupService::restoreBackup(int backupId, std::string& error) {
+    std::vector<ManifestFile> files;
+    if (!loadManifest(backupId, files, error)) {
+        return false;
+    }
+    flushWrites();
+
+    // Rebuild every file beside the original first, so a bad chunk leaves the data untouched
+    std::vector<std::string> restored;
+    auto discard = [&restored]() {
+        for (const std::string& path : restored) {
+            std::remove(path.c_str());
+        }
+    };
+    std::string data;
+    for (const ManifestFile& file : files) {
+        std::string tempFile = file.path + ".restore";
+        restored.push_back(tempFile);
+        std::ofstream out(tempFile, std::ios::binary);
+        if (!out.is_open()) {
+            error = "Cannot create " + tempFile;
+            discard();
+            return false;
+        }
+
+        uint32_t crc = 0;
+        long long size = 0;
+        for (const auto& chunk : file.chunks) {
+            if (!readChunk(chunk.first, chunk.second, data, error)) {
+                error = file.path + ": " + error;
+                out.close();
+                discard();
+                return false;
+            }
+            crc = Checksum::crc32(data.data(), data.size(), crc);
+            size += static_cast<long long>(data.size());
+            out.write(data.data(), data.size());
+        }
+        out.close();
+        if (!out || crc != file.crc || size != file.size) {
+            error = file.path + ": restored data does not match its checksum";
+            discard();
+            return false;
+        }
+    }
+
+    FileManager fileManager;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (!fileManager.replaceFile(restored[i], files[i].path)) {
+            error = "Cannot replace " + files[i].path;
+            for (size_t j = i; j < restored.size(); j++) {
+                std::remove(restored[j].c_str());
+            }
+            return false;
+        }
+        FileManager::markFileWritten(files[i].path); // Services reload on their next access
+    }
+    return true;
+}
+
+std::vector<std::string> BackupService::dataFiles() {
+    std::vector<std::string> files = {carService.getDataFile(), customerService.getDataFile()};
+    std::vector<std::string> bookings = bookingService.getStorageFiles();
+    files.insert(files.end(), bookings.begin(), bookings.end());
+    std::vector<std::string> archive = bookingService.getArchiveFiles();
+    files.insert(files.end(), archive.begin(), archive.end());
+    return files;
+}
+
+void BackupService::flushWrites() {
+    carService.flushWrites();
+    customerService.flushWrites();
+    bookingService.flushWrites();
+}
+
+std::string BackupService::chunkPath(const std::string& hash) const {
+    return backupDirectory + "/chunks/" + hash.substr(0, 2) + "/" + hash;
+}
+
+std::string BackupService::manifestPath(int backupId) const {
+    return backupDirectory + "/snapshots/" + std::to_string(backupId) + ".manifest";
+}
+
+bool BackupService::storeChunk(const std::string& hash, const char* data, size_t size, bool& stored) {
+    std::string path = chunkPath(hash);
+    FileManager fileManager;
+    if (fileManager.fileExists(path)) {
+        stored = false;
+        return true;
+    }
+    if (!fileManager.createDirectory(backupDirectory + "/chunks/" + hash.substr(0, 2))) {
+        return false;
+    }
+    stored = writeFileAtomically(path, data, size);
+    return stored;
+}
+
+bool BackupService::readChunk(const std::string& hash, uint32_t length, std::string& data, std::string& error) {
+    if (!readFile(chunkPath(hash), data)) {
+        error = "chunk " + hash + " is missing";
+        return false;
+    }
+    if (data.size() != length || Checksum::contentHash(data.data(), data.size()) != hash) {
+        error = "chunk " + hash + " is corrupt";
+        return false;
+    }
+    return true;
+}
+
+// Manifest lines: F,path,size,modifiedNs,racy,crc for each file, followed by
+// C,hash,length for each of its chunks in order
+bool BackupService::loadManifest(int backupId, std::vector<ManifestFile>& files, std::string& error) {
+    files.clear();
+    std::ifstream manifest(manifestPath(backupId));
+    if (!manifest.is_open()) {
+        error = "Backup " + std::to_string(backupId) + " not found.";
+        return false;
+    }
+
+    std::string line;
+    std::vector<std::string> fields;
+    while (std::getline(manifest, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() == 6 && fields[0] == "F") {
+            ManifestFile file;
+            file.path = fields[1];
+            file.size = std::atoll(fields[2].c_str());
+            file.modifiedNs = std::atoll(fields[3].c_str());
+            file.racy = fields[4] == "1";
+            file.crc = static_cast<uint32_t>(std::strtoul(fields[5].c_str(), nullptr, 16));
+            files.push_back(file);
+        } else if (fields.size() == 3 && fields[0] == "C" && !files.empty()) {
+            files.back().chunks.push_back({fields[1], static_cast<uint32_t>(std::strtoul(fields[2].c_str(), nullptr, 10))});
+        } else if (!line.empty()) {
+            error = "Backup " + std::to_string(backupId) + " has a damaged manifest.";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BackupService::saveManifest(int backupId, const std::vector<ManifestFile>& files) {
+    std::string contents;
+    for (const ManifestFile& file : files) {
+        contents += "F," + file.path + "," + std::to_string(file.size) + "," + std::to_string(file.modifiedNs) +
+                    "," + (file.racy ? "1" : "0") + "," + Checksum::toHex(file.crc) + "\n";
+        for (const auto& chunk : file.chunks) {
+            contents += "C," + chunk.first + "," + std::to_string(chunk.second) + "\n";
+        }
+    }
+    return writeFileAtomically(manifestPath(backupId), contents.data(), contents.size());
+}
+
+bool BackupService::appendCatalog(const BackupInfo& info) {
+    std::string path = backupDirectory + "/catalog.csv";
+    FileManager fileManager;
+    bool exists = fileManager.fileExists(path);
+    std::ofstream catalog(path, std::ios::app);
+    if (!catalog.is_open()) {
+        return false;
+    }
+    if (!exists) {
+        catalog << "ID,Created,Files,TotalBytes,NewChunks,NewBytes\n";
+    }
+    catalog << info.backupId << "," << info.created << "," << info.files << "," << info.totalBytes << ","
+            << info.newChunks << "," << info.newBytes << "\n";
+    catalog.close();
+    return static_cast<bool>(catalog);
+}
@@ -0,0 +1,95 @@
+#ifndef BACKUPSERVICE_H
+#define BACKUPSERVICE_H
+
+#include "CarService.h"
+#include "CustomerService.h"
+#include "BookingService.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One line of the backup catalog
+struct BackupInfo {
+    int backupId;
+    std::string created;
+    int files;
+    long long totalBytes;
+    int newChunks;
+    long long newBytes;
+
+    BackupInfo() : backupId(0), files(0), totalBytes(0), newChunks(0), newBytes(0) {}
+};
+
+struct BackupResult {
+    bool success;
+    BackupInfo info;
+    int filesUnchanged;     // Reused from the previous backup without being read
+    std::string error;
+
+    BackupResult() : success(false), filesUnchanged(0) {}
+};
+
+struct VerifyResult {
+    bool success;
+    int chunksChecked;
+    long long bytesChecked;
+    std::vector<std::string> problems;
+    std::string error;
+
+    VerifyResult() : success(false), chunksChecked(0), bytesChecked(0) {}
+};
+
+// Deduplicated point-in-time backups of the data files in data/backups.
+//
+// Files are cut into content-defined chunks (a rolling hash picks the
+// boundaries, so an edit only changes the chunks around it) and each chunk is
+// stored once under chunks/, named by its content hash. A backup is a manifest
+// listing every file's size, CRC-32 and chunk sequence, plus a catalog line.
+// Files whose size and modification time match the previous backup are not
+// read at all, and only chunks not already stored are written, so the cost of
+// a backup follows the amount of change rather than the size of the data.
+class BackupService {
+private:
+    struct ManifestFile {
+        std::string path;
+        long long size;
+        long long modifiedNs;
+        bool racy;              // Modified too close to the backup to trust its timestamp
+        uint32_t crc;
+        std::vector<std::pair<std::string, uint32_t>> chunks;   // (hash, length)
+
+        ManifestFile() : size(0), modifiedNs(0), racy(true), crc(0) {}
+    };
+
+    CarService& carService;
+    CustomerService& customerService;
+    BookingService& bookingService;
+    std::string backupDirectory;
+
+    std::vector<std::string> dataFiles();
+    void flushWrites();
+    std::string chunkPath(const std::string& hash) const;
+    std::string manifestPath(int backupId) const;
+    bool storeChunk(const std::string& hash, const char* data, size_t size, bool& stored);
+    bool readChunk(const std::string& hash, uint32_t length, std::string& data, std::string& error);
+    bool loadManifest(int backupId, std::vector<ManifestFile>& files, std::string& error);
+    bool saveManifest(int backupId, const std::vector<ManifestFile>& files);
+    bool appendCatalog(const BackupInfo& info);
+
+public:
+    BackupService(CarService& carService, CustomerService& customerService, BookingService& bookingService,
+                  const std::string& backupDirectory = "data/backups");
+
+    BackupResult createBackup();
+    std::vector<BackupInfo> listBackups();
+    // Re-reads every chunk of the backup and checks chunk hashes and file CRCs
+    VerifyResult verifyBackup(int backupId);
+    // Rebuilds the data files from a backup; each file is verified before any is replaced
+    bool restoreBackup(int backupId, std::string& error);
+
+    // Chunk size bounds in bytes; the average chunk is about 8 KB
+    static const size_t MIN_CHUNK;
+    static const size_t MAX_CHUNK;
+};
+
+#endif // BACKUPSERVICE_H
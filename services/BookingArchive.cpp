@@ -0,0 +1,397 @@
+#include "BookingArchive.h"
+#include "BookingService.h"
+#include "RevenueRollup.h"
+#include "../utils/Checksum.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/Lz.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace {
+
+const char* SEGMENT_MAGIC = "BKSEG1";
+
+// Segment files are never overwritten: each rewrite of a month gets the next
+// sequence number, so bookings-2024-03-2.seg replaces bookings-2024-03-1.seg
+std::string nextFileName(const std::string& month, const std::string& previous) {
+    int sequence = 1;
+    size_t dash = previous.rfind('-');
+    if (!previous.empty() && dash != std::string::npos) {
+        sequence = std::atoi(previous.c_str() + dash + 1) + 1;
+    }
+    return "bookings-" + month + "-" + std::to_string(sequence) + ".seg";
+}
+
+bool overlaps(const std::string& start, const std::string& end, const ArchiveFilter& filter) {
+    return Booking::dateToDays(start) < filter.toDay && Booking::dateToDays(end) > filter.fromDay;
+}
+
+bool matches(const Booking& booking, const ArchiveFilter& filter) {
+    if (filter.carId != 0 && booking.getCarId() != filter.carId) return false;
+    if (filter.customerId != 0 && booking.getCustomerId() != filter.customerId) return false;
+    return overlaps(booking.getStartDate(), booking.getEndDate(), filter);
+}
+
+} // namespace
+
+BookingArchive::BookingArchive(const std::string& directory)
+    : directory(directory), catalogFile(directory + "/segments.csv"), version(0), countsValid(false) {
+}
+
+bool BookingArchive::add(const std::vector<Booking>& bookings) {
+    lastError.clear();
+    refreshCatalog();
+
+    std::map<std::string, std::vector<Booking>> byMonth;
+    for (const auto& booking : bookings) {
+        byMonth[booking.getEndDate().substr(0, 7)].push_back(booking);
+    }
+
+    std::vector<ArchiveSegment> changed;
+    for (auto& entry : byMonth) {
+        std::map<int, Booking> merged;
+        std::string previous;
+        for (const auto& segment : segments) {
+            if (segment.month != entry.first) continue;
+            std::vector<Booking> existing;
+            if (!readSegment(segment, existing)) return false;
+            for (const auto& booking : existing) {
+                merged[booking.getBookingId()] = booking;
+            }
+            previous = segment.file;
+        }
+        for (const auto& booking : entry.second) {
+            merged[booking.getBookingId()] = booking;
+        }
+
+        std::vector<Booking> rows;
+        rows.reserve(merged.size());
+        for (const auto& row : merged) {
+            rows.push_back(row.second);
+        }
+        ArchiveSegment segment;
+        segment.file = nextFileName(entry.first, previous);
+        if (!writeSegment(entry.first, rows, segment)) return false;
+        changed.push_back(segment);
+    }
+    return replaceSegments(changed, {});
+}
+
+bool BookingArchive::removeIf(const ArchiveFilter& filter, const std::function<bool(const Booking&)>& predicate,
+                              std::vector<Booking>& removed) {
+    lastError.clear();
+    refreshCatalog();
+
+    std::vector<ArchiveSegment> changed;
+    std::vector<std::string> emptied;
+    for (const auto& segment : segments) {
+        if (!overlaps(segment.firstStart, segment.lastEnd, filter)) continue;
+        std::vector<Booking> rows;
+        if (!readSegment(segment, rows)) return false;
+
+        std::vector<Booking> kept;
+        size_t removedBefore = removed.size();
+        for (const auto& booking : rows) {
+            if (matches(booking, filter) && (!predicate || predicate(booking))) {
+                removed.push_back(booking);
+            } else {
+                kept.push_back(booking);
+            }
+        }
+        if (removed.size() == removedBefore) continue;
+
+        if (kept.empty()) {
+            emptied.push_back(segment.month);
+            continue;
+        }
+        ArchiveSegment rewritten;
+        rewritten.file = nextFileName(segment.month, segment.file);
+        if (!writeSegment(segment.month, kept, rewritten)) return false;
+        changed.push_back(rewritten);
+    }
+    if (changed.empty() && emptied.empty()) {
+        return true;
+    }
+    return replaceSegments(changed, emptied);
+}
+
+bool BookingArchive::scan(const ArchiveFilter& filter, const std::function<void(const Booking&)>& callback) {
+    lastError.clear();
+    refreshCatalog();
+
+    bool ok = true;
+    std::vector<Booking> rows;
+    for (const auto& segment : segments) {
+        if (!overlaps(segment.firstStart, segment.lastEnd, filter)) continue;
+        if (!readSegment(segment, rows)) {
+            ok = false; // Keep going so one damaged segment does not hide the others
+            continue;
+        }
+        for (const auto& booking : rows) {
+            if (matches(booking, filter)) {
+                callback(booking);
+            }
+        }
+    }
+    return ok;
+}
+
+const std::vector<ArchiveSegment>& BookingArchive::getSegments() {
+    refreshCatalog();
+    return segments;
+}
+
+std::vector<std::string> BookingArchive::getFiles() {
+    refreshCatalog();
+    std::vector<std::string> files;
+    for (const auto& segment : segments) {
+        files.push_back(directory + "/" + segment.file);
+    }
+    if (!segments.empty()) {
+        files.push_back(catalogFile);
+    }
+    return files;
+}
+
+size_t BookingArchive::getBookingCount() {
+    refreshCatalog();
+    size_t count = 0;
+    for (const auto& segment : segments) {
+        count += segment.count;
+    }
+    return count;
+}
+
+int BookingArchive::getMaxId() {
+    refreshCatalog();
+    int maxId = 0;
+    for (const auto& segment : segments) {
+        maxId = std::max(maxId, segment.maxId);
+    }
+    return maxId;
+}
+
+size_t BookingArchive::countForCar(int carId) {
+    ensureCounts();
+    auto found = carCounts.find(carId);
+    return found == carCounts.end() ? 0 : found->second;
+}
+
+size_t BookingArchive::countForCustomer(int customerId) {
+    ensureCounts();
+    auto found = customerCounts.find(customerId);
+    return found == customerCounts.end() ? 0 : found->second;
+}
+
+unsigned long BookingArchive::getVersion() {
+    refreshCatalog();
+    return version;
+}
+
+const std::string& BookingArchive::getLastError() const {
+    return lastError;
+}
+
+void BookingArchive::refreshCatalog() {
+    FileStamp stamp = FileManager::getFileStamp(catalogFile);
+    if (stamp == catalogStamp) {
+        return;
+    }
+
+    segments.clear();
+    std::ifstream file(catalogFile);
+    std::string line;
+    std::vector<std::string> fields;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() < 11) continue;
+        ArchiveSegment segment;
+        segment.month = fields[0];
+        segment.file = fields[1];
+        segment.count = std::atoi(fields[2].c_str());
+        segment.firstStart = fields[3];
+        segment.lastEnd = fields[4];
+        segment.revenueCents = std::atoll(fields[5].c_str());
+        segment.minId = std::atoi(fields[6].c_str());
+        segment.maxId = std::atoi(fields[7].c_str());
+        segment.rawBytes = std::atoll(fields[8].c_str());
+        segment.storedBytes = std::atoll(fields[9].c_str());
+        segment.crc = static_cast<uint32_t>(std::strtoul(fields[10].c_str(), nullptr, 16));
+        segments.push_back(segment);
+    }
+
+    catalogStamp = stamp;
+    version++;
+    countsValid = false;
+}
+
+bool BookingArchive::saveCatalog(const std::vector<ArchiveSegment>& catalog) {
+    std::string tempFile = catalogFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+
+    file << "Month,File,Count,FirstStart,LastEnd,RevenueCents,MinId,MaxId,RawBytes,StoredBytes,Crc\n";
+    for (const auto& segment : catalog) {
+        file << segment.month << "," << segment.file << "," << segment.count << ","
+             << segment.firstStart << "," << segment.lastEnd << "," << segment.revenueCents << ","
+             << segment.minId << "," << segment.maxId << "," << segment.rawBytes << ","
+             << segment.storedBytes << "," << Checksum::toHex(segment.crc) << "\n";
+    }
+    file.close();
+
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, catalogFile)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    FileManager::markFileWritten(catalogFile);
+    return true;
+}
+
+bool BookingArchive::readSegment(const ArchiveSegment& segment, std::vector<Booking>& bookings) {
+    bookings.clear();
+    std::string path = directory + "/" + segment.file;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        lastError = "Archive segment " + segment.file + " is missing.";
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string contents = buffer.str();
+
+    size_t headerEnd = contents.find('\n');
+    std::string expected = std::string(SEGMENT_MAGIC) + "," + std::to_string(segment.rawBytes) + "," +
+                           Checksum::toHex(segment.crc);
+    std::string rows;
+    if (headerEnd == std::string::npos || contents.compare(0, headerEnd, expected) != 0 ||
+        !Lz::decompress(contents.data() + headerEnd + 1, contents.size() - headerEnd - 1,
+                        static_cast<size_t>(segment.rawBytes), rows) ||
+        Checksum::crc32(rows.data(), rows.size()) != segment.crc) {
+        lastError = "Archive segment " + segment.file + " is damaged.";
+        return false;
+    }
+
+    bookings.reserve(segment.count);
+    size_t start = 0;
+    while (start < rows.size()) {
+        size_t end = rows.find('\n', start);
+        if (end == std::string::npos) end = rows.size();
+        Booking booking = BookingService::parseBookingFromLine(rows.substr(start, end - start));
+        if (booking.getBookingId() > 0) {
+            bookings.push_back(booking);
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+// bookings must be in ID order; fills in the segment's summary
+bool BookingArchive::writeSegment(const std::string& month, const std::vector<Booking>& bookings,
+                                  ArchiveSegment& segment) {
+    segment.month = month;
+    segment.count = static_cast<int>(bookings.size());
+    segment.minId = bookings.front().getBookingId();
+    segment.maxId = bookings.back().getBookingId();
+    segment.firstStart = bookings.front().getStartDate();
+    segment.lastEnd = bookings.front().getEndDate();
+    segment.revenueCents = 0;
+
+    std::string rows;
+    for (const auto& booking : bookings) {
+        rows += BookingService::bookingToCsvLine(booking);
+        rows += '\n';
+        segment.firstStart = std::min(segment.firstStart, booking.getStartDate());
+        segment.lastEnd = std::max(segment.lastEnd, booking.getEndDate());
+        if (!booking.isCancelled()) {
+            segment.revenueCents += RevenueRollup::toCents(booking.getTotalCost());
+        }
+    }
+    segment.rawBytes = static_cast<long long>(rows.size());
+    segment.crc = Checksum::crc32(rows.data(), rows.size());
+    std::string compressed = Lz::compress(rows.data(), rows.size());
+    segment.storedBytes = static_cast<long long>(compressed.size());
+
+    FileManager fileManager;
+    std::string path = directory + "/" + segment.file;
+    std::string tempFile = path + ".tmp";
+    if (!fileManager.createDirectory(directory)) {
+        lastError = "Failed to create archive directory " + directory + ".";
+        return false;
+    }
+    std::ofstream file(tempFile, std::ios::binary);
+    if (!file.is_open()) {
+        lastError = "Failed to create archive segment " + segment.file + ".";
+        return false;
+    }
+    file << SEGMENT_MAGIC << "," << segment.rawBytes << "," << Checksum::toHex(segment.crc) << "\n";
+    file.write(compressed.data(), compressed.size());
+    file.close();
+    if (!file || !FileManager::syncFile(tempFile) || !fileManager.replaceFile(tempFile, path)) {
+        std::remove(tempFile.c_str());
+        lastError = "Failed to write archive segment " + segment.file + ".";
+        return false;
+    }
+    return true;
+}
+
+// Commits new segment files by writing the catalog, then removes the files it no longer names
+bool BookingArchive::replaceSegments(const std::vector<ArchiveSegment>& changed,
+                                     const std::vector<std::string>& emptied) {
+    std::map<std::string, ArchiveSegment> catalog;
+    for (const auto& segment : segments) {
+        catalog[segment.month] = segment;
+    }
+    std::vector<std::string> obsolete;
+    for (const auto& segment : changed) {
+        auto found = catalog.find(segment.month);
+        if (found != catalog.end()) obsolete.push_back(found->second.file);
+        catalog[segment.month] = segment;
+    }
+    for (const auto& month : emptied) {
+        auto found = catalog.find(month);
+        if (found == catalog.end()) continue;
+        obsolete.push_back(found->second.file);
+        catalog.erase(found);
+    }
+
+    std::vector<ArchiveSegment> updated;
+    for (const auto& entry : catalog) {
+        updated.push_back(entry.second);
+    }
+    if (!saveCatalog(updated)) {
+        for (const auto& segment : changed) {
+            std::remove((directory + "/" + segment.file).c_str());
+        }
+        lastError = "Failed to write " + catalogFile + ".";
+        return false;
+    }
+
+    for (const auto& file : obsolete) {
+        std::remove((directory + "/" + file).c_str());
+    }
+    segments.swap(updated);
+    catalogStamp = FileManager::getFileStamp(catalogFile);
+    version++;
+    countsValid = false;
+    return true;
+}
+
+void BookingArchive::ensureCounts() {
+    refreshCatalog();
+    if (countsValid) {
+        return;
+    }
+    carCounts.clear();
+    customerCounts.clear();
+    scan(ArchiveFilter(), [this](const Booking& booking) {
+        carCounts[booking.getCarId()]++;
+        customerCounts[booking.getCustomerId()]++;
+    });
+    countsValid = true;
+}
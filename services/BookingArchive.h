@@ -0,0 +1,92 @@
+#ifndef BOOKINGARCHIVE_H
+#define BOOKINGARCHIVE_H
+
+#include "../models/Booking.h"
+#include "../database/FileManager.h"
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Catalog entry for one compressed segment: the bookings that ended in one month
+struct ArchiveSegment {
+    std::string month;          // YYYY-MM of the bookings' end dates
+    std::string file;
+    int count;
+    std::string firstStart;     // Earliest start date in the segment
+    std::string lastEnd;        // Latest end date in the segment
+    long long revenueCents;     // Cancelled bookings count nothing, as in the revenue rollup
+    int minId;
+    int maxId;
+    long long rawBytes;
+    long long storedBytes;
+    uint32_t crc;               // CRC-32 of the uncompressed rows
+
+    ArchiveSegment() : count(0), revenueCents(0), minId(0), maxId(0), rawBytes(0), storedBytes(0), crc(0) {}
+};
+
+// Bookings overlapping [fromDay, toDay), optionally for one car or customer (0 = any)
+struct ArchiveFilter {
+    int fromDay;
+    int toDay;
+    int carId;
+    int customerId;
+
+    ArchiveFilter() : fromDay(INT_MIN), toDay(INT_MAX), carId(0), customerId(0) {}
+};
+
+// Compressed cold storage for closed bookings in data/archive.
+//
+// Bookings are grouped by the month they ended in. Each month is one segment
+// file holding its CSV rows compressed with Lz, and segments.csv lists every
+// segment with its date span, count, revenue and ID range. Scans read the
+// catalog first and only decompress segments whose date span overlaps the
+// filter. A segment is replaced by writing a new file and then the catalog,
+// so the catalog always names complete segments.
+class BookingArchive {
+private:
+    std::string directory;
+    std::string catalogFile;
+    std::vector<ArchiveSegment> segments;   // In month order
+    FileStamp catalogStamp;
+    unsigned long version;
+    std::string lastError;
+
+    // Archived bookings per car and customer, built on first use
+    std::unordered_map<int, size_t> carCounts;
+    std::unordered_map<int, size_t> customerCounts;
+    bool countsValid;
+
+    void refreshCatalog();
+    bool saveCatalog(const std::vector<ArchiveSegment>& catalog);
+    bool readSegment(const ArchiveSegment& segment, std::vector<Booking>& bookings);
+    bool writeSegment(const std::string& month, const std::vector<Booking>& bookings, ArchiveSegment& segment);
+    bool replaceSegments(const std::vector<ArchiveSegment>& changed, const std::vector<std::string>& emptied);
+    void ensureCounts();
+
+public:
+    explicit BookingArchive(const std::string& directory = "data/archive");
+
+    // Merges the bookings into their month segments; a booking already archived is replaced
+    bool add(const std::vector<Booking>& bookings);
+    // Removes every archived booking the predicate accepts; removed receives them
+    bool removeIf(const ArchiveFilter& filter, const std::function<bool(const Booking&)>& predicate,
+                  std::vector<Booking>& removed);
+    // Visits matching bookings, segment by segment; false if a segment could not be read
+    bool scan(const ArchiveFilter& filter, const std::function<void(const Booking&)>& callback);
+
+    const std::vector<ArchiveSegment>& getSegments();
+    // Paths of the segment files and the catalog, for backups
+    std::vector<std::string> getFiles();
+    size_t getBookingCount();
+    int getMaxId();
+    size_t countForCar(int carId);
+    size_t countForCustomer(int customerId);
+    // Changes whenever the archive's contents change
+    unsigned long getVersion();
+    const std::string& getLastError() const;
+};
+
+#endif // BOOKINGARCHIVE_H
@@ -1,19 +1,117 @@
 #include "BookingService.h"
+#include "CarService.h"
+#include "CustomerService.h"
+#include "../utils/CsvUtils.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
 
-BookingService::BookingService() : dataFile("data/bookings.csv"), nextId(1) {
-    loadBookings();
+namespace {
+
+const char* BOOKING_HEADER = "ID,CustomerID,CarID,StartDate,EndDate,TotalCost,Status,Notes";
+// Columns summarized per partition, so reference lookups skip months without the car or customer
+const size_t CUSTOMER_COLUMN = 1;
+const size_t CAR_COLUMN = 2;
+
+bool bookingLess(BookingSortKey sortKey, const Booking& a, const Booking& b) {
+    switch (sortKey) {
+        case BookingSortKey::CUSTOMER: return a.getCustomerId() < b.getCustomerId();
+        case BookingSortKey::CAR: return a.getCarId() < b.getCarId();
+        case BookingSortKey::START_DATE: return a.getStartDate() < b.getStartDate();
+        case BookingSortKey::END_DATE: return a.getEndDate() < b.getEndDate();
+        case BookingSortKey::TOTAL_COST: return a.getTotalCost() < b.getTotalCost();
+        case BookingSortKey::STATUS: return a.getStatus() < b.getStatus();
+        default: return a.getBookingId() < b.getBookingId();
+    }
+}
+
+} // namespace
+
+BookingService::BookingService(const std::string& dataDirectory)
+    : dataFile(dataDirectory + "/bookings.csv"), nextId(1), slotFile(dataFile), writeQueue(nullptr),
+      writes(std::make_shared<WriteTracker>()), loadGeneration(0),
+      sortIndex(bookingLess, [](const Booking& booking) { return booking.getBookingId(); }),
+      partitions(dataDirectory + "/bookings", BOOKING_HEADER), partitioned(false), calendarsValid(false),
+      referencesValid(false), carService(nullptr), customerService(nullptr),
+      rollupFile(dataDirectory + "/rollups.csv"), archive(dataDirectory + "/archive"),
+      changeRecorder(ChangeEntity::BOOKING, bookingToCsvLine, [](const Booking& booking) { return booking.getBookingId(); }) {
+    partitions.summarizeColumns({CUSTOMER_COLUMN, CAR_COLUMN});
+    partitioned = partitions.exists();
+    refreshStore();
 }
 
+// A batch of one, so a single booking gets the same checks and the same rollback
 bool BookingService::addBooking(const Booking& booking) {
-    std::vector<Booking> bookings = loadBookings();
-    Booking newBooking = booking;
-    newBooking.setBookingId(getNextId());
-    bookings.push_back(newBooking);
-    nextId++;
-    return saveBookings(bookings);
+    std::vector<Booking> batch(1, booking);
+    return addBookings(batch);
+}
+
+bool BookingService::addBookings(std::vector<Booking>& bookings) {
+    lastError.clear();
+    if (bookings.empty()) {
+        return true;
+    }
+    
+    refreshStore();
+    ensureCalendars();
+    
+    // Validate every booking and check it against the stored calendars
+    for (size_t i = 0; i < bookings.size(); i++) {
+        const Booking& booking = bookings[i];
+        std::string label = bookings.size() > 1 ? "Booking " + std::to_string(i + 1) + ": " : "";
+        if (!booking.isValid()) {
+            lastError = label + booking.getValidationErrors();
+            return false;
+        }
+        std::string error;
+        if (!checkReferences(booking, nullptr, error)) {
+            lastError = label + error;
+            return false;
+        }
+        if (!booking.occupiesCar()) continue;
+        if (!isCarAvailable(booking.getCarId(), booking.getStartDate(), booking.getEndDate())) {
+            lastError = label + "Car " + std::to_string(booking.getCarId()) + " is already booked for these dates.";
+            return false;
+        }
+    }
+    if (!checkBatchOverlaps(bookings, false, lastError)) {
+        return false;
+    }
+    
+    // Assign contiguous IDs and commit with a single write
+    int firstId = getNextId();
+    std::vector<int> bookingIds;
+    for (size_t i = 0; i < bookings.size(); i++) {
+        bookings[i].setBookingId(firstId + static_cast<int>(i));
+        indexAdd(store[bookings[i].getBookingId()] = bookings[i]);
+        rollup.apply(bookings[i], +1);
+        bookingIds.push_back(bookings[i].getBookingId());
+        changeRecorder.record(nullptr, &bookings[i]);
+    }
+    
+    if (!persistRows(bookingIds)) {
+        changeRecorder.discard();
+        for (auto& booking : bookings) {
+            rollup.apply(booking, -1);
+            auto it = store.find(booking.getBookingId());
+            indexRemove(it->second);
+            store.erase(it);
+            booking.setBookingId(0);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    
+    nextId = firstId + static_cast<int>(bookings.size());
+    if (changeListener) {
+        for (const auto& booking : bookings) {
+            changeListener(booking);
+        }
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 std::vector<Booking> BookingService::getAllBookings() {
@@ -21,104 +119,671 @@ std::vector<Booking> BookingService::getAllBookings() {
 }
 
 Booking BookingService::getBookingById(int bookingId) {
-    std::vector<Booking> bookings = loadBookings();
-    for (const auto& booking : bookings) {
-        if (booking.getBookingId() == bookingId) {
-            return booking;
-        }
+    refreshStore();
+    ensureBookingLoaded(bookingId);
+    auto it = store.find(bookingId);
+    if (it != store.end()) {
+        return it->second;
     }
     return Booking();
 }
 
 std::vector<Booking> BookingService::getBookingsByCustomerId(int customerId) {
-    std::vector<Booking> bookings = loadBookings();
+    std::vector<int> ids = getBookingIdsForCustomer(customerId);
+    std::sort(ids.begin(), ids.end());
     std::vector<Booking> results;
-    for (const auto& booking : bookings) {
-        if (booking.getCustomerId() == customerId) {
-            results.push_back(booking);
-        }
+    results.reserve(ids.size());
+    for (int id : ids) {
+        results.push_back(store[id]);
     }
     return results;
 }
 
 std::vector<Booking> BookingService::getBookingsByCarId(int carId) {
-    std::vector<Booking> bookings = loadBookings();
+    std::vector<int> ids = getBookingIdsForCar(carId);
+    std::sort(ids.begin(), ids.end());
     std::vector<Booking> results;
-    for (const auto& booking : bookings) {
-        if (booking.getCarId() == carId) {
-            results.push_back(booking);
-        }
+    results.reserve(ids.size());
+    for (int id : ids) {
+        results.push_back(store[id]);
     }
     return results;
 }
 
 bool BookingService::updateBooking(const Booking& booking) {
-    std::vector<Booking> bookings = loadBookings();
-    for (auto& b : bookings) {
-        if (b.getBookingId() == booking.getBookingId()) {
-            b = booking;
-            return saveBookings(bookings);
+    return updateBookings(std::vector<Booking>(1, booking));
+}
+
+bool BookingService::updateBookings(const std::vector<Booking>& bookings) {
+    lastError.clear();
+    if (bookings.empty()) {
+        return true;
+    }
+    
+    refreshStore();
+    for (const auto& booking : bookings) {
+        ensureBookingLoaded(booking.getBookingId());
+    }
+    std::set<int> batchIds;
+    for (const auto& booking : bookings) {
+        batchIds.insert(booking.getBookingId());
+    }
+    
+    // The same checks as for new bookings. Only a booking that takes a new
+    // slot (another car or dates, or set back to Active) is checked against
+    // the stored calendars, which skip the batch's own bookings; their new
+    // slots are checked against each other below.
+    for (const auto& booking : bookings) {
+        std::string label = "Booking " + std::to_string(booking.getBookingId()) + ": ";
+        auto it = store.find(booking.getBookingId());
+        if (it == store.end()) {
+            lastError = "Booking " + std::to_string(booking.getBookingId()) + " not found.";
+            return false;
+        }
+        if (!booking.isValid()) {
+            lastError = label + booking.getValidationErrors();
+            return false;
+        }
+        std::string error;
+        if (!checkReferences(booking, &it->second, error)) {
+            lastError = label + error;
+            return false;
+        }
+        const Booking& stored = it->second;
+        bool newSlot = !stored.occupiesCar() || booking.getCarId() != stored.getCarId() ||
+                       booking.getStartDate() != stored.getStartDate() || booking.getEndDate() != stored.getEndDate();
+        if (booking.occupiesCar() && newSlot &&
+            !isCarAvailable(booking.getCarId(), Booking::dateToDays(booking.getStartDate()),
+                            Booking::dateToDays(booking.getEndDate()), batchIds)) {
+            lastError = label + "Car " + std::to_string(booking.getCarId()) + " is already booked for these dates.";
+            return false;
         }
     }
-    return false;
+    if (!checkBatchOverlaps(bookings, true, lastError)) {
+        return false;
+    }
+    
+    std::vector<Booking> previous;
+    std::vector<int> bookingIds;
+    previous.reserve(bookings.size());
+    for (const auto& booking : bookings) {
+        Booking& stored = store[booking.getBookingId()];
+        previous.push_back(stored);
+        bookingIds.push_back(booking.getBookingId());
+        changeRecorder.record(&stored, &booking);
+        indexRemove(stored);
+        rollup.apply(stored, -1);
+        stored = booking;
+        indexAdd(stored);
+        rollup.apply(booking, +1);
+    }
+    
+    if (!persistRows(bookingIds)) {
+        changeRecorder.discard();
+        for (size_t i = bookings.size(); i-- > 0;) {
+            Booking& stored = store[bookings[i].getBookingId()];
+            indexRemove(stored);
+            rollup.apply(stored, -1);
+            stored = previous[i];
+            indexAdd(stored);
+            rollup.apply(stored, +1);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    
+    if (changeListener) {
+        for (const auto& booking : bookings) {
+            changeListener(booking);
+        }
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 bool BookingService::deleteBooking(int bookingId) {
-    std::vector<Booking> bookings = loadBookings();
-    auto it = std::remove_if(bookings.begin(), bookings.end(),
-        [bookingId](const Booking& booking) { return booking.getBookingId() == bookingId; });
+    lastError.clear();
+    refreshStore();
+    ensureBookingLoaded(bookingId);
+    if (store.find(bookingId) == store.end()) {
+        lastError = "Booking " + std::to_string(bookingId) + " not found.";
+        return false;
+    }
+    return deleteBookings({bookingId});
+}
+
+bool BookingService::deleteBookings(const std::vector<int>& bookingIds) {
+    lastError.clear();
+    refreshStore();
     
-    if (it != bookings.end()) {
-        bookings.erase(it, bookings.end());
-        return saveBookings(bookings);
+    std::vector<Booking> removed;
+    for (int bookingId : bookingIds) {
+        ensureBookingLoaded(bookingId);
+        auto it = store.find(bookingId);
+        if (it == store.end()) continue;
+        changeRecorder.record(&it->second, nullptr);
+        indexRemove(it->second);
+        rollup.apply(it->second, -1);
+        removed.push_back(it->second);
+        store.erase(it);
     }
-    return false;
+    if (removed.empty()) {
+        return true;
+    }
+    
+    if (!persistRows(bookingIds)) {
+        changeRecorder.discard();
+        for (const auto& booking : removed) {
+            indexAdd(store[booking.getBookingId()] = booking);
+            rollup.apply(booking, +1);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
-bool BookingService::saveBookings(const std::vector<Booking>& bookings) {
-    std::ofstream file(dataFile);
-    if (!file.is_open()) return false;
+void BookingService::attachReferences(CarService* carService, CustomerService* customerService) {
+    this->carService = carService;
+    this->customerService = customerService;
+}
+
+// Archived bookings count too, so history still protects a car or customer from deletion
+size_t BookingService::countBookingsForCar(int carId) {
+    ensureReferences(CAR_COLUMN, carId);
+    auto found = carBookings.find(carId);
+    return (found == carBookings.end() ? 0 : found->second.size()) + archive.countForCar(carId);
+}
+
+size_t BookingService::countBookingsForCustomer(int customerId) {
+    ensureReferences(CUSTOMER_COLUMN, customerId);
+    auto found = customerBookings.find(customerId);
+    return (found == customerBookings.end() ? 0 : found->second.size()) + archive.countForCustomer(customerId);
+}
+
+std::vector<int> BookingService::getBookingIdsForCar(int carId) {
+    ensureReferences(CAR_COLUMN, carId);
+    auto found = carBookings.find(carId);
+    return found == carBookings.end() ? std::vector<int>() : found->second;
+}
+
+std::vector<int> BookingService::getBookingIdsForCustomer(int customerId) {
+    ensureReferences(CUSTOMER_COLUMN, customerId);
+    auto found = customerBookings.find(customerId);
+    return found == customerBookings.end() ? std::vector<int>() : found->second;
+}
+
+// previous is the stored version when updating; references that did not change
+// are not rechecked so existing history stays editable
+bool BookingService::checkReferences(const Booking& booking, const Booking* previous, std::string& error) {
+    if (carService && (!previous || previous->getCarId() != booking.getCarId())) {
+        Car car = carService->getCarById(booking.getCarId());
+        if (car.getCarId() == 0) {
+            error = "Car " + std::to_string(booking.getCarId()) + " does not exist.";
+            return false;
+        }
+        if (car.getStatus() == CarStatus::RETIRED) {
+            error = "Car " + std::to_string(booking.getCarId()) + " is retired.";
+            return false;
+        }
+    }
+    if (customerService && (!previous || previous->getCustomerId() != booking.getCustomerId())) {
+        Customer customer = customerService->getCustomerById(booking.getCustomerId());
+        if (customer.getCustomerId() == 0) {
+            error = "Customer " + std::to_string(booking.getCustomerId()) + " does not exist.";
+            return false;
+        }
+        if (!customer.isActive()) {
+            error = "Customer " + std::to_string(booking.getCustomerId()) + " is inactive.";
+            return false;
+        }
+    }
+    return true;
+}
+
+void BookingService::forEachBooking(const std::function<bool(const Booking&)>& predicate,
+                                    const std::function<void(const Booking&)>& callback) {
+    ensureAllPartitions();
+    for (const auto& entry : store) {
+        if (!predicate || predicate(entry.second)) {
+            callback(entry.second);
+        }
+    }
+}
+
+void BookingService::forEachBookingInRange(int fromDay, int toDay,
+                                           const std::function<void(const Booking&)>& callback) {
+    refreshStore();
+    if (partitioned) {
+        loadPartitions([fromDay, toDay](const PartitionInfo& partition) {
+            return partition.firstDay < toDay && partition.lastDay > fromDay;
+        });
+    }
+    for (const auto& entry : store) {
+        const Booking& booking = entry.second;
+        if (Booking::dateToDays(booking.getStartDate()) < toDay && Booking::dateToDays(booking.getEndDate()) > fromDay) {
+            callback(booking);
+        }
+    }
+}
+
+void BookingService::forEachOpenBooking(const std::function<void(const Booking&)>& callback) {
+    refreshStore();
+    for (const auto& entry : store) {
+        if (entry.second.occupiesCar()) {
+            callback(entry.second);
+        }
+    }
+}
+
+const FileStamp& BookingService::getStoreStamp() {
+    refreshStore();
+    return storeStamp;
+}
+
+size_t BookingService::getLoadGeneration() {
+    refreshStore();
+    return loadGeneration;
+}
+
+void BookingService::setChangeListener(const std::function<void(const Booking&)>& listener) {
+    changeListener = listener;
+}
+
+size_t BookingService::getBookingCount() {
+    ensureAllPartitions();
+    return store.size();
+}
+
+std::vector<Booking> BookingService::getBookingsPage(BookingSortKey sortKey, size_t offset, size_t limit) {
+    const std::vector<const Booking*>& ordered = getSortIndex(sortKey);
+    std::vector<Booking> page;
+    for (size_t i = offset; i < ordered.size() && i < offset + limit; i++) {
+        page.push_back(*ordered[i]);
+    }
+    return page;
+}
+
+long BookingService::findBookingPosition(int bookingId, BookingSortKey sortKey) {
+    refreshStore();
+    auto it = store.find(bookingId);
+    if (it == store.end()) {
+        return -1;
+    }
+    
+    getSortIndex(sortKey);
+    return static_cast<long>(sortIndex.position(sortKey, store, it->second));
+}
+
+bool BookingService::isCarAvailable(int carId, const std::string& startDate, const std::string& endDate,
+                                    int ignoreBookingId) {
+    return isCarAvailable(carId, Booking::dateToDays(startDate), Booking::dateToDays(endDate), ignoreBookingId);
+}
+
+bool BookingService::isCarAvailable(int carId, int startDay, int endDay, int ignoreBookingId) {
+    ensureCalendars();
+    auto found = calendars.find(carId);
+    if (found == calendars.end()) {
+        return true;
+    }
+    
+    const CarCalendar& calendar = found->second;
+    if (ignoreBookingId != 0) {
+        for (const auto& entry : calendar.entries) {
+            if (entry.startDay >= endDay) break;
+            if (entry.bookingId != ignoreBookingId && entry.endDay > startDay) return false;
+        }
+        return true;
+    }
+    
+    // Last entry starting before endDay; any overlap shows up in its running maximum end
+    auto after = std::lower_bound(calendar.entries.begin(), calendar.entries.end(), endDay,
+        [](const CalendarEntry& entry, int day) { return entry.startDay < day; });
+    if (after == calendar.entries.begin()) {
+        return true;
+    }
+    size_t last = static_cast<size_t>(after - calendar.entries.begin()) - 1;
+    return calendar.maxEnd[last] <= startDay;
+}
+
+// As above, skipping every booking in ignoreBookingIds
+bool BookingService::isCarAvailable(int carId, int startDay, int endDay, const std::set<int>& ignoreBookingIds) {
+    ensureCalendars();
+    auto found = calendars.find(carId);
+    if (found == calendars.end()) {
+        return true;
+    }
+    for (const auto& entry : found->second.entries) {
+        if (entry.startDay >= endDay) break;
+        if (entry.endDay > startDay && !ignoreBookingIds.count(entry.bookingId)) return false;
+    }
+    return true;
+}
+
+// Conflicts inside a batch: sorts the bookings that hold a car by car and
+// start date, then compares neighbours. Bookings are named by ID or by their
+// position in the batch.
+bool BookingService::checkBatchOverlaps(const std::vector<Booking>& bookings, bool byId, std::string& error) {
+    std::vector<std::pair<int, size_t>> order; // (car ID, batch index)
+    for (size_t i = 0; i < bookings.size(); i++) {
+        if (bookings[i].occupiesCar()) order.push_back({bookings[i].getCarId(), i});
+    }
+    std::sort(order.begin(), order.end(), [&bookings](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) {
+        if (a.first != b.first) return a.first < b.first;
+        return bookings[a.second].getStartDate() < bookings[b.second].getStartDate();
+    });
+    for (size_t i = 1; i < order.size(); i++) {
+        const Booking& previous = bookings[order[i - 1].second];
+        const Booking& current = bookings[order[i].second];
+        if (order[i - 1].first == order[i].first && current.getStartDate() < previous.getEndDate()) {
+            int first = byId ? previous.getBookingId() : static_cast<int>(order[i - 1].second + 1);
+            int second = byId ? current.getBookingId() : static_cast<int>(order[i].second + 1);
+            error = "Bookings " + std::to_string(first) + " and " + std::to_string(second) + " overlap on car " +
+                    std::to_string(order[i].first) + ".";
+            return false;
+        }
+    }
+    return true;
+}
+
+const RevenueRollup& BookingService::getRevenueRollup() {
+    refreshStore();
+    return rollup;
+}
+
+bool BookingService::archiveClosedBookings(int beforeDay, size_t& archivedCount) {
+    lastError.clear();
+    archivedCount = 0;
+    ensureAllPartitions();
+    
+    std::vector<Booking> closed;
+    std::vector<int> bookingIds;
+    for (const auto& entry : store) {
+        const Booking& booking = entry.second;
+        if ((booking.isCompleted() || booking.isCancelled()) && Booking::dateToDays(booking.getEndDate()) < beforeDay) {
+            closed.push_back(booking);
+            bookingIds.push_back(entry.first);
+        }
+    }
+    if (closed.empty()) {
+        return true;
+    }
+    
+    // Segments are written before the data file: if that write fails the
+    // bookings are briefly in both places, and the store's copy wins
+    if (!archive.add(closed)) {
+        lastError = archive.getLastError();
+        return false;
+    }
+    for (int bookingId : bookingIds) {
+        auto it = store.find(bookingId);
+        indexRemove(it->second);
+        store.erase(it);
+    }
+    
+    if (!persistRows(bookingIds)) {
+        for (const auto& booking : closed) {
+            indexAdd(store[booking.getBookingId()] = booking);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    archivedCount = closed.size();
+    return true;
+}
+
+bool BookingService::restoreBookings(const std::vector<Booking>& bookings, const std::vector<Booking>& archived) {
+    lastError.clear();
+    refreshStore();
     
-    file << "ID,CustomerID,CarID,StartDate,EndDate,TotalCost,Status,Notes\n";
+    if (!archived.empty()) {
+        if (!archive.add(archived)) {
+            lastError = archive.getLastError();
+            return false;
+        }
+        for (const auto& booking : archived) {
+            if (store.find(booking.getBookingId()) == store.end()) {
+                rollup.apply(booking, +1);
+                changeRecorder.record(nullptr, &booking);
+            }
+        }
+        changeRecorder.publish(lastError); // The archive has already been rewritten
+    }
+    
+    std::vector<int> bookingIds;
     for (const auto& booking : bookings) {
-        file << bookingToCsvLine(booking) << "\n";
+        ensureBookingLoaded(booking.getBookingId());
+        if (store.count(booking.getBookingId())) continue;
+        indexAdd(store[booking.getBookingId()] = booking);
+        rollup.apply(booking, +1);
+        changeRecorder.record(nullptr, &booking);
+        bookingIds.push_back(booking.getBookingId());
     }
-    file.close();
+    if (bookingIds.empty()) {
+        if (archived.empty()) return true;
+        if (partitioned) {
+            rollup.save(rollupFile, storeStamp);
+            return true;
+        }
+        if (!persistStore()) { // The rollup is saved with the data file it describes
+            lastError = "Failed to write " + dataFile + ".";
+            return false;
+        }
+        return true;
+    }
+    if (!persistRows(bookingIds)) {
+        changeRecorder.discard();
+        for (int bookingId : bookingIds) {
+            auto it = store.find(bookingId);
+            rollup.apply(it->second, -1);
+            indexRemove(it->second);
+            store.erase(it);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
+}
+
+bool BookingService::forEachArchivedBooking(const ArchiveFilter& filter,
+                                            const std::function<void(const Booking&)>& callback) {
+    lastError.clear();
+    refreshStore();
+    bool ok = archive.scan(filter, [this, &callback](const Booking& booking) {
+        if (store.find(booking.getBookingId()) == store.end()) {
+            callback(booking);
+        }
+    });
+    if (!ok) {
+        lastError = archive.getLastError();
+    }
+    return ok;
+}
+
+bool BookingService::deleteArchivedBookings(const ArchiveFilter& filter) {
+    lastError.clear();
+    refreshStore();
+    
+    std::vector<Booking> removed;
+    if (!archive.removeIf(filter, nullptr, removed)) {
+        lastError = archive.getLastError();
+        return false;
+    }
+    if (removed.empty()) {
+        return true;
+    }
+    for (const auto& booking : removed) {
+        if (store.find(booking.getBookingId()) == store.end()) {
+            rollup.apply(booking, -1);
+            changeRecorder.record(&booking, nullptr);
+        }
+    }
+    changeRecorder.publish(lastError); // The archive has already been rewritten
+    if (partitioned) {
+        // No booking in the partitions changed, so the rollup is saved against the current catalog
+        rollup.save(rollupFile, storeStamp);
+        return true;
+    }
+    // The rollup is saved with the data file it describes
+    if (!persistStore()) {
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    return true;
+}
+
+const std::vector<ArchiveSegment>& BookingService::getArchiveSegments() {
+    return archive.getSegments();
+}
+
+std::vector<std::string> BookingService::getArchiveFiles() {
+    return archive.getFiles();
+}
+
+unsigned long BookingService::getArchiveVersion() {
+    return archive.getVersion();
+}
+
+bool BookingService::saveBookings(const std::vector<Booking>& bookings) {
+    lastError.clear();
+    if (partitioned) {
+        ensureAllPartitions(); // Partitions not in the new set are dropped, so all must be known
+    } else if (changeRecorder.isEnabled()) {
+        refreshStore();
+    }
+    changeRecorder.recordReplacement(store, bookings);
+    store.clear();
+    for (const auto& booking : bookings) {
+        store[booking.getBookingId()] = booking;
+    }
+    storeChanged();
+    calendarsValid = false;
+    referencesValid = false;
+    rebuildRollup();
+    updateNextId();
+    if (!persistStore()) {
+        changeRecorder.discard();
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
     return true;
 }
 
 std::vector<Booking> BookingService::loadBookings() {
+    ensureAllPartitions();
     std::vector<Booking> bookings;
-    std::ifstream file(dataFile);
-    if (!file.is_open()) return bookings;
-    
-    std::string line;
-    bool firstLine = true;
-    while (std::getline(file, line)) {
-        if (firstLine) { firstLine = false; continue; }
-        if (!line.empty()) {
-            Booking booking = parseBookingFromLine(line);
-            if (booking.getBookingId() > 0) {
-                bookings.push_back(booking);
-            }
-        }
+    bookings.reserve(store.size());
+    for (const auto& entry : store) {
+        bookings.push_back(entry.second);
     }
-    file.close();
-    updateNextId(bookings);
     return bookings;
 }
 
 int BookingService::getNextId() { return nextId; }
 
+const std::string& BookingService::getDataFile() const { return dataFile; }
+
+const std::string& BookingService::getLastError() const { return lastError; }
+
+void BookingService::setStorageMode(StorageMode mode) {
+    flushWrites();
+    slotFile.setMode(mode);
+    storeStamp = FileStamp(); // Reload so the slot layout is read
+}
+
+bool BookingService::enablePartitions() {
+    lastError.clear();
+    if (partitioned) {
+        return true;
+    }
+    flushWrites();
+    refreshStore();
+    
+    partitioned = true;
+    partitions.reset();
+    if (!persistStore()) {
+        partitioned = false;
+        storeStamp = FileStamp();
+        lastError = "Failed to write the booking partitions.";
+        return false;
+    }
+    // The old data file is kept, renamed so it is not mistaken for current data
+    FileManager fileManager;
+    fileManager.replaceFile(dataFile, dataFile + ".migrated");
+    return true;
+}
+
+bool BookingService::isPartitioned() const {
+    return partitioned;
+}
+
+size_t BookingService::getPartitionCount() const {
+    return partitions.getPartitions().size();
+}
+
+std::vector<std::string> BookingService::getStorageFiles() const {
+    if (partitioned) {
+        return partitions.getFiles();
+    }
+    return {dataFile};
+}
+
+void BookingService::setPersistenceQueue(PersistenceQueue* queue) {
+    flushWrites();
+    writeQueue = queue;
+}
+
+void BookingService::setChangeLog(ChangeLog* log) {
+    changeRecorder.setLog(log);
+}
+
+bool BookingService::applyChanges(const std::vector<ChangeEvent>& changes) {
+    lastError.clear();
+    refreshStore();
+    std::vector<int> bookingIds;
+    for (const auto& change : changes) {
+        if (change.entity != ChangeEntity::BOOKING) continue;
+        ensureBookingLoaded(change.entityId);
+        auto it = store.find(change.entityId);
+        if (it != store.end()) {
+            indexRemove(it->second);
+            rollup.apply(it->second, -1);
+        }
+        if (change.type == ChangeType::DELETED) {
+            if (it != store.end()) store.erase(it);
+        } else {
+            Booking booking = parseBookingFromLine(change.after);
+            indexAdd(store[change.entityId] = booking);
+            rollup.apply(booking, +1);
+        }
+        bookingIds.push_back(change.entityId);
+    }
+    if (bookingIds.empty()) {
+        return true;
+    }
+    std::sort(bookingIds.begin(), bookingIds.end());
+    bookingIds.erase(std::unique(bookingIds.begin(), bookingIds.end()), bookingIds.end());
+    updateNextId();
+    if (!persistRows(bookingIds)) {
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    return true;
+}
+
+void BookingService::flushWrites() {
+    if (writeQueue) {
+        writeQueue->flush();
+    }
+}
+
 Booking BookingService::parseBookingFromLine(const std::string& line) {
     Booking booking;
-    std::stringstream ss(line);
-    std::string field;
     std::vector<std::string> fields;
-    
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
-    }
+    CsvUtils::splitLine(line, fields);
     
     if (fields.size() >= 7) {
         try {
@@ -152,12 +817,455 @@ std::string BookingService::bookingToCsvLine(const Booking& booking) {
     return ss.str();
 }
 
-void BookingService::updateNextId(const std::vector<Booking>& bookings) {
-    int maxId = 0;
-    for (const auto& booking : bookings) {
-        if (booking.getBookingId() > maxId) {
-            maxId = booking.getBookingId();
+void BookingService::refreshStore() {
+    if (partitioned) {
+        refreshPartitions();
+        return;
+    }
+    if (writes->isBusy()) {
+        return;
+    }
+    FileStamp written;
+    if (writes->takeStamp(written)) {
+        storeStamp = written;
+    }
+    if (slotFile.poll()) {
+        // Compacted in the background: same rows, new file stamp
+        storeStamp = slotFile.getStamp();
+        rollup.save(rollupFile, storeStamp);
+    }
+    FileStamp stamp = FileManager::getFileStamp(dataFile);
+    if (stamp == storeStamp) {
+        return;
+    }
+    
+    store.clear();
+    slotFile.load([this](const std::string& line) {
+        Booking booking = parseBookingFromLine(line);
+        if (booking.getBookingId() > 0) {
+            store[booking.getBookingId()] = booking;
+        }
+    });
+    
+    storeStamp = stamp;
+    loadGeneration++;
+    storeChanged();
+    calendarsValid = false;
+    referencesValid = false;
+    updateNextId();
+    
+    if (!rollup.load(rollupFile, stamp)) {
+        rebuildRollup();
+        rollup.save(rollupFile, stamp);
+    }
+}
+
+// Writes a complete new file and renames it over the old one, so a failed
+// write never leaves a partially written data file behind
+bool BookingService::persistStore() {
+    const char* header = BOOKING_HEADER;
+    if (partitioned) {
+        loadPartitions(nullptr);
+        partitionRows.clear();
+        std::set<std::string> keys;
+        for (const auto& entry : store) {
+            std::string key = partitionKey(entry.second);
+            partitionRows[key].insert(entry.first);
+            keys.insert(key);
+        }
+        for (const auto& partition : partitions.getPartitions()) {
+            keys.insert(partition.key); // Emptied partitions are dropped
+        }
+        return writePartitions(keys);
+    }
+    if (slotFile.getMode() == StorageMode::SLOTTED) {
+        std::vector<std::pair<int, std::string>> rows;
+        rows.reserve(store.size());
+        for (const auto& entry : store) {
+            rows.emplace_back(entry.first, bookingToCsvLine(entry.second));
+        }
+        if (!slotFile.rewrite(header, rows)) return false;
+        storeStamp = slotFile.getStamp();
+        rollup.save(rollupFile, storeStamp);
+        return true;
+    }
+    
+    if (writeQueue) {
+        auto rows = std::make_shared<std::vector<Booking>>();
+        rows->reserve(store.size());
+        for (const auto& entry : store) {
+            rows->push_back(entry.second);
+        }
+        auto render = [rows, header]() {
+            std::string contents = header;
+            contents += '\n';
+            for (const auto& booking : *rows) {
+                contents += bookingToCsvLine(booking);
+                contents += '\n';
+            }
+            return contents;
+        };
+        WriteTracker::markQueued(storeStamp);
+        // The rollup is saved against the stamp of the file it describes
+        auto snapshot = std::make_shared<RevenueRollup>(rollup);
+        std::string path = rollupFile;
+        return writeQueue->submit(dataFile, render, writes,
+                                  [snapshot, path](const FileStamp& stamp) { snapshot->save(path, stamp); });
+    }
+    
+    std::string tempFile = dataFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+    
+    file << header << "\n";
+    for (const auto& entry : store) {
+        file << bookingToCsvLine(entry.second) << "\n";
+    }
+    file.close();
+    
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, dataFile)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    
+    FileManager::markFileWritten(dataFile);
+    storeStamp = FileManager::getFileStamp(dataFile);
+    rollup.save(rollupFile, storeStamp);
+    return true;
+}
+
+// Writes back only the given bookings (changed or deleted) when slots are in use
+bool BookingService::persistRows(const std::vector<int>& bookingIds) {
+    if (partitioned) {
+        return persistPartitions(bookingIds);
+    }
+    if (slotFile.getMode() != StorageMode::SLOTTED) {
+        return persistStore();
+    }
+    for (int bookingId : bookingIds) {
+        auto it = store.find(bookingId);
+        if (it != store.end()) {
+            slotFile.put(bookingId, bookingToCsvLine(it->second));
+        } else {
+            slotFile.remove(bookingId);
+        }
+    }
+    if (!slotFile.commit()) {
+        return persistStore();
+    }
+    storeStamp = slotFile.getStamp();
+    rollup.save(rollupFile, storeStamp);
+    return true;
+}
+
+void BookingService::storeChanged() {
+    sortIndex.clear();
+}
+
+void BookingService::refreshPartitions() {
+    FileStamp stamp = partitions.getCatalogStamp();
+    if (stamp == storeStamp) {
+        return;
+    }
+    
+    store.clear();
+    partitionRows.clear();
+    partitions.reset();
+    
+    int today = Booking::today();
+    loadPartitions([today](const PartitionInfo& partition) {
+        return partition.openRows > 0 || partition.lastDay >= today;
+    });
+    
+    storeStamp = stamp;
+    loadGeneration++;
+    storeChanged();
+    calendarsValid = false;
+    referencesValid = false;
+    updateNextId();
+    
+    if (!rollup.load(rollupFile, stamp)) {
+        rebuildRollup();
+        rollup.save(rollupFile, stamp);
+    }
+}
+
+// Rewrites the partitions that held or now hold the given bookings
+bool BookingService::persistPartitions(const std::vector<int>& bookingIds) {
+    std::set<std::string> keys;
+    for (int bookingId : bookingIds) {
+        auto it = store.find(bookingId);
+        std::string key = it != store.end() ? partitionKey(it->second) : std::string();
+        if (!key.empty()) {
+            keys.insert(key);
+        }
+        // Where the booking was before: usually the same partition
+        auto same = partitionRows.find(key);
+        if (same == partitionRows.end() || same->second.erase(bookingId) == 0) {
+            for (auto& rows : partitionRows) {
+                if (rows.second.erase(bookingId) > 0) {
+                    keys.insert(rows.first);
+                    break;
+                }
+            }
+        }
+    }
+    // A partition is rewritten whole, so one that was never read has to be read first
+    loadPartitions([&keys](const PartitionInfo& partition) { return keys.count(partition.key) > 0; });
+    for (int bookingId : bookingIds) {
+        auto it = store.find(bookingId);
+        if (it != store.end()) {
+            partitionRows[partitionKey(it->second)].insert(bookingId);
+        }
+    }
+    return writePartitions(keys);
+}
+
+bool BookingService::writePartitions(const std::set<std::string>& keys) {
+    for (const auto& key : keys) {
+        PartitionInfo partition;
+        partition.key = key;
+        partition.file = "bookings-" + key + ".csv";
+        std::string rows;
+        auto found = partitionRows.find(key);
+        if (found != partitionRows.end()) {
+            for (int bookingId : found->second) {
+                const Booking& booking = store[bookingId];
+                int startDay = Booking::dateToDays(booking.getStartDate());
+                int endDay = Booking::dateToDays(booking.getEndDate());
+                if (partition.rows == 0) {
+                    partition.firstDay = startDay;
+                    partition.lastDay = endDay;
+                    partition.minId = bookingId;
+                }
+                partition.rows++;
+                partition.openRows += booking.occupiesCar() ? 1 : 0;
+                partition.firstDay = std::min(partition.firstDay, startDay);
+                partition.lastDay = std::max(partition.lastDay, endDay);
+                partition.maxId = bookingId;
+                rows += bookingToCsvLine(booking);
+                rows += '\n';
+            }
+            if (found->second.empty()) {
+                partitionRows.erase(found);
+            }
+        }
+        // Either failure discards every partition written so far, so the
+        // catalog's versions are reloaded on next access
+        if (!partitions.writePartition(partition, rows)) {
+            storeStamp = FileStamp();
+            return false;
+        }
+    }
+    if (!partitions.commit()) {
+        storeStamp = FileStamp();
+        return false;
+    }
+    storeStamp = partitions.getStamp();
+    rollup.save(rollupFile, storeStamp);
+    return true;
+}
+
+// Reads the partitions the filter accepts; rows already in memory are newer and are kept
+size_t BookingService::loadPartitions(const std::function<bool(const PartitionInfo&)>& filter) {
+    size_t read = partitions.load(filter, [this](const std::string& line) {
+        Booking booking = parseBookingFromLine(line);
+        int bookingId = booking.getBookingId();
+        if (bookingId <= 0 || store.count(bookingId)) {
+            return;
+        }
+        store[bookingId] = booking;
+        partitionRows[partitionKey(booking)].insert(bookingId);
+        if (referencesValid) {
+            carBookings[booking.getCarId()].push_back(bookingId);
+            customerBookings[booking.getCustomerId()].push_back(bookingId);
+        }
+    });
+    if (read > 0) {
+        storeChanged();
+        calendarsValid = false;
+    }
+    return read;
+}
+
+void BookingService::ensureAllPartitions() {
+    refreshStore();
+    if (partitioned && !partitions.isFullyLoaded()) {
+        loadPartitions(nullptr);
+    }
+}
+
+void BookingService::ensureBookingLoaded(int bookingId) {
+    if (!partitioned || store.count(bookingId)) {
+        return;
+    }
+    loadPartitions([bookingId](const PartitionInfo& partition) {
+        return partition.minId <= bookingId && bookingId <= partition.maxId;
+    });
+}
+
+std::string BookingService::partitionKey(const Booking& booking) {
+    const std::string& startDate = booking.getStartDate();
+    bool dated = startDate.size() >= 7 && startDate[4] == '-' && std::isdigit(static_cast<unsigned char>(startDate[0]));
+    return dated ? startDate.substr(0, 7) : "undated";
+}
+
+const std::vector<const Booking*>& BookingService::getSortIndex(BookingSortKey sortKey) {
+    ensureAllPartitions();
+    return sortIndex.get(sortKey, store);
+}
+
+// Calendars, reference indexes and sort orders change together on every
+// mutation; booking is the store's copy
+void BookingService::indexAdd(const Booking& booking) {
+    sortIndex.insert(booking);
+    calendarAdd(booking);
+    if (referencesValid) {
+        carBookings[booking.getCarId()].push_back(booking.getBookingId());
+        customerBookings[booking.getCustomerId()].push_back(booking.getBookingId());
+    }
+}
+
+void BookingService::indexRemove(const Booking& booking) {
+    sortIndex.erase(booking);
+    calendarRemove(booking);
+    if (referencesValid) {
+        removeReference(carBookings, booking.getCarId(), booking.getBookingId());
+        removeReference(customerBookings, booking.getCustomerId(), booking.getBookingId());
+    }
+}
+
+void BookingService::removeReference(std::unordered_map<int, std::vector<int>>& index, int key, int bookingId) {
+    auto found = index.find(key);
+    if (found == index.end()) {
+        return;
+    }
+    std::vector<int>& ids = found->second;
+    auto it = std::find(ids.begin(), ids.end(), bookingId);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+    if (ids.empty()) {
+        index.erase(found);
+    }
+}
+
+// The reverse indexes cover the bookings in memory; with partitions, the ones
+// whose summaries may hold the ID are read first
+void BookingService::ensureReferences(size_t column, int id) {
+    refreshStore();
+    if (partitioned) {
+        loadPartitions([this, column, id](const PartitionInfo& partition) {
+            return partitions.mayContain(partition, column, id);
+        });
+    }
+    if (referencesValid) {
+        return;
+    }
+    
+    carBookings.clear();
+    customerBookings.clear();
+    for (const auto& entry : store) {
+        carBookings[entry.second.getCarId()].push_back(entry.first);
+        customerBookings[entry.second.getCustomerId()].push_back(entry.first);
+    }
+    referencesValid = true;
+}
+
+void BookingService::ensureCalendars() {
+    refreshStore();
+    if (calendarsValid) {
+        return;
+    }
+    
+    calendars.clear();
+    for (const auto& entry : store) {
+        const Booking& booking = entry.second;
+        if (booking.occupiesCar()) {
+            calendars[booking.getCarId()].entries.push_back(
+                {Booking::dateToDays(booking.getStartDate()), Booking::dateToDays(booking.getEndDate()),
+                 booking.getBookingId()});
+        }
+    }
+    for (auto& entry : calendars) {
+        CarCalendar& calendar = entry.second;
+        std::sort(calendar.entries.begin(), calendar.entries.end(),
+            [](const CalendarEntry& a, const CalendarEntry& b) { return a.startDay < b.startDay; });
+        recomputeMaxEnd(calendar, 0);
+    }
+    calendarsValid = true;
+}
+
+void BookingService::calendarAdd(const Booking& booking) {
+    if (!calendarsValid || !booking.occupiesCar()) {
+        return;
+    }
+    
+    CalendarEntry added = {Booking::dateToDays(booking.getStartDate()), Booking::dateToDays(booking.getEndDate()),
+                           booking.getBookingId()};
+    CarCalendar& calendar = calendars[booking.getCarId()];
+    auto pos = std::upper_bound(calendar.entries.begin(), calendar.entries.end(), added.startDay,
+        [](int day, const CalendarEntry& entry) { return day < entry.startDay; });
+    size_t index = static_cast<size_t>(pos - calendar.entries.begin());
+    calendar.entries.insert(pos, added);
+    recomputeMaxEnd(calendar, index);
+}
+
+void BookingService::calendarRemove(const Booking& booking) {
+    if (!calendarsValid) {
+        return;
+    }
+    
+    auto found = calendars.find(booking.getCarId());
+    if (found == calendars.end()) {
+        return;
+    }
+    
+    CarCalendar& calendar = found->second;
+    for (size_t i = 0; i < calendar.entries.size(); i++) {
+        if (calendar.entries[i].bookingId == booking.getBookingId()) {
+            calendar.entries.erase(calendar.entries.begin() + i);
+            recomputeMaxEnd(calendar, i);
+            break;
+        }
+    }
+    if (calendar.entries.empty()) {
+        calendars.erase(found);
+    }
+}
+
+void BookingService::recomputeMaxEnd(CarCalendar& calendar, size_t from) {
+    calendar.maxEnd.resize(calendar.entries.size());
+    for (size_t i = from; i < calendar.entries.size(); i++) {
+        int previous = i > 0 ? calendar.maxEnd[i - 1] : calendar.entries[i].endDay;
+        calendar.maxEnd[i] = std::max(previous, calendar.entries[i].endDay);
+    }
+}
+
+// Archived IDs are never reused
+void BookingService::updateNextId() {
+    int maxId = store.empty() ? 0 : store.rbegin()->first;
+    if (partitioned) {
+        for (const auto& partition : partitions.getPartitions()) {
+            maxId = std::max(maxId, partition.maxId);
         }
     }
-    nextId = maxId + 1;
+    nextId = std::max(maxId, archive.getMaxId()) + 1;
+}
+
+void BookingService::rebuildRollup() {
+    if (partitioned) {
+        loadPartitions(nullptr);
+    }
+    rollup.clear();
+    for (const auto& entry : store) {
+        rollup.apply(entry.second, +1);
+    }
+    archive.scan(ArchiveFilter(), [this](const Booking& booking) {
+        if (store.find(booking.getBookingId()) == store.end()) {
+            rollup.apply(booking, +1);
+        }
+    });
 }
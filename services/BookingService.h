@@ -2,35 +2,220 @@
 #define BOOKINGSERVICE_H
 
 #include "../models/Booking.h"
+#include "../database/FileManager.h"
+#include "../database/SlotFile.h"
+#include "../database/PartitionedFile.h"
+#include "../database/PersistenceQueue.h"
+#include "../database/SortIndex.h"
+#include "../database/ChangeRecorder.h"
+#include "RevenueRollup.h"
+#include "BookingArchive.h"
 #include <vector>
 #include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <functional>
+
+class CarService;
+class CustomerService;
+
+enum class BookingSortKey {
+    ID,
+    CUSTOMER,
+    CAR,
+    START_DATE,
+    END_DATE,
+    TOTAL_COST,
+    STATUS
+};
+
+// One booked interval on a car's calendar: [startDay, endDay) in days since 1970-01-01
+struct CalendarEntry {
+    int startDay;
+    int endDay;
+    int bookingId;
+};
 
 class BookingService {
 private:
     std::string dataFile;
     int nextId;
+    std::string lastError;
+    
+    // In-memory copy of the data file, ordered by booking ID
+    std::map<int, Booking> store;
+    FileStamp storeStamp;
+    SlotFile slotFile;
+    // Whole-file writes go through the queue when one is set (CSV mode only)
+    PersistenceQueue* writeQueue;
+    std::shared_ptr<WriteTracker> writes;
+    size_t loadGeneration;
+    SortIndex<Booking, BookingSortKey> sortIndex;
+    
+    // Monthly partitions by start date, used instead of the data file once
+    // enabled. Only partitions with open bookings or future dates are read at
+    // load; the rest are read when something needs them. Partitions are
+    // written synchronously, bypassing the write queue and the slot file.
+    PartitionedFile partitions;
+    bool partitioned;
+    std::map<std::string, std::set<int>> partitionRows;     // Loaded booking IDs by partition key
+    
+    // Per-car booking calendar: entries sorted by start day, plus the running
+    // maximum end day so an overlap check is a single binary search
+    struct CarCalendar {
+        std::vector<CalendarEntry> entries;
+        std::vector<int> maxEnd;
+    };
+    std::unordered_map<int, CarCalendar> calendars;
+    bool calendarsValid;
+    
+    // Reverse indexes: IDs of the bookings in memory that reference each car and customer
+    std::unordered_map<int, std::vector<int>> carBookings;
+    std::unordered_map<int, std::vector<int>> customerBookings;
+    bool referencesValid;
+    
+    // Stores that bookings point into; reference checks are skipped while unset
+    CarService* carService;
+    CustomerService* customerService;
+    
+    // Revenue aggregates, kept in step with every mutation and saved beside the data file
+    std::string rollupFile;
+    RevenueRollup rollup;
+    
+    // Closed bookings moved out of the data file; they still count in the rollup
+    BookingArchive archive;
+    
+    std::function<void(const Booking&)> changeListener;
+    
+    ChangeRecorder<Booking> changeRecorder;
 
 public:
-    BookingService();
+    explicit BookingService(const std::string& dataDirectory = "data");
     
     // CRUD operations
     bool addBooking(const Booking& booking);
+    // All-or-nothing: validates the batch, checks every car's calendar (including
+    // conflicts inside the batch), assigns contiguous IDs and writes the file once.
+    // On success the assigned IDs are written back into bookings.
+    bool addBookings(std::vector<Booking>& bookings);
     std::vector<Booking> getAllBookings();
     Booking getBookingById(int bookingId);
     std::vector<Booking> getBookingsByCustomerId(int customerId);
     std::vector<Booking> getBookingsByCarId(int carId);
     bool updateBooking(const Booking& booking);
+    // All-or-nothing update of existing bookings with a single write. Checked
+    // like addBookings(), so no update can double-book a car.
+    bool updateBookings(const std::vector<Booking>& bookings);
     bool deleteBooking(int bookingId);
+    // Deletes every listed booking with a single write
+    bool deleteBookings(const std::vector<int>& bookingIds);
+    
+    // Streaming queries: rows are visited in ID order without being copied
+    void forEachBooking(const std::function<bool(const Booking&)>& predicate,
+                        const std::function<void(const Booking&)>& callback);
+    // Bookings overlapping [fromDay, toDay); with partitions only the overlapping ones are read
+    void forEachBookingInRange(int fromDay, int toDay, const std::function<void(const Booking&)>& callback);
+    // Bookings that may still hold a car; these are always in memory
+    void forEachOpenBooking(const std::function<void(const Booking&)>& callback);
+    
+    // Paging: only the requested slice of the sort order is copied out
+    size_t getBookingCount();
+    // Changes whenever the store is reloaded or written; lets derived views detect staleness
+    const FileStamp& getStoreStamp();
+    // Counts reloads from disk, i.e. changes made outside this instance
+    size_t getLoadGeneration();
+    
+    // Called with each booking after it has been added or updated and written
+    void setChangeListener(const std::function<void(const Booking&)>& listener);
+    std::vector<Booking> getBookingsPage(BookingSortKey sortKey, size_t offset, size_t limit);
+    long findBookingPosition(int bookingId, BookingSortKey sortKey);
+    
+    // Availability: true when no booking that still holds the car overlaps
+    // [startDate, endDate). ignoreBookingId lets an update skip itself.
+    bool isCarAvailable(int carId, const std::string& startDate, const std::string& endDate,
+                        int ignoreBookingId = 0);
+    bool isCarAvailable(int carId, int startDay, int endDay, int ignoreBookingId = 0);
+    
+    // Referential integrity: once attached, new bookings must name an existing
+    // active customer and a car that is not retired
+    void attachReferences(CarService* carService, CustomerService* customerService);
+    size_t countBookingsForCar(int carId);
+    size_t countBookingsForCustomer(int customerId);
+    std::vector<int> getBookingIdsForCar(int carId);
+    std::vector<int> getBookingIdsForCustomer(int customerId);
+    
+    // Reporting
+    const RevenueRollup& getRevenueRollup();
+    
+    // Cold storage: completed and cancelled bookings that ended before beforeDay
+    // move to the compressed archive and leave the store. Archived bookings are
+    // read-only; where a booking is in both, the store's copy wins.
+    bool archiveClosedBookings(int beforeDay, size_t& archivedCount);
+    bool forEachArchivedBooking(const ArchiveFilter& filter, const std::function<void(const Booking&)>& callback);
+    // Removes archived bookings matching the filter, e.g. when cascading a delete
+    bool deleteArchivedBookings(const ArchiveFilter& filter);
+    // Puts deleted bookings back under their own IDs, the archived ones into
+    // the archive, e.g. when the rest of a cascading delete failed
+    bool restoreBookings(const std::vector<Booking>& bookings, const std::vector<Booking>& archived);
+    const std::vector<ArchiveSegment>& getArchiveSegments();
+    std::vector<std::string> getArchiveFiles();
+    unsigned long getArchiveVersion();
     
     // Utility methods
     bool saveBookings(const std::vector<Booking>& bookings);
     std::vector<Booking> loadBookings();
     int getNextId();
+    const std::string& getDataFile() const;
+    const std::string& getLastError() const;
+    void setStorageMode(StorageMode mode);
+    // Moves the bookings from the data file into monthly partitions. Once a
+    // partition catalog exists it is used on every later start.
+    bool enablePartitions();
+    bool isPartitioned() const;
+    size_t getPartitionCount() const;
+    // Files holding the bookings: the data file, or the partitions and their catalog
+    std::vector<std::string> getStorageFiles() const;
+    void setPersistenceQueue(PersistenceQueue* queue);
+    // Waits until queued writes of the data file have landed
+    void flushWrites();
+    // Every change made through the service is appended here once written.
+    // Archiving is a move between stores and is not published.
+    void setChangeLog(ChangeLog* log);
+    // Applies changes read from another store's change log, e.g. on a replica.
+    // Rows are taken as given, without validation; other entities' changes are skipped.
+    bool applyChanges(const std::vector<ChangeEvent>& changes);
+    
+    // Serialization
+    static Booking parseBookingFromLine(const std::string& line);
+    static std::string bookingToCsvLine(const Booking& booking);
     
 private:
-    Booking parseBookingFromLine(const std::string& line);
-    std::string bookingToCsvLine(const Booking& booking);
-    void updateNextId(const std::vector<Booking>& bookings);
+    void refreshStore();
+    bool persistStore();
+    bool persistRows(const std::vector<int>& bookingIds);
+    void storeChanged();
+    void refreshPartitions();
+    bool persistPartitions(const std::vector<int>& bookingIds);
+    bool writePartitions(const std::set<std::string>& keys);
+    size_t loadPartitions(const std::function<bool(const PartitionInfo&)>& filter);
+    void ensureAllPartitions();
+    void ensureBookingLoaded(int bookingId);
+    static std::string partitionKey(const Booking& booking);
+    const std::vector<const Booking*>& getSortIndex(BookingSortKey sortKey);
+    bool checkReferences(const Booking& booking, const Booking* previous, std::string& error);
+    bool isCarAvailable(int carId, int startDay, int endDay, const std::set<int>& ignoreBookingIds);
+    static bool checkBatchOverlaps(const std::vector<Booking>& bookings, bool byId, std::string& error);
+    void indexAdd(const Booking& booking);
+    void indexRemove(const Booking& booking);
+    static void removeReference(std::unordered_map<int, std::vector<int>>& index, int key, int bookingId);
+    void ensureReferences(size_t column, int id);
+    void ensureCalendars();
+    void calendarAdd(const Booking& booking);
+    void calendarRemove(const Booking& booking);
+    static void recomputeMaxEnd(CarCalendar& calendar, size_t from);
+    void updateNextId();
+    void rebuildRollup();
 };
 
 #endif // BOOKINGSERVICE_H
@@ -0,0 +1,243 @@
+#include "BranchNetwork.h"
+#include "../utils/CsvUtils.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+
+BranchNetwork::BranchNetwork(const std::string& rootDirectory, size_t workerCount)
+    : rootDirectory(rootDirectory), registryFile(rootDirectory + "/branches.csv"), pool(workerCount) {
+}
+
+bool BranchNetwork::load() {
+    lastError.clear();
+    shards.clear();
+    std::ifstream file(registryFile);
+    if (!file.is_open()) {
+        return true; // No branches yet
+    }
+
+    std::string line;
+    std::vector<std::string> fields;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() < 2 || !isValidCode(fields[0]) || findShard(fields[0])) continue;
+        auto shard = std::make_unique<Shard>();
+        shard->info.code = fields[0];
+        shard->info.name = fields[1];
+        shard->info.dataDirectory = branchDirectory(fields[0]);
+        shard->cars = nullptr;
+        shard->customers = nullptr;
+        shard->bookings = nullptr;
+        shards.push_back(std::move(shard));
+    }
+    return true;
+}
+
+bool BranchNetwork::addBranch(const std::string& code, const std::string& name) {
+    lastError.clear();
+    if (!isValidCode(code)) {
+        lastError = "Branch codes may only use letters, digits, '-' and '_'.";
+        return false;
+    }
+    if (findShard(code)) {
+        lastError = "Branch " + code + " already exists.";
+        return false;
+    }
+
+    FileManager rootManager(rootDirectory);
+    FileManager branchManager(branchDirectory(code));
+    if (!rootManager.createDirectory(rootDirectory + "/branches") || !branchManager.initializeDataDirectory()) {
+        lastError = "Failed to create the data directory for branch " + code + ".";
+        return false;
+    }
+
+    auto shard = std::make_unique<Shard>();
+    shard->info.code = code;
+    shard->info.name = name;
+    std::replace(shard->info.name.begin(), shard->info.name.end(), ',', ' ');
+    shard->info.dataDirectory = branchDirectory(code);
+    shard->cars = nullptr;
+    shard->customers = nullptr;
+    shard->bookings = nullptr;
+    shards.push_back(std::move(shard));
+    if (!saveRegistry()) {
+        shards.pop_back();
+        lastError = "Failed to write " + registryFile + ".";
+        return false;
+    }
+    return true;
+}
+
+bool BranchNetwork::hasBranch(const std::string& code) {
+    return findShard(code) != nullptr;
+}
+
+void BranchNetwork::attach(const std::string& code, CarService& cars, CustomerService& customers,
+                           BookingService& bookings) {
+    Shard* shard = findShard(code);
+    if (!shard) {
+        return;
+    }
+    shard->ownedCars.reset();
+    shard->ownedCustomers.reset();
+    shard->ownedBookings.reset();
+    shard->cars = &cars;
+    shard->customers = &customers;
+    shard->bookings = &bookings;
+}
+
+std::vector<BranchInfo> BranchNetwork::getBranches() const {
+    std::vector<BranchInfo> branches;
+    for (const auto& shard : shards) {
+        branches.push_back(shard->info);
+    }
+    return branches;
+}
+
+std::vector<BranchCar> BranchNetwork::searchCars(const std::string& searchTerm) {
+    std::vector<std::vector<Car>> found(shards.size());
+    fanOut([&](size_t index) { found[index] = shards[index]->cars->searchCars(searchTerm); });
+
+    std::vector<BranchCar> results;
+    for (size_t i = 0; i < shards.size(); i++) {
+        for (const auto& car : found[i]) {
+            results.push_back({shards[i]->info.code, car});
+        }
+    }
+    return results;
+}
+
+std::vector<BranchCustomer> BranchNetwork::searchCustomers(const std::string& searchTerm) {
+    std::vector<std::vector<Customer>> found(shards.size());
+    fanOut([&](size_t index) { found[index] = shards[index]->customers->searchCustomers(searchTerm); });
+
+    std::vector<BranchCustomer> results;
+    for (size_t i = 0; i < shards.size(); i++) {
+        for (const auto& customer : found[i]) {
+            results.push_back({shards[i]->info.code, customer});
+        }
+    }
+    return results;
+}
+
+std::vector<BranchCar> BranchNetwork::findAvailableCars(const AvailabilityQuery& query) {
+    // Each branch returns its own cheapest cars, so the first query.limit of each is enough
+    std::vector<std::vector<Car>> found(shards.size());
+    fanOut([&](size_t index) {
+        AvailabilityService availability(*shards[index]->cars, *shards[index]->bookings);
+        found[index] = availability.findAvailableCars(query);
+    });
+
+    std::vector<BranchCar> results;
+    for (size_t i = 0; i < shards.size(); i++) {
+        for (const auto& car : found[i]) {
+            results.push_back({shards[i]->info.code, car});
+        }
+    }
+    std::stable_sort(results.begin(), results.end(), [](const BranchCar& a, const BranchCar& b) {
+        return a.car.getDailyRate() < b.car.getDailyRate();
+    });
+    if (query.limit > 0 && results.size() > query.limit) {
+        results.resize(query.limit);
+    }
+    return results;
+}
+
+std::vector<BranchStats> BranchNetwork::getStats(BranchStats& total) {
+    std::vector<BranchStats> stats(shards.size());
+    fanOut([&](size_t index) {
+        Shard& shard = *shards[index];
+        BranchStats& row = stats[index];
+        row.branch = shard.info.code;
+        row.cars = shard.cars->getCarCount();
+        row.availableCars = static_cast<size_t>(shard.cars->getAvailableCarsCount());
+        row.customers = shard.customers->getCustomerCount();
+        row.bookings = shard.bookings->getBookingCount();
+        shard.bookings->forEachOpenBooking([&row](const Booking&) { row.openBookings++; });
+        row.revenueCents = shard.bookings->getRevenueRollup().getTotal().revenueCents;
+    });
+
+    total = BranchStats();
+    total.branch = "Total";
+    for (const auto& row : stats) {
+        total.cars += row.cars;
+        total.availableCars += row.availableCars;
+        total.customers += row.customers;
+        total.bookings += row.bookings;
+        total.openBookings += row.openBookings;
+        total.revenueCents += row.revenueCents;
+    }
+    return stats;
+}
+
+const std::string& BranchNetwork::getLastError() const {
+    return lastError;
+}
+
+std::string BranchNetwork::branchDirectory(const std::string& code) const {
+    return rootDirectory + "/branches/" + code;
+}
+
+bool BranchNetwork::isValidCode(const std::string& code) {
+    if (code.empty()) {
+        return false;
+    }
+    for (char c : code) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+BranchNetwork::Shard* BranchNetwork::findShard(const std::string& code) {
+    for (auto& shard : shards) {
+        if (shard->info.code == code) {
+            return shard.get();
+        }
+    }
+    return nullptr;
+}
+
+// Shards are opened on first use, on the thread that first queries them
+void BranchNetwork::openShard(Shard& shard) {
+    if (shard.cars) {
+        return;
+    }
+    shard.ownedCars = std::make_unique<CarService>(shard.info.dataDirectory);
+    shard.ownedCustomers = std::make_unique<CustomerService>(shard.info.dataDirectory);
+    shard.ownedBookings = std::make_unique<BookingService>(shard.info.dataDirectory);
+    shard.cars = shard.ownedCars.get();
+    shard.customers = shard.ownedCustomers.get();
+    shard.bookings = shard.ownedBookings.get();
+}
+
+bool BranchNetwork::saveRegistry() {
+    std::string tempFile = registryFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+
+    file << "Code,Name\n";
+    for (const auto& shard : shards) {
+        file << shard->info.code << "," << shard->info.name << "\n";
+    }
+    file.close();
+
+    FileManager fileManager(rootDirectory);
+    if (!file || !fileManager.replaceFile(tempFile, registryFile)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+void BranchNetwork::fanOut(const std::function<void(size_t shard)>& body) {
+    pool.parallelFor(shards.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            openShard(*shards[i]);
+            body(i);
+        }
+    });
+}
@@ -0,0 +1,99 @@
+#ifndef BRANCHNETWORK_H
+#define BRANCHNETWORK_H
+
+#include "CarService.h"
+#include "CustomerService.h"
+#include "BookingService.h"
+#include "AvailabilityService.h"
+#include "../utils/ThreadPool.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BranchInfo {
+    std::string code;
+    std::string name;
+    std::string dataDirectory;
+};
+
+struct BranchCar {
+    std::string branch;
+    Car car;
+};
+
+struct BranchCustomer {
+    std::string branch;
+    Customer customer;
+};
+
+struct BranchStats {
+    std::string branch;
+    size_t cars;
+    size_t availableCars;
+    size_t customers;
+    size_t bookings;
+    size_t openBookings;
+    long long revenueCents;
+
+    BranchStats() : cars(0), availableCars(0), customers(0), bookings(0), openBookings(0), revenueCents(0) {}
+};
+
+// The branches of a rental network, each a shard with its own data directory
+// under data/branches/<code>, listed in data/branches.csv.
+//
+// Every branch gets its own car, customer and booking services, so work on one
+// branch only reads and writes that branch's files. Fleet-wide queries run on
+// every shard at once across the thread pool (one task per shard; a shard's
+// services are only ever used by one thread at a time) and the per-branch
+// results are merged afterwards. The branch the console is working in can be
+// attached so its services are shared rather than opened twice.
+class BranchNetwork {
+private:
+    struct Shard {
+        BranchInfo info;
+        std::unique_ptr<CarService> ownedCars;
+        std::unique_ptr<CustomerService> ownedCustomers;
+        std::unique_ptr<BookingService> ownedBookings;
+        CarService* cars;
+        CustomerService* customers;
+        BookingService* bookings;
+    };
+
+    std::string rootDirectory;
+    std::string registryFile;
+    std::vector<std::unique_ptr<Shard>> shards;
+    ThreadPool pool;
+    std::string lastError;
+
+    Shard* findShard(const std::string& code);
+    void openShard(Shard& shard);
+    bool saveRegistry();
+    // Runs body(shard index) for every shard in parallel
+    void fanOut(const std::function<void(size_t shard)>& body);
+
+public:
+    explicit BranchNetwork(const std::string& rootDirectory = "data", size_t workerCount = 0);
+
+    // Reads the branch list; shards are opened when first used
+    bool load();
+    bool addBranch(const std::string& code, const std::string& name);
+    bool hasBranch(const std::string& code);
+    // Shares the console's services for this branch with the network
+    void attach(const std::string& code, CarService& cars, CustomerService& customers, BookingService& bookings);
+    std::vector<BranchInfo> getBranches() const;
+
+    // Fleet-wide queries
+    std::vector<BranchCar> searchCars(const std::string& searchTerm);
+    std::vector<BranchCustomer> searchCustomers(const std::string& searchTerm);
+    // Free cars in every branch, cheapest first; query.limit applies to the merged list
+    std::vector<BranchCar> findAvailableCars(const AvailabilityQuery& query);
+    // One row per branch, plus the network total
+    std::vector<BranchStats> getStats(BranchStats& total);
+
+    const std::string& getLastError() const;
+
+    std::string branchDirectory(const std::string& code) const;
+    static bool isValidCode(const std::string& code);
+};
+
+#endif // BRANCHNETWORK_H
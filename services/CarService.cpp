@@ -1,24 +1,68 @@
 #include "CarService.h"
+#include "../utils/CsvUtils.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iostream>
+#include <cctype>
+#include <cstdio>
+#include <unordered_map>
 
-CarService::CarService() : dataFile("data/cars.csv"), nextId(1) {
-    loadCars(); // Load existing cars to get the correct next ID
+namespace {
+
+bool carLess(CarSortKey sortKey, const Car& a, const Car& b) {
+    switch (sortKey) {
+        case CarSortKey::MAKE: return a.getMake() < b.getMake();
+        case CarSortKey::MODEL: return a.getModel() < b.getModel();
+        case CarSortKey::YEAR: return a.getYear() < b.getYear();
+        case CarSortKey::STATUS: return a.getStatus() < b.getStatus();
+        case CarSortKey::DAILY_RATE: return a.getDailyRate() < b.getDailyRate();
+        default: return a.getCarId() < b.getCarId();
+    }
+}
+
+// Order of the rate buckets: the fleet-wide daily rate order, ties by ID
+bool rateBefore(const Car* a, const Car* b) {
+    if (a->getDailyRate() != b->getDailyRate()) return a->getDailyRate() < b->getDailyRate();
+    return a->getCarId() < b->getCarId();
+}
+
+} // namespace
+
+CarService::CarService(const std::string& dataDirectory)
+    : dataFile(dataDirectory + "/cars.csv"), nextId(1), slotFile(dataFile), writeQueue(nullptr),
+      writes(std::make_shared<WriteTracker>()),
+      sortIndex(carLess, [](const Car& car) { return car.getCarId(); }),
+      plateIndex([](const Car& car) { return normalizePlate(car.getLicensePlate()); }),
+      changeRecorder(ChangeEntity::CAR, carToCsvLine, [](const Car& car) { return car.getCarId(); }) {
+    refreshStore(); // Load existing cars to get the correct next ID
 }
 
 bool CarService::addCar(const Car& car) {
-    std::vector<Car> cars = loadCars();
+    lastError.clear();
+    refreshStore();
     
     // Set the ID for the new car
     Car newCar = car;
     newCar.setCarId(getNextId());
+    if (!checkPlate(newCar)) {
+        return false;
+    }
     
-    cars.push_back(newCar);
-    nextId++;
+    indexInsert(store[newCar.getCarId()] = newCar);
+    changeRecorder.record(nullptr, &newCar);
     
-    return saveCars(cars);
+    if (!persistRows({newCar.getCarId()})) {
+        changeRecorder.discard();
+        auto it = store.find(newCar.getCarId());
+        indexErase(it->second);
+        store.erase(it);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    nextId++;
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 std::vector<Car> CarService::getAllCars() {
@@ -26,22 +70,22 @@ std::vector<Car> CarService::getAllCars() {
 }
 
 Car CarService::getCarById(int carId) {
-    std::vector<Car> cars = loadCars();
-    for (const auto& car : cars) {
-        if (car.getCarId() == carId) {
-            return car;
-        }
+    refreshStore();
+    auto it = store.find(carId);
+    if (it != store.end()) {
+        return it->second;
     }
     return Car(); // Return empty car if not found
 }
 
 std::vector<Car> CarService::searchCars(const std::string& searchTerm) {
-    std::vector<Car> cars = loadCars();
+    refreshStore();
     std::vector<Car> results;
     std::string lowerSearchTerm = searchTerm;
     std::transform(lowerSearchTerm.begin(), lowerSearchTerm.end(), lowerSearchTerm.begin(), ::tolower);
     
-    for (const auto& car : cars) {
+    for (const auto& entry : store) {
+        const Car& car = entry.second;
         std::string make = car.getMake();
         std::string model = car.getModel();
         std::string color = car.getColor();
@@ -64,90 +108,292 @@ std::vector<Car> CarService::searchCars(const std::string& searchTerm) {
 }
 
 std::vector<Car> CarService::getAvailableCars() {
-    std::vector<Car> cars = loadCars();
     std::vector<Car> availableCars;
+    forEachCar(
+        [](const Car& car) { return car.isAvailable(); },
+        [&availableCars](const Car& car) { availableCars.push_back(car); });
+    return availableCars;
+}
+
+bool CarService::updateCar(const Car& car) {
+    lastError.clear();
+    refreshStore();
     
-    for (const auto& car : cars) {
-        if (car.isAvailable()) {
-            availableCars.push_back(car);
-        }
+    auto it = store.find(car.getCarId());
+    if (it == store.end()) {
+        return false; // Car not found
+    }
+    if (!checkPlate(car)) {
+        return false;
     }
     
-    return availableCars;
+    Car previous = it->second;
+    changeRecorder.record(&previous, &car);
+    indexErase(it->second);
+    it->second = car;
+    indexInsert(it->second);
+    
+    if (!persistRows({car.getCarId()})) {
+        changeRecorder.discard();
+        indexErase(it->second);
+        it->second = previous;
+        indexInsert(it->second);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
-bool CarService::updateCar(const Car& car) {
-    std::vector<Car> cars = loadCars();
+void CarService::setDeleteGuard(const std::function<bool(int carId)>& guard) {
+    deleteGuard = guard;
+}
+
+Car CarService::findCarByPlate(const std::string& licensePlate) {
+    refreshStore();
+    plateIndex.ensure(store);
+    int carId = plateIndex.find(normalizePlate(licensePlate));
+    return carId != 0 ? store[carId] : Car();
+}
+
+bool CarService::isPlateTaken(const std::string& licensePlate, int ignoreCarId) {
+    refreshStore();
+    plateIndex.ensure(store);
+    int carId = plateIndex.find(normalizePlate(licensePlate));
+    return carId != 0 && carId != ignoreCarId;
+}
+
+std::string CarService::normalizePlate(const std::string& licensePlate) {
+    std::string key;
+    key.reserve(licensePlate.size());
+    for (char c : licensePlate) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            key += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+    }
+    return key;
+}
+
+// Keeps the plate index, sort orders and rate buckets in step; car is the store's copy
+void CarService::indexInsert(const Car& car) {
+    plateIndex.insert(car, car.getCarId());
+    sortIndex.insert(car);
+    for (auto& entry : rateIndexes) {
+        if (inRateBucket(car, entry.first.first, entry.first.second)) {
+            std::vector<const Car*>& bucket = entry.second;
+            bucket.insert(std::lower_bound(bucket.begin(), bucket.end(), &car, rateBefore), &car);
+        }
+    }
+}
+
+void CarService::indexErase(const Car& car) {
+    plateIndex.erase(car, car.getCarId());
+    sortIndex.erase(car);
+    for (auto& entry : rateIndexes) {
+        std::vector<const Car*>& bucket = entry.second;
+        auto pos = std::lower_bound(bucket.begin(), bucket.end(), &car, rateBefore);
+        if (pos != bucket.end() && *pos == &car) {
+            bucket.erase(pos);
+        }
+    }
+}
+
+bool CarService::inRateBucket(const Car& car, int fuelType, int transmission) {
+    return (fuelType < 0 || static_cast<int>(car.getFuelType()) == fuelType) &&
+           (transmission < 0 || static_cast<int>(car.getTransmission()) == transmission);
+}
+
+// Sets lastError when another car already has this car's plate
+bool CarService::checkPlate(const Car& car) {
+    plateIndex.ensure(store);
+    if (plateIndex.conflicts(car, car.getCarId())) {
+        lastError = "License plate " + car.getLicensePlate() + " is already used by car " +
+                    std::to_string(plateIndex.find(normalizePlate(car.getLicensePlate()))) + ".";
+        return false;
+    }
+    return true;
+}
+
+bool CarService::updateCars(const std::vector<Car>& cars) {
+    lastError.clear();
+    refreshStore();
     
-    for (auto& c : cars) {
-        if (c.getCarId() == car.getCarId()) {
-            c = car;
-            return saveCars(cars);
+    // Plates are checked against the fleet as it will be after the batch, so
+    // two cars can swap plates but not both take the same one
+    std::map<int, const Car*> updated; // Last version of each car in the batch
+    for (const auto& car : cars) {
+        if (store.find(car.getCarId()) == store.end()) {
+            lastError = "Car " + std::to_string(car.getCarId()) + " not found.";
+            return false;
         }
+        updated[car.getCarId()] = &car;
+    }
+    plateIndex.ensure(store);
+    std::unordered_map<std::string, int> claimed; // Normalized plate to car ID
+    for (const auto& entry : updated) {
+        std::string plate = normalizePlate(entry.second->getLicensePlate());
+        if (plate.empty()) continue;
+        auto claim = claimed.emplace(plate, entry.first);
+        if (!claim.second) {
+            lastError = "License plate " + entry.second->getLicensePlate() + " is given to both car " +
+                        std::to_string(claim.first->second) + " and car " + std::to_string(entry.first) + ".";
+            return false;
+        }
+        int owner = plateIndex.find(plate);
+        if (owner != 0 && owner != entry.first && !updated.count(owner)) {
+            lastError = "License plate " + entry.second->getLicensePlate() + " is already used by car " +
+                        std::to_string(owner) + ".";
+            return false;
+        }
+    }
+    if (cars.empty()) {
+        return true;
+    }
+    
+    std::vector<Car> previous;
+    std::vector<int> carIds;
+    previous.reserve(cars.size());
+    for (const auto& car : cars) {
+        Car& stored = store[car.getCarId()];
+        previous.push_back(stored);
+        changeRecorder.record(&stored, &car);
+        indexErase(stored);
+        stored = car;
+        indexInsert(stored);
+        carIds.push_back(car.getCarId());
     }
     
-    return false; // Car not found
+    if (!persistRows(carIds)) {
+        changeRecorder.discard();
+        // In reverse, so a car listed twice ends up as it was before the first change
+        for (size_t i = cars.size(); i-- > 0;) {
+            Car& stored = store[cars[i].getCarId()];
+            indexErase(stored);
+            stored = previous[i];
+            indexInsert(stored);
+        }
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 bool CarService::deleteCar(int carId) {
-    std::vector<Car> cars = loadCars();
+    lastError.clear();
+    refreshStore();
+    
+    if (deleteGuard && !deleteGuard(carId)) {
+        lastError = "Car " + std::to_string(carId) + " is still referenced by bookings.";
+        return false;
+    }
     
-    auto it = std::remove_if(cars.begin(), cars.end(),
-        [carId](const Car& car) { return car.getCarId() == carId; });
+    auto it = store.find(carId);
+    if (it == store.end()) {
+        lastError = "Car " + std::to_string(carId) + " not found.";
+        return false;
+    }
+    Car removed = it->second;
+    changeRecorder.record(&removed, nullptr);
+    indexErase(it->second);
+    store.erase(it);
     
-    if (it != cars.end()) {
-        cars.erase(it, cars.end());
-        return saveCars(cars);
+    if (!persistRows({carId})) {
+        changeRecorder.discard();
+        indexInsert(store[carId] = removed);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
+}
+
+void CarService::forEachCar(const std::function<bool(const Car&)>& predicate,
+                            const std::function<void(const Car&)>& callback) {
+    refreshStore();
+    for (const auto& entry : store) {
+        if (!predicate || predicate(entry.second)) {
+            callback(entry.second);
+        }
+    }
+}
+
+size_t CarService::getCarCount() {
+    refreshStore();
+    return store.size();
+}
+
+std::vector<Car> CarService::getCarsPage(CarSortKey sortKey, size_t offset, size_t limit) {
+    const std::vector<const Car*>& ordered = getSortIndex(sortKey);
+    std::vector<Car> page;
+    for (size_t i = offset; i < ordered.size() && i < offset + limit; i++) {
+        page.push_back(*ordered[i]);
+    }
+    return page;
+}
+
+long CarService::findCarPosition(int carId, CarSortKey sortKey) {
+    refreshStore();
+    auto it = store.find(carId);
+    if (it == store.end()) {
+        return -1;
     }
     
-    return false; // Car not found
+    return static_cast<long>(sortIndex.position(sortKey, store, it->second));
 }
 
-bool CarService::saveCars(const std::vector<Car>& cars) {
-    std::ofstream file(dataFile);
-    if (!file.is_open()) {
-        return false;
+void CarService::forEachCarByRate(const CarFilter& filter, const std::function<bool(const Car&)>& callback) {
+    refreshStore();
+    int fuelKey = filter.fuelType ? static_cast<int>(*filter.fuelType) : -1;
+    int transmissionKey = filter.transmission ? static_cast<int>(*filter.transmission) : -1;
+    const std::vector<const Car*>& ordered = getRateIndex(fuelKey, transmissionKey);
+    
+    auto end = ordered.end();
+    if (filter.maxDailyRate > 0) {
+        end = std::upper_bound(ordered.begin(), ordered.end(), filter.maxDailyRate,
+            [](double rate, const Car* car) { return rate < car->getDailyRate(); });
     }
     
-    // Write header
-    file << "ID,Make,Model,Year,Color,LicensePlate,DailyRate,Status,Mileage,FuelType,Transmission,Seats\n";
+    for (auto it = ordered.begin(); it != end; ++it) {
+        if ((*it)->getSeats() < filter.minSeats) continue;
+        if (!callback(**it)) break;
+    }
+}
+
+bool CarService::saveCars(const std::vector<Car>& cars) {
+    lastError.clear();
+    refreshStore();
+    changeRecorder.recordReplacement(store, cars);
     
-    // Write data
+    std::map<int, Car> previous;
+    previous.swap(store);
     for (const auto& car : cars) {
-        file << carToCsvLine(car) << "\n";
+        store[car.getCarId()] = car;
     }
+    plateIndex.clear();
+    storeChanged();
+    updateNextId();
     
-    file.close();
+    if (!persistStore()) {
+        changeRecorder.discard();
+        store.swap(previous);
+        plateIndex.clear();
+        storeChanged();
+        updateNextId();
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
     return true;
 }
 
 std::vector<Car> CarService::loadCars() {
+    refreshStore();
     std::vector<Car> cars;
-    std::ifstream file(dataFile);
-    
-    if (!file.is_open()) {
-        return cars; // Return empty vector if file doesn't exist
-    }
-    
-    std::string line;
-    bool firstLine = true;
-    
-    while (std::getline(file, line)) {
-        if (firstLine) {
-            firstLine = false;
-            continue; // Skip header
-        }
-        
-        if (!line.empty()) {
-            Car car = parseCarFromLine(line);
-            if (car.getCarId() > 0) { // Valid car
-                cars.push_back(car);
-            }
-        }
+    cars.reserve(store.size());
+    for (const auto& entry : store) {
+        cars.push_back(entry.second);
     }
-    
-    file.close();
-    updateNextId(cars);
     return cars;
 }
 
@@ -159,57 +405,116 @@ void CarService::setNextId(int id) {
     nextId = id;
 }
 
+const std::string& CarService::getDataFile() const {
+    return dataFile;
+}
+
+const std::string& CarService::getLastError() const {
+    return lastError;
+}
+
+void CarService::setStorageMode(StorageMode mode) {
+    flushWrites();
+    slotFile.setMode(mode);
+    storeStamp = FileStamp(); // Reload so the slot layout is read
+}
+
+void CarService::setPersistenceQueue(PersistenceQueue* queue) {
+    flushWrites();
+    writeQueue = queue;
+}
+
+void CarService::setChangeLog(ChangeLog* log) {
+    changeRecorder.setLog(log);
+}
+
+bool CarService::publishInserts(int firstId, int lastId) {
+    lastError.clear();
+    if (!changeRecorder.isEnabled() || firstId > lastId) {
+        return true;
+    }
+    refreshStore();
+    for (auto it = store.lower_bound(firstId); it != store.end() && it->first <= lastId; ++it) {
+        changeRecorder.record(nullptr, &it->second);
+    }
+    return changeRecorder.publish(lastError);
+}
+
+bool CarService::applyChanges(const std::vector<ChangeEvent>& changes) {
+    lastError.clear();
+    refreshStore();
+    std::vector<int> carIds;
+    for (const auto& change : changes) {
+        if (change.entity != ChangeEntity::CAR) continue;
+        if (change.type == ChangeType::DELETED) {
+            store.erase(change.entityId);
+        } else {
+            store[change.entityId] = parseCarFromLine(change.after);
+        }
+        carIds.push_back(change.entityId);
+    }
+    if (carIds.empty()) {
+        return true;
+    }
+    std::sort(carIds.begin(), carIds.end());
+    carIds.erase(std::unique(carIds.begin(), carIds.end()), carIds.end());
+    plateIndex.clear(); // Replayed history can pass through states the index would refuse
+    storeChanged();
+    updateNextId();
+    if (!persistRows(carIds)) {
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    return true;
+}
+
+void CarService::flushWrites() {
+    if (writeQueue) {
+        writeQueue->flush();
+    }
+}
+
 int CarService::getTotalCars() {
-    return loadCars().size();
+    return static_cast<int>(getCarCount());
 }
 
 int CarService::getAvailableCarsCount() {
-    return getAvailableCars().size();
+    int count = 0;
+    forEachCar([](const Car& car) { return car.isAvailable(); },
+               [&count](const Car&) { count++; });
+    return count;
 }
 
 int CarService::getRentedCarsCount() {
-    std::vector<Car> cars = loadCars();
     int count = 0;
-    for (const auto& car : cars) {
-        if (car.getStatus() == CarStatus::RENTED) {
-            count++;
-        }
-    }
+    forEachCar([](const Car& car) { return car.getStatus() == CarStatus::RENTED; },
+               [&count](const Car&) { count++; });
     return count;
 }
 
 int CarService::getMaintenanceCarsCount() {
-    std::vector<Car> cars = loadCars();
     int count = 0;
-    for (const auto& car : cars) {
-        if (car.getStatus() == CarStatus::MAINTENANCE) {
-            count++;
-        }
-    }
+    forEachCar([](const Car& car) { return car.getStatus() == CarStatus::MAINTENANCE; },
+               [&count](const Car&) { count++; });
     return count;
 }
 
 double CarService::getAverageDailyRate() {
-    std::vector<Car> cars = loadCars();
-    if (cars.empty()) return 0.0;
+    refreshStore();
+    if (store.empty()) return 0.0;
     
     double total = 0.0;
-    for (const auto& car : cars) {
-        total += car.getDailyRate();
+    for (const auto& entry : store) {
+        total += entry.second.getDailyRate();
     }
     
-    return total / cars.size();
+    return total / store.size();
 }
 
 Car CarService::parseCarFromLine(const std::string& line) {
     Car car;
-    std::stringstream ss(line);
-    std::string field;
     std::vector<std::string> fields;
-    
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
-    }
+    CsvUtils::splitLine(line, fields);
     
     if (fields.size() >= 12) {
         try {
@@ -251,12 +556,140 @@ std::string CarService::carToCsvLine(const Car& car) {
     return ss.str();
 }
 
-void CarService::updateNextId(const std::vector<Car>& cars) {
-    int maxId = 0;
-    for (const auto& car : cars) {
-        if (car.getCarId() > maxId) {
-            maxId = car.getCarId();
+void CarService::refreshStore() {
+    if (writes->isBusy()) {
+        return;
+    }
+    FileStamp written;
+    if (writes->takeStamp(written)) {
+        storeStamp = written;
+    }
+    if (slotFile.poll()) {
+        storeStamp = slotFile.getStamp(); // Compacted in the background; same rows
+    }
+    FileStamp stamp = FileManager::getFileStamp(dataFile);
+    if (stamp == storeStamp) {
+        return;
+    }
+    
+    store.clear();
+    plateIndex.clear();
+    slotFile.load([this](const std::string& line) {
+        Car car = parseCarFromLine(line);
+        if (car.getCarId() > 0) { // Valid car
+            store[car.getCarId()] = car;
+        }
+    });
+    
+    storeStamp = stamp;
+    storeChanged();
+    updateNextId();
+}
+
+bool CarService::persistStore() {
+    const char* header = "ID,Make,Model,Year,Color,LicensePlate,DailyRate,Status,Mileage,FuelType,Transmission,Seats";
+    if (slotFile.getMode() == StorageMode::SLOTTED) {
+        std::vector<std::pair<int, std::string>> rows;
+        rows.reserve(store.size());
+        for (const auto& entry : store) {
+            rows.emplace_back(entry.first, carToCsvLine(entry.second));
+        }
+        if (!slotFile.rewrite(header, rows)) {
+            return false;
+        }
+        storeStamp = slotFile.getStamp();
+        return true;
+    }
+    
+    if (writeQueue) {
+        auto rows = std::make_shared<std::vector<Car>>();
+        rows->reserve(store.size());
+        for (const auto& entry : store) {
+            rows->push_back(entry.second);
+        }
+        auto render = [rows, header]() {
+            std::string contents = header;
+            contents += '\n';
+            for (const auto& car : *rows) {
+                contents += carToCsvLine(car);
+                contents += '\n';
+            }
+            return contents;
+        };
+        WriteTracker::markQueued(storeStamp);
+        return writeQueue->submit(dataFile, render, writes);
+    }
+    
+    // A complete new file is renamed over the old one, so a crash mid-write
+    // never leaves a truncated data file behind
+    std::string tempFile = dataFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+    
+    file << header << "\n";
+    for (const auto& entry : store) {
+        file << carToCsvLine(entry.second) << "\n";
+    }
+    file.close();
+    
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, dataFile)) {
+        std::remove(tempFile.c_str());
+        return false;
+    }
+    
+    FileManager::markFileWritten(dataFile);
+    storeStamp = FileManager::getFileStamp(dataFile);
+    return true;
+}
+
+// Writes back only the given cars (changed or deleted) when slots are in use
+bool CarService::persistRows(const std::vector<int>& carIds) {
+    if (slotFile.getMode() != StorageMode::SLOTTED) {
+        return persistStore();
+    }
+    for (int carId : carIds) {
+        auto it = store.find(carId);
+        if (it != store.end()) {
+            slotFile.put(carId, carToCsvLine(it->second));
+        } else {
+            slotFile.remove(carId);
         }
     }
-    nextId = maxId + 1;
+    if (!slotFile.commit()) {
+        return persistStore();
+    }
+    storeStamp = slotFile.getStamp();
+    return true;
+}
+
+void CarService::storeChanged() {
+    sortIndex.clear();
+    rateIndexes.clear();
+}
+
+const std::vector<const Car*>& CarService::getSortIndex(CarSortKey sortKey) {
+    refreshStore();
+    return sortIndex.get(sortKey, store);
+}
+
+const std::vector<const Car*>& CarService::getRateIndex(int fuelType, int transmission) {
+    auto key = std::make_pair(fuelType, transmission);
+    auto it = rateIndexes.find(key);
+    if (it != rateIndexes.end()) {
+        return it->second;
+    }
+    
+    // Filter the fleet-wide rate ordering into the bucket, which keeps it sorted
+    std::vector<const Car*> bucket;
+    for (const Car* car : getSortIndex(CarSortKey::DAILY_RATE)) {
+        if (inRateBucket(*car, fuelType, transmission)) {
+            bucket.push_back(car);
+        }
+    }
+    return rateIndexes.emplace(key, std::move(bucket)).first->second;
+}
+
+void CarService::updateNextId() {
+    nextId = store.empty() ? 1 : store.rbegin()->first + 1;
 }
@@ -2,16 +2,65 @@
 #define CARSERVICE_H
 
 #include "../models/Car.h"
+#include "../database/FileManager.h"
+#include "../database/SlotFile.h"
+#include "../database/PersistenceQueue.h"
+#include "../database/SortIndex.h"
+#include "../database/UniqueIndex.h"
+#include "../database/ChangeRecorder.h"
 #include <vector>
 #include <string>
+#include <map>
+#include <utility>
+#include <optional>
+#include <functional>
+
+enum class CarSortKey {
+    ID,
+    MAKE,
+    MODEL,
+    YEAR,
+    STATUS,
+    DAILY_RATE
+};
+
+// Attribute filter for fleet searches; unset fields match every car
+struct CarFilter {
+    std::optional<FuelType> fuelType;
+    std::optional<Transmission> transmission;
+    int minSeats;
+    double maxDailyRate;    // 0 means no limit
+    
+    CarFilter() : minSeats(0), maxDailyRate(0.0) {}
+};
 
 class CarService {
 private:
     std::string dataFile;
     int nextId;
+    std::string lastError;
+    
+    // In-memory copy of the data file, ordered by car ID
+    std::map<int, Car> store;
+    FileStamp storeStamp;
+    SlotFile slotFile;
+    // Whole-file writes go through the queue when one is set (CSV mode only)
+    PersistenceQueue* writeQueue;
+    std::shared_ptr<WriteTracker> writes;
+    SortIndex<Car, CarSortKey> sortIndex;
+    UniqueIndex<Car> plateIndex;
+    
+    // Cars bucketed by (fuel type, transmission), -1 meaning "any", each bucket
+    // sorted by daily rate; built on first use, then kept in step like the sort orders
+    std::map<std::pair<int, int>, std::vector<const Car*>> rateIndexes;
+    
+    // Consulted before a delete; returning false blocks it
+    std::function<bool(int)> deleteGuard;
+    
+    ChangeRecorder<Car> changeRecorder;
 
 public:
-    CarService();
+    explicit CarService(const std::string& dataDirectory = "data");
     
     // CRUD operations
     bool addCar(const Car& car);
@@ -20,13 +69,49 @@ public:
     std::vector<Car> searchCars(const std::string& searchTerm);
     std::vector<Car> getAvailableCars();
     bool updateCar(const Car& car);
+    // Updates every listed car with a single write; fails without changes if any is missing
+    bool updateCars(const std::vector<Car>& cars);
     bool deleteCar(int carId);
+    void setDeleteGuard(const std::function<bool(int carId)>& guard);
+    
+    // Unique license plates (compared ignoring case and spaces)
+    Car findCarByPlate(const std::string& licensePlate);
+    bool isPlateTaken(const std::string& licensePlate, int ignoreCarId = 0);
+    static std::string normalizePlate(const std::string& licensePlate);
+    
+    // Streaming queries: rows are visited in ID order without being copied
+    void forEachCar(const std::function<bool(const Car&)>& predicate,
+                    const std::function<void(const Car&)>& callback);
+    
+    // Paging: only the requested slice of the sort order is copied out
+    size_t getCarCount();
+    std::vector<Car> getCarsPage(CarSortKey sortKey, size_t offset, size_t limit);
+    long findCarPosition(int carId, CarSortKey sortKey);
+    
+    // Attribute search: visits matching cars in ascending daily rate until the
+    // callback returns false. Only the bucket for the requested fuel type and
+    // transmission is scanned, and the scan stops at maxDailyRate.
+    void forEachCarByRate(const CarFilter& filter, const std::function<bool(const Car&)>& callback);
     
     // Utility methods
     bool saveCars(const std::vector<Car>& cars);
     std::vector<Car> loadCars();
     int getNextId();
     void setNextId(int id);
+    const std::string& getDataFile() const;
+    const std::string& getLastError() const;
+    void setStorageMode(StorageMode mode);
+    void setPersistenceQueue(PersistenceQueue* queue);
+    // Waits until queued writes of the data file have landed
+    void flushWrites();
+    // Every change made through the service is appended here once written
+    void setChangeLog(ChangeLog* log);
+    // Publishes inserts for cars written to the data file by someone else, e.g. an import;
+    // false if the change log refused them (they are retried with the next change)
+    bool publishInserts(int firstId, int lastId);
+    // Applies changes read from another store's change log, e.g. on a replica.
+    // Rows are taken as given, without validation; other entities' changes are skipped.
+    bool applyChanges(const std::vector<ChangeEvent>& changes);
     
     // Statistics
     int getTotalCars();
@@ -35,10 +120,22 @@ public:
     int getMaintenanceCarsCount();
     double getAverageDailyRate();
     
+    // Serialization
+    static Car parseCarFromLine(const std::string& line);
+    static std::string carToCsvLine(const Car& car);
+    
 private:
-    Car parseCarFromLine(const std::string& line);
-    std::string carToCsvLine(const Car& car);
-    void updateNextId(const std::vector<Car>& cars);
+    void refreshStore();
+    bool persistStore();
+    bool persistRows(const std::vector<int>& carIds);
+    void storeChanged();
+    bool checkPlate(const Car& car);
+    void indexInsert(const Car& car);
+    void indexErase(const Car& car);
+    static bool inRateBucket(const Car& car, int fuelType, int transmission);
+    const std::vector<const Car*>& getSortIndex(CarSortKey sortKey);
+    const std::vector<const Car*>& getRateIndex(int fuelType, int transmission);
+    void updateNextId();
 };
 
 #endif // CARSERVICE_H
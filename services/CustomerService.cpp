@@ -1,19 +1,58 @@
 #include "CustomerService.h"
+#include "../utils/CsvUtils.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
+#include <cstdio>
 
-CustomerService::CustomerService() : dataFile("data/customers.csv"), nextId(1) {
-    loadCustomers();
+namespace {
+
+bool customerLess(CustomerSortKey sortKey, const Customer& a, const Customer& b) {
+    switch (sortKey) {
+        case CustomerSortKey::NAME:
+            if (a.getLastName() != b.getLastName()) return a.getLastName() < b.getLastName();
+            return a.getFirstName() < b.getFirstName();
+        case CustomerSortKey::EMAIL: return a.getEmail() < b.getEmail();
+        case CustomerSortKey::LICENSE_EXPIRY: return a.getLicenseExpiry() < b.getLicenseExpiry();
+        default: return a.getCustomerId() < b.getCustomerId();
+    }
+}
+
+} // namespace
+
+CustomerService::CustomerService(const std::string& dataDirectory)
+    : dataFile(dataDirectory + "/customers.csv"), nextId(1), slotFile(dataFile), writeQueue(nullptr),
+      writes(std::make_shared<WriteTracker>()),
+      sortIndex(customerLess, [](const Customer& customer) { return customer.getCustomerId(); }),
+      emailIndex([](const Customer& customer) { return normalizeEmail(customer.getEmail()); }),
+      licenseIndex([](const Customer& customer) { return normalizeLicense(customer.getLicenseNumber()); }),
+      changeRecorder(ChangeEntity::CUSTOMER, customerToCsvLine,
+                     [](const Customer& customer) { return customer.getCustomerId(); }) {
+    refreshStore();
 }
 
 bool CustomerService::addCustomer(const Customer& customer) {
-    std::vector<Customer> customers = loadCustomers();
+    lastError.clear();
+    refreshStore();
     Customer newCustomer = customer;
     newCustomer.setCustomerId(getNextId());
-    customers.push_back(newCustomer);
+    if (!checkUnique(newCustomer)) {
+        return false;
+    }
+    indexInsert(store[newCustomer.getCustomerId()] = newCustomer);
+    changeRecorder.record(nullptr, &newCustomer);
+    if (!persistRows({newCustomer.getCustomerId()})) {
+        changeRecorder.discard();
+        auto it = store.find(newCustomer.getCustomerId());
+        indexErase(it->second);
+        store.erase(it);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
     nextId++;
-    return saveCustomers(customers);
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 std::vector<Customer> CustomerService::getAllCustomers() {
@@ -21,22 +60,22 @@ std::vector<Customer> CustomerService::getAllCustomers() {
 }
 
 Customer CustomerService::getCustomerById(int customerId) {
-    std::vector<Customer> customers = loadCustomers();
-    for (const auto& customer : customers) {
-        if (customer.getCustomerId() == customerId) {
-            return customer;
-        }
+    refreshStore();
+    auto it = store.find(customerId);
+    if (it != store.end()) {
+        return it->second;
     }
     return Customer();
 }
 
 std::vector<Customer> CustomerService::searchCustomers(const std::string& searchTerm) {
-    std::vector<Customer> customers = loadCustomers();
+    refreshStore();
     std::vector<Customer> results;
     std::string lowerSearchTerm = searchTerm;
     std::transform(lowerSearchTerm.begin(), lowerSearchTerm.end(), lowerSearchTerm.begin(), ::tolower);
     
-    for (const auto& customer : customers) {
+    for (const auto& entry : store) {
+        const Customer& customer = entry.second;
         std::string name = customer.getFullName();
         std::string email = customer.getEmail();
         std::transform(name.begin(), name.end(), name.begin(), ::tolower);
@@ -51,72 +90,286 @@ std::vector<Customer> CustomerService::searchCustomers(const std::string& search
 }
 
 bool CustomerService::updateCustomer(const Customer& customer) {
-    std::vector<Customer> customers = loadCustomers();
-    for (auto& c : customers) {
-        if (c.getCustomerId() == customer.getCustomerId()) {
-            c = customer;
-            return saveCustomers(customers);
-        }
+    lastError.clear();
+    refreshStore();
+    auto it = store.find(customer.getCustomerId());
+    if (it == store.end()) {
+        return false;
     }
-    return false;
+    if (!checkUnique(customer)) {
+        return false;
+    }
+    Customer previous = it->second;
+    changeRecorder.record(&previous, &customer);
+    indexErase(it->second);
+    it->second = customer;
+    indexInsert(it->second);
+    if (!persistRows({customer.getCustomerId()})) {
+        changeRecorder.discard();
+        indexErase(it->second);
+        it->second = previous;
+        indexInsert(it->second);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
 bool CustomerService::deleteCustomer(int customerId) {
-    std::vector<Customer> customers = loadCustomers();
-    auto it = std::remove_if(customers.begin(), customers.end(),
-        [customerId](const Customer& customer) { return customer.getCustomerId() == customerId; });
-    
-    if (it != customers.end()) {
-        customers.erase(it, customers.end());
-        return saveCustomers(customers);
+    lastError.clear();
+    refreshStore();
+    if (deleteGuard && !deleteGuard(customerId)) {
+        lastError = "Customer " + std::to_string(customerId) + " is still referenced by bookings.";
+        return false;
     }
-    return false;
+    auto it = store.find(customerId);
+    if (it == store.end()) {
+        lastError = "Customer " + std::to_string(customerId) + " not found.";
+        return false;
+    }
+    Customer removed = it->second;
+    changeRecorder.record(&removed, nullptr);
+    indexErase(it->second);
+    store.erase(it);
+    if (!persistRows({customerId})) {
+        changeRecorder.discard();
+        indexInsert(store[customerId] = removed);
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
+    return true;
 }
 
-bool CustomerService::saveCustomers(const std::vector<Customer>& customers) {
-    std::ofstream file(dataFile);
-    if (!file.is_open()) return false;
+void CustomerService::setDeleteGuard(const std::function<bool(int customerId)>& guard) {
+    deleteGuard = guard;
+}
+
+Customer CustomerService::findCustomerByEmail(const std::string& email) {
+    refreshStore();
+    emailIndex.ensure(store);
+    int customerId = emailIndex.find(normalizeEmail(email));
+    return customerId != 0 ? store[customerId] : Customer();
+}
+
+Customer CustomerService::findCustomerByLicense(const std::string& licenseNumber) {
+    refreshStore();
+    licenseIndex.ensure(store);
+    int customerId = licenseIndex.find(normalizeLicense(licenseNumber));
+    return customerId != 0 ? store[customerId] : Customer();
+}
+
+bool CustomerService::isEmailTaken(const std::string& email, int ignoreCustomerId) {
+    refreshStore();
+    emailIndex.ensure(store);
+    int customerId = emailIndex.find(normalizeEmail(email));
+    return customerId != 0 && customerId != ignoreCustomerId;
+}
+
+bool CustomerService::isLicenseTaken(const std::string& licenseNumber, int ignoreCustomerId) {
+    refreshStore();
+    licenseIndex.ensure(store);
+    int customerId = licenseIndex.find(normalizeLicense(licenseNumber));
+    return customerId != 0 && customerId != ignoreCustomerId;
+}
+
+std::string CustomerService::normalizeEmail(const std::string& email) {
+    size_t begin = email.find_first_not_of(" \t");
+    size_t end = email.find_last_not_of(" \t");
+    if (begin == std::string::npos) return "";
+    std::string key = email.substr(begin, end - begin + 1);
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+std::string CustomerService::normalizeLicense(const std::string& licenseNumber) {
+    std::string key;
+    key.reserve(licenseNumber.size());
+    for (char c : licenseNumber) {
+        if (!std::isspace(static_cast<unsigned char>(c))) {
+            key += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+    }
+    return key;
+}
+
+// Sets lastError when another customer already has this email or license number
+bool CustomerService::checkUnique(const Customer& customer) {
+    emailIndex.ensure(store);
+    licenseIndex.ensure(store);
+    if (emailIndex.conflicts(customer, customer.getCustomerId())) {
+        lastError = "Email " + customer.getEmail() + " is already used by customer " +
+                    std::to_string(emailIndex.find(normalizeEmail(customer.getEmail()))) + ".";
+        return false;
+    }
+    if (licenseIndex.conflicts(customer, customer.getCustomerId())) {
+        lastError = "License number " + customer.getLicenseNumber() + " is already used by customer " +
+                    std::to_string(licenseIndex.find(normalizeLicense(customer.getLicenseNumber()))) + ".";
+        return false;
+    }
+    return true;
+}
+
+void CustomerService::indexErase(const Customer& customer) {
+    emailIndex.erase(customer, customer.getCustomerId());
+    licenseIndex.erase(customer, customer.getCustomerId());
+    sortIndex.erase(customer);
+}
+
+// customer is the store's copy
+void CustomerService::indexInsert(const Customer& customer) {
+    emailIndex.insert(customer, customer.getCustomerId());
+    licenseIndex.insert(customer, customer.getCustomerId());
+    sortIndex.insert(customer);
+}
+
+void CustomerService::forEachCustomer(const std::function<bool(const Customer&)>& predicate,
+                                      const std::function<void(const Customer&)>& callback) {
+    refreshStore();
+    for (const auto& entry : store) {
+        if (!predicate || predicate(entry.second)) {
+            callback(entry.second);
+        }
+    }
+}
+
+size_t CustomerService::getCustomerCount() {
+    refreshStore();
+    return store.size();
+}
+
+std::vector<Customer> CustomerService::getCustomersPage(CustomerSortKey sortKey, size_t offset, size_t limit) {
+    const std::vector<const Customer*>& ordered = getSortIndex(sortKey);
+    std::vector<Customer> page;
+    for (size_t i = offset; i < ordered.size() && i < offset + limit; i++) {
+        page.push_back(*ordered[i]);
+    }
+    return page;
+}
+
+long CustomerService::findCustomerPosition(int customerId, CustomerSortKey sortKey) {
+    refreshStore();
+    auto it = store.find(customerId);
+    if (it == store.end()) {
+        return -1;
+    }
     
-    file << "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry\n";
+    return static_cast<long>(sortIndex.position(sortKey, store, it->second));
+}
+
+bool CustomerService::saveCustomers(const std::vector<Customer>& customers) {
+    lastError.clear();
+    refreshStore();
+    changeRecorder.recordReplacement(store, customers);
+    std::map<int, Customer> previous;
+    previous.swap(store);
     for (const auto& customer : customers) {
-        file << customerToCsvLine(customer) << "\n";
+        store[customer.getCustomerId()] = customer;
     }
-    file.close();
+    emailIndex.clear();
+    licenseIndex.clear();
+    storeChanged();
+    updateNextId();
+    if (!persistStore()) {
+        changeRecorder.discard();
+        store.swap(previous);
+        emailIndex.clear();
+        licenseIndex.clear();
+        storeChanged();
+        updateNextId();
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    changeRecorder.publish(lastError);
     return true;
 }
 
 std::vector<Customer> CustomerService::loadCustomers() {
+    refreshStore();
     std::vector<Customer> customers;
-    std::ifstream file(dataFile);
-    if (!file.is_open()) return customers;
-    
-    std::string line;
-    bool firstLine = true;
-    while (std::getline(file, line)) {
-        if (firstLine) { firstLine = false; continue; }
-        if (!line.empty()) {
-            Customer customer = parseCustomerFromLine(line);
-            if (customer.getCustomerId() > 0) {
-                customers.push_back(customer);
-            }
-        }
+    customers.reserve(store.size());
+    for (const auto& entry : store) {
+        customers.push_back(entry.second);
     }
-    file.close();
-    updateNextId(customers);
     return customers;
 }
 
 int CustomerService::getNextId() { return nextId; }
 
+void CustomerService::setNextId(int id) { nextId = id; }
+
+const std::string& CustomerService::getDataFile() const { return dataFile; }
+
+const std::string& CustomerService::getLastError() const { return lastError; }
+
+void CustomerService::setStorageMode(StorageMode mode) {
+    flushWrites();
+    slotFile.setMode(mode);
+    storeStamp = FileStamp(); // Reload so the slot layout is read
+}
+
+void CustomerService::setPersistenceQueue(PersistenceQueue* queue) {
+    flushWrites();
+    writeQueue = queue;
+}
+
+void CustomerService::setChangeLog(ChangeLog* log) {
+    changeRecorder.setLog(log);
+}
+
+bool CustomerService::publishInserts(int firstId, int lastId) {
+    lastError.clear();
+    if (!changeRecorder.isEnabled() || firstId > lastId) {
+        return true;
+    }
+    refreshStore();
+    for (auto it = store.lower_bound(firstId); it != store.end() && it->first <= lastId; ++it) {
+        changeRecorder.record(nullptr, &it->second);
+    }
+    return changeRecorder.publish(lastError);
+}
+
+bool CustomerService::applyChanges(const std::vector<ChangeEvent>& changes) {
+    lastError.clear();
+    refreshStore();
+    std::vector<int> customerIds;
+    for (const auto& change : changes) {
+        if (change.entity != ChangeEntity::CUSTOMER) continue;
+        if (change.type == ChangeType::DELETED) {
+            store.erase(change.entityId);
+        } else {
+            store[change.entityId] = parseCustomerFromLine(change.after);
+        }
+        customerIds.push_back(change.entityId);
+    }
+    if (customerIds.empty()) {
+        return true;
+    }
+    std::sort(customerIds.begin(), customerIds.end());
+    customerIds.erase(std::unique(customerIds.begin(), customerIds.end()), customerIds.end());
+    emailIndex.clear(); // Replayed history can pass through states the indexes would refuse
+    licenseIndex.clear();
+    storeChanged();
+    updateNextId();
+    if (!persistRows(customerIds)) {
+        lastError = "Failed to write " + dataFile + ".";
+        return false;
+    }
+    return true;
+}
+
+void CustomerService::flushWrites() {
+    if (writeQueue) {
+        writeQueue->flush();
+    }
+}
+
 Customer CustomerService::parseCustomerFromLine(const std::string& line) {
     Customer customer;
-    std::stringstream ss(line);
-    std::string field;
     std::vector<std::string> fields;
-    
-    while (std::getline(ss, field, ',')) {
-        fields.push_back(field);
-    }
+    CsvUtils::splitLine(line, fields);
     
     if (fields.size() >= 8) {
         try {
@@ -128,6 +381,8 @@ Customer CustomerService::parseCustomerFromLine(const std::string& line) {
             customer.setAddress(fields[5]);
             customer.setLicenseNumber(fields[6]);
             customer.setLicenseExpiry(fields[7]);
+            // Files written before the status column existed have 8 fields
+            customer.setActive(fields.size() < 9 || fields[8] != "Inactive");
         } catch (const std::exception& e) {
             return Customer();
         }
@@ -144,16 +399,124 @@ std::string CustomerService::customerToCsvLine(const Customer& customer) {
        << customer.getPhone() << ","
        << customer.getAddress() << ","
        << customer.getLicenseNumber() << ","
-       << customer.getLicenseExpiry();
+       << customer.getLicenseExpiry() << ","
+       << (customer.isActive() ? "Active" : "Inactive");
     return ss.str();
 }
 
-void CustomerService::updateNextId(const std::vector<Customer>& customers) {
-    int maxId = 0;
-    for (const auto& customer : customers) {
-        if (customer.getCustomerId() > maxId) {
-            maxId = customer.getCustomerId();
+void CustomerService::refreshStore() {
+    if (writes->isBusy()) {
+        return;
+    }
+    FileStamp written;
+    if (writes->takeStamp(written)) {
+        storeStamp = written;
+    }
+    if (slotFile.poll()) {
+        storeStamp = slotFile.getStamp(); // Compacted in the background; same rows
+    }
+    FileStamp stamp = FileManager::getFileStamp(dataFile);
+    if (stamp == storeStamp) {
+        return;
+    }
+    
+    store.clear();
+    emailIndex.clear();
+    licenseIndex.clear();
+    slotFile.load([this](const std::string& line) {
+        Customer customer = parseCustomerFromLine(line);
+        if (customer.getCustomerId() > 0) {
+            store[customer.getCustomerId()] = customer;
+        }
+    });
+    
+    storeStamp = stamp;
+    storeChanged();
+    updateNextId();
+}
+
+bool CustomerService::persistStore() {
+    const char* header = "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry,Status";
+    if (slotFile.getMode() == StorageMode::SLOTTED) {
+        std::vector<std::pair<int, std::string>> rows;
+        rows.reserve(store.size());
+        for (const auto& entry : store) {
+            rows.emplace_back(entry.first, customerToCsvLine(entry.second));
+        }
+        if (!slotFile.rewrite(header, rows)) return false;
+        storeStamp = slotFile.getStamp();
+        return true;
+    }
+    
+    if (writeQueue) {
+        auto rows = std::make_shared<std::vector<Customer>>();
+        rows->reserve(store.size());
+        for (const auto& entry : store) {
+            rows->push_back(entry.second);
         }
+        auto render = [rows, header]() {
+            std::string contents = header;
+            contents += '\n';
+            for (const auto& customer : *rows) {
+                contents += customerToCsvLine(customer);
+                contents += '\n';
+            }
+            return contents;
+        };
+        WriteTracker::markQueued(storeStamp);
+        return writeQueue->submit(dataFile, render, writes);
+    }
+    
+    std::string tempFile = dataFile + ".tmp";
+    std::ofstream file(tempFile);
+    if (!file.is_open()) return false;
+    
+    file << header << "\n";
+    for (const auto& entry : store) {
+        file << customerToCsvLine(entry.second) << "\n";
+    }
+    file.close();
+    
+    FileManager fileManager;
+    if (!file || !fileManager.replaceFile(tempFile, dataFile)) {
+        std::remove(tempFile.c_str());
+        return false;
     }
-    nextId = maxId + 1;
+    
+    FileManager::markFileWritten(dataFile);
+    storeStamp = FileManager::getFileStamp(dataFile);
+    return true;
+}
+
+// Writes back only the given customers (changed or deleted) when slots are in use
+bool CustomerService::persistRows(const std::vector<int>& customerIds) {
+    if (slotFile.getMode() != StorageMode::SLOTTED) {
+        return persistStore();
+    }
+    for (int customerId : customerIds) {
+        auto it = store.find(customerId);
+        if (it != store.end()) {
+            slotFile.put(customerId, customerToCsvLine(it->second));
+        } else {
+            slotFile.remove(customerId);
+        }
+    }
+    if (!slotFile.commit()) {
+        return persistStore();
+    }
+    storeStamp = slotFile.getStamp();
+    return true;
+}
+
+void CustomerService::storeChanged() {
+    sortIndex.clear();
+}
+
+const std::vector<const Customer*>& CustomerService::getSortIndex(CustomerSortKey sortKey) {
+    refreshStore();
+    return sortIndex.get(sortKey, store);
+}
+
+void CustomerService::updateNextId() {
+    nextId = store.empty() ? 1 : store.rbegin()->first + 1;
 }
@@ -2,16 +2,48 @@
 #define CUSTOMERSERVICE_H
 
 #include "../models/Customer.h"
+#include "../database/FileManager.h"
+#include "../database/SlotFile.h"
+#include "../database/PersistenceQueue.h"
+#include "../database/SortIndex.h"
+#include "../database/UniqueIndex.h"
+#include "../database/ChangeRecorder.h"
 #include <vector>
 #include <string>
+#include <map>
+#include <functional>
+
+enum class CustomerSortKey {
+    ID,
+    NAME,
+    EMAIL,
+    LICENSE_EXPIRY
+};
 
 class CustomerService {
 private:
     std::string dataFile;
     int nextId;
+    std::string lastError;
+    
+    // In-memory copy of the data file, ordered by customer ID
+    std::map<int, Customer> store;
+    FileStamp storeStamp;
+    SlotFile slotFile;
+    // Whole-file writes go through the queue when one is set (CSV mode only)
+    PersistenceQueue* writeQueue;
+    std::shared_ptr<WriteTracker> writes;
+    SortIndex<Customer, CustomerSortKey> sortIndex;
+    UniqueIndex<Customer> emailIndex;
+    UniqueIndex<Customer> licenseIndex;
+    
+    // Consulted before a delete; returning false blocks it
+    std::function<bool(int)> deleteGuard;
+    
+    ChangeRecorder<Customer> changeRecorder;
 
 public:
-    CustomerService();
+    explicit CustomerService(const std::string& dataDirectory = "data");
     
     // CRUD operations
     bool addCustomer(const Customer& customer);
@@ -20,16 +52,59 @@ public:
     std::vector<Customer> searchCustomers(const std::string& searchTerm);
     bool updateCustomer(const Customer& customer);
     bool deleteCustomer(int customerId);
+    void setDeleteGuard(const std::function<bool(int customerId)>& guard);
+    
+    // Unique email (case-insensitive) and license number (ignoring case and spaces)
+    Customer findCustomerByEmail(const std::string& email);
+    Customer findCustomerByLicense(const std::string& licenseNumber);
+    bool isEmailTaken(const std::string& email, int ignoreCustomerId = 0);
+    bool isLicenseTaken(const std::string& licenseNumber, int ignoreCustomerId = 0);
+    static std::string normalizeEmail(const std::string& email);
+    static std::string normalizeLicense(const std::string& licenseNumber);
+    
+    // Streaming queries: rows are visited in ID order without being copied
+    void forEachCustomer(const std::function<bool(const Customer&)>& predicate,
+                         const std::function<void(const Customer&)>& callback);
+    
+    // Paging: only the requested slice of the sort order is copied out
+    size_t getCustomerCount();
+    std::vector<Customer> getCustomersPage(CustomerSortKey sortKey, size_t offset, size_t limit);
+    long findCustomerPosition(int customerId, CustomerSortKey sortKey);
     
     // Utility methods
     bool saveCustomers(const std::vector<Customer>& customers);
     std::vector<Customer> loadCustomers();
     int getNextId();
+    void setNextId(int id);
+    const std::string& getDataFile() const;
+    const std::string& getLastError() const;
+    void setStorageMode(StorageMode mode);
+    void setPersistenceQueue(PersistenceQueue* queue);
+    // Waits until queued writes of the data file have landed
+    void flushWrites();
+    // Every change made through the service is appended here once written
+    void setChangeLog(ChangeLog* log);
+    // Publishes inserts for customers written to the data file by someone else, e.g. an import;
+    // false if the change log refused them (they are retried with the next change)
+    bool publishInserts(int firstId, int lastId);
+    // Applies changes read from another store's change log, e.g. on a replica.
+    // Rows are taken as given, without validation; other entities' changes are skipped.
+    bool applyChanges(const std::vector<ChangeEvent>& changes);
+    
+    // Serialization
+    static Customer parseCustomerFromLine(const std::string& line);
+    static std::string customerToCsvLine(const Customer& customer);
     
 private:
-    Customer parseCustomerFromLine(const std::string& line);
-    std::string customerToCsvLine(const Customer& customer);
-    void updateNextId(const std::vector<Customer>& customers);
+    void refreshStore();
+    bool persistStore();
+    bool persistRows(const std::vector<int>& customerIds);
+    void storeChanged();
+    bool checkUnique(const Customer& customer);
+    void indexErase(const Customer& customer);
+    void indexInsert(const Customer& customer);
+    const std::vector<const Customer*>& getSortIndex(CustomerSortKey sortKey);
+    void updateNextId();
 };
 
 #endif // CUSTOMERSERVICE_H
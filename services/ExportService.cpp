@@ -0,0 +1,222 @@
+#include "ExportService.h"
+#include "../utils/BufferedWriter.h"
+#include "../utils/JsonWriter.h"
+#include <algorithm>
+
+namespace {
+
+// Pending JSON text is handed to the writer once it reaches this size
+const size_t JSON_DRAIN_SIZE = 64 * 1024;
+
+void writeCsvField(BufferedWriter& writer, const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        writer.write(text);
+        return;
+    }
+    writer.writeChar('"');
+    for (char c : text) {
+        if (c == '"') writer.writeChar('"');
+        writer.writeChar(c);
+    }
+    writer.writeChar('"');
+}
+
+// Runs one export: opens the file, lets visit() stream rows, and finishes the
+// file. visit() sets error when it could not read every row; the export then fails.
+template <typename Visit>
+ExportResult runExport(const std::string& path, ExportFormat format, const std::string& csvHeader, Visit visit) {
+    ExportResult result;
+    BufferedWriter writer(path);
+    if (!writer.isOpen()) {
+        result.error = "Cannot create export file: " + path;
+        return result;
+    }
+
+    std::string json;
+    if (format == ExportFormat::CSV) {
+        writer.write(csvHeader);
+        writer.writeChar('\n');
+    } else {
+        json += '[';
+    }
+
+    visit(writer, json, result.rows, result.error);
+    if (!result.error.empty()) {
+        writer.close();
+        return result;
+    }
+
+    if (format == ExportFormat::JSON) {
+        json += "]\n";
+        writer.write(json);
+    }
+
+    if (!writer.close()) {
+        result.error = "Failed to write export file: " + path;
+        return result;
+    }
+    result.success = true;
+    return result;
+}
+
+void drainJson(BufferedWriter& writer, std::string& json) {
+    if (json.size() >= JSON_DRAIN_SIZE) {
+        writer.write(json);
+        json.clear();
+    }
+}
+
+} // namespace
+
+ExportResult ExportService::exportBookings(BookingService& bookingService, const std::string& path, ExportFormat format,
+                                           const std::function<bool(const Booking&)>& predicate) {
+    return runExport(path, format, "ID,CustomerID,CarID,StartDate,EndDate,TotalCost,Status,Notes",
+        [&](BufferedWriter& writer, std::string& json, long long& rows, std::string& error) {
+            auto writeBooking = [&](const Booking& booking) {
+                if (format == ExportFormat::CSV) {
+                    writer.writeInt(booking.getBookingId()); writer.writeChar(',');
+                    writer.writeInt(booking.getCustomerId()); writer.writeChar(',');
+                    writer.writeInt(booking.getCarId()); writer.writeChar(',');
+                    writer.write(booking.getStartDate()); writer.writeChar(',');
+                    writer.write(booking.getEndDate()); writer.writeChar(',');
+                    writer.writeFixed(booking.getTotalCost()); writer.writeChar(',');
+                    writeCsvField(writer, booking.getStatus()); writer.writeChar(',');
+                    writeCsvField(writer, booking.getNotes()); writer.writeChar('\n');
+                } else {
+                    if (rows > 0) json += ',';
+                    json += "\n  ";
+                    writeBookingJson(json, booking);
+                    drainJson(writer, json);
+                }
+                rows++;
+            };
+            // Archived bookings are older, so they go first to keep the rows roughly in ID order
+            if (!bookingService.forEachArchivedBooking(ArchiveFilter(), [&](const Booking& booking) {
+                    if (!predicate || predicate(booking)) writeBooking(booking);
+                })) {
+                error = "Failed to read archived bookings: " + bookingService.getLastError();
+                return;
+            }
+            bookingService.forEachBooking(predicate, writeBooking);
+        });
+}
+
+ExportResult ExportService::exportCars(CarService& carService, const std::string& path, ExportFormat format,
+                                       const std::function<bool(const Car&)>& predicate) {
+    return runExport(path, format, "ID,Make,Model,Year,Color,LicensePlate,DailyRate,Status,Mileage,FuelType,Transmission,Seats",
+        [&](BufferedWriter& writer, std::string& json, long long& rows, std::string&) {
+            carService.forEachCar(predicate, [&](const Car& car) {
+                if (format == ExportFormat::CSV) {
+                    writer.writeInt(car.getCarId()); writer.writeChar(',');
+                    writeCsvField(writer, car.getMake()); writer.writeChar(',');
+                    writeCsvField(writer, car.getModel()); writer.writeChar(',');
+                    writer.writeInt(car.getYear()); writer.writeChar(',');
+                    writeCsvField(writer, car.getColor()); writer.writeChar(',');
+                    writeCsvField(writer, car.getLicensePlate()); writer.writeChar(',');
+                    writer.writeFixed(car.getDailyRate()); writer.writeChar(',');
+                    writer.write(car.getStatusString()); writer.writeChar(',');
+                    writer.writeInt(car.getMileage()); writer.writeChar(',');
+                    writer.write(car.getFuelTypeString()); writer.writeChar(',');
+                    writer.write(car.getTransmissionString()); writer.writeChar(',');
+                    writer.writeInt(car.getSeats()); writer.writeChar('\n');
+                } else {
+                    if (rows > 0) json += ',';
+                    json += "\n  ";
+                    writeCarJson(json, car);
+                    drainJson(writer, json);
+                }
+                rows++;
+            });
+        });
+}
+
+ExportResult ExportService::exportCustomers(CustomerService& customerService, const std::string& path, ExportFormat format,
+                                            const std::function<bool(const Customer&)>& predicate) {
+    return runExport(path, format, "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry,Status",
+        [&](BufferedWriter& writer, std::string& json, long long& rows, std::string&) {
+            customerService.forEachCustomer(predicate, [&](const Customer& customer) {
+                if (format == ExportFormat::CSV) {
+                    writer.writeInt(customer.getCustomerId()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getFirstName()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getLastName()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getEmail()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getPhone()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getAddress()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getLicenseNumber()); writer.writeChar(',');
+                    writeCsvField(writer, customer.getLicenseExpiry()); writer.writeChar(',');
+                    writer.write(customer.isActive() ? "Active" : "Inactive"); writer.writeChar('\n');
+                } else {
+                    if (rows > 0) json += ',';
+                    json += "\n  ";
+                    writeCustomerJson(json, customer);
+                    drainJson(writer, json);
+                }
+                rows++;
+            });
+        });
+}
+
+ExportFormat ExportService::stringToFormat(const std::string& formatStr) {
+    std::string lower = formatStr;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower == "json" ? ExportFormat::JSON : ExportFormat::CSV;
+}
+
+void ExportService::writeBookingJson(std::string& out, const Booking& booking) {
+    JsonWriter json(out);
+    writeBookingJson(json, booking);
+}
+
+void ExportService::writeBookingJson(JsonWriter& json, const Booking& booking) {
+    json.beginObject()
+        .key("id").value(booking.getBookingId())
+        .key("customerId").value(booking.getCustomerId())
+        .key("carId").value(booking.getCarId())
+        .key("startDate").value(booking.getStartDate())
+        .key("endDate").value(booking.getEndDate())
+        .key("totalCost").value(booking.getTotalCost())
+        .key("status").value(booking.getStatus())
+        .key("notes").value(booking.getNotes())
+        .endObject();
+}
+
+void ExportService::writeCarJson(std::string& out, const Car& car) {
+    JsonWriter json(out);
+    writeCarJson(json, car);
+}
+
+void ExportService::writeCarJson(JsonWriter& json, const Car& car) {
+    json.beginObject()
+        .key("id").value(car.getCarId())
+        .key("make").value(car.getMake())
+        .key("model").value(car.getModel())
+        .key("year").value(car.getYear())
+        .key("color").value(car.getColor())
+        .key("licensePlate").value(car.getLicensePlate())
+        .key("dailyRate").value(car.getDailyRate())
+        .key("status").value(car.getStatusString())
+        .key("mileage").value(car.getMileage())
+        .key("fuelType").value(car.getFuelTypeString())
+        .key("transmission").value(car.getTransmissionString())
+        .key("seats").value(car.getSeats())
+        .endObject();
+}
+
+void ExportService::writeCustomerJson(std::string& out, const Customer& customer) {
+    JsonWriter json(out);
+    writeCustomerJson(json, customer);
+}
+
+void ExportService::writeCustomerJson(JsonWriter& json, const Customer& customer) {
+    json.beginObject()
+        .key("id").value(customer.getCustomerId())
+        .key("firstName").value(customer.getFirstName())
+        .key("lastName").value(customer.getLastName())
+        .key("email").value(customer.getEmail())
+        .key("phone").value(customer.getPhone())
+        .key("address").value(customer.getAddress())
+        .key("licenseNumber").value(customer.getLicenseNumber())
+        .key("licenseExpiry").value(customer.getLicenseExpiry())
+        .key("active").value(customer.isActive())
+        .endObject();
+}
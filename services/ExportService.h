@@ -0,0 +1,49 @@
+#ifndef EXPORTSERVICE_H
+#define EXPORTSERVICE_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include "CustomerService.h"
+#include <functional>
+#include <string>
+
+class JsonWriter;
+
+enum class ExportFormat {
+    CSV,
+    JSON
+};
+
+struct ExportResult {
+    bool success;
+    long long rows;
+    std::string error;
+
+    ExportResult() : success(false), rows(0) {}
+};
+
+// Streams query results straight to a file. Rows are visited through the
+// services' forEach* APIs and written through a BufferedWriter, so memory use
+// does not grow with the number of exported rows.
+class ExportService {
+public:
+    static ExportResult exportBookings(BookingService& bookingService, const std::string& path, ExportFormat format,
+                                       const std::function<bool(const Booking&)>& predicate = nullptr);
+    static ExportResult exportCars(CarService& carService, const std::string& path, ExportFormat format,
+                                   const std::function<bool(const Car&)>& predicate = nullptr);
+    static ExportResult exportCustomers(CustomerService& customerService, const std::string& path, ExportFormat format,
+                                        const std::function<bool(const Customer&)>& predicate = nullptr);
+
+    static ExportFormat stringToFormat(const std::string& formatStr);
+
+    // JSON encoders shared with other writers of the same records
+    static void writeBookingJson(std::string& out, const Booking& booking);
+    static void writeCarJson(std::string& out, const Car& car);
+    static void writeCustomerJson(std::string& out, const Customer& customer);
+    // Same records written as the next value of an open writer, e.g. an array element
+    static void writeBookingJson(JsonWriter& json, const Booking& booking);
+    static void writeCarJson(JsonWriter& json, const Car& car);
+    static void writeCustomerJson(JsonWriter& json, const Customer& customer);
+};
+
+#endif // EXPORTSERVICE_H
@@ -0,0 +1,313 @@
+#include "ImportService.h"
+#include "../database/FileManager.h"
+#include "../utils/CsvUtils.h"
+#include <fstream>
+#include <future>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <unordered_set>
+
+const size_t ImportService::CHUNK_SIZE = 16384;
+
+namespace {
+
+template <typename Record>
+struct ParsedRow {
+    bool ok;
+    Record record;
+    std::string errors;
+};
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0') return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseDouble(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+}
+
+// Leading integer of a data file row, i.e. its ID column
+int leadingId(const std::string& line) {
+    return std::atoi(line.c_str());
+}
+
+std::string quoteCsv(std::string text) {
+    while (!text.empty() && text.back() == ' ') text.pop_back();
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+bool parseCarRow(const std::vector<std::string>& fields, Car& car, std::string& errors) {
+    if (fields.size() != 10) {
+        errors = "Expected 10 fields, found " + std::to_string(fields.size()) + ". ";
+        return false;
+    }
+
+    int year = 0, mileage = 0, seats = 0;
+    double dailyRate = 0.0;
+    car.setMake(fields[0]);
+    car.setModel(fields[1]);
+    if (!parseInt(fields[2], year)) errors += "Year must be a number. ";
+    car.setYear(year);
+    car.setColor(fields[3]);
+    car.setLicensePlate(fields[4]);
+    if (!parseDouble(fields[5], dailyRate)) errors += "Daily rate must be a number. ";
+    car.setDailyRate(dailyRate);
+    if (!parseInt(fields[6], mileage) || mileage < 0) errors += "Mileage must be a non-negative number. ";
+    car.setMileage(mileage);
+
+    FuelType fuelType = Car::stringToFuelType(fields[7]);
+    if (!equalsIgnoreCase(Car::fuelTypeToString(fuelType), fields[7])) errors += "Unknown fuel type. ";
+    car.setFuelType(fuelType);
+
+    Transmission transmission = Car::stringToTransmission(fields[8]);
+    if (!equalsIgnoreCase(Car::transmissionToString(transmission), fields[8])) errors += "Unknown transmission. ";
+    car.setTransmission(transmission);
+
+    if (!parseInt(fields[9], seats)) errors += "Seats must be a number. ";
+    car.setSeats(seats);
+
+    if (!car.isValid()) errors += car.getValidationErrors();
+    return errors.empty();
+}
+
+bool parseCustomerRow(const std::vector<std::string>& fields, Customer& customer, std::string& errors) {
+    if (fields.size() != 7) {
+        errors = "Expected 7 fields, found " + std::to_string(fields.size()) + ". ";
+        return false;
+    }
+
+    customer.setFirstName(fields[0]);
+    customer.setLastName(fields[1]);
+    customer.setEmail(fields[2]);
+    customer.setPhone(fields[3]);
+    customer.setAddress(fields[4]);
+    customer.setLicenseNumber(fields[5]);
+    customer.setLicenseExpiry(fields[6]);
+
+    if (!customer.isValid()) errors += customer.getValidationErrors();
+    return errors.empty();
+}
+
+size_t readChunk(std::ifstream& source, std::vector<std::string>& lines) {
+    lines.clear();
+    std::string line;
+    while (lines.size() < ImportService::CHUNK_SIZE && std::getline(source, line)) {
+        lines.push_back(std::move(line));
+    }
+    return lines.size();
+}
+
+// Shared import pipeline: parse/validate on the pool; claim unique keys, number and
+// stage on the calling thread
+template <typename Record, typename ParseRow, typename Claim, typename SetId, typename Serialize>
+ImportResult runImport(ThreadPool& pool, const std::string& sourceFile, const std::string& rejectFile,
+                       const std::string& dataFile, const std::string& header, int serviceNextId,
+                       ParseRow parseRow, Claim claim, SetId setId, Serialize serialize) {
+    ImportResult result;
+
+    std::ifstream source(sourceFile);
+    if (!source.is_open()) {
+        result.error = "Cannot open source file: " + sourceFile;
+        return result;
+    }
+
+    std::ofstream rejects(rejectFile);
+    if (!rejects.is_open()) {
+        result.error = "Cannot create reject file: " + rejectFile;
+        return result;
+    }
+    rejects << "Line,Errors\n";
+
+    // Stage a copy of the current data file; the new rows are appended to it
+    std::string stagingFile = dataFile + ".import";
+    std::ofstream staging(stagingFile, std::ios::binary);
+    if (!staging.is_open()) {
+        result.error = "Cannot create staging file: " + stagingFile;
+        return result;
+    }
+
+    int maxId = 0;
+    std::ifstream existing(dataFile);
+    if (existing.is_open()) {
+        std::string line;
+        bool firstLine = true;
+        while (std::getline(existing, line)) {
+            if (!firstLine && !line.empty()) {
+                maxId = std::max(maxId, leadingId(line));
+            }
+            firstLine = false;
+            staging << line << "\n";
+        }
+    } else {
+        staging << header << "\n";
+    }
+    existing.close();
+
+    int nextId = std::max(maxId + 1, serviceNextId);
+    result.firstId = nextId;
+
+    std::string skippedHeader;
+    std::getline(source, skippedHeader);
+    int lineNumber = 1;
+
+    std::vector<std::string> current, next;
+    std::vector<ParsedRow<Record>> parsed;
+    std::string stagedRows, rejectedRows;
+    readChunk(source, current);
+
+    while (!current.empty()) {
+        parsed.assign(current.size(), ParsedRow<Record>());
+
+        // Validate this chunk on the pool while the next chunk is read
+        auto validation = std::async(std::launch::async, [&]() {
+            pool.parallelFor(current.size(), [&](size_t begin, size_t end) {
+                std::vector<std::string> fields;
+                for (size_t i = begin; i < end; i++) {
+                    CsvUtils::splitLine(current[i], fields);
+                    parsed[i].ok = parseRow(fields, parsed[i].record, parsed[i].errors);
+                }
+            });
+        });
+        readChunk(source, next);
+        validation.get();
+
+        stagedRows.clear();
+        rejectedRows.clear();
+        for (size_t i = 0; i < current.size(); i++) {
+            lineNumber++;
+            if (current[i].empty() || current[i] == "\r") continue;
+
+            result.rowsRead++;
+            if (parsed[i].ok && claim(parsed[i].record, parsed[i].errors)) {
+                setId(parsed[i].record, nextId++);
+                stagedRows += serialize(parsed[i].record);
+                stagedRows += '\n';
+                result.imported++;
+            } else {
+                rejectedRows += std::to_string(lineNumber) + "," + quoteCsv(parsed[i].errors) + "\n";
+                result.rejected++;
+            }
+        }
+        staging.write(stagedRows.data(), stagedRows.size());
+        rejects.write(rejectedRows.data(), rejectedRows.size());
+
+        current.swap(next);
+    }
+
+    staging.close();
+    rejects.close();
+    result.lastId = nextId - 1;
+
+    if (!staging) {
+        std::remove(stagingFile.c_str());
+        result.error = "Failed to write staging file: " + stagingFile;
+        return result;
+    }
+
+    // Single commit point for the whole import
+    FileManager fileManager;
+    if (!fileManager.replaceFile(stagingFile, dataFile)) {
+        std::remove(stagingFile.c_str());
+        result.error = "Failed to replace data file: " + dataFile;
+        return result;
+    }
+    FileManager::markFileWritten(dataFile);
+
+    result.success = true;
+    return result;
+}
+
+} // namespace
+
+ImportService::ImportService(size_t workerCount) : pool(workerCount) {
+}
+
+ImportResult ImportService::importCars(CarService& carService, const std::string& sourceFile,
+                                       const std::string& rejectFile) {
+    // Plates must be unique against the fleet and within the file
+    std::unordered_set<std::string> plates;
+    auto claimPlate = [&](const Car& car, std::string& errors) {
+        std::string plate = CarService::normalizePlate(car.getLicensePlate());
+        if (carService.isPlateTaken(plate) || !plates.insert(plate).second) {
+            errors = "Duplicate license plate. ";
+            return false;
+        }
+        return true;
+    };
+
+    carService.flushWrites(); // The import starts from the data file on disk
+    ImportResult result = runImport<Car>(
+        pool, sourceFile, rejectFile, carService.getDataFile(),
+        "ID,Make,Model,Year,Color,LicensePlate,DailyRate,Status,Mileage,FuelType,Transmission,Seats",
+        carService.getNextId(), parseCarRow, claimPlate,
+        [](Car& car, int id) { car.setCarId(id); },
+        [](const Car& car) { return CarService::carToCsvLine(car); });
+
+    if (result.success) {
+        carService.setNextId(result.lastId + 1);
+        if (!carService.publishInserts(result.firstId, result.lastId)) {
+            result.error = carService.getLastError();
+        }
+    }
+    return result;
+}
+
+ImportResult ImportService::importCustomers(CustomerService& customerService, const std::string& sourceFile,
+                                            const std::string& rejectFile) {
+    // Emails and license numbers must be unique against existing customers and within the file
+    std::unordered_set<std::string> emails, licenses;
+    auto claimKeys = [&](const Customer& customer, std::string& errors) {
+        std::string email = CustomerService::normalizeEmail(customer.getEmail());
+        std::string license = CustomerService::normalizeLicense(customer.getLicenseNumber());
+        if (customerService.isEmailTaken(email) || emails.count(email)) {
+            errors += "Duplicate email. ";
+        }
+        if (customerService.isLicenseTaken(license) || licenses.count(license)) {
+            errors += "Duplicate license number. ";
+        }
+        if (!errors.empty()) {
+            return false;
+        }
+        emails.insert(email);
+        licenses.insert(license);
+        return true;
+    };
+
+    customerService.flushWrites();
+    ImportResult result = runImport<Customer>(
+        pool, sourceFile, rejectFile, customerService.getDataFile(),
+        "ID,FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry,Status",
+        customerService.getNextId(), parseCustomerRow, claimKeys,
+        [](Customer& customer, int id) { customer.setCustomerId(id); },
+        [](const Customer& customer) { return CustomerService::customerToCsvLine(customer); });
+
+    if (result.success) {
+        customerService.setNextId(result.lastId + 1);
+        if (!customerService.publishInserts(result.firstId, result.lastId)) {
+            result.error = customerService.getLastError();
+        }
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#ifndef IMPORTSERVICE_H
+#define IMPORTSERVICE_H
+
+#include "CarService.h"
+#include "CustomerService.h"
+#include "../utils/ThreadPool.h"
+#include <string>
+
+struct ImportResult {
+    bool success;
+    int rowsRead;
+    int imported;
+    int rejected;
+    int firstId;
+    int lastId;
+    std::string error;      // Why the import failed; on success, a problem after the rows were saved
+
+    ImportResult() : success(false), rowsRead(0), imported(0), rejected(0), firstId(0), lastId(0) {}
+};
+
+// Bulk loader for external CSV files.
+//
+// The source file is streamed in fixed-size chunks: each chunk is parsed and
+// validated on the thread pool while the next one is read, accepted rows get
+// consecutive IDs and are appended to a staging copy of the data file, and the
+// staging file replaces the data file once at the end. Rejected rows are written
+// to the reject file with their line number and validation errors. A row whose
+// license plate, email or license number is already taken (in the store or
+// earlier in the file) is rejected as a duplicate.
+//
+// Car rows:      Make,Model,Year,Color,LicensePlate,DailyRate,Mileage,FuelType,Transmission,Seats
+// Customer rows: FirstName,LastName,Email,Phone,Address,LicenseNumber,LicenseExpiry
+// The first line of the source file is a header and is skipped.
+class ImportService {
+private:
+    ThreadPool pool;
+
+public:
+    explicit ImportService(size_t workerCount = 0);
+
+    ImportResult importCars(CarService& carService, const std::string& sourceFile,
+                            const std::string& rejectFile);
+    ImportResult importCustomers(CustomerService& customerService, const std::string& sourceFile,
+                                 const std::string& rejectFile);
+
+    static const size_t CHUNK_SIZE;
+};
+
+#endif // IMPORTSERVICE_H
@@ -0,0 +1,139 @@
+#include "IntegrityService.h"
+
+IntegrityService::IntegrityService(CarService& carService, CustomerService& customerService,
+                                   BookingService& bookingService)
+    : carService(carService), customerService(customerService), bookingService(bookingService) {
+    bookingService.attachReferences(&carService, &customerService);
+    carService.setDeleteGuard([this](int carId) { return countCarReferences(carId) == 0; });
+    customerService.setDeleteGuard([this](int customerId) { return countCustomerReferences(customerId) == 0; });
+}
+
+IntegrityService::~IntegrityService() {
+    bookingService.attachReferences(nullptr, nullptr);
+    carService.setDeleteGuard(nullptr);
+    customerService.setDeleteGuard(nullptr);
+}
+
+size_t IntegrityService::countCarReferences(int carId) {
+    return bookingService.countBookingsForCar(carId);
+}
+
+size_t IntegrityService::countCustomerReferences(int customerId) {
+    return bookingService.countBookingsForCustomer(customerId);
+}
+
+bool IntegrityService::deleteCar(int carId, DeletePolicy policy) {
+    lastError.clear();
+    Car car = carService.getCarById(carId);
+    if (car.getCarId() == 0) {
+        lastError = "Car not found with ID: " + std::to_string(carId);
+        return false;
+    }
+
+    size_t references = countCarReferences(carId);
+    if (policy == DeletePolicy::SOFT_DELETE) {
+        car.setStatus(CarStatus::RETIRED);
+        if (!carService.updateCar(car)) {
+            lastError = "Failed to retire car.";
+            return false;
+        }
+        return true;
+    }
+    if (references > 0 && policy == DeletePolicy::RESTRICT) {
+        lastError = "Car " + std::to_string(carId) + " is referenced by " + std::to_string(references) +
+                    " booking(s).";
+        return false;
+    }
+    ArchiveFilter archived;
+    archived.carId = carId;
+    if (references == 0) {
+        if (!carService.deleteCar(carId)) {
+            lastError = "Failed to delete car: " + carService.getLastError();
+            return false;
+        }
+        return true;
+    }
+    return cascade(bookingService.getBookingIdsForCar(carId), archived, "car",
+                   [this, carId]() { return carService.deleteCar(carId) ? std::string() : carService.getLastError(); });
+}
+
+bool IntegrityService::deleteCustomer(int customerId, DeletePolicy policy) {
+    lastError.clear();
+    Customer customer = customerService.getCustomerById(customerId);
+    if (customer.getCustomerId() == 0) {
+        lastError = "Customer not found with ID: " + std::to_string(customerId);
+        return false;
+    }
+
+    size_t references = countCustomerReferences(customerId);
+    if (policy == DeletePolicy::SOFT_DELETE) {
+        customer.setActive(false);
+        if (!customerService.updateCustomer(customer)) {
+            lastError = "Failed to deactivate customer.";
+            return false;
+        }
+        return true;
+    }
+    if (references > 0 && policy == DeletePolicy::RESTRICT) {
+        lastError = "Customer " + std::to_string(customerId) + " is referenced by " + std::to_string(references) +
+                    " booking(s).";
+        return false;
+    }
+    ArchiveFilter archived;
+    archived.customerId = customerId;
+    if (references == 0) {
+        if (!customerService.deleteCustomer(customerId)) {
+            lastError = "Failed to delete customer: " + customerService.getLastError();
+            return false;
+        }
+        return true;
+    }
+    return cascade(bookingService.getBookingIdsForCustomer(customerId), archived, "customer", [this, customerId]() {
+        return customerService.deleteCustomer(customerId) ? std::string() : customerService.getLastError();
+    });
+}
+
+// The bookings go first so the delete guard sees no references. Everything
+// that can be read is read before the first write, and a failed step puts
+// back the bookings already deleted, so the row and its bookings go together
+// or not at all. Only a failed restore leaves them apart, and says so.
+bool IntegrityService::cascade(const std::vector<int>& bookingIds, const ArchiveFilter& archived,
+                               const std::string& entity, const std::function<std::string()>& deleteEntity) {
+    std::vector<Booking> bookings;
+    for (int bookingId : bookingIds) {
+        bookings.push_back(bookingService.getBookingById(bookingId));
+    }
+    std::vector<Booking> archivedBookings;
+    if (!bookingService.forEachArchivedBooking(archived, [&archivedBookings](const Booking& booking) {
+            archivedBookings.push_back(booking);
+        })) {
+        lastError = "Failed to read archived bookings: " + bookingService.getLastError();
+        return false;
+    }
+
+    std::string error;
+    if (!bookings.empty() && !bookingService.deleteBookings(bookingIds)) {
+        lastError = "Failed to delete bookings: " + bookingService.getLastError();
+        return false;
+    }
+    if (!archivedBookings.empty() && !bookingService.deleteArchivedBookings(archived)) {
+        error = "Failed to delete archived bookings: " + bookingService.getLastError();
+    } else {
+        std::string failed = deleteEntity();
+        if (failed.empty()) {
+            return true;
+        }
+        error = "Failed to delete " + entity + ": " + failed;
+    }
+
+    if (!bookingService.restoreBookings(bookings, archivedBookings)) {
+        error += " Its " + std::to_string(bookings.size() + archivedBookings.size()) +
+                 " booking(s) were deleted and could not be restored: " + bookingService.getLastError();
+    }
+    lastError = error;
+    return false;
+}
+
+const std::string& IntegrityService::getLastError() const {
+    return lastError;
+}
@@ -0,0 +1,50 @@
+#ifndef INTEGRITYSERVICE_H
+#define INTEGRITYSERVICE_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include "CustomerService.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class DeletePolicy {
+    RESTRICT,       // refuse while any booking references the row
+    CASCADE,        // delete the referencing bookings too, all or nothing
+    SOFT_DELETE     // keep the row: retire the car / deactivate the customer
+};
+
+// Foreign-key rules between bookings and the cars and customers they name.
+//
+// While an IntegrityService exists, the booking service rejects bookings for
+// unknown or soft-deleted cars and customers, and plain deleteCar /
+// deleteCustomer calls behave as RESTRICT. Every check is answered from the
+// booking service's reverse indexes, so no file is reloaded per mutation.
+class IntegrityService {
+private:
+    CarService& carService;
+    CustomerService& customerService;
+    BookingService& bookingService;
+    std::string lastError;
+
+    // deleteEntity returns an empty string on success, else the reason
+    bool cascade(const std::vector<int>& bookingIds, const ArchiveFilter& archived, const std::string& entity,
+                 const std::function<std::string()>& deleteEntity);
+
+public:
+    IntegrityService(CarService& carService, CustomerService& customerService, BookingService& bookingService);
+    ~IntegrityService();
+
+    IntegrityService(const IntegrityService&) = delete;
+    IntegrityService& operator=(const IntegrityService&) = delete;
+
+    size_t countCarReferences(int carId);
+    size_t countCustomerReferences(int customerId);
+
+    bool deleteCar(int carId, DeletePolicy policy);
+    bool deleteCustomer(int customerId, DeletePolicy policy);
+
+    const std::string& getLastError() const;
+};
+
+#endif // INTEGRITYSERVICE_H
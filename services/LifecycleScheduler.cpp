@@ -0,0 +1,196 @@
+#include "LifecycleScheduler.h"
+#include <algorithm>
+#include <map>
+
+LifecycleScheduler::LifecycleScheduler(BookingService& bookingService, CarService& carService)
+    : bookingService(bookingService), carService(carService), autoComplete(false), loadGeneration(0) {
+    bookingService.setChangeListener([this](const Booking& booking) { schedule(booking); });
+    rebuild();
+}
+
+LifecycleScheduler::~LifecycleScheduler() {
+    bookingService.setChangeListener(nullptr);
+}
+
+void LifecycleScheduler::setAutoComplete(bool enabled) {
+    autoComplete = enabled;
+}
+
+void LifecycleScheduler::rebuild() {
+    heap.clear();
+    bookingService.forEachOpenBooking([this](const Booking& booking) {
+        if (!booking.isActive()) return;
+        heap.push_back({Booking::dateToDays(booking.getStartDate()), EventKind::START, booking.getBookingId()});
+        heap.push_back({Booking::dateToDays(booking.getEndDate()), EventKind::END, booking.getBookingId()});
+    });
+    std::make_heap(heap.begin(), heap.end(), EventLater());
+    loadGeneration = bookingService.getLoadGeneration();
+}
+
+void LifecycleScheduler::schedule(const Booking& booking) {
+    if (!booking.isActive()) {
+        return;
+    }
+    push(Booking::dateToDays(booking.getStartDate()), EventKind::START, booking.getBookingId());
+    push(Booking::dateToDays(booking.getEndDate()), EventKind::END, booking.getBookingId());
+}
+
+void LifecycleScheduler::push(int day, EventKind kind, int bookingId) {
+    heap.push_back({day, kind, bookingId});
+    std::push_heap(heap.begin(), heap.end(), EventLater());
+}
+
+LifecycleTickResult LifecycleScheduler::tick() {
+    return tick(Booking::today());
+}
+
+LifecycleTickResult LifecycleScheduler::tick(int today) {
+    LifecycleTickResult result;
+    lastError.clear();
+    if (bookingService.getLoadGeneration() != loadGeneration) {
+        rebuild();
+    }
+    if (heap.empty() || heap.front().day > today) {
+        return result;
+    }
+
+    // Collect the changes first so each file is written once per tick
+    std::map<int, Booking> bookings;
+    std::map<int, Car> cars;
+    auto currentBooking = [&](int bookingId) -> Booking& {
+        auto found = bookings.find(bookingId);
+        if (found == bookings.end()) {
+            found = bookings.emplace(bookingId, bookingService.getBookingById(bookingId)).first;
+        }
+        return found->second;
+    };
+    auto currentCar = [&](int carId) -> Car& {
+        auto found = cars.find(carId);
+        if (found == cars.end()) {
+            found = cars.emplace(carId, carService.getCarById(carId)).first;
+        }
+        return found->second;
+    };
+    std::map<int, CarStatus> originalStatus;
+    std::vector<int> endedBookings;
+    std::vector<Booking> previousBookings;
+    std::vector<Event> popped;     // Go back on the heap if the changes cannot be written
+
+    while (!heap.empty() && heap.front().day <= today) {
+        std::pop_heap(heap.begin(), heap.end(), EventLater());
+        Event event = heap.back();
+        heap.pop_back();
+        popped.push_back(event);
+
+        Booking& booking = currentBooking(event.bookingId);
+        if (booking.getBookingId() == 0) continue;
+
+        if (event.kind == EventKind::START) {
+            if (!booking.isActive() || Booking::dateToDays(booking.getStartDate()) != event.day) continue;
+            Car& car = currentCar(booking.getCarId());
+            if (car.getCarId() == 0) continue;
+            originalStatus.emplace(car.getCarId(), car.getStatus());
+            if (car.getStatus() == CarStatus::AVAILABLE) {
+                car.setStatus(CarStatus::RENTED);
+                result.started++;
+            }
+        } else {
+            if (!booking.isActive() || Booking::dateToDays(booking.getEndDate()) != event.day) continue;
+            previousBookings.push_back(booking);
+            if (autoComplete) {
+                booking.setStatus("Completed");
+                endedBookings.push_back(booking.getBookingId());
+                result.completed++;
+                Car& car = currentCar(booking.getCarId());
+                if (car.getCarId() == 0) continue;
+                originalStatus.emplace(car.getCarId(), car.getStatus());
+                if (car.getStatus() == CarStatus::RENTED &&
+                    !carInUseToday(car.getCarId(), today, booking.getBookingId())) {
+                    car.setStatus(CarStatus::AVAILABLE);
+                }
+            } else {
+                booking.setStatus("Overdue");
+                endedBookings.push_back(booking.getBookingId());
+                result.overdue++;
+            }
+        }
+    }
+
+    std::vector<Booking> changedBookings;
+    for (int bookingId : endedBookings) {
+        changedBookings.push_back(bookings[bookingId]);
+    }
+    std::vector<Car> changedCars;
+    for (const auto& entry : cars) {
+        auto original = originalStatus.find(entry.first);
+        if (original != originalStatus.end() && original->second != entry.second.getStatus()) {
+            changedCars.push_back(entry.second);
+        }
+    }
+
+    if (!bookingService.updateBookings(changedBookings)) {
+        lastError = bookingService.getLastError();
+        requeue(popped);
+        return LifecycleTickResult();
+    }
+    if (!carService.updateCars(changedCars)) {
+        // Undo the bookings too, so the next tick redoes both
+        lastError = "Failed to update car statuses: " + carService.getLastError();
+        if (!bookingService.updateBookings(previousBookings)) {
+            lastError += " The bookings could not be restored either: " + bookingService.getLastError();
+        }
+        requeue(popped);
+        return LifecycleTickResult();
+    }
+    result.carsUpdated = static_cast<int>(changedCars.size());
+    return result;
+}
+
+void LifecycleScheduler::requeue(const std::vector<Event>& events) {
+    for (const auto& event : events) {
+        push(event.day, event.kind, event.bookingId);
+    }
+}
+
+bool LifecycleScheduler::returnCar(int bookingId) {
+    lastError.clear();
+    Booking booking = bookingService.getBookingById(bookingId);
+    if (booking.getBookingId() == 0) {
+        lastError = "Booking not found.";
+        return false;
+    }
+    if (!booking.isActive() && !booking.isOverdue()) {
+        lastError = "Only active or overdue bookings can be returned.";
+        return false;
+    }
+
+    booking.setStatus("Completed");
+    if (!bookingService.updateBooking(booking)) {
+        lastError = "Failed to update booking.";
+        return false;
+    }
+
+    Car car = carService.getCarById(booking.getCarId());
+    if (car.getCarId() != 0 && car.getStatus() == CarStatus::RENTED &&
+        !carInUseToday(car.getCarId(), Booking::today(), bookingId)) {
+        car.setStatus(CarStatus::AVAILABLE);
+        if (!carService.updateCar(car)) {
+            lastError = "Booking completed, but the car status could not be updated.";
+            return false;
+        }
+    }
+    return true;
+}
+
+// True when another booking that holds the car covers today
+bool LifecycleScheduler::carInUseToday(int carId, int today, int ignoreBookingId) {
+    return !bookingService.isCarAvailable(carId, today, today + 1, ignoreBookingId);
+}
+
+size_t LifecycleScheduler::getPendingEvents() const {
+    return heap.size();
+}
+
+const std::string& LifecycleScheduler::getLastError() const {
+    return lastError;
+}
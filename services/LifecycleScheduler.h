@@ -0,0 +1,88 @@
+#ifndef LIFECYCLESCHEDULER_H
+#define LIFECYCLESCHEDULER_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include <string>
+#include <vector>
+
+struct LifecycleTickResult {
+    int started;        // bookings whose car was switched to Rented
+    int completed;      // bookings moved to Completed
+    int overdue;        // bookings moved to Overdue
+    int carsUpdated;
+
+    LifecycleTickResult() : started(0), completed(0), overdue(0), carsUpdated(0) {}
+    bool hasChanges() const { return started + completed + overdue + carsUpdated > 0; }
+};
+
+// Moves bookings and car statuses forward as dates pass.
+//
+// Every active booking has a start event and an end event in a min-heap keyed
+// on the day they fall due. A tick pops only the events that are due, so an
+// idle tick costs one comparison. At the start day the car becomes Rented; at
+// the end day the booking becomes Overdue (or Completed when auto-complete is
+// on) and the car becomes Available again unless the booking is overdue or
+// another booking has the car today.
+//
+// Events are never removed: a popped event is checked against the booking's
+// current status and dates and dropped if the booking changed since it was
+// queued. Bookings added or edited through the BookingService are queued via
+// its change listener; a reload from disk rebuilds the heap.
+//
+// A tick reports changes only once both files are written. If the bookings
+// cannot be written, or the cars cannot and the bookings are put back, the
+// popped events return to the heap and the next tick tries again.
+class LifecycleScheduler {
+private:
+    enum class EventKind {
+        END,        // ordered before START so a same-day handover ends first
+        START
+    };
+
+    struct Event {
+        int day;
+        EventKind kind;
+        int bookingId;
+    };
+
+    struct EventLater {
+        bool operator()(const Event& a, const Event& b) const {
+            if (a.day != b.day) return a.day > b.day;
+            return a.kind > b.kind;
+        }
+    };
+
+    BookingService& bookingService;
+    CarService& carService;
+    bool autoComplete;
+    std::vector<Event> heap;
+    size_t loadGeneration;
+    std::string lastError;
+
+public:
+    LifecycleScheduler(BookingService& bookingService, CarService& carService);
+    ~LifecycleScheduler();
+
+    // When on, bookings past their end day are completed instead of marked overdue
+    void setAutoComplete(bool enabled);
+
+    // Process every event due on or before today (days since 1970-01-01)
+    LifecycleTickResult tick(int today);
+    LifecycleTickResult tick();
+
+    // Check a car back in: completes an active or overdue booking and frees the car
+    bool returnCar(int bookingId);
+
+    size_t getPendingEvents() const;
+    const std::string& getLastError() const;
+
+private:
+    void rebuild();
+    void schedule(const Booking& booking);
+    void push(int day, EventKind kind, int bookingId);
+    void requeue(const std::vector<Event>& events);
+    bool carInUseToday(int carId, int today, int ignoreBookingId);
+};
+
+#endif // LIFECYCLESCHEDULER_H
@@ -0,0 +1,160 @@
+#include "LogShipper.h"
+#include "../utils/LocalSocket.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+const int ACCEPT_POLL_MS = 200;
+const int WAIT_POLL_MS = 200;
+const int HEARTBEAT_MS = 1000;
+const int REQUEST_TIMEOUT_MS = 5000;
+const size_t BATCH_EVENTS = 512;
+
+} // namespace
+
+LogShipper::LogShipper(ChangeLog& log, const std::string& socketPath)
+    : log(log), socketPath(socketPath), listenFd(-1), stopping(false) {
+}
+
+LogShipper::~LogShipper() {
+    stop();
+}
+
+bool LogShipper::start() {
+    if (isRunning()) {
+        return true;
+    }
+    std::string error;
+    int fd = LocalSocket::listenAt(socketPath, error);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        lastError = error;
+        return false;
+    }
+    lastError.clear();
+    listenFd = fd;
+    stopping = false;
+    acceptThread = std::thread(&LogShipper::acceptLoop, this);
+    return true;
+}
+
+void LogShipper::stop() {
+    stopping = true;
+    if (acceptThread.joinable()) {
+        acceptThread.join();
+    }
+    std::vector<std::unique_ptr<Replica>> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing.swap(replicas);
+        if (listenFd >= 0) {
+            LocalSocket::close(listenFd);
+            listenFd = -1;
+        }
+    }
+    for (auto& replica : closing) {
+        LocalSocket::shutdown(replica->fd);
+        replica->thread.join();
+        LocalSocket::close(replica->fd);
+    }
+}
+
+void LogShipper::acceptLoop() {
+    while (!stopping) {
+        int fd = LocalSocket::acceptFrom(listenFd, ACCEPT_POLL_MS);
+        reapFinished();
+        if (fd < 0) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        replicas.push_back(std::make_unique<Replica>(fd));
+        Replica& replica = *replicas.back();
+        replica.thread = std::thread(&LogShipper::serve, this, std::ref(replica));
+    }
+}
+
+void LogShipper::reapFinished() {
+    std::vector<std::unique_ptr<Replica>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto split = std::stable_partition(replicas.begin(), replicas.end(),
+                                           [](const std::unique_ptr<Replica>& replica) { return !replica->done; });
+        std::move(split, replicas.end(), std::back_inserter(finished));
+        replicas.erase(split, replicas.end());
+    }
+    for (auto& replica : finished) {
+        replica->thread.join();
+        LocalSocket::close(replica->fd);
+    }
+}
+
+void LogShipper::serve(Replica& replica) {
+    LocalSocket::LineReader reader(replica.fd);
+    std::string request;
+    if (reader.readLine(request, REQUEST_TIMEOUT_MS) == LocalSocket::ReadStatus::LINE &&
+        request.compare(0, 5, "FROM ") == 0) {
+        ChangeCursor cursor(log, std::atoll(request.c_str() + 5));
+        replica.sentSequence = cursor.getNextSequence() - 1;
+        bool open = LocalSocket::sendAll(replica.fd, "HELLO " + std::to_string(log.getFirstSequence()) + " " +
+                                                         std::to_string(log.getLastSequence()) + "\n");
+
+        auto lastSent = std::chrono::steady_clock::now();
+        std::vector<ChangeEvent> events;
+        while (open && !stopping && cursor.poll(events, BATCH_EVENTS)) {
+            if (!events.empty()) {
+                std::string text;
+                for (const auto& event : events) {
+                    text += ChangeLog::toLine(event);
+                }
+                text += "HEAD " + std::to_string(log.getLastSequence()) + "\n";
+                open = LocalSocket::sendAll(replica.fd, text);
+                replica.sentSequence = events.back().sequence;
+                lastSent = std::chrono::steady_clock::now();
+                continue;
+            }
+            // Appends by another process are only seen by polling, hence the short wait
+            if (!log.waitForAppend(cursor.getNextSequence() - 1, WAIT_POLL_MS) &&
+                std::chrono::steady_clock::now() - lastSent >= std::chrono::milliseconds(HEARTBEAT_MS)) {
+                open = LocalSocket::sendAll(replica.fd, "HEAD " + std::to_string(log.getLastSequence()) + "\n");
+                lastSent = std::chrono::steady_clock::now();
+            }
+        }
+    }
+    replica.done = true; // Closed by whoever joins the thread, so the descriptor is never reused under it
+}
+
+bool LogShipper::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return listenFd >= 0;
+}
+
+size_t LogShipper::getReplicaCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<size_t>(std::count_if(replicas.begin(), replicas.end(),
+        [](const std::unique_ptr<Replica>& replica) { return !replica->done; }));
+}
+
+long long LogShipper::getSlowestSentSequence() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    long long slowest = 0;
+    bool any = false;
+    for (const auto& replica : replicas) {
+        if (replica->done) continue;
+        slowest = any ? std::min(slowest, replica->sentSequence.load()) : replica->sentSequence.load();
+        any = true;
+    }
+    return slowest;
+}
+
+const std::string& LogShipper::getSocketPath() const {
+    return socketPath;
+}
+
+std::string LogShipper::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
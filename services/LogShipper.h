@@ -0,0 +1,64 @@
+#ifndef LOGSHIPPER_H
+#define LOGSHIPPER_H
+
+#include "../database/ChangeLog.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Streams the change log to read replicas over a Unix domain socket.
+//
+// A replica connects and sends "FROM <sequence>". The shipper answers
+// "HELLO <first> <last>" with the log's current range, then sends every event
+// from that sequence on as change log lines, each batch followed by
+// "HEAD <last>" so the replica knows how far behind it is. Events appended in
+// this process are sent as soon as they are written; while nothing happens a
+// HEAD line goes out every second, which also notices replicas that went
+// away. Every replica has its own thread and cursor, so a slow replica holds
+// up neither the others nor the clerks.
+class LogShipper {
+private:
+    struct Replica {
+        int fd;
+        std::thread thread;
+        std::atomic<bool> done;
+        std::atomic<long long> sentSequence;
+
+        explicit Replica(int fd) : fd(fd), done(false), sentSequence(0) {}
+    };
+
+    ChangeLog& log;
+    std::string socketPath;
+    int listenFd;
+    std::atomic<bool> stopping;
+    std::thread acceptThread;
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Replica>> replicas;
+    std::string lastError;
+
+    void acceptLoop();
+    void serve(Replica& replica);
+    void reapFinished();
+
+public:
+    LogShipper(ChangeLog& log, const std::string& socketPath);
+    ~LogShipper();
+
+    LogShipper(const LogShipper&) = delete;
+    LogShipper& operator=(const LogShipper&) = delete;
+
+    bool start();
+    // Disconnects every replica; they catch up again once the shipper is back
+    void stop();
+    bool isRunning() const;
+    size_t getReplicaCount() const;
+    // Last sequence sent to the replica furthest behind, or 0 without replicas
+    long long getSlowestSentSequence() const;
+    const std::string& getSocketPath() const;
+    std::string getLastError() const;
+};
+
+#endif // LOGSHIPPER_H
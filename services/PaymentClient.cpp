@@ -0,0 +1,236 @@
+#include "PaymentClient.h"
+
+namespace {
+
+double millisecondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+PaymentClient::PaymentClient(PaymentGateway& gateway, PaymentLedger& ledger, const PaymentClientOptions& options)
+    : gateway(gateway), ledger(ledger), options(options), inFlight(0), unanswered(0), active(0), stopping(false) {
+    if (this->options.maxInFlight == 0) this->options.maxInFlight = 1;
+    if (this->options.maxAttempts < 1) this->options.maxAttempts = 1;
+    timerThread = std::thread(&PaymentClient::timerLoop, this);
+}
+
+PaymentClient::~PaymentClient() {
+    waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeTimer.notify_one();
+    timerThread.join();
+}
+
+std::future<PaymentOutcome> PaymentClient::submit(const AuthorizationRequest& request) {
+    auto call = std::make_shared<Call>();
+    call->request = request;
+    call->outcome.request = request;
+    call->started = std::chrono::steady_clock::now();
+    std::future<PaymentOutcome> future = call->promise.get_future();
+
+    // Paid before under this key: answer from the ledger
+    if (!request.idempotencyKey.empty() && ledger.hasKey(request.idempotencyKey)) {
+        PaymentRecordResult original = ledger.record(request.bookingId, PaymentType::CHARGE, request.amountCents,
+                                                     request.method, request.idempotencyKey);
+        PaymentOutcome& outcome = call->outcome;
+        outcome.result.status = AuthorizationStatus::APPROVED;
+        outcome.result.message = "Already charged";
+        outcome.recorded = original.success;
+        outcome.duplicate = original.duplicate;
+        outcome.entryId = original.entry.entryId;
+        outcome.error = original.error;
+        call->promise.set_value(outcome);
+        return future;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    active++;
+    queued.push_back(call);
+    startQueued(lock);
+    return future;
+}
+
+// Sends queued calls while there is room; the gateway is called without the lock
+void PaymentClient::startQueued(std::unique_lock<std::mutex>& lock) {
+    std::vector<std::pair<std::shared_ptr<Call>, unsigned>> starts;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+    while (inFlight < options.maxInFlight && !queued.empty()) {
+        std::shared_ptr<Call> call = queued.front();
+        queued.pop_front();
+        call->attempt++;
+        call->waiting = true;
+        call->outcome.attempts++;
+        inFlight++;
+        unanswered++;
+        timers.emplace(deadline, Timer{call, call->attempt, false});
+        starts.emplace_back(call, call->attempt);
+    }
+    if (starts.empty()) {
+        return;
+    }
+    wakeTimer.notify_one();
+
+    lock.unlock();
+    for (const auto& start : starts) {
+        std::shared_ptr<Call> call = start.first;
+        unsigned attempt = start.second;
+        gateway.authorize(call->request, [this, call, attempt](const AuthorizationResult& result) {
+            onAnswer(call, attempt, result);
+        });
+    }
+    lock.lock();
+}
+
+void PaymentClient::onAnswer(const std::shared_ptr<Call>& call, unsigned attempt, const AuthorizationResult& result) {
+    std::vector<std::shared_ptr<Call>> finished;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        unanswered--;
+        if (call->waiting && call->attempt == attempt) {
+            call->waiting = false;
+            inFlight--;
+            call->outcome.result = result;
+            if (result.status == AuthorizationStatus::FAILED) {
+                retryOrFinish(call, finished);
+            } else {
+                finished.push_back(call);
+            }
+            startQueued(lock);
+        }
+        if (active == 0 && unanswered == 0) {
+            idle.notify_all();
+        }
+    }
+    for (const auto& done : finished) {
+        finish(done);
+    }
+}
+
+// Called with the lock held after a failed or timed-out attempt
+void PaymentClient::retryOrFinish(const std::shared_ptr<Call>& call, std::vector<std::shared_ptr<Call>>& finished) {
+    if (call->outcome.attempts >= options.maxAttempts) {
+        finished.push_back(call);
+        return;
+    }
+    int delayMs = options.retryDelayMs << (call->outcome.attempts - 1);
+    timers.emplace(std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs),
+                   Timer{call, call->attempt, true});
+    wakeTimer.notify_one();
+}
+
+void PaymentClient::finish(const std::shared_ptr<Call>& call) {
+    PaymentOutcome& outcome = call->outcome;
+    if (outcome.result.status == AuthorizationStatus::APPROVED) {
+        PaymentRecordResult recorded = ledger.record(call->request.bookingId, PaymentType::CHARGE,
+                                                     call->request.amountCents, call->request.method,
+                                                     call->request.idempotencyKey);
+        outcome.recorded = recorded.success;
+        outcome.duplicate = recorded.duplicate;
+        outcome.entryId = recorded.entry.entryId;
+        if (!recorded.success) {
+            outcome.error = "Charged as " + outcome.result.reference + " but not recorded: " + recorded.error;
+        }
+    } else {
+        outcome.error = outcome.result.message;
+    }
+    outcome.elapsedMs = millisecondsSince(call->started);
+    call->promise.set_value(outcome);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    active--;
+    if (active == 0 && unanswered == 0) {
+        idle.notify_all();
+    }
+}
+
+void PaymentClient::timerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (timers.empty()) {
+            wakeTimer.wait(lock);
+            continue;
+        }
+        auto due = timers.begin()->first;
+        if (due > std::chrono::steady_clock::now()) {
+            wakeTimer.wait_until(lock, due);
+            continue;
+        }
+        Timer timer = timers.begin()->second;
+        timers.erase(timers.begin());
+
+        std::vector<std::shared_ptr<Call>> finished;
+        if (timer.retry) {
+            queued.push_front(timer.call);
+            startQueued(lock);
+        } else if (timer.call->waiting && timer.call->attempt == timer.attempt) {
+            // Abandon the attempt; its answer, if it ever comes, is ignored
+            timer.call->waiting = false;
+            inFlight--;
+            timer.call->outcome.result = AuthorizationResult();
+            timer.call->outcome.result.status = AuthorizationStatus::TIMED_OUT;
+            timer.call->outcome.result.message = "No answer within " + std::to_string(options.timeoutMs) + " ms";
+            retryOrFinish(timer.call, finished);
+            startQueued(lock);
+        }
+        if (!finished.empty()) {
+            lock.unlock();
+            for (const auto& done : finished) {
+                finish(done);
+            }
+            lock.lock();
+        }
+    }
+}
+
+SettlementRun PaymentClient::settle(const std::vector<AuthorizationRequest>& requests) {
+    SettlementRun run;
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::future<PaymentOutcome>> futures;
+    futures.reserve(requests.size());
+    for (const auto& request : requests) {
+        futures.push_back(submit(request));
+    }
+
+    run.outcomes.reserve(requests.size());
+    for (auto& future : futures) {
+        run.outcomes.push_back(future.get());
+        const PaymentOutcome& outcome = run.outcomes.back();
+        if (outcome.recorded && outcome.duplicate) {
+            run.duplicates++;
+        } else if (outcome.recorded) {
+            run.approved++;
+            run.chargedCents += outcome.request.amountCents;
+        } else if (outcome.result.status == AuthorizationStatus::DECLINED) {
+            run.declined++;
+        } else {
+            run.failed++;
+        }
+    }
+    run.elapsedMs = millisecondsSince(started);
+    return run;
+}
+
+void PaymentClient::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return active == 0 && unanswered == 0; });
+}
+
+const PaymentClientOptions& PaymentClient::getOptions() const {
+    return options;
+}
+
+void PaymentClient::setOptions(const PaymentClientOptions& options) {
+    std::unique_lock<std::mutex> lock(mutex);
+    this->options = options;
+    if (this->options.maxInFlight == 0) this->options.maxInFlight = 1;
+    if (this->options.maxAttempts < 1) this->options.maxAttempts = 1;
+    startQueued(lock);
+}
+
+PaymentGateway& PaymentClient::getGateway() {
+    return gateway;
+}
@@ -0,0 +1,120 @@
+#ifndef PAYMENTCLIENT_H
+#define PAYMENTCLIENT_H
+
+#include "PaymentGateway.h"
+#include "PaymentLedger.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PaymentClientOptions {
+    size_t maxInFlight;     // Authorizations waiting on the gateway at once
+    int timeoutMs;          // Per attempt
+    int maxAttempts;        // Failed and timed-out attempts are retried up to this many in total
+    int retryDelayMs;       // Doubled after each retry
+
+    PaymentClientOptions() : maxInFlight(32), timeoutMs(1000), maxAttempts(3), retryDelayMs(50) {}
+};
+
+struct PaymentOutcome {
+    AuthorizationRequest request;
+    AuthorizationResult result;     // Of the last attempt
+    int attempts;
+    bool recorded;                  // Charged and written to the ledger (now or by an earlier submission)
+    bool duplicate;                 // The key was already in the ledger; the gateway was not called
+    long long entryId;
+    double elapsedMs;
+    std::string error;
+
+    PaymentOutcome() : attempts(0), recorded(false), duplicate(false), entryId(0), elapsedMs(0) {}
+};
+
+struct SettlementRun {
+    std::vector<PaymentOutcome> outcomes;
+    size_t approved;
+    size_t declined;
+    size_t failed;
+    size_t duplicates;
+    long long chargedCents;
+    double elapsedMs;
+
+    SettlementRun() : approved(0), declined(0), failed(0), duplicates(0), chargedCents(0), elapsedMs(0) {}
+};
+
+// Runs card authorizations against a gateway with many in flight at once.
+//
+// submit() returns a future straight away. Up to maxInFlight requests wait on
+// the gateway together; the rest queue in submission order. An attempt that
+// gets no answer within timeoutMs is abandoned and, like a transient failure,
+// retried after a growing delay with the same idempotency key, so the gateway
+// never charges twice. A late answer to an abandoned attempt is ignored, and
+// an abandoned attempt stops counting against maxInFlight. Approved charges
+// are written to the ledger before the future is ready; keys already in the
+// ledger are answered from it without calling the gateway.
+//
+// Throughput is then bounded by maxInFlight / latency rather than 1 / latency.
+class PaymentClient {
+private:
+    struct Call {
+        AuthorizationRequest request;
+        std::promise<PaymentOutcome> promise;
+        PaymentOutcome outcome;
+        std::chrono::steady_clock::time_point started;
+        unsigned attempt;           // Identifies the attempt whose answer is awaited
+        bool waiting;               // An attempt is in flight
+
+        Call() : attempt(0), waiting(false) {}
+    };
+    struct Timer {
+        std::shared_ptr<Call> call;
+        unsigned attempt;
+        bool retry;                 // Otherwise a timeout
+    };
+
+    PaymentGateway& gateway;
+    PaymentLedger& ledger;
+    PaymentClientOptions options;
+
+    std::mutex mutex;
+    std::condition_variable wakeTimer;
+    std::condition_variable idle;
+    std::deque<std::shared_ptr<Call>> queued;
+    std::multimap<std::chrono::steady_clock::time_point, Timer> timers;
+    size_t inFlight;
+    size_t unanswered;              // Gateway callbacks still to come, including abandoned attempts
+    size_t active;                  // Submitted and not finished
+    bool stopping;
+    std::thread timerThread;
+
+    void startQueued(std::unique_lock<std::mutex>& lock);
+    void onAnswer(const std::shared_ptr<Call>& call, unsigned attempt, const AuthorizationResult& result);
+    void retryOrFinish(const std::shared_ptr<Call>& call, std::vector<std::shared_ptr<Call>>& finished);
+    void finish(const std::shared_ptr<Call>& call);
+    void timerLoop();
+
+public:
+    PaymentClient(PaymentGateway& gateway, PaymentLedger& ledger,
+                  const PaymentClientOptions& options = PaymentClientOptions());
+    // Waits for every submitted payment and every outstanding gateway answer
+    ~PaymentClient();
+
+    PaymentClient(const PaymentClient&) = delete;
+    PaymentClient& operator=(const PaymentClient&) = delete;
+
+    std::future<PaymentOutcome> submit(const AuthorizationRequest& request);
+    // Submits every request and waits for all of them; outcomes keep the request order
+    SettlementRun settle(const std::vector<AuthorizationRequest>& requests);
+    void waitIdle();
+
+    const PaymentClientOptions& getOptions() const;
+    void setOptions(const PaymentClientOptions& options);
+    PaymentGateway& getGateway();
+};
+
+#endif // PAYMENTCLIENT_H
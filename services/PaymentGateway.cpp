@@ -0,0 +1,111 @@
+#include "PaymentGateway.h"
+#include <algorithm>
+
+std::string PaymentGateway::statusToString(AuthorizationStatus status) {
+    switch (status) {
+        case AuthorizationStatus::APPROVED: return "Approved";
+        case AuthorizationStatus::DECLINED: return "Declined";
+        case AuthorizationStatus::FAILED: return "Failed";
+        case AuthorizationStatus::TIMED_OUT: return "Timed out";
+        default: return "Unknown";
+    }
+}
+
+SimulatedGateway::SimulatedGateway(const SimulatedGatewayOptions& options)
+    : options(options), random(options.seed), nextReference(1), stopping(false) {
+    worker = std::thread(&SimulatedGateway::workerLoop, this);
+}
+
+SimulatedGateway::~SimulatedGateway() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+
+    for (auto& request : pending) {
+        AuthorizationResult result;
+        result.status = AuthorizationStatus::FAILED;
+        result.message = "Gateway shut down";
+        request.done(result);
+    }
+}
+
+void SimulatedGateway::authorize(const AuthorizationRequest& request, Callback done) {
+    Pending call;
+    call.done = std::move(done);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        int latencyMs = std::uniform_int_distribution<int>(options.minLatencyMs,
+                                                           std::max(options.minLatencyMs, options.maxLatencyMs))(random);
+        call.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(latencyMs);
+
+        auto known = request.idempotencyKey.empty() ? outcomes.end() : outcomes.find(request.idempotencyKey);
+        if (known != outcomes.end()) {
+            call.result = known->second;
+        } else {
+            double draw = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+            if (request.amountCents <= 0) {
+                call.result.status = AuthorizationStatus::DECLINED;
+                call.result.message = "Invalid amount";
+            } else if (draw < options.failureRate) {
+                call.result.status = AuthorizationStatus::FAILED;
+                call.result.message = "Gateway temporarily unavailable";
+            } else if (draw < options.failureRate + options.declineRate) {
+                call.result.status = AuthorizationStatus::DECLINED;
+                call.result.message = "Card declined";
+            } else {
+                call.result.status = AuthorizationStatus::APPROVED;
+                call.result.reference = "SIM" + std::to_string(nextReference++);
+                call.result.message = "Approved";
+            }
+            if (call.result.status != AuthorizationStatus::FAILED && !request.idempotencyKey.empty()) {
+                outcomes[request.idempotencyKey] = call.result;
+            }
+        }
+
+        pending.push_back(std::move(call));
+        std::push_heap(pending.begin(), pending.end(),
+                       [](const Pending& a, const Pending& b) { return a.due > b.due; });
+    }
+    wake.notify_one();
+}
+
+std::string SimulatedGateway::getName() const {
+    return "Simulated (" + std::to_string(options.minLatencyMs) + "-" + std::to_string(options.maxLatencyMs) + " ms)";
+}
+
+const SimulatedGatewayOptions& SimulatedGateway::getOptions() const {
+    return options;
+}
+
+void SimulatedGateway::workerLoop() {
+    auto byDue = [](const Pending& a, const Pending& b) { return a.due > b.due; };
+    std::vector<Pending> ready;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (pending.empty()) {
+            wake.wait(lock);
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (pending.front().due > now) {
+            wake.wait_until(lock, pending.front().due);
+            continue;
+        }
+        while (!pending.empty() && pending.front().due <= now) {
+            std::pop_heap(pending.begin(), pending.end(), byDue);
+            ready.push_back(std::move(pending.back()));
+            pending.pop_back();
+        }
+
+        // Answer outside the lock; callbacks may start new requests
+        lock.unlock();
+        for (auto& call : ready) {
+            call.done(call.result);
+        }
+        ready.clear();
+        lock.lock();
+    }
+}
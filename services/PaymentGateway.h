@@ -0,0 +1,99 @@
+#ifndef PAYMENTGATEWAY_H
+#define PAYMENTGATEWAY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct AuthorizationRequest {
+    int bookingId;
+    long long amountCents;
+    std::string method;
+    std::string idempotencyKey;     // Also sent to the gateway, so a retried call is not charged twice
+
+    AuthorizationRequest() : bookingId(0), amountCents(0) {}
+};
+
+enum class AuthorizationStatus {
+    APPROVED,
+    DECLINED,       // Final: retrying will not help
+    FAILED,         // Transient gateway error; worth retrying
+    TIMED_OUT       // No answer in time; the charge may or may not have happened
+};
+
+struct AuthorizationResult {
+    AuthorizationStatus status;
+    std::string reference;          // Gateway transaction reference when approved
+    std::string message;
+
+    AuthorizationResult() : status(AuthorizationStatus::FAILED) {}
+};
+
+// A card processor. authorize() only starts the request: the result is
+// delivered to done exactly once, usually later and on another thread, so a
+// caller can keep many authorizations in flight without a thread for each.
+class PaymentGateway {
+public:
+    using Callback = std::function<void(const AuthorizationResult&)>;
+
+    virtual ~PaymentGateway() {}
+    virtual void authorize(const AuthorizationRequest& request, Callback done) = 0;
+    virtual std::string getName() const = 0;
+
+    static std::string statusToString(AuthorizationStatus status);
+};
+
+struct SimulatedGatewayOptions {
+    int minLatencyMs;
+    int maxLatencyMs;
+    double failureRate;     // Share of calls answered with a transient failure
+    double declineRate;     // Share of calls declined
+    unsigned seed;
+
+    SimulatedGatewayOptions() : minLatencyMs(100), maxLatencyMs(500), failureRate(0.05), declineRate(0.02), seed(1) {}
+};
+
+// Local stand-in for a real processor with configurable latency and failure
+// rates. Requests wait in a timer queue served by one thread, so any number
+// can be in flight at once. Like real gateways it remembers the outcome of
+// every idempotency key it approved or declined and replays it on a retry.
+class SimulatedGateway : public PaymentGateway {
+private:
+    struct Pending {
+        std::chrono::steady_clock::time_point due;
+        AuthorizationResult result;
+        Callback done;
+    };
+
+    SimulatedGatewayOptions options;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<Pending> pending;   // Min-heap on due
+    std::unordered_map<std::string, AuthorizationResult> outcomes;
+    std::mt19937 random;
+    long long nextReference;
+    bool stopping;
+    std::thread worker;
+
+    void workerLoop();
+
+public:
+    explicit SimulatedGateway(const SimulatedGatewayOptions& options = SimulatedGatewayOptions());
+    // Requests still waiting are answered with a failure
+    ~SimulatedGateway();
+
+    SimulatedGateway(const SimulatedGateway&) = delete;
+    SimulatedGateway& operator=(const SimulatedGateway&) = delete;
+
+    void authorize(const AuthorizationRequest& request, Callback done) override;
+    std::string getName() const override;
+    const SimulatedGatewayOptions& getOptions() const;
+};
+
+#endif // PAYMENTGATEWAY_H
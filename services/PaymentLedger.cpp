@@ -0,0 +1,190 @@
+#include "PaymentLedger.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/TimeUtils.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+const std::string HEADER = "EntryID,BookingID,Type,AmountCents,Method,Key,Timestamp,CRC";
+
+// Fields are written without quoting, so they may not contain separators
+bool isPlainField(const std::string& text) {
+    return text.find_first_of(",\r\n") == std::string::npos;
+}
+
+} // namespace
+
+PaymentLedger::PaymentLedger(const std::string& dataDirectory)
+    : file(dataDirectory + "/payments.csv", HEADER), entryCount(0), nextEntryId(1) {
+}
+
+bool PaymentLedger::load() {
+    std::lock_guard<std::mutex> lock(mutex);
+    file.clear();
+    return catchUp();
+}
+
+void PaymentLedger::clear() {
+    offsetByKey.clear();
+    balances.clear();
+    offsetsByBooking.clear();
+    entryCount = 0;
+    nextEntryId = 1;
+}
+
+// Reads whatever was appended since the last call; the caller holds the mutex
+bool PaymentLedger::catchUp() {
+    LedgerEntry entry;
+    return file.catchUp([this]() { clear(); }, [this, &entry](const std::string& line, long long offset) {
+        if (!parseLine(line, entry)) {
+            return false;
+        }
+        index(entry, offset);
+        return true;
+    }, lastError);
+}
+
+void PaymentLedger::index(const LedgerEntry& entry, long long offset) {
+    if (!entry.idempotencyKey.empty()) {
+        offsetByKey[entry.idempotencyKey] = offset;
+    }
+    PaymentBalance& balance = balances[entry.bookingId];
+    if (entry.type == PaymentType::CHARGE) {
+        balance.chargedCents += entry.amountCents;
+    } else {
+        balance.refundedCents += entry.amountCents;
+    }
+    balance.entries++;
+    offsetsByBooking[entry.bookingId].push_back(offset);
+    entryCount++;
+    if (entry.entryId >= nextEntryId) {
+        nextEntryId = entry.entryId + 1;
+    }
+}
+
+bool PaymentLedger::readEntry(long long offset, LedgerEntry& entry) const {
+    std::ifstream input(file.getPath(), std::ios::binary);
+    std::string line;
+    return input.is_open() && input.seekg(offset) && std::getline(input, line) && parseLine(line, entry);
+}
+
+PaymentRecordResult PaymentLedger::record(int bookingId, PaymentType type, long long amountCents,
+                                          const std::string& method, const std::string& idempotencyKey) {
+    std::lock_guard<std::mutex> lock(mutex);
+    PaymentRecordResult result;
+    if (!catchUp()) {
+        result.error = lastError;
+        return result;
+    }
+
+    if (!idempotencyKey.empty()) {
+        auto existing = offsetByKey.find(idempotencyKey);
+        if (existing != offsetByKey.end()) {
+            result.duplicate = true;
+            result.success = readEntry(existing->second, result.entry);
+            if (!result.success) result.error = "Cannot read the original payment for this key.";
+            return result;
+        }
+    }
+    if (bookingId <= 0 || amountCents <= 0) {
+        result.error = "A payment needs a booking and a positive amount.";
+        return result;
+    }
+    if (!isPlainField(method) || !isPlainField(idempotencyKey)) {
+        result.error = "Payment method and key may not contain commas or line breaks.";
+        return result;
+    }
+
+    LedgerEntry& entry = result.entry;
+    entry.entryId = nextEntryId;
+    entry.bookingId = bookingId;
+    entry.type = type;
+    entry.amountCents = amountCents;
+    entry.method = method;
+    entry.idempotencyKey = idempotencyKey;
+    entry.timestamp = TimeUtils::currentTimestamp();
+
+    long long offset = 0;
+    if (!file.append(toLine(entry), true, offset, result.error)) {
+        return result;
+    }
+    index(entry, offset);
+    result.success = true;
+    return result;
+}
+
+bool PaymentLedger::hasKey(const std::string& idempotencyKey) {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    return offsetByKey.count(idempotencyKey) > 0;
+}
+
+PaymentBalance PaymentLedger::getBalance(int bookingId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    auto it = balances.find(bookingId);
+    return it == balances.end() ? PaymentBalance() : it->second;
+}
+
+std::vector<LedgerEntry> PaymentLedger::getEntries(int bookingId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    std::vector<LedgerEntry> entries;
+    auto it = offsetsByBooking.find(bookingId);
+    if (it == offsetsByBooking.end()) {
+        return entries;
+    }
+    for (long long offset : it->second) {
+        LedgerEntry entry;
+        if (readEntry(offset, entry)) {
+            entries.push_back(entry);
+        }
+    }
+    return entries;
+}
+
+size_t PaymentLedger::getEntryCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    catchUp();
+    return entryCount;
+}
+
+const std::string& PaymentLedger::getLedgerFile() const {
+    return file.getPath();
+}
+
+std::string PaymentLedger::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastError;
+}
+
+std::string PaymentLedger::typeToString(PaymentType type) {
+    return type == PaymentType::REFUND ? "Refund" : "Charge";
+}
+
+std::string PaymentLedger::toLine(const LedgerEntry& entry) {
+    std::string body = std::to_string(entry.entryId) + "," + std::to_string(entry.bookingId) + "," +
+                       typeToString(entry.type) + "," + std::to_string(entry.amountCents) + "," + entry.method +
+                       "," + entry.idempotencyKey + "," + entry.timestamp;
+    return AppendOnlyFile::withChecksum(body, ',');
+}
+
+bool PaymentLedger::parseLine(const std::string& line, LedgerEntry& entry) {
+    if (AppendOnlyFile::checkedLength(line, ',') == std::string::npos) {
+        return false;
+    }
+    std::vector<std::string> fields;
+    CsvUtils::splitLine(line, fields);
+    if (fields.size() != 8 || (fields[2] != "Charge" && fields[2] != "Refund")) {
+        return false;
+    }
+    entry.entryId = std::atoll(fields[0].c_str());
+    entry.bookingId = std::atoi(fields[1].c_str());
+    entry.type = fields[2] == "Refund" ? PaymentType::REFUND : PaymentType::CHARGE;
+    entry.amountCents = std::atoll(fields[3].c_str());
+    entry.method = fields[4];
+    entry.idempotencyKey = fields[5];
+    entry.timestamp = fields[6];
+    return true;
+}
@@ -0,0 +1,94 @@
+#ifndef PAYMENTLEDGER_H
+#define PAYMENTLEDGER_H
+
+#include "../database/AppendOnlyFile.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class PaymentType {
+    CHARGE,
+    REFUND
+};
+
+struct LedgerEntry {
+    long long entryId;
+    int bookingId;
+    PaymentType type;
+    long long amountCents;      // Always positive; the type gives the direction
+    std::string method;
+    std::string idempotencyKey;
+    std::string timestamp;
+
+    LedgerEntry() : entryId(0), bookingId(0), type(PaymentType::CHARGE), amountCents(0) {}
+};
+
+struct PaymentBalance {
+    long long chargedCents;
+    long long refundedCents;
+    int entries;
+
+    PaymentBalance() : chargedCents(0), refundedCents(0), entries(0) {}
+    long long getPaidCents() const { return chargedCents - refundedCents; }
+};
+
+struct PaymentRecordResult {
+    bool success;
+    bool duplicate;             // The key was already used; entry is the original payment
+    LedgerEntry entry;
+    std::string error;
+
+    PaymentRecordResult() : success(false), duplicate(false) {}
+};
+
+// Append-only record of every charge and refund, in data/payments.csv.
+//
+// Entries are only ever added: each is one line ending in a CRC-32 of its
+// fields, appended and synced before record() returns. A torn final line (a
+// crash mid-append) is handled by AppendOnlyFile, as for the change log.
+// Every idempotency key seen is kept in a hash map, so a retried
+// submission is recognised in constant time and returns the original entry
+// instead of charging again. Per-booking totals and the file offsets of each
+// booking's entries are indexed as entries are read, so balance and history
+// queries never scan the ledger. Entries appended by another process are
+// picked up by reading only the new tail of the file.
+class PaymentLedger {
+private:
+    AppendOnlyFile file;
+    mutable std::mutex mutex;
+    std::string lastError;
+
+    std::unordered_map<std::string, long long> offsetByKey;
+    std::unordered_map<int, PaymentBalance> balances;
+    std::unordered_map<int, std::vector<long long>> offsetsByBooking;
+    size_t entryCount;
+    long long nextEntryId;
+
+    void clear();
+    bool catchUp();
+    void index(const LedgerEntry& entry, long long offset);
+    bool readEntry(long long offset, LedgerEntry& entry) const;
+
+public:
+    explicit PaymentLedger(const std::string& dataDirectory = "data");
+
+    bool load();
+    // Appends a charge or refund unless the key was used before. An empty key
+    // is never treated as a duplicate.
+    PaymentRecordResult record(int bookingId, PaymentType type, long long amountCents, const std::string& method,
+                               const std::string& idempotencyKey);
+    bool hasKey(const std::string& idempotencyKey);
+    PaymentBalance getBalance(int bookingId);
+    std::vector<LedgerEntry> getEntries(int bookingId);
+    size_t getEntryCount();
+
+    const std::string& getLedgerFile() const;
+    std::string getLastError() const;
+
+    static std::string typeToString(PaymentType type);
+    static std::string toLine(const LedgerEntry& entry);
+    static bool parseLine(const std::string& line, LedgerEntry& entry);
+};
+
+#endif // PAYMENTLEDGER_H
@@ -1,9 +1,40 @@
 #include "PaymentService.h"
+#include "../models/Booking.h"
+#include "../utils/BufferedWriter.h"
+#include <cmath>
 #include <iostream>
-#include <sstream>
 #include <iomanip>
 
 const double PaymentService::TAX_RATE = 0.08; // 8% tax rate
+const long long PaymentService::TAX_BASIS_POINTS = 800;
+
+namespace {
+
+void appendInt(std::string& out, long long value) {
+    char digits[24];
+    int length = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : value;
+    do {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) out += '-';
+    while (length > 0) out += digits[--length];
+}
+
+// 1234 -> "12.34", -5 -> "-0.05"
+void appendCents(std::string& out, long long cents) {
+    if (cents < 0) {
+        out += '-';
+        cents = -cents;
+    }
+    appendInt(out, cents / 100);
+    out += '.';
+    out += static_cast<char>('0' + cents % 100 / 10);
+    out += static_cast<char>('0' + cents % 10);
+}
+
+}
 
 bool PaymentService::processPayment(double amount, const std::string& paymentMethod) {
     if (!validatePayment(amount)) {
@@ -19,27 +50,107 @@ bool PaymentService::processPayment(double amount, const std::string& paymentMet
     return true;
 }
 
+PaymentRecordResult PaymentService::processPayment(PaymentLedger& ledger, int bookingId, double amount,
+                                                   const std::string& paymentMethod,
+                                                   const std::string& idempotencyKey) {
+    if (!validatePayment(amount)) {
+        PaymentRecordResult result;
+        result.error = "Payments must be more than $0.00 and at most $10000.00.";
+        return result;
+    }
+    return ledger.record(bookingId, PaymentType::CHARGE, toCents(amount), paymentMethod, idempotencyKey);
+}
+
 bool PaymentService::validatePayment(double amount) {
     return amount > 0.0 && amount <= 10000.0; // Basic validation
 }
 
 std::string PaymentService::generateReceipt(int bookingId, double amount, const std::string& paymentMethod) {
-    std::stringstream receipt;
-    double tax = amount * TAX_RATE;
-    double total = amount + tax;
-    
-    receipt << "=== PAYMENT RECEIPT ===" << std::endl;
-    receipt << "Booking ID: " << bookingId << std::endl;
-    receipt << "Base Amount: $" << std::fixed << std::setprecision(2) << amount << std::endl;
-    receipt << "Tax (" << (TAX_RATE * 100) << "%): $" << tax << std::endl;
-    receipt << "Total: $" << total << std::endl;
-    receipt << "Payment Method: " << paymentMethod << std::endl;
-    receipt << "Date: " << "2024-01-01" << std::endl; // In real app, use current date
-    receipt << "=========================" << std::endl;
-    
-    return receipt.str();
+    long long baseCents = toCents(amount);
+    std::string receipt;
+    appendReceipt(receipt, bookingId, baseCents, calculateTaxCents(baseCents), paymentMethod,
+                  Booking::daysToDate(Booking::today()));
+    return receipt;
 }
 
 double PaymentService::calculateTotalWithTax(double baseAmount) {
-    return baseAmount + (baseAmount * TAX_RATE);
+    long long baseCents = toCents(baseAmount);
+    return (baseCents + calculateTaxCents(baseCents)) / 100.0;
+}
+
+long long PaymentService::toCents(double amount) {
+    return std::llround(amount * 100.0);
+}
+
+long long PaymentService::calculateTaxCents(long long baseCents) {
+    long long tax = 0;
+    long long total = 0;
+    calculateTaxBatch(&baseCents, 1, &tax, &total);
+    return tax;
+}
+
+void PaymentService::calculateTaxBatch(const long long* baseCents, size_t count, long long* taxCents,
+                                       long long* totalCents) {
+    for (size_t i = 0; i < count; i++) {
+        long long scaled = baseCents[i] * TAX_BASIS_POINTS;
+        long long tax = (scaled + (scaled < 0 ? -5000 : 5000)) / 10000;
+        taxCents[i] = tax;
+        totalCents[i] = baseCents[i] + tax;
+    }
+}
+
+void PaymentService::appendReceipt(std::string& out, int bookingId, long long baseCents, long long taxCents,
+                                   const std::string& paymentMethod, const std::string& date) {
+    out += "=== PAYMENT RECEIPT ===\nBooking ID: ";
+    appendInt(out, bookingId);
+    out += "\nBase Amount: $";
+    appendCents(out, baseCents);
+    out += "\nTax (";
+    appendCents(out, TAX_BASIS_POINTS);
+    out += "%): $";
+    appendCents(out, taxCents);
+    out += "\nTotal: $";
+    appendCents(out, baseCents + taxCents);
+    out += "\nPayment Method: ";
+    out += paymentMethod;
+    out += "\nDate: ";
+    out += date;
+    out += "\n=========================\n";
+}
+
+SettlementResult PaymentService::writeSettlement(const std::string& path, const std::vector<int>& bookingIds,
+                                                 const std::vector<long long>& baseCents,
+                                                 const std::string& paymentMethod, const std::string& date) {
+    SettlementResult result;
+    if (bookingIds.size() != baseCents.size()) {
+        result.error = "Every booking needs exactly one amount.";
+        return result;
+    }
+
+    std::vector<long long> taxCents(baseCents.size());
+    std::vector<long long> totalCents(baseCents.size());
+    calculateTaxBatch(baseCents.data(), baseCents.size(), taxCents.data(), totalCents.data());
+
+    BufferedWriter writer(path);
+    if (!writer.isOpen()) {
+        result.error = "Cannot open " + path + " for writing.";
+        return result;
+    }
+    std::string receipt;
+    for (size_t i = 0; i < baseCents.size(); i++) {
+        receipt.clear();
+        appendReceipt(receipt, bookingIds[i], baseCents[i], taxCents[i], paymentMethod, date);
+        writer.write(receipt.data(), receipt.size());
+        result.baseCents += baseCents[i];
+        result.taxCents += taxCents[i];
+        result.totalCents += totalCents[i];
+    }
+    if (!writer.close()) {
+        result.error = "Failed to write " + path + ".";
+        return result;
+    }
+
+    result.receipts = baseCents.size();
+    result.success = true;
+    return result;
 }
@@ -1,17 +1,52 @@
 #ifndef PAYMENTSERVICE_H
 #define PAYMENTSERVICE_H
 
+#include "PaymentLedger.h"
+#include <cstddef>
 #include <string>
+#include <vector>
+
+struct SettlementResult {
+    bool success;
+    size_t receipts;
+    long long baseCents;
+    long long taxCents;
+    long long totalCents;
+    std::string error;
+
+    SettlementResult() : success(false), receipts(0), baseCents(0), taxCents(0), totalCents(0) {}
+};
 
 class PaymentService {
 public:
     static bool processPayment(double amount, const std::string& paymentMethod);
+    // Validates the amount and records the charge in the ledger. Resubmitting
+    // with the same idempotency key returns the first charge instead of a new one.
+    static PaymentRecordResult processPayment(PaymentLedger& ledger, int bookingId, double amount,
+                                              const std::string& paymentMethod, const std::string& idempotencyKey);
     static bool validatePayment(double amount);
     static std::string generateReceipt(int bookingId, double amount, const std::string& paymentMethod);
     static double calculateTotalWithTax(double baseAmount);
     
+    // Fixed-point versions: amounts are integer cents and tax is rounded half
+    // away from zero once per amount, so totals add up to the cent
+    static long long toCents(double amount);
+    static long long calculateTaxCents(long long baseCents);
+    // taxCents[i] and totalCents[i] for each baseCents[i]; a branch-free loop over the arrays
+    static void calculateTaxBatch(const long long* baseCents, size_t count, long long* taxCents,
+                                  long long* totalCents);
+    // Appends one receipt to out, formatting the numbers by hand instead of through a stream
+    static void appendReceipt(std::string& out, int bookingId, long long baseCents, long long taxCents,
+                              const std::string& paymentMethod, const std::string& date);
+    
+    // Writes a receipt for every amount to one file and totals them
+    static SettlementResult writeSettlement(const std::string& path, const std::vector<int>& bookingIds,
+                                            const std::vector<long long>& baseCents,
+                                            const std::string& paymentMethod, const std::string& date);
+    
 private:
     static const double TAX_RATE;
+    static const long long TAX_BASIS_POINTS;
 };
 
 #endif // PAYMENTSERVICE_H
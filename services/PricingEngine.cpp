@@ -0,0 +1,277 @@
+#include "PricingEngine.h"
+#include "../models/Booking.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/ScanKernels.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+const int64_t BASIS_POINTS = 10000;
+
+// MMDD for a day number
+int monthDayOf(int day) {
+    std::string date = Booking::daysToDate(day);
+    return std::atoi(date.substr(5, 2).c_str()) * 100 + std::atoi(date.substr(8, 2).c_str());
+}
+
+// 0 is Sunday; day 0 (1970-01-01) was a Thursday
+int weekdayOf(int day) {
+    return ((day % 7) + 11) % 7;
+}
+
+bool parseMonthDay(const std::string& text, int& monthDay) {
+    int month = 0, day = 0;
+    char extra;
+    if (std::sscanf(text.c_str(), "%d-%d%c", &month, &day, &extra) != 2 || month < 1 || month > 12 ||
+        day < 1 || day > 31) {
+        return false;
+    }
+    monthDay = month * 100 + day;
+    return true;
+}
+
+bool parsePercent(const std::string& text, int& percent) {
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value < 1 || value > 1000) {
+        return false;
+    }
+    percent = static_cast<int>(value);
+    return true;
+}
+
+int64_t toCents(double amount) {
+    return static_cast<int64_t>(std::llround(amount * 100.0));
+}
+
+}
+
+PricingEngine::PricingEngine(const std::string& rulesFile)
+    : rulesFile(rulesFile), rules(defaultRules()), firstDay(0), tableDays(0) {
+    compile();
+}
+
+bool PricingEngine::load() {
+    lastError.clear();
+    std::ifstream file(rulesFile);
+    if (!file.is_open()) {
+        rules = defaultRules();
+        compile();
+        if (!save()) {
+            lastError = "Failed to write " + rulesFile + ".";
+            return false;
+        }
+        return true;
+    }
+
+    PricingRules loaded;
+    std::string line;
+    std::vector<std::string> fields;
+    int lineNumber = 1;
+    std::getline(file, line); // Header
+    while (std::getline(file, line)) {
+        lineNumber++;
+        if (line.empty()) continue;
+        CsvUtils::splitLine(line, fields);
+        fields.resize(4);
+        const std::string& kind = fields[0];
+        int percent = 0;
+        bool ok = parsePercent(fields[3], percent);
+        if (ok && kind == "Season") {
+            SeasonRule season;
+            ok = parseMonthDay(fields[1], season.fromMonthDay) && parseMonthDay(fields[2], season.toMonthDay);
+            season.percent = percent;
+            loaded.seasons.push_back(season);
+        } else if (ok && kind == "Weekend") {
+            loaded.weekendPercent = percent;
+        } else if (ok && kind == "Fuel") {
+            FuelType fuelType = Car::stringToFuelType(fields[1]);
+            ok = Car::fuelTypeToString(fuelType) == fields[1];
+            loaded.fuelPercent[static_cast<int>(fuelType)] = percent;
+        } else if (ok && kind == "Duration") {
+            DurationTier tier(std::atoi(fields[1].c_str()), percent);
+            ok = tier.minDays > 0;
+            loaded.durationTiers.push_back(tier);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            lastError = rulesFile + " line " + std::to_string(lineNumber) + ": invalid rule '" + line + "'.";
+            return false;
+        }
+    }
+
+    rules = loaded;
+    compile();
+    return true;
+}
+
+bool PricingEngine::save() const {
+    std::ofstream file(rulesFile);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << "Rule,From,To,Percent\n";
+    for (const auto& season : rules.seasons) {
+        file << "Season," << formatMonthDay(season.fromMonthDay) << "," << formatMonthDay(season.toMonthDay) << ","
+             << season.percent << "\n";
+    }
+    file << "Weekend,,," << rules.weekendPercent << "\n";
+    for (int fuel = 0; fuel < CLASS_COUNT; fuel++) {
+        file << "Fuel," << Car::fuelTypeToString(static_cast<FuelType>(fuel)) << ",," << rules.fuelPercent[fuel]
+             << "\n";
+    }
+    for (const auto& tier : rules.durationTiers) {
+        file << "Duration," << tier.minDays << ",," << tier.percent << "\n";
+    }
+    file.close();
+    return static_cast<bool>(file);
+}
+
+const PricingRules& PricingEngine::getRules() const {
+    return rules;
+}
+
+void PricingEngine::setRules(const PricingRules& rules) {
+    this->rules = rules;
+    compile();
+}
+
+void PricingEngine::compile() {
+    int year = std::atoi(Booking::daysToDate(Booking::today()).substr(0, 4).c_str());
+    firstDay = Booking::dateToDays(std::to_string(year - 1) + "-01-01");
+    tableDays = Booking::dateToDays(std::to_string(year + 3) + "-01-01") - firstDay;
+
+    for (int carClass = 0; carClass < CLASS_COUNT; carClass++) {
+        prefix[carClass].assign(tableDays + 1, 0);
+    }
+    for (int offset = 0; offset < tableDays; offset++) {
+        for (int carClass = 0; carClass < CLASS_COUNT; carClass++) {
+            prefix[carClass][offset + 1] = prefix[carClass][offset] + dayFactor(carClass, firstDay + offset);
+        }
+    }
+}
+
+// The day's rate as a share of the base rate, in basis points
+int64_t PricingEngine::dayFactor(int carClass, int day) const {
+    int64_t seasonPercent = 100;
+    int monthDay = monthDayOf(day);
+    for (const auto& season : rules.seasons) {
+        bool inSeason = season.fromMonthDay <= season.toMonthDay
+                            ? monthDay >= season.fromMonthDay && monthDay <= season.toMonthDay
+                            : monthDay >= season.fromMonthDay || monthDay <= season.toMonthDay;
+        if (inSeason) {
+            seasonPercent = season.percent;
+            break;
+        }
+    }
+    int weekday = weekdayOf(day);
+    int64_t weekendPercent = weekday == 0 || weekday == 6 ? rules.weekendPercent : 100;
+    int64_t product = seasonPercent * weekendPercent * rules.fuelPercent[carClass];   // In millionths
+    return (product + 50) / 100;
+}
+
+int64_t PricingEngine::rangeFactor(int carClass, int startDay, int endDay) const {
+    int tableEnd = firstDay + tableDays;
+    int64_t total = 0;
+    int from = startDay > firstDay ? startDay : firstDay;
+    int to = endDay < tableEnd ? endDay : tableEnd;
+    if (from < to) {
+        total += prefix[carClass][to - firstDay] - prefix[carClass][from - firstDay];
+    }
+    for (int day = startDay; day < endDay && day < firstDay; day++) {
+        total += dayFactor(carClass, day);
+    }
+    for (int day = startDay > tableEnd ? startDay : tableEnd; day < endDay; day++) {
+        total += dayFactor(carClass, day);
+    }
+    return total;
+}
+
+int PricingEngine::durationPercent(int days) const {
+    int percent = 100;
+    int bestMinDays = 0;
+    for (const auto& tier : rules.durationTiers) {
+        if (tier.minDays <= days && tier.minDays > bestMinDays) {
+            bestMinDays = tier.minDays;
+            percent = tier.percent;
+        }
+    }
+    return percent;
+}
+
+long long PricingEngine::quoteCents(const Car& car, int startDay, int endDay) const {
+    if (endDay <= startDay) {
+        return 0;
+    }
+    int64_t rateCents = toCents(car.getDailyRate());
+    uint8_t carClass = static_cast<uint8_t>(car.getFuelType());
+    int64_t total = 0;
+    quoteBatch(&rateCents, &carClass, 1, startDay, endDay, &total);
+    return total;
+}
+
+double PricingEngine::quote(const Car& car, const std::string& startDate, const std::string& endDate) const {
+    return quoteCents(car, Booking::dateToDays(startDate), Booking::dateToDays(endDate)) / 100.0;
+}
+
+std::vector<double> PricingEngine::quoteAll(const std::vector<Car>& cars, const std::string& startDate,
+                                            const std::string& endDate) const {
+    std::vector<int64_t> rateCents(cars.size());
+    std::vector<uint8_t> carClasses(cars.size());
+    for (size_t i = 0; i < cars.size(); i++) {
+        rateCents[i] = toCents(cars[i].getDailyRate());
+        carClasses[i] = static_cast<uint8_t>(cars[i].getFuelType());
+    }
+
+    std::vector<int64_t> cents(cars.size());
+    quoteBatch(rateCents.data(), carClasses.data(), cars.size(), Booking::dateToDays(startDate),
+               Booking::dateToDays(endDate), cents.data());
+
+    std::vector<double> quotes(cars.size());
+    for (size_t i = 0; i < cars.size(); i++) {
+        quotes[i] = cents[i] / 100.0;
+    }
+    return quotes;
+}
+
+void PricingEngine::quoteBatch(const int64_t* rateCents, const uint8_t* carClasses, size_t count, int startDay,
+                               int endDay, int64_t* outCents) const {
+    // Everything that depends only on the dates is worked out once per class
+    int64_t factors[CLASS_COUNT] = {};
+    if (endDay > startDay) {
+        int64_t lengthPercent = durationPercent(endDay - startDay);
+        for (int carClass = 0; carClass < CLASS_COUNT; carClass++) {
+            factors[carClass] = rangeFactor(carClass, startDay, endDay) * lengthPercent;
+        }
+    }
+    ScanKernels::scaleByKey(rateCents, carClasses, count, factors, CLASS_COUNT, BASIS_POINTS * 100, outCents);
+}
+
+const std::string& PricingEngine::getRulesFile() const {
+    return rulesFile;
+}
+
+std::string PricingEngine::getLastError() const {
+    return lastError;
+}
+
+PricingRules PricingEngine::defaultRules() {
+    PricingRules rules;
+    rules.seasons.push_back(SeasonRule(1220, 103, 125));    // Holidays
+    rules.seasons.push_back(SeasonRule(615, 831, 115));     // Summer
+    rules.weekendPercent = 110;
+    rules.fuelPercent[static_cast<int>(FuelType::ELECTRIC)] = 105;
+    rules.durationTiers.push_back(DurationTier(7, 90));
+    rules.durationTiers.push_back(DurationTier(28, 80));
+    return rules;
+}
+
+std::string PricingEngine::formatMonthDay(int monthDay) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%02d-%02d", monthDay / 100, monthDay % 100);
+    return buffer;
+}
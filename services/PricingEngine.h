@@ -0,0 +1,90 @@
+#ifndef PRICINGENGINE_H
+#define PRICINGENGINE_H
+
+#include "../models/Car.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Percentages are of the car's base daily rate, so 100 leaves it unchanged
+struct SeasonRule {
+    int fromMonthDay;   // MMDD, inclusive; a season may wrap the new year
+    int toMonthDay;
+    int percent;
+
+    SeasonRule() : fromMonthDay(101), toMonthDay(1231), percent(100) {}
+    SeasonRule(int fromMonthDay, int toMonthDay, int percent)
+        : fromMonthDay(fromMonthDay), toMonthDay(toMonthDay), percent(percent) {}
+};
+
+struct DurationTier {
+    int minDays;
+    int percent;
+
+    DurationTier() : minDays(1), percent(100) {}
+    DurationTier(int minDays, int percent) : minDays(minDays), percent(percent) {}
+};
+
+struct PricingRules {
+    std::vector<SeasonRule> seasons;            // The first season containing a day applies
+    int weekendPercent;                         // Saturdays and Sundays
+    int fuelPercent[4];                         // Indexed by FuelType
+    std::vector<DurationTier> durationTiers;    // The tier with the largest minDays <= days applies
+
+    PricingRules() : weekendPercent(100), fuelPercent{100, 100, 100, 100} {}
+};
+
+// Quotes rentals from season, weekend, fuel-type and rental-length rules.
+//
+// The rules are compiled once into a table per car class (fuel type) holding
+// a running total of each day's rate factor, in basis points, over a window
+// from the start of last year to the end of the year after next. The price
+// of any range inside the window is then the difference of two table entries
+// times the car's rate, whatever the length of the rental; days outside the
+// window are priced one by one. All arithmetic is in integer cents, so a
+// batch quote matches the single quote for the same car exactly.
+class PricingEngine {
+private:
+    static const int CLASS_COUNT = 4;
+
+    std::string rulesFile;
+    PricingRules rules;
+    std::string lastError;
+    int firstDay;                               // Day number of the first table entry
+    int tableDays;
+    std::vector<int64_t> prefix[CLASS_COUNT];   // prefix[c][d]: factors of days [firstDay, firstDay + d)
+
+    void compile();
+    int64_t dayFactor(int carClass, int day) const;
+    int64_t rangeFactor(int carClass, int startDay, int endDay) const;
+    int durationPercent(int days) const;
+
+public:
+    explicit PricingEngine(const std::string& rulesFile = "data/pricing.csv");
+
+    // Reads the rules file, writing the default rules when there is none yet.
+    // On a malformed file the previous rules stay in effect.
+    bool load();
+    bool save() const;
+    const PricingRules& getRules() const;
+    void setRules(const PricingRules& rules);
+
+    // Price in cents of renting the car for the days [startDay, endDay)
+    long long quoteCents(const Car& car, int startDay, int endDay) const;
+    double quote(const Car& car, const std::string& startDate, const std::string& endDate) const;
+
+    // Prices for every car over the same dates, in the order given. Each car
+    // costs one table lookup, one multiply and one divide over plain arrays.
+    std::vector<double> quoteAll(const std::vector<Car>& cars, const std::string& startDate,
+                                 const std::string& endDate) const;
+    void quoteBatch(const int64_t* rateCents, const uint8_t* carClasses, size_t count, int startDay, int endDay,
+                    int64_t* outCents) const;
+
+    const std::string& getRulesFile() const;
+    std::string getLastError() const;
+
+    static PricingRules defaultRules();
+    static std::string formatMonthDay(int monthDay);
+};
+
+#endif // PRICINGENGINE_H
@@ -0,0 +1,274 @@
+#include "ReadReplica.h"
+#include "../database/PartitionedFile.h"
+#include "../database/SlotFile.h"
+#include "../utils/LocalSocket.h"
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+const int READ_TIMEOUT_MS = 3000;       // The primary sends a heartbeat every second
+const int RECONNECT_DELAY_MS = 1000;
+const int SAVE_INTERVAL_SECONDS = 5;
+
+double secondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+ReadReplica::ReadReplica(const std::string& primaryDirectory, const std::string& replicaDirectory,
+                         const std::string& socketPath)
+    : primaryDirectory(primaryDirectory), replicaDirectory(replicaDirectory), socketPath(socketPath),
+      stateFile(replicaDirectory + "/replica.csv"), persistence(Durability::ASYNC),
+      carService(replicaDirectory), customerService(replicaDirectory), bookingService(replicaDirectory),
+      reseedNeeded(false), connected(false), socketFd(-1), appliedSequence(0), receivedSequence(0),
+      primarySequence(0), connects(0), reseeds(0), lastContact(std::chrono::steady_clock::now()),
+      lastCaughtUp(lastContact), lastSaved(lastContact), stopping(false) {
+    carService.setPersistenceQueue(&persistence);
+    customerService.setPersistenceQueue(&persistence);
+    bookingService.setPersistenceQueue(&persistence);
+}
+
+ReadReplica::~ReadReplica() {
+    stop();
+}
+
+bool ReadReplica::start() {
+    FileManager fileManager(replicaDirectory);
+    if (!fileManager.createDirectory(replicaDirectory)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        lastError = "Cannot create " + replicaDirectory + ".";
+        return false;
+    }
+    if (!loadState()) {
+        if (!seed()) {
+            return false;
+        }
+        saveState();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        receivedSequence = appliedSequence;
+        primarySequence = appliedSequence;
+    }
+    stopping = false;
+    receiver = std::thread(&ReadReplica::receiveLoop, this);
+    return true;
+}
+
+void ReadReplica::stop() {
+    if (!receiver.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        LocalSocket::shutdown(socketFd);
+    }
+    wake.notify_all();
+    receiver.join();
+    applyPending();
+    persistence.flush();
+    saveState();
+}
+
+// Copies the primary's rows into the replica's stores; the caller replays the log from the start
+bool ReadReplica::seed() {
+    std::vector<Car> cars;
+    SlotFile(primaryDirectory + "/cars.csv").load([&cars](const std::string& row) {
+        Car car = CarService::parseCarFromLine(row);
+        if (car.getCarId() > 0) cars.push_back(car);
+    });
+    std::vector<Customer> customers;
+    SlotFile(primaryDirectory + "/customers.csv").load([&customers](const std::string& row) {
+        Customer customer = CustomerService::parseCustomerFromLine(row);
+        if (customer.getCustomerId() > 0) customers.push_back(customer);
+    });
+    std::vector<Booking> bookings;
+    auto addBooking = [&bookings](const std::string& row) {
+        Booking booking = BookingService::parseBookingFromLine(row);
+        if (booking.getBookingId() > 0) bookings.push_back(booking);
+    };
+    PartitionedFile partitions(primaryDirectory + "/bookings", "");
+    if (partitions.exists()) {
+        partitions.load(nullptr, addBooking);
+    } else {
+        SlotFile(primaryDirectory + "/bookings.csv").load(addBooking);
+    }
+
+    bool ok = carService.saveCars(cars) && customerService.saveCustomers(customers) &&
+              bookingService.saveBookings(bookings);
+    persistence.flush();
+    std::lock_guard<std::mutex> lock(mutex);
+    appliedSequence = 0;
+    if (!ok) {
+        lastError = "Cannot write the replica's data files in " + replicaDirectory + ".";
+    }
+    return ok;
+}
+
+bool ReadReplica::loadState() {
+    std::ifstream file(stateFile);
+    std::string line;
+    if (!std::getline(file, line) || !std::getline(file, line)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    appliedSequence = std::atoll(line.c_str());
+    return true;
+}
+
+// Only called once the stores' queued writes have landed, so the files hold everything up to the sequence
+bool ReadReplica::saveState() {
+    long long sequence;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sequence = appliedSequence;
+        lastSaved = std::chrono::steady_clock::now();
+    }
+    std::ofstream file(stateFile);
+    file << "AppliedSequence\n" << sequence << "\n";
+    file.close();
+    return static_cast<bool>(file);
+}
+
+void ReadReplica::requestReseed() {
+    reseedNeeded = true;
+    pending.clear();
+    receivedSequence = 0;
+    primarySequence = 0;
+}
+
+void ReadReplica::receiveLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        long long from = receivedSequence + 1;
+        lock.unlock();
+        std::string error;
+        int fd = LocalSocket::connectTo(socketPath, error);
+        bool sent = fd >= 0 && LocalSocket::sendAll(fd, "FROM " + std::to_string(from) + "\n");
+        lock.lock();
+        if (!sent) {
+            LocalSocket::close(fd);
+            lastError = error.empty() ? "Lost the connection to the primary." : error;
+            wake.wait_for(lock, std::chrono::milliseconds(RECONNECT_DELAY_MS), [this]() { return stopping.load(); });
+            continue;
+        }
+        socketFd = fd;
+        connected = true;
+        connects++;
+        lastError.clear();
+        lastContact = std::chrono::steady_clock::now();
+
+        LocalSocket::LineReader reader(fd);
+        std::string line;
+        ChangeEvent event;
+        while (!stopping) {
+            lock.unlock();
+            LocalSocket::ReadStatus status = reader.readLine(line, READ_TIMEOUT_MS);
+            lock.lock();
+            if (status != LocalSocket::ReadStatus::LINE) {
+                lastError = status == LocalSocket::ReadStatus::TIMEOUT ? "The primary stopped answering."
+                                                                       : "The primary closed the connection.";
+                break;
+            }
+            lastContact = std::chrono::steady_clock::now();
+            if (line.compare(0, 6, "HELLO ") == 0 || line.compare(0, 5, "HEAD ") == 0) {
+                // HELLO <first> <last> and HEAD <last> both end with the primary's last sequence
+                long long last = std::atoll(line.c_str() + line.rfind(' ') + 1);
+                if (last < receivedSequence) {
+                    requestReseed();
+                    break; // Ask again from the start of the new log
+                }
+                primarySequence = last;
+            } else if (ChangeLog::parseLine(line, event)) {
+                if (event.sequence > receivedSequence) {
+                    receivedSequence = event.sequence;
+                    pending.push_back(event);
+                }
+            } else {
+                lastError = "Received a damaged event; reconnecting.";
+                break;
+            }
+        }
+        socketFd = -1;
+        connected = false;
+        lock.unlock();
+        LocalSocket::close(fd);
+        lock.lock();
+    }
+}
+
+size_t ReadReplica::applyPending() {
+    std::vector<ChangeEvent> batch;
+    bool reseed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batch.swap(pending);
+        reseed = reseedNeeded;
+        reseedNeeded = false;
+    }
+    if (reseed) {
+        seed();
+        std::lock_guard<std::mutex> lock(mutex);
+        reseeds++;
+    }
+
+    if (!batch.empty()) {
+        bool ok = carService.applyChanges(batch) && customerService.applyChanges(batch) &&
+                  bookingService.applyChanges(batch);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ok) {
+            appliedSequence = batch.back().sequence;
+        } else {
+            lastError = "Cannot write the replica's data files in " + replicaDirectory + ".";
+        }
+    }
+
+    bool save;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (appliedSequence >= primarySequence) {
+            lastCaughtUp = std::chrono::steady_clock::now();
+        }
+        save = reseed || secondsSince(lastSaved) >= SAVE_INTERVAL_SECONDS;
+    }
+    if (save) {
+        persistence.flush();
+        saveState();
+    }
+    return batch.size();
+}
+
+ReplicaStatus ReadReplica::getStatus() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ReplicaStatus status;
+    status.connected = connected;
+    status.appliedSequence = appliedSequence;
+    status.receivedSequence = receivedSequence;
+    status.primarySequence = primarySequence;
+    status.eventsBehind = primarySequence > appliedSequence ? primarySequence - appliedSequence : 0;
+    status.secondsBehind = status.eventsBehind > 0 ? secondsSince(lastCaughtUp) : 0.0;
+    status.secondsSinceContact = secondsSince(lastContact);
+    status.connects = connects;
+    status.reseeds = reseeds;
+    status.lastError = lastError;
+    return status;
+}
+
+CarService& ReadReplica::getCarService() {
+    return carService;
+}
+
+CustomerService& ReadReplica::getCustomerService() {
+    return customerService;
+}
+
+BookingService& ReadReplica::getBookingService() {
+    return bookingService;
+}
+
+const std::string& ReadReplica::getSocketPath() const {
+    return socketPath;
+}
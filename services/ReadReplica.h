@@ -0,0 +1,107 @@
+#ifndef READREPLICA_H
+#define READREPLICA_H
+
+#include "CarService.h"
+#include "CustomerService.h"
+#include "BookingService.h"
+#include "../database/ChangeLog.h"
+#include "../database/PersistenceQueue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReplicaStatus {
+    bool connected;
+    long long appliedSequence;      // Last event applied to the stores
+    long long receivedSequence;     // Last event received from the primary
+    long long primarySequence;      // Last event the primary reported having
+    long long eventsBehind;         // primarySequence - appliedSequence
+    double secondsBehind;           // Since the stores last held everything the primary had
+    double secondsSinceContact;     // Since the primary was last heard from
+    size_t connects;
+    size_t reseeds;
+    std::string lastError;
+
+    ReplicaStatus()
+        : connected(false), appliedSequence(0), receivedSequence(0), primarySequence(0), eventsBehind(0),
+          secondsBehind(0), secondsSinceContact(0), connects(0), reseeds(0) {}
+};
+
+// Read-only copy of a primary's cars, customers and bookings, kept current
+// from the primary's change log, which a LogShipper streams over a Unix
+// domain socket.
+//
+// The replica has its own data files, in data/replica by default. The first
+// time, they are seeded from the primary's data files and the whole change
+// log is replayed over them: every event carries the full row, so replaying
+// changes the files already hold ends in the same state. A background thread
+// receives events and queues them; applyPending() applies them on the thread
+// that runs queries, so a query never sees half a batch. The last applied
+// sequence is saved in replica.csv every few seconds and on shutdown, and after
+// a disconnect or restart the replica asks for the events after the last one it
+// has. If the primary's log turns out to be behind the replica (it was reset),
+// the replica seeds itself again.
+class ReadReplica {
+private:
+    std::string primaryDirectory;
+    std::string replicaDirectory;
+    std::string socketPath;
+    std::string stateFile;
+
+    // Declared before the services, which write through it
+    PersistenceQueue persistence;
+    CarService carService;
+    CustomerService customerService;
+    BookingService bookingService;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<ChangeEvent> pending;
+    bool reseedNeeded;
+    bool connected;
+    int socketFd;
+    long long appliedSequence;
+    long long receivedSequence;
+    long long primarySequence;
+    size_t connects;
+    size_t reseeds;
+    std::string lastError;
+    std::chrono::steady_clock::time_point lastContact;
+    std::chrono::steady_clock::time_point lastCaughtUp;
+    std::chrono::steady_clock::time_point lastSaved;
+    std::atomic<bool> stopping;
+    std::thread receiver;
+
+    void receiveLoop();
+    // Called with the lock held when the primary's log is behind the replica
+    void requestReseed();
+    bool seed();
+    bool loadState();
+    bool saveState();
+
+public:
+    ReadReplica(const std::string& primaryDirectory, const std::string& replicaDirectory,
+                const std::string& socketPath);
+    ~ReadReplica();
+
+    ReadReplica(const ReadReplica&) = delete;
+    ReadReplica& operator=(const ReadReplica&) = delete;
+
+    // Seeds the stores on first use and starts receiving
+    bool start();
+    void stop();
+    // Applies the received events; returns how many
+    size_t applyPending();
+    ReplicaStatus getStatus();
+
+    CarService& getCarService();
+    CustomerService& getCustomerService();
+    BookingService& getBookingService();
+    const std::string& getSocketPath() const;
+};
+
+#endif // READREPLICA_H
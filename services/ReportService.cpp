@@ -0,0 +1,67 @@
+#include "ReportService.h"
+#include <algorithm>
+#include <map>
+
+namespace {
+
+std::vector<std::pair<std::string, RevenueTotal>> rangeOf(const std::map<std::string, RevenueTotal>& totals,
+                                                          const std::string& from, const std::string& to) {
+    std::vector<std::pair<std::string, RevenueTotal>> results;
+    auto it = from.empty() ? totals.begin() : totals.lower_bound(from);
+    for (; it != totals.end(); ++it) {
+        if (!to.empty() && it->first > to) break;
+        results.push_back(*it);
+    }
+    return results;
+}
+
+std::vector<std::pair<int, RevenueTotal>> topOf(const std::unordered_map<int, RevenueTotal>& totals, size_t count) {
+    std::vector<std::pair<int, RevenueTotal>> results(totals.begin(), totals.end());
+    auto byRevenue = [](const std::pair<int, RevenueTotal>& a, const std::pair<int, RevenueTotal>& b) {
+        if (a.second.revenueCents != b.second.revenueCents) return a.second.revenueCents > b.second.revenueCents;
+        return a.first < b.first;
+    };
+    count = std::min(count, results.size());
+    std::partial_sort(results.begin(), results.begin() + count, results.end(), byRevenue);
+    results.resize(count);
+    return results;
+}
+
+} // namespace
+
+ReportService::ReportService(BookingService& bookingService, CarService& carService)
+    : bookingService(bookingService), carService(carService) {
+}
+
+RevenueTotal ReportService::getTotalRevenue() {
+    return bookingService.getRevenueRollup().getTotal();
+}
+
+std::vector<std::pair<std::string, RevenueTotal>> ReportService::getRevenueByDay(const std::string& from,
+                                                                                 const std::string& to) {
+    return rangeOf(bookingService.getRevenueRollup().getByDay(), from, to);
+}
+
+std::vector<std::pair<std::string, RevenueTotal>> ReportService::getRevenueByMonth(const std::string& from,
+                                                                                   const std::string& to) {
+    return rangeOf(bookingService.getRevenueRollup().getByMonth(), from, to);
+}
+
+std::vector<std::pair<int, RevenueTotal>> ReportService::getTopCars(size_t count) {
+    return topOf(bookingService.getRevenueRollup().getByCar(), count);
+}
+
+std::vector<std::pair<int, RevenueTotal>> ReportService::getTopCustomers(size_t count) {
+    return topOf(bookingService.getRevenueRollup().getByCustomer(), count);
+}
+
+std::vector<std::pair<std::string, RevenueTotal>> ReportService::getRevenueByMake() {
+    std::map<std::string, RevenueTotal> byMake;
+    for (const auto& entry : bookingService.getRevenueRollup().getByCar()) {
+        Car car = carService.getCarById(entry.first);
+        RevenueTotal& total = byMake[car.getCarId() > 0 ? car.getMake() : "(deleted car)"];
+        total.revenueCents += entry.second.revenueCents;
+        total.bookings += entry.second.bookings;
+    }
+    return std::vector<std::pair<std::string, RevenueTotal>>(byMake.begin(), byMake.end());
+}
@@ -0,0 +1,31 @@
+#ifndef REPORTSERVICE_H
+#define REPORTSERVICE_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include "RevenueRollup.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Dashboard queries answered from the booking service's revenue rollups,
+// so no report rescans the booking history.
+class ReportService {
+private:
+    BookingService& bookingService;
+    CarService& carService;
+
+public:
+    ReportService(BookingService& bookingService, CarService& carService);
+
+    RevenueTotal getTotalRevenue();
+    // Inclusive ranges of YYYY-MM-DD days / YYYY-MM months; empty bounds are open
+    std::vector<std::pair<std::string, RevenueTotal>> getRevenueByDay(const std::string& from, const std::string& to);
+    std::vector<std::pair<std::string, RevenueTotal>> getRevenueByMonth(const std::string& from, const std::string& to);
+    std::vector<std::pair<int, RevenueTotal>> getTopCars(size_t count);
+    std::vector<std::pair<int, RevenueTotal>> getTopCustomers(size_t count);
+    // Joins the per-car rollup with each car's current make
+    std::vector<std::pair<std::string, RevenueTotal>> getRevenueByMake();
+};
+
+#endif // REPORTSERVICE_H
@@ -0,0 +1,131 @@
+#include "RevenueRollup.h"
+#include "../utils/CsvUtils.h"
+#include "../utils/BufferedWriter.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+void addTo(RevenueTotal& target, long long cents, int sign) {
+    target.revenueCents += sign * cents;
+    target.bookings += sign;
+}
+
+template <typename Key>
+void addTo(std::map<Key, RevenueTotal>& totals, const Key& key, long long cents, int sign) {
+    RevenueTotal& target = totals[key];
+    addTo(target, cents, sign);
+    if (target.bookings == 0) totals.erase(key);
+}
+
+void addTo(std::unordered_map<int, RevenueTotal>& totals, int key, long long cents, int sign) {
+    RevenueTotal& target = totals[key];
+    addTo(target, cents, sign);
+    if (target.bookings == 0) totals.erase(key);
+}
+
+void writeRow(BufferedWriter& writer, const char* kind, const std::string& key, const RevenueTotal& value) {
+    writer.write(kind, std::char_traits<char>::length(kind));
+    writer.writeChar(',');
+    writer.write(key);
+    writer.writeChar(',');
+    writer.writeInt(value.revenueCents);
+    writer.writeChar(',');
+    writer.writeInt(value.bookings);
+    writer.writeChar('\n');
+}
+
+} // namespace
+
+void RevenueRollup::apply(const Booking& booking, int sign) {
+    if (booking.isCancelled()) return;
+
+    long long cents = toCents(booking.getTotalCost());
+    const std::string& startDate = booking.getStartDate();
+    addTo(byDay, startDate, cents, sign);
+    addTo(byMonth, startDate.substr(0, 7), cents, sign);
+    addTo(byCar, booking.getCarId(), cents, sign);
+    addTo(byCustomer, booking.getCustomerId(), cents, sign);
+    addTo(total, cents, sign);
+}
+
+void RevenueRollup::clear() {
+    byDay.clear();
+    byMonth.clear();
+    byCar.clear();
+    byCustomer.clear();
+    total = RevenueTotal();
+}
+
+const std::map<std::string, RevenueTotal>& RevenueRollup::getByDay() const { return byDay; }
+const std::map<std::string, RevenueTotal>& RevenueRollup::getByMonth() const { return byMonth; }
+const std::unordered_map<int, RevenueTotal>& RevenueRollup::getByCar() const { return byCar; }
+const std::unordered_map<int, RevenueTotal>& RevenueRollup::getByCustomer() const { return byCustomer; }
+const RevenueTotal& RevenueRollup::getTotal() const { return total; }
+
+bool RevenueRollup::save(const std::string& path, const FileStamp& sourceStamp) const {
+    std::string tempFile = path + ".tmp";
+    {
+        BufferedWriter writer(tempFile);
+        if (!writer.isOpen()) return false;
+
+        writer.write("Source,");
+        writer.writeInt(sourceStamp.size);
+        writer.writeChar(',');
+        writer.writeInt(sourceStamp.modifiedNs);
+        writer.write("\nKind,Key,RevenueCents,Bookings\n");
+        writeRow(writer, "total", "all", total);
+        for (const auto& entry : byDay) writeRow(writer, "day", entry.first, entry.second);
+        for (const auto& entry : byMonth) writeRow(writer, "month", entry.first, entry.second);
+        for (const auto& entry : byCar) writeRow(writer, "car", std::to_string(entry.first), entry.second);
+        for (const auto& entry : byCustomer) writeRow(writer, "customer", std::to_string(entry.first), entry.second);
+
+        if (!writer.close()) {
+            std::remove(tempFile.c_str());
+            return false;
+        }
+    }
+
+    FileManager fileManager;
+    return fileManager.replaceFile(tempFile, path);
+}
+
+bool RevenueRollup::load(const std::string& path, const FileStamp& sourceStamp) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string line;
+    std::vector<std::string> fields;
+    if (!std::getline(file, line)) return false;
+    CsvUtils::splitLine(line, fields);
+    if (fields.size() != 3 || fields[0] != "Source" ||
+        std::atoll(fields[1].c_str()) != sourceStamp.size ||
+        std::atoll(fields[2].c_str()) != sourceStamp.modifiedNs) {
+        return false;
+    }
+    std::getline(file, line); // Column header
+
+    clear();
+    while (std::getline(file, line)) {
+        CsvUtils::splitLine(line, fields);
+        if (fields.size() != 4) continue;
+
+        RevenueTotal value;
+        value.revenueCents = std::atoll(fields[2].c_str());
+        value.bookings = std::atoll(fields[3].c_str());
+        const std::string& kind = fields[0];
+        if (kind == "total") total = value;
+        else if (kind == "day") byDay[fields[1]] = value;
+        else if (kind == "month") byMonth[fields[1]] = value;
+        else if (kind == "car") byCar[std::atoi(fields[1].c_str())] = value;
+        else if (kind == "customer") byCustomer[std::atoi(fields[1].c_str())] = value;
+    }
+    return true;
+}
+
+long long RevenueRollup::toCents(double amount) {
+    return std::llround(amount * 100.0);
+}
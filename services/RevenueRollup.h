@@ -0,0 +1,48 @@
+#ifndef REVENUEROLLUP_H
+#define REVENUEROLLUP_H
+
+#include "../models/Booking.h"
+#include "../database/FileManager.h"
+#include <map>
+#include <string>
+#include <unordered_map>
+
+struct RevenueTotal {
+    long long revenueCents;
+    long long bookings;
+
+    RevenueTotal() : revenueCents(0), bookings(0) {}
+    double getRevenue() const { return revenueCents / 100.0; }
+};
+
+// Running revenue and booking counts per day, month, car and customer.
+// Bookings are counted on their start date; cancelled bookings count nothing.
+// Callers apply +1 for a booking entering the data set and -1 for one leaving
+// it, so an update is apply(old, -1) followed by apply(new, +1).
+class RevenueRollup {
+private:
+    std::map<std::string, RevenueTotal> byDay;      // YYYY-MM-DD
+    std::map<std::string, RevenueTotal> byMonth;    // YYYY-MM
+    std::unordered_map<int, RevenueTotal> byCar;
+    std::unordered_map<int, RevenueTotal> byCustomer;
+    RevenueTotal total;
+
+public:
+    void apply(const Booking& booking, int sign);
+    void clear();
+
+    const std::map<std::string, RevenueTotal>& getByDay() const;
+    const std::map<std::string, RevenueTotal>& getByMonth() const;
+    const std::unordered_map<int, RevenueTotal>& getByCar() const;
+    const std::unordered_map<int, RevenueTotal>& getByCustomer() const;
+    const RevenueTotal& getTotal() const;
+
+    // Persistence: the file records the size and modification time of the
+    // bookings file it was built from, and load() fails if they differ
+    bool save(const std::string& path, const FileStamp& sourceStamp) const;
+    bool load(const std::string& path, const FileStamp& sourceStamp);
+
+    static long long toCents(double amount);
+};
+
+#endif // REVENUEROLLUP_H
@@ -0,0 +1,165 @@
+#include "UtilizationService.h"
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+
+struct Interval {
+    int startDay;
+    int endDay;
+};
+
+// Start day of the month after monthStartDay
+int nextMonthStart(int monthStartDay) {
+    std::string date = Booking::daysToDate(monthStartDay);
+    int year = 0, month = 0;
+    sscanf(date.c_str(), "%d-%d", &year, &month);
+    if (++month > 12) {
+        month = 1;
+        year++;
+    }
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-01", year, month);
+    return Booking::dateToDays(buffer);
+}
+
+} // namespace
+
+UtilizationService::UtilizationService(BookingService& bookingService, CarService& carService, size_t workerCount)
+    : bookingService(bookingService), carService(carService), pool(workerCount) {
+}
+
+UtilizationReport UtilizationService::buildReport(const std::string& fromMonth, const std::string& toMonth) {
+    UtilizationReport report;
+    report.fromMonth = fromMonth;
+    report.toMonth = toMonth;
+
+    // Month boundaries: monthStarts[m] .. monthStarts[m + 1] is month m
+    std::vector<int> monthStarts;
+    int periodEnd = nextMonthStart(Booking::dateToDays(toMonth + "-01"));
+    for (int day = Booking::dateToDays(fromMonth + "-01"); day < periodEnd; day = nextMonthStart(day)) {
+        monthStarts.push_back(day);
+    }
+    if (monthStarts.empty()) {
+        return report;
+    }
+    monthStarts.push_back(periodEnd);
+    size_t monthCount = monthStarts.size() - 1;
+    int periodStart = monthStarts.front();
+
+    // Fleet, in car ID order
+    std::vector<Car> cars;
+    std::unordered_map<int, size_t> carIndex;
+    carService.forEachCar(nullptr, [&](const Car& car) {
+        carIndex[car.getCarId()] = cars.size();
+        cars.push_back(car);
+    });
+
+    // Bucket the intervals that touch the period by car (counting sort by car index)
+    std::vector<size_t> offsets(cars.size() + 1, 0);
+    std::vector<std::pair<size_t, Interval>> clipped;
+    auto collect = [&](const Booking& booking) {
+        if (booking.isCancelled()) return;
+        auto car = carIndex.find(booking.getCarId());
+        if (car == carIndex.end()) return;
+        int start = std::max(Booking::dateToDays(booking.getStartDate()), periodStart);
+        int end = std::min(Booking::dateToDays(booking.getEndDate()), periodEnd);
+        if (start >= end) return;
+        clipped.push_back({car->second, {start, end}});
+        offsets[car->second + 1]++;
+    };
+    bookingService.forEachBookingInRange(periodStart, periodEnd, collect);
+    // Only archive segments whose dates reach into the period are read
+    ArchiveFilter period;
+    period.fromDay = periodStart;
+    period.toDay = periodEnd;
+    bookingService.forEachArchivedBooking(period, collect);
+    for (size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1];
+    }
+    std::vector<Interval> intervals(clipped.size());
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (const auto& entry : clipped) {
+            intervals[fill[entry.first]++] = entry.second;
+        }
+    }
+    clipped.clear();
+    clipped.shrink_to_fit();
+
+    // Sweep each car's intervals; workers keep their own month totals
+    std::vector<long long> carRented(cars.size(), 0);
+    std::vector<std::vector<long long>> workerMonths;
+    std::mutex monthsMutex;
+    pool.parallelFor(cars.size(), [&](size_t begin, size_t end) {
+        std::vector<long long> months(monthCount, 0);
+        for (size_t car = begin; car < end; car++) {
+            auto first = intervals.begin() + offsets[car];
+            auto last = intervals.begin() + offsets[car + 1];
+            std::sort(first, last, [](const Interval& a, const Interval& b) { return a.startDay < b.startDay; });
+
+            long long rented = 0;
+            int coveredUntil = periodStart;
+            for (auto it = first; it != last; ++it) {
+                int start = std::max(it->startDay, coveredUntil);
+                if (start >= it->endDay) continue;
+                rented += it->endDay - start;
+                coveredUntil = it->endDay;
+
+                // Split the newly covered days [start, endDay) across month boundaries
+                size_t month = std::upper_bound(monthStarts.begin(), monthStarts.end(), start) - monthStarts.begin() - 1;
+                while (start < it->endDay) {
+                    int stop = std::min(it->endDay, monthStarts[month + 1]);
+                    months[month] += stop - start;
+                    start = stop;
+                    month++;
+                }
+            }
+            carRented[car] = rented;
+        }
+        std::lock_guard<std::mutex> lock(monthsMutex);
+        workerMonths.push_back(std::move(months));
+    });
+
+    long long periodDays = periodEnd - periodStart;
+    long long fleetSize = static_cast<long long>(cars.size());
+
+    report.fleet.label = "Fleet";
+    report.fleet.availableDays = periodDays * fleetSize;
+    for (size_t month = 0; month < monthCount; month++) {
+        UtilizationRow row;
+        row.label = Booking::daysToDate(monthStarts[month]).substr(0, 7);
+        row.availableDays = static_cast<long long>(monthStarts[month + 1] - monthStarts[month]) * fleetSize;
+        for (const auto& months : workerMonths) {
+            row.rentedDays += months[month];
+        }
+        report.fleet.rentedDays += row.rentedDays;
+        report.byMonth.push_back(row);
+    }
+
+    std::map<std::string, UtilizationRow> models;
+    report.carIds.reserve(cars.size());
+    report.byCar.reserve(cars.size());
+    for (size_t car = 0; car < cars.size(); car++) {
+        UtilizationRow row;
+        row.label = cars[car].getMake() + " " + cars[car].getModel();
+        row.rentedDays = carRented[car];
+        row.availableDays = periodDays;
+
+        UtilizationRow& model = models[row.label];
+        model.label = row.label;
+        model.rentedDays += row.rentedDays;
+        model.availableDays += row.availableDays;
+
+        report.carIds.push_back(cars[car].getCarId());
+        report.byCar.push_back(row);
+    }
+    for (const auto& model : models) {
+        report.byModel.push_back(model.second);
+    }
+
+    return report;
+}
@@ -0,0 +1,50 @@
+#ifndef UTILIZATIONSERVICE_H
+#define UTILIZATIONSERVICE_H
+
+#include "BookingService.h"
+#include "CarService.h"
+#include "../utils/ThreadPool.h"
+#include <string>
+#include <vector>
+
+struct UtilizationRow {
+    std::string label;
+    long long rentedDays;       // car-days covered by at least one booking
+    long long availableDays;    // car-days in the period
+
+    UtilizationRow() : rentedDays(0), availableDays(0) {}
+    double getUtilization() const {
+        return availableDays > 0 ? 100.0 * rentedDays / availableDays : 0.0;
+    }
+};
+
+struct UtilizationReport {
+    std::string fromMonth;
+    std::string toMonth;
+    UtilizationRow fleet;
+    std::vector<UtilizationRow> byMonth;    // in month order
+    std::vector<UtilizationRow> byModel;    // "Make Model", alphabetical
+    std::vector<int> carIds;                // parallel to byCar
+    std::vector<UtilizationRow> byCar;      // in car ID order
+};
+
+// Percentage of car-days rented per car, model and month.
+//
+// Booking intervals are bucketed by car and sorted once; each car's intervals
+// are then swept in start order, merging overlaps so a day is never counted
+// twice, and clipped to month boundaries. Cars are independent, so the sweep
+// runs across the thread pool. Cancelled bookings do not count as rented.
+class UtilizationService {
+private:
+    BookingService& bookingService;
+    CarService& carService;
+    ThreadPool pool;
+
+public:
+    UtilizationService(BookingService& bookingService, CarService& carService, size_t workerCount = 0);
+
+    // Inclusive month range, both YYYY-MM
+    UtilizationReport buildReport(const std::string& fromMonth, const std::string& toMonth);
+};
+
+#endif // UTILIZATIONSERVICE_H
@@ -0,0 +1,143 @@
+// Throughput benchmark for the booking analytics kernels.
+//
+// Build from the repository root with one command, e.g.
+//   g++ -std=c++17 -O3 -march=native -pthread -I. -o AnalyticsBenchmark tools/AnalyticsBenchmark.cpp
+//       utils/ScanKernels.cpp
+// and compare against a build without -march=native to see the scalar path.
+//
+// Usage: AnalyticsBenchmark [rows] [repeats]
+
+#include "../utils/ScanKernels.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Columns {
+    std::vector<int32_t> startDay;
+    std::vector<int32_t> endDay;
+    std::vector<int32_t> carId;
+    std::vector<int64_t> costCents;
+    std::vector<uint8_t> status;
+};
+
+Columns generate(size_t rows, size_t cars) {
+    Columns columns;
+    std::mt19937_64 random(42);
+    std::uniform_int_distribution<int32_t> startDays(19000, 20000);
+    std::uniform_int_distribution<int32_t> lengths(1, 21);
+    std::uniform_int_distribution<int32_t> carIds(1, static_cast<int32_t>(cars));
+    std::uniform_int_distribution<int64_t> rates(2500, 20000);
+    std::uniform_int_distribution<int> statuses(0, 9);
+
+    columns.startDay.resize(rows);
+    columns.endDay.resize(rows);
+    columns.carId.resize(rows);
+    columns.costCents.resize(rows);
+    columns.status.resize(rows);
+    for (size_t i = 0; i < rows; i++) {
+        int32_t length = lengths(random);
+        columns.startDay[i] = startDays(random);
+        columns.endDay[i] = columns.startDay[i] + length;
+        columns.carId[i] = carIds(random);
+        columns.costCents[i] = rates(random) * length;
+        int roll = statuses(random);
+        columns.status[i] = static_cast<uint8_t>(roll < 6 ? 1 : roll < 9 ? 0 : 2);
+    }
+    return columns;
+}
+
+template <typename Body>
+void measure(const std::string& name, size_t rows, int repeats, Body body) {
+    body();    // warm-up
+    auto started = std::chrono::steady_clock::now();
+    int64_t checksum = 0;
+    for (int run = 0; run < repeats; run++) {
+        checksum += body();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    double rowsPerSecond = static_cast<double>(rows) * repeats / seconds;
+    std::cout << std::left << std::setw(34) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << rowsPerSecond / 1e6
+              << " M rows/s   (checksum " << checksum << ")" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    size_t rows = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    int repeats = argc > 2 ? std::atoi(argv[2]) : 20;
+    const size_t cars = 50000;
+    if (rows == 0 || repeats <= 0) {
+        std::cerr << "Usage: AnalyticsBenchmark [rows] [repeats]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Generating " << rows << " bookings..." << std::endl;
+    Columns columns = generate(rows, cars);
+    std::vector<uint8_t> mask(rows);
+    std::vector<uint8_t> keys(rows);
+
+    // Every third car counts as "diesel" for the join filter
+    std::vector<uint8_t> diesel(cars + 1);
+    std::vector<uint8_t> fuel(cars + 1);
+    for (size_t id = 0; id <= cars; id++) {
+        diesel[id] = id % 3 == 0;
+        fuel[id] = static_cast<uint8_t>(id % 4);
+    }
+
+    std::cout << "Kernel path: " << ScanKernels::instructionSet() << ", " << repeats << " runs each" << std::endl;
+
+    measure("filterRange (start day)", rows, repeats, [&]() {
+        ScanKernels::fillMask(mask.data(), rows);
+        ScanKernels::filterRange(columns.startDay.data(), rows, 19200, 19300, mask.data());
+        return static_cast<int64_t>(mask[rows / 2]);
+    });
+    measure("filterDifference (duration)", rows, repeats, [&]() {
+        ScanKernels::fillMask(mask.data(), rows);
+        ScanKernels::filterDifference(columns.startDay.data(), columns.endDay.data(), rows, 8, 1 << 30, mask.data());
+        return static_cast<int64_t>(mask[rows / 2]);
+    });
+    ScanKernels::fillMask(mask.data(), rows);
+    measure("countMasked", rows, repeats, [&]() {
+        return static_cast<int64_t>(ScanKernels::countMasked(mask.data(), rows));
+    });
+    measure("sumMasked", rows, repeats, [&]() {
+        return ScanKernels::sumMasked(columns.costCents.data(), mask.data(), rows);
+    });
+    measure("minMasked + maxMasked", rows, repeats, [&]() {
+        int64_t low = 0, high = 0;
+        ScanKernels::minMasked(columns.costCents.data(), mask.data(), rows, low);
+        ScanKernels::maxMasked(columns.costCents.data(), mask.data(), rows, high);
+        return low + high;
+    });
+    measure("groupSum (status)", rows, repeats, [&]() {
+        int64_t sums[4] = {}, counts[4] = {};
+        ScanKernels::groupSum(columns.status.data(), columns.costCents.data(), mask.data(), rows, sums, counts, 4);
+        return sums[1];
+    });
+
+    // The example query: diesel cars, Q3, more than 7 days, excluding cancelled
+    measure("query: diesel, Q3, >7 days", rows, repeats, [&]() {
+        ScanKernels::fillMask(mask.data(), rows);
+        ScanKernels::filterRange(columns.startDay.data(), rows, 19539, 19630, mask.data());
+        ScanKernels::filterDifference(columns.startDay.data(), columns.endDay.data(), rows, 8, 1 << 30, mask.data());
+        ScanKernels::filterInSet(columns.status.data(), rows, 0x3, mask.data());
+        ScanKernels::filterLookup(columns.carId.data(), rows, diesel.data(), diesel.size(), mask.data());
+        return ScanKernels::sumMasked(columns.costCents.data(), mask.data(), rows);
+    });
+    measure("query: group by fuel (join)", rows, repeats, [&]() {
+        ScanKernels::gatherBytes(columns.carId.data(), rows, fuel.data(), fuel.size(), 0xFF, keys.data());
+        int64_t sums[256] = {}, counts[256] = {};
+        ScanKernels::groupSum(keys.data(), columns.costCents.data(), mask.data(), rows, sums, counts, 256);
+        return sums[1];
+    });
+
+    return 0;
+}
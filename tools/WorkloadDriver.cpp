@@ -0,0 +1,781 @@
+// Load generator that replays a clerk and customer workload against the
+// stores, either in this process or through a running API server.
+//
+// Build from the repository root with one command, e.g.
+//   g++ -std=c++17 -O2 -pthread -I. -o WorkloadDriver tools/WorkloadDriver.cpp
+//       models/*.cpp services/*.cpp database/*.cpp utils/*.cpp
+//
+// Usage: WorkloadDriver [options]
+//   --data=DIR          data directory (default data). In-process runs change it: use a copy.
+//   --url=HOST:PORT     drive a server started with --server instead of the stores in this process;
+//                       --data must then name the server's data directory, which is only read
+//   --threads=N         concurrent clients (default 8)
+//   --seconds=S         length of the run (default 30)
+//   --interval=S        seconds between progress lines (default 5)
+//   --rate=R            target operations per second over all clients; 0 runs flat out (default).
+//                       With a rate, latency counts from when each operation was due.
+//   --mix=NAME=W,...    weights of search, availability, quote, book, update, cancel and batch
+//                       (default search=10,availability=45,quote=20,book=12,update=8,cancel=5,batch=2).
+//                       batch books 2-5 cars for one customer and the same dates in one request,
+//                       all or nothing (POST /bookings/batch, i.e. BookingService::addBookings)
+//   --zipf=S            skew of car model popularity (default 1.1; 0 is uniform)
+//   --horizon=D         latest rental start, in days from today (default 180)
+//   --seed=N            random seed (default 42)
+//   --csv=FILE          also write the progress lines to FILE
+//   --slotted-storage, --durability=MODE, --partitioned-bookings   as for the application (in-process only)
+
+#include "../database/ChangeLog.h"
+#include "../database/PersistenceQueue.h"
+#include "../services/ApiServer.h"
+#include "../services/BookingService.h"
+#include "../services/CarService.h"
+#include "../services/CustomerService.h"
+#include "../services/IntegrityService.h"
+#include "../services/LifecycleScheduler.h"
+#include "../services/PricingEngine.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum Operation {
+    SEARCH,
+    AVAILABILITY,
+    QUOTE,
+    BOOK,
+    UPDATE,
+    CANCEL,
+    BATCH,
+    OPERATION_COUNT
+};
+
+const char* OPERATION_NAMES[OPERATION_COUNT] = {"search", "availability", "quote", "book", "update", "cancel",
+                                              "batch"};
+
+enum class Outcome {
+    OK,
+    REJECTED,   // Answered with 404, 409 or 422: e.g. the car was taken meanwhile
+    ERROR       // Malformed request, server error or lost connection
+};
+
+// Latency histogram in microseconds with 64 buckets per power of two, so any
+// percentile is within about 1.6% of the exact value. Fixed size and cheap to
+// merge, which keeps recording off the allocator.
+class Histogram {
+private:
+    static const int SUB_BITS = 6;
+    static const size_t SUB_COUNT = 1 << SUB_BITS;
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+    double sum;
+
+    static size_t indexOf(uint64_t micros) {
+        if (micros < SUB_COUNT) return static_cast<size_t>(micros);
+        int exponent = 0;
+        while ((micros >> (exponent + 1)) != 0) exponent++;
+        return (exponent - SUB_BITS + 1) * SUB_COUNT + ((micros >> (exponent - SUB_BITS)) & (SUB_COUNT - 1));
+    }
+
+    static uint64_t valueAt(size_t index) {
+        if (index < SUB_COUNT) return index;
+        size_t exponent = index / SUB_COUNT + SUB_BITS - 1;
+        return (static_cast<uint64_t>(SUB_COUNT + index % SUB_COUNT)) << (exponent - SUB_BITS);
+    }
+
+public:
+    Histogram() : counts((64 - SUB_BITS + 1) * SUB_COUNT, 0), total(0), maxValue(0), sum(0) {}
+
+    void record(uint64_t micros) {
+        counts[indexOf(micros)]++;
+        total++;
+        maxValue = std::max(maxValue, micros);
+        sum += static_cast<double>(micros);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+        sum += other.sum;
+    }
+
+    void clear() {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        maxValue = 0;
+        sum = 0;
+    }
+
+    uint64_t count() const { return total; }
+    double meanMs() const { return total == 0 ? 0.0 : sum / total / 1000.0; }
+    double maxMs() const { return maxValue / 1000.0; }
+
+    double percentileMs(double percent) const {
+        if (total == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(percent / 100.0 * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= std::max<uint64_t>(rank, 1)) return std::min(valueAt(i), maxValue) / 1000.0;
+        }
+        return maxMs();
+    }
+};
+
+struct Tally {
+    Histogram latency[OPERATION_COUNT];
+    uint64_t rejected[OPERATION_COUNT];
+    uint64_t errors[OPERATION_COUNT];
+
+    Tally() { clear(); }
+
+    void clear() {
+        for (int op = 0; op < OPERATION_COUNT; op++) {
+            latency[op].clear();
+            rejected[op] = 0;
+            errors[op] = 0;
+        }
+    }
+
+    void merge(const Tally& other) {
+        for (int op = 0; op < OPERATION_COUNT; op++) {
+            latency[op].merge(other.latency[op]);
+            rejected[op] += other.rejected[op];
+            errors[op] += other.errors[op];
+        }
+    }
+
+    Histogram overall() const {
+        Histogram all;
+        for (const auto& histogram : latency) all.merge(histogram);
+        return all;
+    }
+
+    uint64_t totalErrors() const {
+        uint64_t sum = 0;
+        for (uint64_t count : errors) sum += count;
+        return sum;
+    }
+};
+
+// What the generator knows about the fleet and the customers
+struct Catalog {
+    struct Model {
+        std::string make;
+        std::string name;
+        std::string fuelType;
+        std::vector<int> carIds;
+    };
+    std::vector<Model> models;          // In popularity order after shuffling
+    std::vector<double> modelWeights;   // Cumulative Zipf weights over models
+    std::vector<int> customerIds;
+    std::vector<double> startWeights;   // Cumulative seasonal demand over start days 1..horizon
+    int today;
+};
+
+Catalog loadCatalog(CarService& carService, CustomerService& customerService, double zipf, int horizon,
+                    std::mt19937_64& random) {
+    Catalog catalog;
+    std::map<std::string, size_t> modelIndex;
+    carService.forEachCar(nullptr, [&](const Car& car) {
+        if (car.getStatus() == CarStatus::RETIRED) return;
+        std::string key = car.getMake() + "\t" + car.getModel();
+        auto found = modelIndex.find(key);
+        if (found == modelIndex.end()) {
+            found = modelIndex.emplace(key, catalog.models.size()).first;
+            catalog.models.push_back({car.getMake(), car.getModel(), car.getFuelTypeString(), {}});
+        }
+        catalog.models[found->second].carIds.push_back(car.getCarId());
+    });
+    customerService.forEachCustomer(nullptr, [&](const Customer& customer) {
+        if (customer.isActive()) catalog.customerIds.push_back(customer.getCustomerId());
+    });
+
+    // Which models are popular is random; how popular follows rank^-zipf
+    std::shuffle(catalog.models.begin(), catalog.models.end(), random);
+    double cumulative = 0;
+    for (size_t rank = 1; rank <= catalog.models.size(); rank++) {
+        cumulative += 1.0 / std::pow(static_cast<double>(rank), zipf);
+        catalog.modelWeights.push_back(cumulative);
+    }
+
+    // Demand by start day: summer and the Christmas holidays are busier, and so are Fridays and Saturdays
+    catalog.today = Booking::today();
+    cumulative = 0;
+    for (int offset = 1; offset <= horizon; offset++) {
+        std::string date = Booking::daysToDate(catalog.today + offset);
+        int monthDay = std::atoi(date.substr(5, 2).c_str()) * 100 + std::atoi(date.substr(8, 2).c_str());
+        double weight = 1.0;
+        if (monthDay >= 615 && monthDay <= 831) weight += 0.8;
+        if (monthDay >= 1218 || monthDay <= 103) weight += 1.2;
+        int weekday = ((catalog.today + offset) % 7 + 7 + 3) % 7;   // 1970-01-01 was a Thursday; 0 is Monday
+        if (weekday == 4 || weekday == 5) weight += 0.4;
+        cumulative += weight;
+        catalog.startWeights.push_back(cumulative);
+    }
+    return catalog;
+}
+
+size_t pickCumulative(const std::vector<double>& weights, std::mt19937_64& random) {
+    std::uniform_real_distribution<double> uniform(0.0, weights.back());
+    return std::upper_bound(weights.begin(), weights.end(), uniform(random)) - weights.begin();
+}
+
+// Rental lengths: weekends and single weeks dominate, with a tail of long rentals
+const int LENGTHS[] = {1, 2, 3, 4, 5, 7, 10, 14, 21, 28};
+const double LENGTH_WEIGHTS[] = {14, 18, 16, 9, 8, 16, 6, 8, 3, 2};
+
+std::string urlEncode(const std::string& text) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 15];
+        }
+    }
+    return out;
+}
+
+// Sends a request and waits for the answer; false when there was no answer
+class Transport {
+public:
+    virtual ~Transport() {}
+    virtual bool send(const std::string& method, const std::string& target, const std::string& body,
+                      int& status, std::string& responseBody) = 0;
+};
+
+class InProcessTransport : public Transport {
+private:
+    ApiServer& api;
+
+public:
+    explicit InProcessTransport(ApiServer& api) : api(api) {}
+
+    bool send(const std::string& method, const std::string& target, const std::string& body, int& status,
+              std::string& responseBody) override {
+        HttpRequest request;
+        request.method = method;
+        HttpServer::parseTarget(target, request);
+        request.body = body;
+        HttpResponse response;
+        api.handle(request, response);
+        status = response.status;
+        responseBody.swap(response.body);
+        return true;
+    }
+};
+
+#ifndef _WIN32
+
+// One keep-alive connection; reconnects after a failure
+class HttpTransport : public Transport {
+private:
+    std::string host;
+    int port;
+    int fd;
+    std::string buffer;
+
+    bool connectNow() {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<uint16_t>(port));
+        if (fd < 0 || ::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1 ||
+            ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            disconnect();
+            return false;
+        }
+        int yes = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        timeval timeout;
+        timeout.tv_sec = 10;
+        timeout.tv_usec = 0;
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return true;
+    }
+
+    void disconnect() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        buffer.clear();
+    }
+
+public:
+    HttpTransport(const std::string& host, int port) : host(host), port(port), fd(-1) {}
+    ~HttpTransport() override { disconnect(); }
+
+    bool send(const std::string& method, const std::string& target, const std::string& body, int& status,
+              std::string& responseBody) override {
+        if (fd < 0 && !connectNow()) {
+            return false;
+        }
+        std::string request = method + " " + target + " HTTP/1.1\r\nHost: " + host + "\r\nContent-Length: " +
+                              std::to_string(body.size()) + "\r\n\r\n" + body;
+        size_t sent = 0;
+        while (sent < request.size()) {
+            ssize_t count = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (count <= 0) {
+                disconnect();
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+
+        size_t headerEnd = std::string::npos;
+        size_t total = std::string::npos;
+        char chunk[16384];
+        while (total == std::string::npos || buffer.size() < total) {
+            if (headerEnd == std::string::npos) {
+                headerEnd = buffer.find("\r\n\r\n");
+                if (headerEnd != std::string::npos) {
+                    size_t length = buffer.find("Content-Length: ");
+                    if (length == std::string::npos || length > headerEnd) {
+                        disconnect();
+                        return false;
+                    }
+                    total = headerEnd + 4 + std::strtoul(buffer.c_str() + length + 16, nullptr, 10);
+                    continue;
+                }
+            }
+            ssize_t count = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (count <= 0) {
+                disconnect();
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(count));
+        }
+        status = std::atoi(buffer.c_str() + 9);
+        responseBody.assign(buffer, headerEnd + 4, total - headerEnd - 4);
+        bool closing = buffer.find("Connection: close") < headerEnd;
+        buffer.erase(0, total);
+        if (closing) disconnect();
+        return true;
+    }
+};
+
+#endif
+
+struct Options {
+    std::string dataDirectory = "data";
+    std::string host;
+    int port = 0;
+    int threads = 8;
+    double seconds = 30;
+    double interval = 5;
+    double rate = 0;
+    double zipf = 1.1;
+    int horizon = 180;
+    unsigned long long seed = 42;
+    std::string csvFile;
+    double mix[OPERATION_COUNT] = {10, 45, 20, 12, 8, 5, 2};
+    StorageMode storageMode = StorageMode::CSV;
+    Durability durability = Durability::GROUP_COMMIT;
+    bool partitionBookings = false;
+};
+
+bool parseMix(const std::string& text, double mix[OPERATION_COUNT]) {
+    double parsed[OPERATION_COUNT] = {};
+    std::stringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) return false;
+        std::string name = item.substr(0, equals);
+        int op = 0;
+        while (op < OPERATION_COUNT && name != OPERATION_NAMES[op]) op++;
+        if (op == OPERATION_COUNT) return false;
+        parsed[op] = std::atof(item.c_str() + equals + 1);
+        if (parsed[op] < 0) return false;
+    }
+    double sum = 0;
+    for (double weight : parsed) sum += weight;
+    if (sum <= 0) return false;
+    std::copy(std::begin(parsed), std::end(parsed), mix);
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        std::string name = arg.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+        if (name == "--data") {
+            options.dataDirectory = value;
+        } else if (name == "--url") {
+            if (value.compare(0, 7, "http://") == 0) value = value.substr(7);
+            size_t colon = value.rfind(':');
+            options.host = value.substr(0, colon);
+            options.port = colon == std::string::npos ? 8080 : std::atoi(value.c_str() + colon + 1);
+            if (options.host == "localhost") options.host = "127.0.0.1";
+        } else if (name == "--threads") {
+            options.threads = std::atoi(value.c_str());
+        } else if (name == "--seconds") {
+            options.seconds = std::atof(value.c_str());
+        } else if (name == "--interval") {
+            options.interval = std::atof(value.c_str());
+        } else if (name == "--rate") {
+            options.rate = std::atof(value.c_str());
+        } else if (name == "--zipf") {
+            options.zipf = std::atof(value.c_str());
+        } else if (name == "--horizon") {
+            options.horizon = std::atoi(value.c_str());
+        } else if (name == "--seed") {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--csv") {
+            options.csvFile = value;
+        } else if (name == "--mix") {
+            if (!parseMix(value, options.mix)) return false;
+        } else if (name == "--slotted-storage") {
+            options.storageMode = StorageMode::SLOTTED;
+        } else if (name == "--durability") {
+            options.durability = PersistenceQueue::parseDurability(value, options.durability);
+        } else if (name == "--partitioned-bookings") {
+            options.partitionBookings = true;
+        } else {
+            return false;
+        }
+    }
+    return options.threads > 0 && options.seconds > 0 && options.interval > 0 && options.rate >= 0 &&
+           options.zipf >= 0 && options.horizon > 0 && (options.host.empty() || options.port > 0);
+}
+
+// One simulated client: picks operations from the mix and records how each went
+class Client {
+private:
+    const Options& options;
+    const Catalog& catalog;
+    Transport& transport;
+    std::mt19937_64 random;
+    std::discrete_distribution<int> operations;
+    std::discrete_distribution<int> lengths;
+    std::vector<int> myBookings;    // Active bookings this client made, candidates for cancelling
+    std::mutex mutex;
+    Tally tally;                    // Since the last progress line
+
+    int pickCar() {
+        const Catalog::Model& model = catalog.models[pickCumulative(catalog.modelWeights, random)];
+        return model.carIds[std::uniform_int_distribution<size_t>(0, model.carIds.size() - 1)(random)];
+    }
+
+    void pickDates(std::string& startDate, std::string& endDate) {
+        int start = catalog.today + 1 + static_cast<int>(pickCumulative(catalog.startWeights, random));
+        startDate = Booking::daysToDate(start);
+        endDate = Booking::daysToDate(start + LENGTHS[lengths(random)]);
+    }
+
+    // Every booking ID in a response, one for a single booking
+    static void parseIds(const std::string& body, std::vector<int>& ids) {
+        for (size_t found = body.find("\"id\":"); found != std::string::npos; found = body.find("\"id\":", found + 5)) {
+            int id = std::atoi(body.c_str() + found + 5);
+            if (id > 0) ids.push_back(id);
+        }
+    }
+
+public:
+    Client(const Options& options, const Catalog& catalog, Transport& transport, unsigned long long seed)
+        : options(options), catalog(catalog), transport(transport), random(seed),
+          operations(std::begin(options.mix), std::end(options.mix)),
+          lengths(std::begin(LENGTH_WEIGHTS), std::end(LENGTH_WEIGHTS)) {}
+
+    void run(Clock::time_point start, Clock::time_point end) {
+        // With a rate, operations are due on a fixed schedule and latency counts from when each was due
+        Clock::duration period = options.rate > 0
+            ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.threads / options.rate))
+            : Clock::duration::zero();
+        Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+            period * std::uniform_real_distribution<double>(0.0, 1.0)(random));
+        std::string method, target, body, responseBody;
+        while (true) {
+            Clock::time_point began = Clock::now();
+            if (period != Clock::duration::zero()) {
+                if (due >= end) break;
+                if (due > began) std::this_thread::sleep_until(due);
+                began = due;
+                due += period;
+            } else if (began >= end) {
+                break;
+            }
+
+            int op = operations(random);
+            if (op == CANCEL && myBookings.empty()) op = BOOK;
+            std::string startDate, endDate;
+            pickDates(startDate, endDate);
+            body.clear();
+            size_t cancelIndex = 0;
+            switch (op) {
+                case SEARCH: {
+                    const Catalog::Model& model = catalog.models[pickCumulative(catalog.modelWeights, random)];
+                    method = "GET";
+                    target = "/cars?q=" + urlEncode(random() % 2 ? model.name : model.make);
+                    break;
+                }
+                case AVAILABILITY: {
+                    method = "GET";
+                    target = "/availability?start=" + startDate + "&end=" + endDate + "&limit=20";
+                    if (random() % 2) {
+                        target += "&fuel=" + catalog.models[pickCumulative(catalog.modelWeights, random)].fuelType;
+                    }
+                    break;
+                }
+                case QUOTE:
+                    method = "GET";
+                    target = "/quote?carId=" + std::to_string(pickCar()) + "&start=" + startDate + "&end=" + endDate;
+                    break;
+                case BOOK:
+                case BATCH: {
+                    int customerId = catalog.customerIds[std::uniform_int_distribution<size_t>(
+                        0, catalog.customerIds.size() - 1)(random)];
+                    int count = op == BATCH ? std::uniform_int_distribution<int>(2, 5)(random) : 1;
+                    method = "POST";
+                    target = op == BATCH ? "/bookings/batch" : "/bookings";
+                    for (int i = 0; i < count; i++) {
+                        body += "{\"customerId\":" + std::to_string(customerId) + ",\"carId\":" +
+                                std::to_string(pickCar()) + ",\"startDate\":\"" + startDate + "\",\"endDate\":\"" +
+                                endDate + "\",\"notes\":\"workload\"}\n";
+                    }
+                    break;
+                }
+                case UPDATE: {
+                    int customerId = catalog.customerIds[std::uniform_int_distribution<size_t>(
+                        0, catalog.customerIds.size() - 1)(random)];
+                    method = "PUT";
+                    target = "/customers/" + std::to_string(customerId);
+                    body = "{\"phone\":\"555" + std::to_string(1000000 + random() % 9000000) + "\"}";
+                    break;
+                }
+                case CANCEL:
+                    cancelIndex = std::uniform_int_distribution<size_t>(0, myBookings.size() - 1)(random);
+                    method = "POST";
+                    target = "/bookings/" + std::to_string(myBookings[cancelIndex]) + "/cancel";
+                    break;
+            }
+
+            int status = 0;
+            bool answered = transport.send(method, target, body, status, responseBody);
+            uint64_t micros = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - began).count());
+            Outcome outcome = !answered || status >= 500 || status == 400 ? Outcome::ERROR
+                            : status >= 400 ? Outcome::REJECTED : Outcome::OK;
+            if ((op == BOOK || op == BATCH) && outcome == Outcome::OK) {
+                parseIds(responseBody, myBookings);
+            } else if (op == CANCEL) {
+                myBookings[cancelIndex] = myBookings.back();
+                myBookings.pop_back();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            tally.latency[op].record(micros);
+            if (outcome == Outcome::REJECTED) tally.rejected[op]++;
+            if (outcome == Outcome::ERROR) tally.errors[op]++;
+        }
+    }
+
+    // Adds what happened since the last call to into and starts over
+    void drain(Tally& into) {
+        std::lock_guard<std::mutex> lock(mutex);
+        into.merge(tally);
+        tally.clear();
+    }
+};
+
+void printSummary(const Tally& total, double seconds) {
+    std::cout << std::endl << std::left << std::setw(14) << "operation" << std::right
+              << std::setw(10) << "count" << std::setw(10) << "ops/s" << std::setw(10) << "rejected"
+              << std::setw(8) << "errors" << std::setw(10) << "mean ms" << std::setw(9) << "p50"
+              << std::setw(9) << "p90" << std::setw(9) << "p99" << std::setw(9) << "p99.9"
+              << std::setw(10) << "max" << std::endl;
+    auto row = [seconds](const std::string& name, const Histogram& latency, uint64_t rejected, uint64_t errors) {
+        std::cout << std::left << std::setw(14) << name << std::right << std::fixed
+                  << std::setw(10) << latency.count()
+                  << std::setw(10) << std::setprecision(0) << latency.count() / seconds
+                  << std::setw(10) << rejected << std::setw(8) << errors << std::setprecision(2)
+                  << std::setw(10) << latency.meanMs() << std::setw(9) << latency.percentileMs(50)
+                  << std::setw(9) << latency.percentileMs(90) << std::setw(9) << latency.percentileMs(99)
+                  << std::setw(9) << latency.percentileMs(99.9) << std::setw(10) << latency.maxMs() << std::endl;
+    };
+    uint64_t rejected = 0;
+    for (int op = 0; op < OPERATION_COUNT; op++) {
+        rejected += total.rejected[op];
+        if (total.latency[op].count() > 0) {
+            row(OPERATION_NAMES[op], total.latency[op], total.rejected[op], total.errors[op]);
+        }
+    }
+    row("all", total.overall(), rejected, total.totalErrors());
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: WorkloadDriver [--data=DIR] [--url=HOST:PORT] [--threads=N] [--seconds=S] "
+                     "[--interval=S] [--rate=R] [--mix=search=W,availability=W,quote=W,book=W,update=W,cancel=W,batch=W] "
+                     "[--zipf=S] [--horizon=D] [--seed=N] [--csv=FILE] [--slotted-storage] "
+                     "[--durability=sync|group|async] [--partitioned-bookings]" << std::endl;
+        return 1;
+    }
+#ifdef _WIN32
+    if (!options.host.empty()) {
+        std::cerr << "--url is not supported on this platform." << std::endl;
+        return 1;
+    }
+#endif
+
+    // The same wiring as the application; in-process runs go through ApiServer::handle without the network
+    PersistenceQueue persistence(options.durability);
+    ChangeLog changeLog(options.dataDirectory);
+    CarService carService(options.dataDirectory);
+    CustomerService customerService(options.dataDirectory);
+    BookingService bookingService(options.dataDirectory);
+    std::unique_ptr<IntegrityService> integrityService;
+    std::unique_ptr<LifecycleScheduler> scheduler;
+    std::unique_ptr<PricingEngine> pricing;
+    std::unique_ptr<ApiServer> api;
+    bool inProcess = options.host.empty();
+    if (inProcess) {
+        carService.setPersistenceQueue(&persistence);
+        customerService.setPersistenceQueue(&persistence);
+        bookingService.setPersistenceQueue(&persistence);
+        changeLog.load();
+        carService.setChangeLog(&changeLog);
+        customerService.setChangeLog(&changeLog);
+        bookingService.setChangeLog(&changeLog);
+        if (options.storageMode == StorageMode::SLOTTED) {
+            carService.setStorageMode(options.storageMode);
+            customerService.setStorageMode(options.storageMode);
+            bookingService.setStorageMode(options.storageMode);
+        }
+        if (options.partitionBookings && !bookingService.enablePartitions()) {
+            std::cerr << "Bookings stay in one file: " << bookingService.getLastError() << std::endl;
+        }
+        integrityService = std::make_unique<IntegrityService>(carService, customerService, bookingService);
+        scheduler = std::make_unique<LifecycleScheduler>(bookingService, carService);
+        pricing = std::make_unique<PricingEngine>(options.dataDirectory + "/pricing.csv");
+        pricing->load();
+        api = std::make_unique<ApiServer>(carService, customerService, bookingService, *integrityService,
+                                          *scheduler, *pricing, 1);
+        api->tick();
+    }
+
+    std::mt19937_64 random(options.seed);
+    std::cout << "Loading the fleet and customers from " << options.dataDirectory << "..." << std::endl;
+    Catalog catalog = loadCatalog(carService, customerService, options.zipf, options.horizon, random);
+    if (catalog.models.empty() || catalog.customerIds.empty()) {
+        std::cerr << "Need at least one car and one active customer in " << options.dataDirectory << "." << std::endl;
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Transport>> transports;
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < options.threads; i++) {
+#ifndef _WIN32
+        if (!inProcess) {
+            transports.push_back(std::make_unique<HttpTransport>(options.host, options.port));
+        } else
+#endif
+        {
+            transports.push_back(std::make_unique<InProcessTransport>(*api));
+        }
+        clients.push_back(std::make_unique<Client>(options, catalog, *transports.back(), random()));
+    }
+
+    std::cout << (inProcess ? "In-process" : "HTTP to " + options.host + ":" + std::to_string(options.port))
+              << ", " << options.threads << " client(s), " << options.seconds << " s, "
+              << (options.rate > 0 ? std::to_string(static_cast<long long>(options.rate)) + " ops/s target"
+                                   : std::string("unthrottled"))
+              << ", " << catalog.models.size() << " models (zipf " << options.zipf << "), "
+              << catalog.customerIds.size() << " customers" << std::endl;
+    std::ofstream csv;
+    if (!options.csvFile.empty()) {
+        csv.open(options.csvFile);
+        csv << "Seconds,OpsPerSecond,Errors,P50Ms,P99Ms,P999Ms,MaxMs\n";
+    }
+    std::cout << std::endl << std::right << std::setw(8) << "time" << std::setw(10) << "ops/s"
+              << std::setw(8) << "errors" << std::setw(9) << "p50 ms" << std::setw(9) << "p99"
+              << std::setw(9) << "p99.9" << std::setw(10) << "max" << std::endl;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.seconds));
+    std::vector<std::thread> threads;
+    for (auto& client : clients) {
+        threads.emplace_back([&client, start, end]() { client->run(start, end); });
+    }
+
+    // Progress lines from this thread while the clients run
+    Tally total;
+    Clock::time_point lastReport = start;
+    while (lastReport < end) {
+        Clock::time_point next = std::min(end, lastReport + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.interval)));
+        std::this_thread::sleep_until(next);
+        if (next >= end) {
+            for (auto& thread : threads) thread.join();
+            threads.clear();
+        }
+        Tally window;
+        for (auto& client : clients) client->drain(window);
+        total.merge(window);
+
+        Histogram latency = window.overall();
+        double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        double windowSeconds = std::chrono::duration<double>(Clock::now() - lastReport).count();
+        lastReport = next;
+        std::cout << std::fixed << std::setprecision(1) << std::setw(7) << elapsed << "s"
+                  << std::setprecision(0) << std::setw(10) << latency.count() / windowSeconds
+                  << std::setw(8) << window.totalErrors() << std::setprecision(2)
+                  << std::setw(9) << latency.percentileMs(50) << std::setw(9) << latency.percentileMs(99)
+                  << std::setw(9) << latency.percentileMs(99.9) << std::setw(10) << latency.maxMs() << std::endl;
+        if (csv.is_open()) {
+            csv << std::fixed << std::setprecision(1) << elapsed << "," << std::setprecision(0)
+                << latency.count() / windowSeconds << "," << window.totalErrors() << "," << std::setprecision(3)
+                << latency.percentileMs(50) << "," << latency.percentileMs(99) << ","
+                << latency.percentileMs(99.9) << "," << latency.maxMs() << "\n";
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printSummary(total, seconds);
+    if (inProcess) {
+        persistence.flush();
+        if (persistence.getFailedWrites() > 0) {
+            std::cerr << persistence.getFailedWrites() << " write(s) failed: " << persistence.getLastError()
+                      << std::endl;
+        }
+    }
+    return total.totalErrors() > 0 ? 2 : 0;
+}
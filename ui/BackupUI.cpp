@@ -0,0 +1,115 @@
+#include "BackupUI.h"
+#include <iostream>
+#include <iomanip>
+
+BackupUI::BackupUI(CarService& carService, CustomerService& customerService, BookingService& bookingService,
+                   const std::string& backupDirectory)
+    : backupService(carService, customerService, bookingService, backupDirectory) {
+}
+
+void BackupUI::showMainMenu() {
+    Menu menu("Backup & Restore");
+    
+    menu.addOption("Create Backup", [this]() { createBackup(); });
+    menu.addOption("List Backups", [this]() { listBackups(); });
+    menu.addOption("Verify Backup", [this]() { verifyBackup(); });
+    menu.addOption("Restore Backup", [this]() { restoreBackup(); });
+    
+    menu.run();
+}
+
+void BackupUI::createBackup() {
+    Menu::displayHeader("Create Backup");
+    
+    BackupResult result = backupService.createBackup();
+    if (result.success) {
+        displayBackupResult(result);
+    } else {
+        Menu::displayError(result.error);
+    }
+    
+    Menu::pause();
+}
+
+void BackupUI::listBackups() {
+    Menu::displayHeader("Backups");
+    
+    std::vector<BackupInfo> backups = backupService.listBackups();
+    if (backups.empty()) {
+        Menu::displayInfo("No backups found.");
+        Menu::pause();
+        return;
+    }
+    
+    std::cout << std::left << std::setw(6) << "ID" << std::setw(22) << "Created" << std::setw(8) << "Files"
+              << std::right << std::setw(14) << "Size" << std::setw(14) << "New Data" << std::endl;
+    std::cout << std::string(64, '-') << std::endl;
+    for (const auto& info : backups) {
+        std::cout << std::left << std::setw(6) << info.backupId << std::setw(22) << info.created
+                  << std::setw(8) << info.files << std::right << std::setw(14) << info.totalBytes
+                  << std::setw(14) << info.newBytes << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void BackupUI::verifyBackup() {
+    Menu::displayHeader("Verify Backup");
+    
+    int backupId = Menu::getPositiveInt("Enter backup ID: ");
+    VerifyResult result = backupService.verifyBackup(backupId);
+    if (!result.error.empty()) {
+        Menu::displayError(result.error);
+    } else {
+        std::cout << "Chunks checked: " << result.chunksChecked << " (" << result.bytesChecked << " bytes)" << std::endl;
+        for (const auto& problem : result.problems) {
+            std::cout << "  " << problem << std::endl;
+        }
+        if (result.success) {
+            Menu::displaySuccess("Backup " + std::to_string(backupId) + " is intact.");
+        } else {
+            Menu::displayError("Backup " + std::to_string(backupId) + " is damaged.");
+        }
+    }
+    
+    Menu::pause();
+}
+
+void BackupUI::restoreBackup() {
+    Menu::displayHeader("Restore Backup");
+    
+    int backupId = Menu::getPositiveInt("Enter backup ID: ");
+    std::cout << "The current data is backed up first, so the restore can be undone." << std::endl;
+    if (!Menu::getYesNo("Replace the current data with backup " + std::to_string(backupId) + "?")) {
+        Menu::displayInfo("Restore cancelled.");
+        Menu::pause();
+        return;
+    }
+    
+    BackupResult safety = backupService.createBackup();
+    if (!safety.success) {
+        Menu::displayError("Could not back up the current data: " + safety.error);
+        Menu::pause();
+        return;
+    }
+    std::cout << "Current data saved as backup " << safety.info.backupId << "." << std::endl;
+    
+    std::string error;
+    if (backupService.restoreBackup(backupId, error)) {
+        Menu::displaySuccess("Backup " + std::to_string(backupId) + " restored.");
+    } else {
+        Menu::displayError(error);
+    }
+    
+    Menu::pause();
+}
+
+void BackupUI::displayBackupResult(const BackupResult& result) {
+    const BackupInfo& info = result.info;
+    std::cout << "Backup ID: " << info.backupId << std::endl;
+    std::cout << "Created: " << info.created << std::endl;
+    std::cout << "Files: " << info.files << " (" << result.filesUnchanged << " unchanged since the last backup)" << std::endl;
+    std::cout << "Data size: " << info.totalBytes << " bytes" << std::endl;
+    std::cout << "New data stored: " << info.newBytes << " bytes in " << info.newChunks << " chunk(s)" << std::endl;
+    Menu::displaySuccess("Backup created successfully!");
+}
@@ -0,0 +1,25 @@
+#ifndef BACKUP_UI_H
+#define BACKUP_UI_H
+
+#include "../services/BackupService.h"
+#include "Menu.h"
+
+class BackupUI {
+private:
+    BackupService backupService;
+
+public:
+    BackupUI(CarService& carService, CustomerService& customerService, BookingService& bookingService,
+             const std::string& backupDirectory = "data/backups");
+    
+    void showMainMenu();
+    void createBackup();
+    void listBackups();
+    void verifyBackup();
+    void restoreBackup();
+    
+private:
+    void displayBackupResult(const BackupResult& result);
+};
+
+#endif // BACKUP_UI_H
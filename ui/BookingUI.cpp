@@ -1,14 +1,24 @@
 #include "BookingUI.h"
+#include "../services/ExportService.h"
+#include "Pager.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <cstdlib>
 
-BookingUI::BookingUI() {
+BookingUI::BookingUI(BookingService& bookingService, CarService& carService, CustomerService& customerService,
+                     LifecycleScheduler& scheduler, PricingEngine& pricing)
+    : bookingService(bookingService), carService(carService), customerService(customerService),
+      scheduler(scheduler), pricing(pricing), availabilityService(carService, bookingService) {
 }
 
 void BookingUI::showMainMenu() {
     Menu menu("Booking Management");
     
     menu.addOption("Add New Booking", [this]() { addBooking(); });
+    menu.addOption("Add Group Booking", [this]() { addGroupBooking(); });
+    menu.addOption("Search Available Cars", [this]() { searchAvailableCars(); });
+    menu.addOption("Quote Rental", [this]() { quoteRental(); });
     menu.addOption("View All Bookings", [this]() { viewAllBookings(); });
     menu.addOption("View Booking by ID", [this]() { viewBookingById(); });
     menu.addOption("View Bookings by Customer", [this]() { viewBookingsByCustomer(); });
@@ -16,6 +26,11 @@ void BookingUI::showMainMenu() {
     menu.addOption("Update Booking", [this]() { updateBooking(); });
     menu.addOption("Delete Booking", [this]() { deleteBooking(); });
     menu.addOption("View Active Bookings", [this]() { viewActiveBookings(); });
+    menu.addOption("View Overdue Bookings", [this]() { viewOverdueBookings(); });
+    menu.addOption("Return Car", [this]() { returnCar(); });
+    menu.addOption("Export Bookings", [this]() { exportBookings(); });
+    menu.addOption("Archive Closed Bookings", [this]() { archiveClosedBookings(); });
+    menu.addOption("Search Archived Bookings", [this]() { searchArchivedBookings(); });
     
     menu.run();
 }
@@ -30,28 +45,91 @@ void BookingUI::addBooking() {
         return;
     }
     
+    if (!bookingService.isCarAvailable(booking.getCarId(), booking.getStartDate(), booking.getEndDate())) {
+        Menu::displayError("Car " + std::to_string(booking.getCarId()) + " is already booked for these dates.");
+        Menu::pause();
+        return;
+    }
+    
     if (bookingService.addBooking(booking)) {
         Menu::displaySuccess("Booking added successfully!");
     } else {
-        Menu::displayError("Failed to add booking. Please try again.");
+        std::string error = bookingService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to add booking. Please try again." : error);
     }
     
     Menu::pause();
 }
 
-void BookingUI::viewAllBookings() {
-    Menu::displayHeader("All Bookings");
+void BookingUI::addGroupBooking() {
+    Menu::displayHeader("Add Group Booking");
+    
+    displayCustomerSelection();
+    int customerId = Menu::getPositiveInt("Enter Customer ID: ");
+    std::string startDate = Menu::getNonEmptyString("Enter Start Date (YYYY-MM-DD): ");
+    std::string endDate = Menu::getNonEmptyString("Enter End Date (YYYY-MM-DD): ");
+    
+    displayCarSelection(startDate, endDate);
+    std::string carList = Menu::getNonEmptyString("Enter Car IDs (comma separated): ");
+    std::string notes = Menu::getString("Enter Notes (optional): ");
+    
+    std::vector<Booking> bookings;
+    std::stringstream ss(carList);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.find_first_not_of(" ") == std::string::npos) continue;
+        
+        int carId = std::atoi(item.c_str());
+        Car car = carService.getCarById(carId);
+        if (car.getCarId() == 0) {
+            Menu::displayError("Car not found with ID: " + item);
+            Menu::pause();
+            return;
+        }
+        
+        Booking booking(customerId, carId, startDate, endDate, 0.0);
+        booking.setTotalCost(pricing.quote(car, startDate, endDate));
+        booking.setNotes(notes);
+        bookings.push_back(booking);
+    }
     
-    std::vector<Booking> bookings = bookingService.getAllBookings();
     if (bookings.empty()) {
-        Menu::displayInfo("No bookings found.");
+        Menu::displayError("No cars selected.");
+        Menu::pause();
+        return;
+    }
+    
+    if (bookingService.addBookings(bookings)) {
+        double total = 0.0;
+        for (const auto& booking : bookings) {
+            total += booking.getTotalCost();
+        }
+        Menu::displaySuccess(std::to_string(bookings.size()) + " bookings added (IDs " +
+                             std::to_string(bookings.front().getBookingId()) + "-" +
+                             std::to_string(bookings.back().getBookingId()) + ").");
+        std::cout << "Group total: $" << std::fixed << std::setprecision(2) << total << std::endl;
     } else {
-        displayBookings(bookings);
+        Menu::displayError("Group booking rejected: " + bookingService.getLastError());
     }
     
     Menu::pause();
 }
 
+void BookingUI::viewAllBookings() {
+    PagerSource source;
+    source.sortColumns = {"ID", "Customer", "Car", "Start Date", "End Date", "Total Cost", "Status"};
+    source.count = [this]() { return bookingService.getBookingCount(); };
+    source.showPage = [this](size_t sortColumn, size_t offset, size_t limit) {
+        displayBookings(bookingService.getBookingsPage(static_cast<BookingSortKey>(sortColumn), offset, limit));
+    };
+    source.findPosition = [this](size_t sortColumn, int bookingId) {
+        return bookingService.findBookingPosition(bookingId, static_cast<BookingSortKey>(sortColumn));
+    };
+    
+    Pager pager("All Bookings", source);
+    pager.run();
+}
+
 void BookingUI::viewBookingById() {
     Menu::displayHeader("View Booking by ID");
     
@@ -113,16 +191,11 @@ void BookingUI::updateBooking() {
     std::cout << "\nEnter new details:" << std::endl;
     updateBookingFromInput(booking);
     
-    if (!booking.isValid()) {
-        Menu::displayError("Invalid booking data: " + booking.getValidationErrors());
-        Menu::pause();
-        return;
-    }
-    
     if (bookingService.updateBooking(booking)) {
         Menu::displaySuccess("Booking updated successfully!");
     } else {
-        Menu::displayError("Failed to update booking. Please try again.");
+        std::string error = bookingService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to update booking. Please try again." : error);
     }
     
     Menu::pause();
@@ -158,19 +231,225 @@ void BookingUI::deleteBooking() {
 void BookingUI::viewActiveBookings() {
     Menu::displayHeader("Active Bookings");
     
-    std::vector<Booking> allBookings = bookingService.getAllBookings();
-    std::vector<Booking> activeBookings;
+    if (streamBookings([](const Booking& booking) { return booking.isActive(); }) == 0) {
+        Menu::displayInfo("No active bookings found.");
+    }
+    
+    Menu::pause();
+}
+
+void BookingUI::viewOverdueBookings() {
+    Menu::displayHeader("Overdue Bookings");
+    
+    if (streamBookings([](const Booking& booking) { return booking.isOverdue(); }) == 0) {
+        Menu::displayInfo("No overdue bookings found.");
+    }
     
-    for (const auto& booking : allBookings) {
-        if (booking.isActive()) {
-            activeBookings.push_back(booking);
+    Menu::pause();
+}
+
+void BookingUI::returnCar() {
+    Menu::displayHeader("Return Car");
+    
+    std::string input = Menu::getNonEmptyString("Enter Booking ID or License Plate: ");
+    int bookingId = 0;
+    if (input.find_first_not_of("0123456789") == std::string::npos) {
+        bookingId = std::atoi(input.c_str());
+    } else {
+        // At the counter the plate is what the clerk has: find the booking holding that car
+        Car car = carService.findCarByPlate(input);
+        if (car.getCarId() == 0) {
+            Menu::displayError("No car found with license plate: " + input);
+            Menu::pause();
+            return;
+        }
+        for (const auto& candidate : bookingService.getBookingsByCarId(car.getCarId())) {
+            if (candidate.isOverdue() || (candidate.isActive() &&
+                Booking::dateToDays(candidate.getStartDate()) <= Booking::today())) {
+                bookingId = candidate.getBookingId();
+            }
         }
+        if (bookingId == 0) {
+            Menu::displayError("Car " + input + " has no booking in progress.");
+            Menu::pause();
+            return;
+        }
+    }
+    Booking booking = bookingService.getBookingById(bookingId);
+    
+    if (booking.getBookingId() == 0) {
+        Menu::displayError("Booking not found with ID: " + std::to_string(bookingId));
+        Menu::pause();
+        return;
     }
     
-    if (activeBookings.empty()) {
-        Menu::displayInfo("No active bookings found.");
+    displayBooking(booking);
+    
+    if (Menu::getYesNo("Mark this car as returned?")) {
+        if (scheduler.returnCar(bookingId)) {
+            Menu::displaySuccess("Car returned and booking completed.");
+        } else {
+            Menu::displayError(scheduler.getLastError());
+        }
+    }
+    
+    Menu::pause();
+}
+
+void BookingUI::searchAvailableCars() {
+    Menu::displayHeader("Search Available Cars");
+    
+    AvailabilityQuery query;
+    query.startDate = Menu::getNonEmptyString("Enter Start Date (YYYY-MM-DD): ");
+    query.endDate = Menu::getNonEmptyString("Enter End Date (YYYY-MM-DD): ");
+    if (!Booking::isValidDate(query.startDate) || !Booking::isValidDate(query.endDate) ||
+        !Booking::isDateAfter(query.endDate, query.startDate)) {
+        Menu::displayError("Please enter valid dates with the end date after the start date.");
+        Menu::pause();
+        return;
+    }
+    
+    std::cout << "Fuel Type (0-Any, 1-Gasoline, 2-Diesel, 3-Electric, 4-Hybrid): ";
+    int fuelChoice = Menu::getChoice(0, 4);
+    if (fuelChoice > 0) query.filter.fuelType = static_cast<FuelType>(fuelChoice - 1);
+    
+    std::cout << "Transmission (0-Any, 1-Manual, 2-Automatic): ";
+    int transChoice = Menu::getChoice(0, 2);
+    if (transChoice > 0) query.filter.transmission = static_cast<Transmission>(transChoice - 1);
+    
+    query.filter.minSeats = Menu::getInt("Minimum seats (0 for any): ");
+    query.filter.maxDailyRate = Menu::getDouble("Maximum daily rate (0 for any): $");
+    
+    std::vector<Car> cars = availabilityService.findAvailableCars(query);
+    if (cars.empty()) {
+        Menu::displayInfo("No cars are free for these dates with the selected filters.");
     } else {
-        displayBookings(activeBookings);
+        std::cout << "\n" << cars.size() << " car(s) free from " << query.startDate
+                  << " to " << query.endDate << ":" << std::endl;
+        displayAvailableCars(cars, query.startDate, query.endDate);
+    }
+    
+    Menu::pause();
+}
+
+void BookingUI::quoteRental() {
+    Menu::displayHeader("Quote Rental");
+    
+    Car car = carService.getCarById(Menu::getPositiveInt("Enter Car ID: "));
+    if (car.getCarId() == 0) {
+        Menu::displayError("Car not found.");
+        Menu::pause();
+        return;
+    }
+    std::string startDate = Menu::getNonEmptyString("Enter Start Date (YYYY-MM-DD): ");
+    std::string endDate = Menu::getNonEmptyString("Enter End Date (YYYY-MM-DD): ");
+    if (!Booking::isValidDate(startDate) || !Booking::isValidDate(endDate) ||
+        !Booking::isDateAfter(endDate, startDate)) {
+        Menu::displayError("Please enter valid dates with the end date after the start date.");
+        Menu::pause();
+        return;
+    }
+    
+    int days = Booking::daysBetween(startDate, endDate);
+    double quote = pricing.quote(car, startDate, endDate);
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << car.getMake() << " " << car.getModel() << " (" << car.getFuelTypeString() << "), "
+              << days << " day(s)" << std::endl;
+    std::cout << "Base rate:  $" << car.getDailyRate() << " x " << days << " = $" << car.calculateRentalCost(days)
+              << std::endl;
+    std::cout << "Quote:      $" << quote << " ($" << quote / days << " per day)" << std::endl;
+    if (!bookingService.isCarAvailable(car.getCarId(), startDate, endDate)) {
+        Menu::displayInfo("This car is already booked for some of these dates.");
+    }
+    
+    Menu::pause();
+}
+
+void BookingUI::exportBookings() {
+    Menu::displayHeader("Export Bookings");
+    
+    std::cout << "Format (1-CSV, 2-JSON): ";
+    ExportFormat format = Menu::getChoice(1, 2) == 1 ? ExportFormat::CSV : ExportFormat::JSON;
+    std::string defaultPath = format == ExportFormat::CSV ? "data/bookings_export.csv" : "data/bookings_export.json";
+    std::string path = Menu::getString("Enter output file [" + defaultPath + "]: ");
+    if (path.empty()) path = defaultPath;
+    bool activeOnly = Menu::getYesNo("Export active bookings only?");
+    
+    std::function<bool(const Booking&)> predicate;
+    if (activeOnly) {
+        predicate = [](const Booking& booking) { return booking.isActive(); };
+    }
+    
+    ExportResult result = ExportService::exportBookings(bookingService, path, format, predicate);
+    if (result.success) {
+        Menu::displaySuccess("Exported " + std::to_string(result.rows) + " booking(s) to " + path);
+    } else {
+        Menu::displayError("Export failed: " + result.error);
+    }
+    
+    Menu::pause();
+}
+
+void BookingUI::archiveClosedBookings() {
+    Menu::displayHeader("Archive Closed Bookings");
+    
+    std::string defaultCutoff = Booking::daysToDate(Booking::today() - 90);
+    std::string cutoff = Menu::getString("Archive completed/cancelled bookings that ended before [" +
+                                         defaultCutoff + "]: ");
+    if (cutoff.empty()) cutoff = defaultCutoff;
+    if (!Booking::isValidDate(cutoff)) {
+        Menu::displayError("Invalid date: " + cutoff);
+        Menu::pause();
+        return;
+    }
+    
+    size_t archived = 0;
+    if (bookingService.archiveClosedBookings(Booking::dateToDays(cutoff), archived)) {
+        Menu::displaySuccess("Archived " + std::to_string(archived) + " booking(s).");
+    } else {
+        Menu::displayError("Archiving failed: " + bookingService.getLastError());
+    }
+    
+    const std::vector<ArchiveSegment>& segments = bookingService.getArchiveSegments();
+    long long count = 0, rawBytes = 0, storedBytes = 0;
+    for (const auto& segment : segments) {
+        count += segment.count;
+        rawBytes += segment.rawBytes;
+        storedBytes += segment.storedBytes;
+    }
+    std::cout << "Archive: " << count << " booking(s) in " << segments.size() << " segment(s), "
+              << storedBytes / 1024 << " KB stored (" << rawBytes / 1024 << " KB uncompressed)" << std::endl;
+    
+    Menu::pause();
+}
+
+void BookingUI::searchArchivedBookings() {
+    Menu::displayHeader("Search Archived Bookings");
+    
+    std::string fromDate = Menu::getNonEmptyString("From date (YYYY-MM-DD): ");
+    std::string toDate = Menu::getNonEmptyString("To date (YYYY-MM-DD): ");
+    if (!Booking::isValidDate(fromDate) || !Booking::isValidDate(toDate)) {
+        Menu::displayError("Invalid date range.");
+        Menu::pause();
+        return;
+    }
+    
+    ArchiveFilter filter;
+    filter.fromDay = Booking::dateToDays(fromDate);
+    filter.toDay = Booking::dateToDays(toDate) + 1; // Inclusive
+    filter.carId = Menu::getInt("Car ID (0 for any): ");
+    filter.customerId = Menu::getInt("Customer ID (0 for any): ");
+    
+    int count = 0;
+    bool ok = bookingService.forEachArchivedBooking(filter, [this, &count](const Booking& booking) {
+        if (count++ == 0) displayBookingHeader();
+        displayBookingRow(booking);
+    });
+    if (!ok) {
+        Menu::displayError(bookingService.getLastError());
+    }
+    if (count == 0) {
+        Menu::displayInfo("No archived bookings found.");
     }
     
     Menu::pause();
@@ -181,6 +460,13 @@ void BookingUI::displayBooking(const Booking& booking) {
 }
 
 void BookingUI::displayBookings(const std::vector<Booking>& bookings) {
+    displayBookingHeader();
+    for (const auto& booking : bookings) {
+        displayBookingRow(booking);
+    }
+}
+
+void BookingUI::displayBookingHeader() {
     std::cout << std::left << std::setw(5) << "ID" 
               << std::setw(8) << "CustID" 
               << std::setw(6) << "CarID" 
@@ -190,18 +476,27 @@ void BookingUI::displayBookings(const std::vector<Booking>& bookings) {
               << std::setw(12) << "Total Cost" 
               << std::setw(10) << "Status" << std::endl;
     std::cout << std::string(90, '-') << std::endl;
-    
-    for (const auto& booking : bookings) {
-        std::cout << std::left << std::setw(5) << booking.getBookingId()
-                  << std::setw(8) << booking.getCustomerId()
-                  << std::setw(6) << booking.getCarId()
-                  << std::setw(12) << booking.getStartDate()
-                  << std::setw(12) << booking.getEndDate()
-                  << std::setw(8) << booking.getDuration()
-                  << std::setw(12) << std::fixed << std::setprecision(2) << booking.getTotalCost()
-                  << std::setw(10) << booking.getStatus()
-                  << std::endl;
-    }
+}
+
+void BookingUI::displayBookingRow(const Booking& booking) {
+    std::cout << std::left << std::setw(5) << booking.getBookingId()
+              << std::setw(8) << booking.getCustomerId()
+              << std::setw(6) << booking.getCarId()
+              << std::setw(12) << booking.getStartDate()
+              << std::setw(12) << booking.getEndDate()
+              << std::setw(8) << booking.getDuration()
+              << std::setw(12) << std::fixed << std::setprecision(2) << booking.getTotalCost()
+              << std::setw(10) << booking.getStatus()
+              << std::endl;
+}
+
+int BookingUI::streamBookings(const std::function<bool(const Booking&)>& predicate) {
+    int count = 0;
+    bookingService.forEachBooking(predicate, [this, &count](const Booking& booking) {
+        if (count++ == 0) displayBookingHeader();
+        displayBookingRow(booking);
+    });
+    return count;
 }
 
 Booking BookingUI::createBookingFromInput() {
@@ -211,17 +506,17 @@ Booking BookingUI::createBookingFromInput() {
     displayCustomerSelection();
     booking.setCustomerId(Menu::getPositiveInt("Enter Customer ID: "));
     
-    // Display available cars
-    displayCarSelection();
-    booking.setCarId(Menu::getPositiveInt("Enter Car ID: "));
-    
     booking.setStartDate(Menu::getNonEmptyString("Enter Start Date (YYYY-MM-DD): "));
     booking.setEndDate(Menu::getNonEmptyString("Enter End Date (YYYY-MM-DD): "));
     
+    // Display cars that are free for the requested dates
+    displayCarSelection(booking.getStartDate(), booking.getEndDate());
+    booking.setCarId(Menu::getPositiveInt("Enter Car ID: "));
+    
     // Calculate total cost
     Car car = carService.getCarById(booking.getCarId());
     if (car.getCarId() > 0) {
-        double totalCost = booking.calculateCost(car.getDailyRate());
+        double totalCost = pricing.quote(car, booking.getStartDate(), booking.getEndDate());
         booking.setTotalCost(totalCost);
         std::cout << "Calculated total cost: $" << std::fixed << std::setprecision(2) << totalCost << std::endl;
     } else {
@@ -262,27 +557,45 @@ void BookingUI::updateBookingFromInput(Booking& booking) {
     if (!input.empty()) booking.setNotes(input);
 }
 
-void BookingUI::displayCarSelection() {
-    std::vector<Car> cars = carService.getAvailableCars();
+void BookingUI::displayCarSelection(const std::string& startDate, const std::string& endDate) {
+    const size_t maxShown = 50;
+    
+    AvailabilityQuery query;
+    query.startDate = startDate;
+    query.endDate = endDate;
+    query.limit = maxShown;
+    
+    std::vector<Car> cars = availabilityService.findAvailableCars(query);
     if (cars.empty()) {
-        Menu::displayInfo("No available cars found.");
+        Menu::displayInfo("No available cars found for these dates.");
         return;
     }
     
-    std::cout << "\nAvailable Cars:" << std::endl;
+    std::cout << "\nAvailable Cars" << (cars.size() == maxShown ? " (cheapest " + std::to_string(maxShown) + ")" : "")
+              << ":" << std::endl;
+    displayAvailableCars(cars, startDate, endDate);
+}
+
+void BookingUI::displayAvailableCars(const std::vector<Car>& cars, const std::string& startDate,
+                                     const std::string& endDate) {
+    std::vector<double> quotes = pricing.quoteAll(cars, startDate, endDate);
+    
     std::cout << std::left << std::setw(5) << "ID" 
               << std::setw(15) << "Make" 
               << std::setw(15) << "Model" 
               << std::setw(8) << "Year" 
-              << std::setw(12) << "Daily Rate" << std::endl;
-    std::cout << std::string(60, '-') << std::endl;
+              << std::setw(12) << "Daily Rate"
+              << std::setw(12) << "Quote" << std::endl;
+    std::cout << std::string(72, '-') << std::endl;
     
-    for (const auto& car : cars) {
+    for (size_t i = 0; i < cars.size(); i++) {
+        const Car& car = cars[i];
         std::cout << std::left << std::setw(5) << car.getCarId()
                   << std::setw(15) << car.getMake()
                   << std::setw(15) << car.getModel()
                   << std::setw(8) << car.getYear()
                   << std::setw(12) << std::fixed << std::setprecision(2) << car.getDailyRate()
+                  << std::setw(12) << quotes[i]
                   << std::endl;
     }
 }
@@ -302,6 +615,7 @@ void BookingUI::displayCustomerSelection() {
     std::cout << std::string(65, '-') << std::endl;
     
     for (const auto& customer : customers) {
+        if (!customer.isActive()) continue;
         std::cout << std::left << std::setw(5) << customer.getCustomerId()
                   << std::setw(20) << customer.getFullName()
                   << std::setw(25) << customer.getEmail()
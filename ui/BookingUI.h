@@ -5,20 +5,29 @@
 #include "../services/BookingService.h"
 #include "../services/CarService.h"
 #include "../services/CustomerService.h"
+#include "../services/AvailabilityService.h"
+#include "../services/LifecycleScheduler.h"
+#include "../services/PricingEngine.h"
 #include "Menu.h"
 #include <vector>
+#include <functional>
 
 class BookingUI {
 private:
-    BookingService bookingService;
-    CarService carService;
-    CustomerService customerService;
+    BookingService& bookingService;
+    CarService& carService;
+    CustomerService& customerService;
+    LifecycleScheduler& scheduler;
+    PricingEngine& pricing;
+    AvailabilityService availabilityService;
 
 public:
-    BookingUI();
+    BookingUI(BookingService& bookingService, CarService& carService, CustomerService& customerService,
+              LifecycleScheduler& scheduler, PricingEngine& pricing);
     
     void showMainMenu();
     void addBooking();
+    void addGroupBooking();
     void viewAllBookings();
     void viewBookingById();
     void viewBookingsByCustomer();
@@ -26,13 +35,24 @@ public:
     void updateBooking();
     void deleteBooking();
     void viewActiveBookings();
+    void viewOverdueBookings();
+    void returnCar();
+    void exportBookings();
+    void archiveClosedBookings();
+    void searchArchivedBookings();
+    void searchAvailableCars();
+    void quoteRental();
     
 private:
     void displayBooking(const Booking& booking);
     void displayBookings(const std::vector<Booking>& bookings);
+    void displayBookingHeader();
+    void displayBookingRow(const Booking& booking);
+    int streamBookings(const std::function<bool(const Booking&)>& predicate);
     Booking createBookingFromInput();
     void updateBookingFromInput(Booking& booking);
-    void displayCarSelection();
+    void displayCarSelection(const std::string& startDate, const std::string& endDate);
+    void displayAvailableCars(const std::vector<Car>& cars, const std::string& startDate, const std::string& endDate);
     void displayCustomerSelection();
 };
 
@@ -0,0 +1,172 @@
+#include "BranchUI.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+
+BranchUI::BranchUI(BranchNetwork& network, const std::string& currentBranch)
+    : network(network), currentBranch(currentBranch) {
+}
+
+void BranchUI::showMainMenu() {
+    Menu menu("Branch Network");
+    
+    menu.addOption("List Branches", [this]() { listBranches(); });
+    menu.addOption("Add Branch", [this]() { addBranch(); });
+    menu.addOption("Fleet Statistics (all branches)", [this]() { showFleetStatistics(); });
+    menu.addOption("Search Cars (all branches)", [this]() { searchCars(); });
+    menu.addOption("Search Customers (all branches)", [this]() { searchCustomers(); });
+    menu.addOption("Search Available Cars (all branches)", [this]() { searchAvailableCars(); });
+    
+    menu.run();
+}
+
+void BranchUI::listBranches() {
+    Menu::displayHeader("Branches");
+    
+    if (!requireBranches()) return;
+    std::cout << std::left << std::setw(12) << "Code" << std::setw(30) << "Name" << "Data Directory" << std::endl;
+    std::cout << std::string(70, '-') << std::endl;
+    for (const auto& branch : network.getBranches()) {
+        std::cout << std::left << std::setw(12) << branch.code << std::setw(30) << branch.name
+                  << branch.dataDirectory << (branch.code == currentBranch ? "  (current)" : "") << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void BranchUI::addBranch() {
+    Menu::displayHeader("Add Branch");
+    
+    std::string code = Menu::getNonEmptyString("Branch code (letters, digits, - and _): ");
+    std::string name = Menu::getNonEmptyString("Branch name: ");
+    if (network.addBranch(code, name)) {
+        Menu::displaySuccess("Branch " + code + " added. Start with --branch=" + code + " to work in it.");
+    } else {
+        Menu::displayError(network.getLastError());
+    }
+    
+    Menu::pause();
+}
+
+void BranchUI::showFleetStatistics() {
+    Menu::displayHeader("Fleet Statistics");
+    
+    if (!requireBranches()) return;
+    auto started = std::chrono::steady_clock::now();
+    BranchStats total;
+    std::vector<BranchStats> stats = network.getStats(total);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    
+    auto printRow = [](const BranchStats& row) {
+        std::cout << std::left << std::setw(12) << row.branch << std::right << std::setw(8) << row.cars
+                  << std::setw(11) << row.availableCars << std::setw(11) << row.customers
+                  << std::setw(10) << row.bookings << std::setw(8) << row.openBookings
+                  << std::setw(16) << std::fixed << std::setprecision(2) << row.revenueCents / 100.0 << std::endl;
+    };
+    std::cout << std::left << std::setw(12) << "Branch" << std::right << std::setw(8) << "Cars"
+              << std::setw(11) << "Available" << std::setw(11) << "Customers" << std::setw(10) << "Bookings"
+              << std::setw(8) << "Open" << std::setw(16) << "Revenue" << std::endl;
+    std::cout << std::string(76, '-') << std::endl;
+    for (const auto& row : stats) {
+        printRow(row);
+    }
+    std::cout << std::string(76, '-') << std::endl;
+    printRow(total);
+    std::cout << "\n" << stats.size() << " branch(es) queried in " << std::setprecision(1) << elapsedMs << " ms"
+              << std::endl;
+    
+    Menu::pause();
+}
+
+void BranchUI::searchCars() {
+    Menu::displayHeader("Search Cars");
+    
+    if (!requireBranches()) return;
+    std::string term = Menu::getNonEmptyString("Search (make, model, plate): ");
+    std::vector<BranchCar> results = network.searchCars(term);
+    if (results.empty()) {
+        Menu::displayInfo("No cars found.");
+    } else {
+        std::cout << std::left << std::setw(12) << "Branch" << std::setw(6) << "ID" << std::setw(15) << "Make"
+                  << std::setw(15) << "Model" << std::setw(12) << "Plate" << std::setw(10) << "Rate"
+                  << "Status" << std::endl;
+        std::cout << std::string(80, '-') << std::endl;
+        for (const auto& result : results) {
+            const Car& car = result.car;
+            std::cout << std::left << std::setw(12) << result.branch << std::setw(6) << car.getCarId()
+                      << std::setw(15) << car.getMake() << std::setw(15) << car.getModel()
+                      << std::setw(12) << car.getLicensePlate() << std::setw(10) << std::fixed
+                      << std::setprecision(2) << car.getDailyRate() << car.getStatusString() << std::endl;
+        }
+        std::cout << "\n" << results.size() << " car(s) found." << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void BranchUI::searchCustomers() {
+    Menu::displayHeader("Search Customers");
+    
+    if (!requireBranches()) return;
+    std::string term = Menu::getNonEmptyString("Search (name, email): ");
+    std::vector<BranchCustomer> results = network.searchCustomers(term);
+    if (results.empty()) {
+        Menu::displayInfo("No customers found.");
+    } else {
+        std::cout << std::left << std::setw(12) << "Branch" << std::setw(6) << "ID" << std::setw(25) << "Name"
+                  << "Email" << std::endl;
+        std::cout << std::string(75, '-') << std::endl;
+        for (const auto& result : results) {
+            const Customer& customer = result.customer;
+            std::cout << std::left << std::setw(12) << result.branch << std::setw(6) << customer.getCustomerId()
+                      << std::setw(25) << customer.getFullName() << customer.getEmail() << std::endl;
+        }
+        std::cout << "\n" << results.size() << " customer(s) found." << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void BranchUI::searchAvailableCars() {
+    Menu::displayHeader("Search Available Cars");
+    
+    if (!requireBranches()) return;
+    AvailabilityQuery query;
+    query.startDate = Menu::getNonEmptyString("Enter Start Date (YYYY-MM-DD): ");
+    query.endDate = Menu::getNonEmptyString("Enter End Date (YYYY-MM-DD): ");
+    if (!Booking::isValidDate(query.startDate) || !Booking::isValidDate(query.endDate) ||
+        !Booking::isDateAfter(query.endDate, query.startDate)) {
+        Menu::displayError("Please enter valid dates with the end date after the start date.");
+        Menu::pause();
+        return;
+    }
+    query.filter.maxDailyRate = Menu::getDouble("Maximum daily rate (0 for any): $");
+    query.limit = 50;
+    
+    std::vector<BranchCar> results = network.findAvailableCars(query);
+    if (results.empty()) {
+        Menu::displayInfo("No cars are free for these dates in any branch.");
+    } else {
+        std::cout << std::left << std::setw(12) << "Branch" << std::setw(6) << "ID" << std::setw(15) << "Make"
+                  << std::setw(15) << "Model" << std::setw(10) << "Rate" << std::endl;
+        std::cout << std::string(58, '-') << std::endl;
+        for (const auto& result : results) {
+            const Car& car = result.car;
+            std::cout << std::left << std::setw(12) << result.branch << std::setw(6) << car.getCarId()
+                      << std::setw(15) << car.getMake() << std::setw(15) << car.getModel() << std::fixed
+                      << std::setprecision(2) << car.getDailyRate() << std::endl;
+        }
+        std::cout << "\nCheapest " << results.size() << " free car(s) across the network." << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+bool BranchUI::requireBranches() {
+    if (!network.getBranches().empty()) {
+        return true;
+    }
+    Menu::displayInfo("No branches yet. Use Add Branch to create one.");
+    Menu::pause();
+    return false;
+}
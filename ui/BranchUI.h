@@ -0,0 +1,28 @@
+#ifndef BRANCH_UI_H
+#define BRANCH_UI_H
+
+#include "../services/BranchNetwork.h"
+#include "Menu.h"
+#include <string>
+
+class BranchUI {
+private:
+    BranchNetwork& network;
+    std::string currentBranch;
+
+public:
+    BranchUI(BranchNetwork& network, const std::string& currentBranch);
+    
+    void showMainMenu();
+    void listBranches();
+    void addBranch();
+    void showFleetStatistics();
+    void searchCars();
+    void searchCustomers();
+    void searchAvailableCars();
+    
+private:
+    bool requireBranches();
+};
+
+#endif // BRANCH_UI_H
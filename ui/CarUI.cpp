@@ -1,8 +1,12 @@
 #include "CarUI.h"
+#include "../services/ImportService.h"
+#include "../services/ExportService.h"
+#include "Pager.h"
 #include <iostream>
 #include <iomanip>
 
-CarUI::CarUI() {
+CarUI::CarUI(CarService& carService, IntegrityService& integrityService)
+    : carService(carService), integrityService(integrityService) {
 }
 
 void CarUI::showMainMenu() {
@@ -11,11 +15,14 @@ void CarUI::showMainMenu() {
     menu.addOption("Add New Car", [this]() { addCar(); });
     menu.addOption("View All Cars", [this]() { viewAllCars(); });
     menu.addOption("View Car by ID", [this]() { viewCarById(); });
+    menu.addOption("Find Car by License Plate", [this]() { findCarByPlate(); });
     menu.addOption("Search Cars", [this]() { searchCars(); });
     menu.addOption("Update Car", [this]() { updateCar(); });
     menu.addOption("Delete Car", [this]() { deleteCar(); });
     menu.addOption("View Available Cars", [this]() { viewAvailableCars(); });
     menu.addOption("View Statistics", [this]() { viewStatistics(); });
+    menu.addOption("Import Cars from CSV", [this]() { importCars(); });
+    menu.addOption("Export Cars", [this]() { exportCars(); });
     
     menu.run();
 }
@@ -33,23 +40,26 @@ void CarUI::addCar() {
     if (carService.addCar(car)) {
         Menu::displaySuccess("Car added successfully!");
     } else {
-        Menu::displayError("Failed to add car. Please try again.");
+        std::string error = carService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to add car. Please try again." : error);
     }
     
     Menu::pause();
 }
 
 void CarUI::viewAllCars() {
-    Menu::displayHeader("All Cars");
-    
-    std::vector<Car> cars = carService.getAllCars();
-    if (cars.empty()) {
-        Menu::displayInfo("No cars found.");
-    } else {
-        displayCars(cars);
-    }
-    
-    Menu::pause();
+    PagerSource source;
+    source.sortColumns = {"ID", "Make", "Model", "Year", "Status", "Daily Rate"};
+    source.count = [this]() { return carService.getCarCount(); };
+    source.showPage = [this](size_t sortColumn, size_t offset, size_t limit) {
+        displayCars(carService.getCarsPage(static_cast<CarSortKey>(sortColumn), offset, limit));
+    };
+    source.findPosition = [this](size_t sortColumn, int carId) {
+        return carService.findCarPosition(carId, static_cast<CarSortKey>(sortColumn));
+    };
+    
+    Pager pager("All Cars", source);
+    pager.run();
 }
 
 void CarUI::viewCarById() {
@@ -67,6 +77,21 @@ void CarUI::viewCarById() {
     Menu::pause();
 }
 
+void CarUI::findCarByPlate() {
+    Menu::displayHeader("Find Car by License Plate");
+    
+    std::string plate = Menu::getNonEmptyString("Enter License Plate: ");
+    Car car = carService.findCarByPlate(plate);
+    
+    if (car.getCarId() == 0) {
+        Menu::displayError("No car found with license plate: " + plate);
+    } else {
+        displayCar(car);
+    }
+    
+    Menu::pause();
+}
+
 void CarUI::searchCars() {
     Menu::displayHeader("Search Cars");
     
@@ -108,7 +133,8 @@ void CarUI::updateCar() {
     if (carService.updateCar(car)) {
         Menu::displaySuccess("Car updated successfully!");
     } else {
-        Menu::displayError("Failed to update car. Please try again.");
+        std::string error = carService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to update car. Please try again." : error);
     }
     
     Menu::pause();
@@ -128,11 +154,29 @@ void CarUI::deleteCar() {
     
     displayCar(car);
     
-    if (Menu::getYesNo("Are you sure you want to delete this car?")) {
-        if (carService.deleteCar(carId)) {
-            Menu::displaySuccess("Car deleted successfully!");
+    size_t references = integrityService.countCarReferences(carId);
+    DeletePolicy policy = DeletePolicy::RESTRICT;
+    if (references > 0) {
+        std::cout << "\nThis car is referenced by " << references << " booking(s)." << std::endl;
+        std::cout << "1. Keep the car" << std::endl;
+        std::cout << "2. Retire the car (keeps booking history)" << std::endl;
+        std::cout << "3. Delete the car and its bookings" << std::endl;
+        int choice = Menu::getChoice(1, 3);
+        if (choice == 1) {
+            Menu::displayInfo("Deletion cancelled.");
+            Menu::pause();
+            return;
+        }
+        policy = choice == 2 ? DeletePolicy::SOFT_DELETE : DeletePolicy::CASCADE;
+    }
+    
+    if (Menu::getYesNo(policy == DeletePolicy::SOFT_DELETE ? "Are you sure you want to retire this car?"
+                                                           : "Are you sure you want to delete this car?")) {
+        if (integrityService.deleteCar(carId, policy)) {
+            Menu::displaySuccess(policy == DeletePolicy::SOFT_DELETE ? "Car retired successfully!"
+                                                                     : "Car deleted successfully!");
         } else {
-            Menu::displayError("Failed to delete car. Please try again.");
+            Menu::displayError(integrityService.getLastError());
         }
     } else {
         Menu::displayInfo("Deletion cancelled.");
@@ -167,6 +211,56 @@ void CarUI::viewStatistics() {
     Menu::pause();
 }
 
+void CarUI::importCars() {
+    Menu::displayHeader("Import Cars from CSV");
+    
+    std::string sourceFile = Menu::getNonEmptyString("Enter source CSV file: ");
+    std::string rejectFile = Menu::getString("Enter reject file [data/cars_rejects.csv]: ");
+    if (rejectFile.empty()) rejectFile = "data/cars_rejects.csv";
+    
+    ImportService importService;
+    ImportResult result = importService.importCars(carService, sourceFile, rejectFile);
+    
+    if (!result.success) {
+        Menu::displayError("Import failed: " + result.error);
+    } else {
+        std::cout << "Rows read: " << result.rowsRead << std::endl;
+        std::cout << "Imported: " << result.imported << std::endl;
+        std::cout << "Rejected: " << result.rejected << std::endl;
+        if (result.imported > 0) {
+            std::cout << "Assigned IDs: " << result.firstId << " - " << result.lastId << std::endl;
+        }
+        if (result.rejected > 0) {
+            Menu::displayInfo("Rejected rows were written to " + rejectFile);
+        }
+        if (!result.error.empty()) {
+            Menu::displayError(result.error);
+        }
+        Menu::displaySuccess("Import completed!");
+    }
+    
+    Menu::pause();
+}
+
+void CarUI::exportCars() {
+    Menu::displayHeader("Export Cars");
+    
+    std::cout << "Format (1-CSV, 2-JSON): ";
+    ExportFormat format = Menu::getChoice(1, 2) == 1 ? ExportFormat::CSV : ExportFormat::JSON;
+    std::string defaultPath = format == ExportFormat::CSV ? "data/cars_export.csv" : "data/cars_export.json";
+    std::string path = Menu::getString("Enter output file [" + defaultPath + "]: ");
+    if (path.empty()) path = defaultPath;
+    
+    ExportResult result = ExportService::exportCars(carService, path, format);
+    if (result.success) {
+        Menu::displaySuccess("Exported " + std::to_string(result.rows) + " car(s) to " + path);
+    } else {
+        Menu::displayError("Export failed: " + result.error);
+    }
+    
+    Menu::pause();
+}
+
 void CarUI::displayCar(const Car& car) {
     car.display();
 }
@@ -3,25 +3,30 @@
 
 #include "../models/Car.h"
 #include "../services/CarService.h"
+#include "../services/IntegrityService.h"
 #include "Menu.h"
 #include <vector>
 
 class CarUI {
 private:
-    CarService carService;
+    CarService& carService;
+    IntegrityService& integrityService;
 
 public:
-    CarUI();
+    CarUI(CarService& carService, IntegrityService& integrityService);
     
     void showMainMenu();
     void addCar();
     void viewAllCars();
     void viewCarById();
+    void findCarByPlate();
     void searchCars();
     void updateCar();
     void deleteCar();
     void viewAvailableCars();
     void viewStatistics();
+    void importCars();
+    void exportCars();
     
 private:
     void displayCar(const Car& car);
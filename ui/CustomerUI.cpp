@@ -1,8 +1,12 @@
 #include "CustomerUI.h"
+#include "../services/ImportService.h"
+#include "../services/ExportService.h"
+#include "Pager.h"
 #include <iostream>
 #include <iomanip>
 
-CustomerUI::CustomerUI() {
+CustomerUI::CustomerUI(CustomerService& customerService, IntegrityService& integrityService)
+    : customerService(customerService), integrityService(integrityService) {
 }
 
 void CustomerUI::showMainMenu() {
@@ -11,9 +15,12 @@ void CustomerUI::showMainMenu() {
     menu.addOption("Add New Customer", [this]() { addCustomer(); });
     menu.addOption("View All Customers", [this]() { viewAllCustomers(); });
     menu.addOption("View Customer by ID", [this]() { viewCustomerById(); });
+    menu.addOption("Find Customer by Email or License", [this]() { findCustomer(); });
     menu.addOption("Search Customers", [this]() { searchCustomers(); });
     menu.addOption("Update Customer", [this]() { updateCustomer(); });
     menu.addOption("Delete Customer", [this]() { deleteCustomer(); });
+    menu.addOption("Import Customers from CSV", [this]() { importCustomers(); });
+    menu.addOption("Export Customers", [this]() { exportCustomers(); });
     
     menu.run();
 }
@@ -31,23 +38,26 @@ void CustomerUI::addCustomer() {
     if (customerService.addCustomer(customer)) {
         Menu::displaySuccess("Customer added successfully!");
     } else {
-        Menu::displayError("Failed to add customer. Please try again.");
+        std::string error = customerService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to add customer. Please try again." : error);
     }
     
     Menu::pause();
 }
 
 void CustomerUI::viewAllCustomers() {
-    Menu::displayHeader("All Customers");
-    
-    std::vector<Customer> customers = customerService.getAllCustomers();
-    if (customers.empty()) {
-        Menu::displayInfo("No customers found.");
-    } else {
-        displayCustomers(customers);
-    }
-    
-    Menu::pause();
+    PagerSource source;
+    source.sortColumns = {"ID", "Name", "Email", "License Expiry"};
+    source.count = [this]() { return customerService.getCustomerCount(); };
+    source.showPage = [this](size_t sortColumn, size_t offset, size_t limit) {
+        displayCustomers(customerService.getCustomersPage(static_cast<CustomerSortKey>(sortColumn), offset, limit));
+    };
+    source.findPosition = [this](size_t sortColumn, int customerId) {
+        return customerService.findCustomerPosition(customerId, static_cast<CustomerSortKey>(sortColumn));
+    };
+    
+    Pager pager("All Customers", source);
+    pager.run();
 }
 
 void CustomerUI::viewCustomerById() {
@@ -65,6 +75,22 @@ void CustomerUI::viewCustomerById() {
     Menu::pause();
 }
 
+void CustomerUI::findCustomer() {
+    Menu::displayHeader("Find Customer by Email or License");
+    
+    std::string key = Menu::getNonEmptyString("Enter Email or License Number: ");
+    Customer customer = key.find('@') != std::string::npos ? customerService.findCustomerByEmail(key)
+                                                           : customerService.findCustomerByLicense(key);
+    
+    if (customer.getCustomerId() == 0) {
+        Menu::displayError("No customer found for: " + key);
+    } else {
+        displayCustomer(customer);
+    }
+    
+    Menu::pause();
+}
+
 void CustomerUI::searchCustomers() {
     Menu::displayHeader("Search Customers");
     
@@ -106,7 +132,8 @@ void CustomerUI::updateCustomer() {
     if (customerService.updateCustomer(customer)) {
         Menu::displaySuccess("Customer updated successfully!");
     } else {
-        Menu::displayError("Failed to update customer. Please try again.");
+        std::string error = customerService.getLastError();
+        Menu::displayError(error.empty() ? "Failed to update customer. Please try again." : error);
     }
     
     Menu::pause();
@@ -126,11 +153,29 @@ void CustomerUI::deleteCustomer() {
     
     displayCustomer(customer);
     
-    if (Menu::getYesNo("Are you sure you want to delete this customer?")) {
-        if (customerService.deleteCustomer(customerId)) {
-            Menu::displaySuccess("Customer deleted successfully!");
+    size_t references = integrityService.countCustomerReferences(customerId);
+    DeletePolicy policy = DeletePolicy::RESTRICT;
+    if (references > 0) {
+        std::cout << "\nThis customer is referenced by " << references << " booking(s)." << std::endl;
+        std::cout << "1. Keep the customer" << std::endl;
+        std::cout << "2. Deactivate the customer (keeps booking history)" << std::endl;
+        std::cout << "3. Delete the customer and their bookings" << std::endl;
+        int choice = Menu::getChoice(1, 3);
+        if (choice == 1) {
+            Menu::displayInfo("Deletion cancelled.");
+            Menu::pause();
+            return;
+        }
+        policy = choice == 2 ? DeletePolicy::SOFT_DELETE : DeletePolicy::CASCADE;
+    }
+    
+    if (Menu::getYesNo(policy == DeletePolicy::SOFT_DELETE ? "Are you sure you want to deactivate this customer?"
+                                                           : "Are you sure you want to delete this customer?")) {
+        if (integrityService.deleteCustomer(customerId, policy)) {
+            Menu::displaySuccess(policy == DeletePolicy::SOFT_DELETE ? "Customer deactivated successfully!"
+                                                                     : "Customer deleted successfully!");
         } else {
-            Menu::displayError("Failed to delete customer. Please try again.");
+            Menu::displayError(integrityService.getLastError());
         }
     } else {
         Menu::displayInfo("Deletion cancelled.");
@@ -139,6 +184,56 @@ void CustomerUI::deleteCustomer() {
     Menu::pause();
 }
 
+void CustomerUI::importCustomers() {
+    Menu::displayHeader("Import Customers from CSV");
+    
+    std::string sourceFile = Menu::getNonEmptyString("Enter source CSV file: ");
+    std::string rejectFile = Menu::getString("Enter reject file [data/customers_rejects.csv]: ");
+    if (rejectFile.empty()) rejectFile = "data/customers_rejects.csv";
+    
+    ImportService importService;
+    ImportResult result = importService.importCustomers(customerService, sourceFile, rejectFile);
+    
+    if (!result.success) {
+        Menu::displayError("Import failed: " + result.error);
+    } else {
+        std::cout << "Rows read: " << result.rowsRead << std::endl;
+        std::cout << "Imported: " << result.imported << std::endl;
+        std::cout << "Rejected: " << result.rejected << std::endl;
+        if (result.imported > 0) {
+            std::cout << "Assigned IDs: " << result.firstId << " - " << result.lastId << std::endl;
+        }
+        if (result.rejected > 0) {
+            Menu::displayInfo("Rejected rows were written to " + rejectFile);
+        }
+        if (!result.error.empty()) {
+            Menu::displayError(result.error);
+        }
+        Menu::displaySuccess("Import completed!");
+    }
+    
+    Menu::pause();
+}
+
+void CustomerUI::exportCustomers() {
+    Menu::displayHeader("Export Customers");
+    
+    std::cout << "Format (1-CSV, 2-JSON): ";
+    ExportFormat format = Menu::getChoice(1, 2) == 1 ? ExportFormat::CSV : ExportFormat::JSON;
+    std::string defaultPath = format == ExportFormat::CSV ? "data/customers_export.csv" : "data/customers_export.json";
+    std::string path = Menu::getString("Enter output file [" + defaultPath + "]: ");
+    if (path.empty()) path = defaultPath;
+    
+    ExportResult result = ExportService::exportCustomers(customerService, path, format);
+    if (result.success) {
+        Menu::displaySuccess("Exported " + std::to_string(result.rows) + " customer(s) to " + path);
+    } else {
+        Menu::displayError("Export failed: " + result.error);
+    }
+    
+    Menu::pause();
+}
+
 void CustomerUI::displayCustomer(const Customer& customer) {
     customer.display();
 }
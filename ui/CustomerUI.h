@@ -3,23 +3,28 @@
 
 #include "../models/Customer.h"
 #include "../services/CustomerService.h"
+#include "../services/IntegrityService.h"
 #include "Menu.h"
 #include <vector>
 
 class CustomerUI {
 private:
-    CustomerService customerService;
+    CustomerService& customerService;
+    IntegrityService& integrityService;
 
 public:
-    CustomerUI();
+    CustomerUI(CustomerService& customerService, IntegrityService& integrityService);
     
     void showMainMenu();
     void addCustomer();
     void viewAllCustomers();
     void viewCustomerById();
+    void findCustomer();
     void searchCustomers();
     void updateCustomer();
     void deleteCustomer();
+    void importCustomers();
+    void exportCustomers();
     
 private:
     void displayCustomer(const Customer& customer);
@@ -2,6 +2,8 @@
 #include <limits>
 #include <cstdlib>
 
+std::function<void()> Menu::tickHook;
+
 Menu::Menu(const std::string& title) : title(title), isRunning(false) {
 }
 
@@ -25,6 +27,9 @@ void Menu::run() {
     isRunning = true;
     
     while (isRunning) {
+        if (tickHook) {
+            tickHook();
+        }
         display();
         int choice = getChoice(0, static_cast<int>(options.size()));
         
@@ -45,6 +50,10 @@ void Menu::stop() {
     isRunning = false;
 }
 
+void Menu::setTickHook(const std::function<void()>& hook) {
+    tickHook = hook;
+}
+
 void Menu::clearScreen() {
     #ifdef _WIN32
         system("cls");
@@ -12,6 +12,7 @@ private:
     std::vector<std::string> options;
     std::vector<std::function<void()>> actions;
     bool isRunning;
+    static std::function<void()> tickHook;
 
 public:
     Menu(const std::string& title);
@@ -21,6 +22,9 @@ public:
     void run();
     void stop();
     
+    // Runs before every menu is shown, e.g. to process scheduled work
+    static void setTickHook(const std::function<void()>& hook);
+    
     // Simple input methods
     static void clearScreen();
     static void pause();
@@ -0,0 +1,97 @@
+#include "Pager.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+Pager::Pager(const std::string& title, const PagerSource& source, size_t pageSize)
+    : title(title), source(source), pageSize(pageSize), sortColumn(0), page(0) {
+}
+
+void Pager::run() {
+    while (true) {
+        size_t total = source.count();
+        if (total == 0) {
+            Menu::displayInfo("No records found.");
+            Menu::pause();
+            return;
+        }
+        
+        size_t pageCount = (total + pageSize - 1) / pageSize;
+        page = std::min(page, pageCount - 1);
+        display(total, pageCount);
+        
+        std::string input = Menu::getString("Command: ");
+        if (input.empty()) continue;
+        
+        char command = static_cast<char>(std::tolower(static_cast<unsigned char>(input[0])));
+        std::string argument = input.size() > 1 ? input.substr(1) : "";
+        
+        switch (command) {
+            case 'n':
+                if (page + 1 < pageCount) page++;
+                break;
+            case 'p':
+                if (page > 0) page--;
+                break;
+            case 'g': {
+                int target = argument.empty() ? Menu::getPositiveInt("Go to page: ") : std::atoi(argument.c_str());
+                if (target >= 1 && static_cast<size_t>(target) <= pageCount) {
+                    page = static_cast<size_t>(target) - 1;
+                } else {
+                    Menu::displayError("Page out of range.");
+                    Menu::pause();
+                }
+                break;
+            }
+            case 'j': {
+                int id = argument.empty() ? Menu::getPositiveInt("Jump to ID: ") : std::atoi(argument.c_str());
+                long position = source.findPosition(sortColumn, id);
+                if (position < 0) {
+                    Menu::displayError("No record with ID: " + std::to_string(id));
+                    Menu::pause();
+                } else {
+                    page = static_cast<size_t>(position) / pageSize;
+                }
+                break;
+            }
+            case 's':
+                chooseSortColumn();
+                break;
+            case 'z': {
+                int size = argument.empty() ? Menu::getPositiveInt("Rows per page: ") : std::atoi(argument.c_str());
+                if (size > 0) {
+                    size_t firstRow = page * pageSize;
+                    pageSize = static_cast<size_t>(size);
+                    page = firstRow / pageSize;
+                }
+                break;
+            }
+            case 'q':
+                return;
+            default:
+                break;
+        }
+    }
+}
+
+void Pager::display(size_t total, size_t pageCount) const {
+    Menu::clearScreen();
+    Menu::displayHeader(title);
+    
+    source.showPage(sortColumn, page * pageSize, pageSize);
+    
+    std::cout << std::string(50, '-') << std::endl;
+    std::cout << "Page " << (page + 1) << " of " << pageCount
+              << " (" << total << " records, sorted by " << source.sortColumns[sortColumn] << ")" << std::endl;
+    std::cout << "[N]ext  [P]rev  [G]o to page  [J]ump to ID  [S]ort  [Z] page size  [Q]uit" << std::endl;
+}
+
+void Pager::chooseSortColumn() {
+    std::cout << "\nSort by:" << std::endl;
+    for (size_t i = 0; i < source.sortColumns.size(); i++) {
+        std::cout << (i + 1) << ". " << source.sortColumns[i] << std::endl;
+    }
+    int choice = Menu::getChoice(1, static_cast<int>(source.sortColumns.size()));
+    sortColumn = static_cast<size_t>(choice - 1);
+    page = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "Menu.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// Callbacks a listing screen provides to the pager. Only the rows of the
+// visible page are requested from showPage.
+struct PagerSource {
+    std::vector<std::string> sortColumns;
+    std::function<size_t()> count;
+    std::function<void(size_t sortColumn, size_t offset, size_t limit)> showPage;
+    std::function<long(size_t sortColumn, int id)> findPosition;
+};
+
+class Pager {
+private:
+    std::string title;
+    PagerSource source;
+    size_t pageSize;
+    size_t sortColumn;
+    size_t page;
+
+public:
+    Pager(const std::string& title, const PagerSource& source, size_t pageSize = 20);
+    
+    void run();
+    
+private:
+    void display(size_t total, size_t pageCount) const;
+    void chooseSortColumn();
+};
+
+#endif // PAGER_H
@@ -0,0 +1,231 @@
+#include "PaymentUI.h"
+#include "../services/PaymentService.h"
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+
+PaymentUI::PaymentUI(PaymentLedger& ledger, PaymentClient& client, BookingService& bookingService)
+    : ledger(ledger), client(client), bookingService(bookingService) {
+}
+
+void PaymentUI::showMainMenu() {
+    Menu menu("Payments");
+    
+    menu.addOption("Record Payment", [this]() { recordPayment(); });
+    menu.addOption("Refund Payment", [this]() { refundPayment(); });
+    menu.addOption("View Booking Payments", [this]() { viewBookingPayments(); });
+    menu.addOption("Collect Payments Due", [this]() { collectPaymentsDue(); });
+    
+    menu.run();
+}
+
+void PaymentUI::recordPayment() {
+    Menu::displayHeader("Record Payment");
+    
+    Booking booking;
+    if (!selectBooking(booking)) return;
+    displayBalance(booking);
+    
+    long long dueCents = amountDueCents(booking);
+    double amount = dueCents / 100.0;
+    char dueText[32];
+    std::snprintf(dueText, sizeof(dueText), "%.2f", amount);
+    std::string input = Menu::getString("Amount [" + std::string(dueText) + "]: $");
+    if (!input.empty()) amount = std::atof(input.c_str());
+    std::string method = Menu::getString("Payment method [Card]: ");
+    if (method.empty()) method = "Card";
+    
+    std::string defaultKey = chargeKey(booking, dueCents, PaymentService::toCents(amount));
+    std::string key = Menu::getString("Idempotency key [" + defaultKey + "]: ");
+    if (key.empty()) key = defaultKey;
+    if (!PaymentService::validatePayment(amount)) {
+        Menu::displayError("Payments must be more than $0.00 and at most $10000.00.");
+        Menu::pause();
+        return;
+    }
+    
+    AuthorizationRequest request;
+    request.bookingId = booking.getBookingId();
+    request.amountCents = PaymentService::toCents(amount);
+    request.method = method;
+    request.idempotencyKey = key;
+    std::cout << "Authorizing with " << client.getGateway().getName() << "..." << std::endl;
+    PaymentOutcome outcome = client.submit(request).get();
+    
+    if (outcome.recorded && outcome.duplicate) {
+        Menu::displayInfo("Already recorded as entry " + std::to_string(outcome.entryId) +
+                          "; nothing was charged again.");
+    } else if (outcome.recorded) {
+        Menu::displaySuccess("Charge approved (" + outcome.result.reference + ") and recorded as entry " +
+                             std::to_string(outcome.entryId) + ".");
+    } else if (outcome.result.status == AuthorizationStatus::TIMED_OUT) {
+        Menu::displayError("The gateway did not answer after " + std::to_string(outcome.attempts) +
+                           " attempt(s). Retry with the same key; it cannot charge twice.");
+    } else {
+        Menu::displayError(PaymentGateway::statusToString(outcome.result.status) + ": " + outcome.error);
+    }
+    Menu::pause();
+}
+
+void PaymentUI::refundPayment() {
+    Menu::displayHeader("Refund Payment");
+    
+    Booking booking;
+    if (!selectBooking(booking)) return;
+    displayBalance(booking);
+    
+    long long paidCents = ledger.getBalance(booking.getBookingId()).getPaidCents();
+    if (paidCents <= 0) {
+        Menu::displayInfo("Nothing has been paid for this booking.");
+        Menu::pause();
+        return;
+    }
+    long long amountCents = PaymentService::toCents(Menu::getPositiveDouble("Refund amount: $"));
+    if (amountCents > paidCents) {
+        Menu::displayError("The refund is larger than the amount paid.");
+        Menu::pause();
+        return;
+    }
+    std::string method = Menu::getString("Refund method [Card]: ");
+    if (method.empty()) method = "Card";
+    std::string key = "RF" + std::to_string(booking.getBookingId()) + "-" + std::to_string(paidCents) + "-" +
+                      std::to_string(amountCents);
+    
+    displayRecordResult(ledger.record(booking.getBookingId(), PaymentType::REFUND, amountCents, method, key));
+    Menu::pause();
+}
+
+void PaymentUI::viewBookingPayments() {
+    Menu::displayHeader("View Booking Payments");
+    
+    Booking booking;
+    if (!selectBooking(booking)) return;
+    
+    std::vector<LedgerEntry> entries = ledger.getEntries(booking.getBookingId());
+    if (entries.empty()) {
+        Menu::displayInfo("No payments recorded for this booking.");
+    } else {
+        std::cout << std::left << std::setw(8) << "Entry"
+                  << std::setw(22) << "Time"
+                  << std::setw(9) << "Type"
+                  << std::setw(12) << "Amount"
+                  << std::setw(12) << "Method"
+                  << "Key" << std::endl;
+        std::cout << std::string(80, '-') << std::endl;
+        for (const auto& entry : entries) {
+            std::cout << std::left << std::setw(8) << entry.entryId
+                      << std::setw(22) << entry.timestamp
+                      << std::setw(9) << PaymentLedger::typeToString(entry.type)
+                      << std::setw(12) << std::fixed << std::setprecision(2) << entry.amountCents / 100.0
+                      << std::setw(12) << entry.method
+                      << entry.idempotencyKey << std::endl;
+        }
+    }
+    std::cout << std::endl;
+    displayBalance(booking);
+    
+    Menu::pause();
+}
+
+void PaymentUI::collectPaymentsDue() {
+    Menu::displayHeader("Collect Payments Due");
+    
+    std::string date = Menu::getString("Charge bookings ending on (YYYY-MM-DD) [today]: ");
+    if (date.empty()) date = Booking::daysToDate(Booking::today());
+    if (!Booking::isValidDate(date)) {
+        Menu::displayError("Invalid date.");
+        Menu::pause();
+        return;
+    }
+    PaymentClientOptions options = client.getOptions();
+    std::string input = Menu::getString("Authorizations in flight at once [" +
+                                        std::to_string(options.maxInFlight) + "]: ");
+    if (!input.empty() && std::atoi(input.c_str()) > 0) {
+        options.maxInFlight = static_cast<size_t>(std::atoi(input.c_str()));
+        client.setOptions(options);
+    }
+    
+    // Keys match the ones Record Payment would use, so a rerun or a manual
+    // payment of the same balance is never charged twice
+    int day = Booking::dateToDays(date);
+    std::vector<AuthorizationRequest> requests;
+    bookingService.forEachBookingInRange(day - 1, day + 1, [&](const Booking& booking) {
+        if (booking.getEndDate() != date || booking.isCancelled()) return;
+        long long dueCents = amountDueCents(booking);
+        if (dueCents <= 0) return;
+        AuthorizationRequest request;
+        request.bookingId = booking.getBookingId();
+        request.amountCents = dueCents;
+        request.method = "Card on file";
+        request.idempotencyKey = chargeKey(booking, dueCents, dueCents);
+        requests.push_back(request);
+    });
+    if (requests.empty()) {
+        Menu::displayInfo("No balances due for bookings ending on " + date + ".");
+        Menu::pause();
+        return;
+    }
+    
+    std::cout << "Charging " << requests.size() << " booking(s) through " << client.getGateway().getName()
+              << ", " << options.maxInFlight << " at a time..." << std::endl;
+    SettlementRun run = client.settle(requests);
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Approved:  " << run.approved << " ($" << run.chargedCents / 100.0 << ")" << std::endl;
+    std::cout << "Already paid: " << run.duplicates << std::endl;
+    std::cout << "Declined:  " << run.declined << std::endl;
+    std::cout << "Failed:    " << run.failed << " (retry later; nothing is charged twice)" << std::endl;
+    std::cout << "Time:      " << run.elapsedMs / 1000.0 << " s ("
+              << std::setprecision(1) << requests.size() * 1000.0 / run.elapsedMs << " per second)" << std::endl;
+    
+    Menu::pause();
+}
+
+bool PaymentUI::selectBooking(Booking& booking) {
+    int bookingId = Menu::getPositiveInt("Enter Booking ID: ");
+    booking = bookingService.getBookingById(bookingId);
+    if (booking.getBookingId() == 0) {
+        Menu::displayError("Booking not found.");
+        Menu::pause();
+        return false;
+    }
+    return true;
+}
+
+// Booking cost plus tax, less what has been paid so far
+long long PaymentUI::amountDueCents(const Booking& booking) {
+    long long costCents = PaymentService::toCents(booking.getTotalCost());
+    long long dueCents = costCents + PaymentService::calculateTaxCents(costCents) -
+                         ledger.getBalance(booking.getBookingId()).getPaidCents();
+    return dueCents > 0 ? dueCents : 0;
+}
+
+// The same outstanding amount and payment give the same key, so repeating a
+// payment whose outcome was unclear cannot charge twice
+std::string PaymentUI::chargeKey(const Booking& booking, long long dueCents, long long amountCents) {
+    return "BK" + std::to_string(booking.getBookingId()) + "-" + std::to_string(dueCents) + "-" +
+           std::to_string(amountCents);
+}
+
+void PaymentUI::displayBalance(const Booking& booking) {
+    PaymentBalance balance = ledger.getBalance(booking.getBookingId());
+    long long costCents = PaymentService::toCents(booking.getTotalCost());
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Booking " << booking.getBookingId() << ": $" << costCents / 100.0 << " + tax $"
+              << PaymentService::calculateTaxCents(costCents) / 100.0 << std::endl;
+    std::cout << "Paid: $" << balance.getPaidCents() / 100.0 << " (" << balance.entries << " entries)"
+              << "  Due: $" << amountDueCents(booking) / 100.0 << std::endl;
+}
+
+void PaymentUI::displayRecordResult(const PaymentRecordResult& result) {
+    if (!result.success) {
+        Menu::displayError("Payment not recorded: " + result.error);
+    } else if (result.duplicate) {
+        Menu::displayInfo("Already recorded as entry " + std::to_string(result.entry.entryId) + " on " +
+                          result.entry.timestamp + "; nothing was charged again.");
+    } else {
+        Menu::displaySuccess(PaymentLedger::typeToString(result.entry.type) + " recorded as entry " +
+                             std::to_string(result.entry.entryId) + ".");
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef PAYMENT_UI_H
+#define PAYMENT_UI_H
+
+#include "../services/BookingService.h"
+#include "../services/PaymentClient.h"
+#include "../services/PaymentLedger.h"
+#include "Menu.h"
+#include <string>
+
+class PaymentUI {
+private:
+    PaymentLedger& ledger;
+    PaymentClient& client;
+    BookingService& bookingService;
+
+public:
+    PaymentUI(PaymentLedger& ledger, PaymentClient& client, BookingService& bookingService);
+    
+    void showMainMenu();
+    void recordPayment();
+    void refundPayment();
+    void viewBookingPayments();
+    void collectPaymentsDue();
+    
+private:
+    bool selectBooking(Booking& booking);
+    long long amountDueCents(const Booking& booking);
+    std::string chargeKey(const Booking& booking, long long dueCents, long long amountCents);
+    void displayBalance(const Booking& booking);
+    void displayRecordResult(const PaymentRecordResult& result);
+};
+
+#endif // PAYMENT_UI_H
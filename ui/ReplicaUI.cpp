@@ -0,0 +1,83 @@
+#include "ReplicaUI.h"
+#include <iostream>
+#include <iomanip>
+
+ReplicaUI::ReplicaUI(ReadReplica& replica)
+    : replica(replica),
+      reportUI(replica.getBookingService(), replica.getCarService(), replica.getCustomerService()) {
+}
+
+void ReplicaUI::showMainMenu() {
+    Menu menu("Car Rental Read Replica");
+    
+    menu.addOption("Revenue Reports", [this]() { reportUI.showMainMenu(); });
+    menu.addOption("Search Cars", [this]() { searchCars(); });
+    menu.addOption("View Booking", [this]() { viewBooking(); });
+    menu.addOption("Replication Status", [this]() { viewStatus(); });
+    menu.addOption("Exit", [&menu]() { menu.stop(); });
+    
+    menu.run();
+}
+
+void ReplicaUI::searchCars() {
+    Menu::displayHeader("Search Cars");
+    
+    std::string searchTerm = Menu::getNonEmptyString("Enter search term: ");
+    std::vector<Car> results = replica.getCarService().searchCars(searchTerm);
+    if (results.empty()) {
+        Menu::displayInfo("No cars found matching: " + searchTerm);
+        Menu::pause();
+        return;
+    }
+    
+    std::cout << "Found " << results.size() << " car(s) matching: " << searchTerm << std::endl;
+    std::cout << std::left << std::setw(5) << "ID" << std::setw(15) << "Make" << std::setw(15) << "Model"
+              << std::setw(8) << "Year" << std::setw(10) << "Status" << std::setw(12) << "Daily Rate" << std::endl;
+    std::cout << std::string(80, '-') << std::endl;
+    for (const auto& car : results) {
+        std::cout << std::left << std::setw(5) << car.getCarId() << std::setw(15) << car.getMake()
+                  << std::setw(15) << car.getModel() << std::setw(8) << car.getYear()
+                  << std::setw(10) << car.getStatusString()
+                  << std::setw(12) << std::fixed << std::setprecision(2) << car.getDailyRate() << std::endl;
+    }
+    Menu::pause();
+}
+
+void ReplicaUI::viewBooking() {
+    Menu::displayHeader("View Booking");
+    
+    int bookingId = Menu::getPositiveInt("Enter Booking ID: ");
+    Booking booking = replica.getBookingService().getBookingById(bookingId);
+    if (booking.getBookingId() == 0) {
+        Menu::displayError("Booking not found with ID: " + std::to_string(bookingId));
+        Menu::pause();
+        return;
+    }
+    
+    std::cout << "Booking ID: " << booking.getBookingId() << std::endl;
+    std::cout << "Customer ID: " << booking.getCustomerId() << std::endl;
+    std::cout << "Car ID: " << booking.getCarId() << std::endl;
+    std::cout << "Dates: " << booking.getStartDate() << " to " << booking.getEndDate() << std::endl;
+    std::cout << "Total Cost: $" << std::fixed << std::setprecision(2) << booking.getTotalCost() << std::endl;
+    std::cout << "Status: " << booking.getStatus() << std::endl;
+    Menu::pause();
+}
+
+void ReplicaUI::viewStatus() {
+    Menu::displayHeader("Replication Status");
+    
+    replica.applyPending();
+    ReplicaStatus status = replica.getStatus();
+    std::cout << "Primary: " << replica.getSocketPath()
+              << (status.connected ? " (connected)" : " (not connected)") << std::endl;
+    std::cout << "Applied sequence: " << status.appliedSequence << std::endl;
+    std::cout << "Primary sequence: " << status.primarySequence << std::endl;
+    std::cout << "Lag: " << status.eventsBehind << " event(s), " << std::fixed << std::setprecision(1)
+              << status.secondsBehind << " s" << std::endl;
+    std::cout << "Last heard from the primary: " << status.secondsSinceContact << " s ago" << std::endl;
+    std::cout << "Connections: " << status.connects << ", reseeds: " << status.reseeds << std::endl;
+    if (!status.lastError.empty()) {
+        std::cout << "Last error: " << status.lastError << std::endl;
+    }
+    Menu::pause();
+}
@@ -0,0 +1,23 @@
+#ifndef REPLICA_UI_H
+#define REPLICA_UI_H
+
+#include "../services/ReadReplica.h"
+#include "ReportUI.h"
+#include "Menu.h"
+
+// Console of a read replica: reports and lookups only, nothing can be changed
+class ReplicaUI {
+private:
+    ReadReplica& replica;
+    ReportUI reportUI;
+
+public:
+    explicit ReplicaUI(ReadReplica& replica);
+    
+    void showMainMenu();
+    void searchCars();
+    void viewBooking();
+    void viewStatus();
+};
+
+#endif // REPLICA_UI_H
@@ -0,0 +1,269 @@
+#include "ReportUI.h"
+#include "../services/PaymentService.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+ReportUI::ReportUI(BookingService& bookingService, CarService& carService, CustomerService& customerService)
+    : bookingService(bookingService), carService(carService), customerService(customerService),
+      reportService(bookingService, carService), analyticsService(bookingService, carService),
+      utilizationService(bookingService, carService) {
+}
+
+void ReportUI::showMainMenu() {
+    Menu menu("Revenue Reports");
+    
+    menu.addOption("Revenue Summary", [this]() { viewRevenueSummary(); });
+    menu.addOption("Revenue by Month", [this]() { viewRevenueByMonth(); });
+    menu.addOption("Revenue by Day", [this]() { viewRevenueByDay(); });
+    menu.addOption("Top Cars by Revenue", [this]() { viewTopCars(); });
+    menu.addOption("Top Customers by Revenue", [this]() { viewTopCustomers(); });
+    menu.addOption("Revenue by Make", [this]() { viewRevenueByMake(); });
+    menu.addOption("Booking Analytics (full history scan)", [this]() { runBookingAnalytics(); });
+    menu.addOption("Fleet Utilization", [this]() { viewFleetUtilization(); });
+    menu.addOption("Daily Settlement", [this]() { runDailySettlement(); });
+    
+    menu.run();
+}
+
+void ReportUI::viewRevenueSummary() {
+    Menu::displayHeader("Revenue Summary");
+    
+    RevenueTotal total = reportService.getTotalRevenue();
+    std::cout << "Bookings (excluding cancelled): " << total.bookings << std::endl;
+    std::cout << "Total Revenue: $" << std::fixed << std::setprecision(2) << total.getRevenue() << std::endl;
+    if (total.bookings > 0) {
+        std::cout << "Average per Booking: $" << total.getRevenue() / total.bookings << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void ReportUI::viewRevenueByMonth() {
+    Menu::displayHeader("Revenue by Month");
+    
+    std::string from = Menu::getString("From month (YYYY-MM, blank for all): ");
+    std::string to = Menu::getString("To month (YYYY-MM, blank for all): ");
+    displayTotals("Month", reportService.getRevenueByMonth(from, to));
+    
+    Menu::pause();
+}
+
+void ReportUI::viewRevenueByDay() {
+    Menu::displayHeader("Revenue by Day");
+    
+    std::string from = Menu::getNonEmptyString("From date (YYYY-MM-DD): ");
+    std::string to = Menu::getNonEmptyString("To date (YYYY-MM-DD): ");
+    displayTotals("Date", reportService.getRevenueByDay(from, to));
+    
+    Menu::pause();
+}
+
+void ReportUI::viewTopCars() {
+    Menu::displayHeader("Top Cars by Revenue");
+    
+    std::vector<std::pair<std::string, RevenueTotal>> rows;
+    for (const auto& entry : reportService.getTopCars(10)) {
+        Car car = carService.getCarById(entry.first);
+        std::string label = "[" + std::to_string(entry.first) + "] ";
+        label += car.getCarId() > 0 ? car.getMake() + " " + car.getModel() : "(deleted)";
+        rows.push_back({label, entry.second});
+    }
+    displayTotals("Car", rows);
+    
+    Menu::pause();
+}
+
+void ReportUI::viewTopCustomers() {
+    Menu::displayHeader("Top Customers by Revenue");
+    
+    std::vector<std::pair<std::string, RevenueTotal>> rows;
+    for (const auto& entry : reportService.getTopCustomers(10)) {
+        Customer customer = customerService.getCustomerById(entry.first);
+        std::string label = "[" + std::to_string(entry.first) + "] ";
+        label += customer.getCustomerId() > 0 ? customer.getFullName() : "(deleted)";
+        rows.push_back({label, entry.second});
+    }
+    displayTotals("Customer", rows);
+    
+    Menu::pause();
+}
+
+void ReportUI::viewRevenueByMake() {
+    Menu::displayHeader("Revenue by Make");
+    
+    displayTotals("Make", reportService.getRevenueByMake());
+    
+    Menu::pause();
+}
+
+void ReportUI::runBookingAnalytics() {
+    Menu::displayHeader("Booking Analytics");
+    
+    AnalyticsQuery query;
+    query.startFrom = Menu::getString("Start date from (YYYY-MM-DD, blank for any): ");
+    query.startTo = Menu::getString("Start date to (YYYY-MM-DD, blank for any): ");
+    query.minDays = std::max(0, Menu::getInt("Minimum rental days (0 for any): "));
+    query.maxDays = std::max(0, Menu::getInt("Maximum rental days (0 for any): "));
+    if (!Menu::getYesNo("Include cancelled bookings?")) {
+        query.statuses &= ~(1u << BookingColumns::STATUS_CANCELLED);
+    }
+    
+    std::cout << "Fuel Type (0-Any, 1-Gasoline, 2-Diesel, 3-Electric, 4-Hybrid): ";
+    int fuelChoice = Menu::getChoice(0, 4);
+    if (fuelChoice > 0) query.fuelType = static_cast<FuelType>(fuelChoice - 1);
+    
+    std::cout << "Transmission (0-Any, 1-Manual, 2-Automatic): ";
+    int transmissionChoice = Menu::getChoice(0, 2);
+    if (transmissionChoice > 0) query.transmission = static_cast<Transmission>(transmissionChoice - 1);
+    
+    std::cout << "Group by (0-None, 1-Status, 2-Fuel Type, 3-Transmission): ";
+    query.groupBy = static_cast<AnalyticsGroupBy>(Menu::getChoice(0, 3));
+    
+    AnalyticsResult result = analyticsService.run(query);
+    
+    std::cout << "\nMatching bookings: " << result.bookings << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Revenue: $" << result.revenueCents / 100.0 << std::endl;
+    if (result.bookings > 0) {
+        std::cout << "Average: $" << result.revenueCents / 100.0 / result.bookings
+                  << "  Min: $" << result.minCents / 100.0
+                  << "  Max: $" << result.maxCents / 100.0 << std::endl;
+    }
+    
+    if (!result.groups.empty()) {
+        std::vector<std::pair<std::string, RevenueTotal>> rows;
+        for (const auto& group : result.groups) {
+            RevenueTotal total;
+            total.revenueCents = group.revenueCents;
+            total.bookings = group.bookings;
+            rows.push_back({group.label, total});
+        }
+        std::cout << std::endl;
+        displayTotals("Group", rows);
+    }
+    
+    std::cout << "\nScanned " << result.rowsScanned << " rows in "
+              << std::setprecision(3) << result.scanSeconds * 1000.0 << " ms" << std::endl;
+    
+    Menu::pause();
+}
+
+void ReportUI::viewFleetUtilization() {
+    Menu::displayHeader("Fleet Utilization");
+    
+    std::string from = Menu::getNonEmptyString("From month (YYYY-MM): ");
+    std::string to = Menu::getNonEmptyString("To month (YYYY-MM): ");
+    UtilizationReport report = utilizationService.buildReport(from, to);
+    if (report.byMonth.empty()) {
+        Menu::displayError("The month range is empty.");
+        Menu::pause();
+        return;
+    }
+    
+    displayUtilization("Month", report.byMonth);
+    std::cout << std::endl;
+    displayUtilization("Fleet", {report.fleet});
+    std::cout << std::endl;
+    displayUtilization("Model", report.byModel);
+    
+    // Least and most used cars
+    std::vector<size_t> order(report.byCar.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&report](size_t a, size_t b) {
+        return report.byCar[a].rentedDays > report.byCar[b].rentedDays;
+    });
+    size_t shown = std::min<size_t>(10, order.size());
+    std::vector<UtilizationRow> top, bottom;
+    for (size_t i = 0; i < shown; i++) {
+        UtilizationRow row = report.byCar[order[i]];
+        row.label = "[" + std::to_string(report.carIds[order[i]]) + "] " + row.label;
+        top.push_back(row);
+        row = report.byCar[order[order.size() - 1 - i]];
+        row.label = "[" + std::to_string(report.carIds[order[order.size() - 1 - i]]) + "] " + row.label;
+        bottom.push_back(row);
+    }
+    std::cout << "\nMost used cars:" << std::endl;
+    displayUtilization("Car", top);
+    std::cout << "\nLeast used cars:" << std::endl;
+    displayUtilization("Car", bottom);
+    
+    Menu::pause();
+}
+
+void ReportUI::runDailySettlement() {
+    Menu::displayHeader("Daily Settlement");
+    
+    std::string date = Menu::getString("Settle bookings ending on (YYYY-MM-DD) [today]: ");
+    if (date.empty()) date = Booking::daysToDate(Booking::today());
+    if (!Booking::isValidDate(date)) {
+        Menu::displayError("Invalid date.");
+        Menu::pause();
+        return;
+    }
+    std::string defaultPath = "data/settlement-" + date + ".txt";
+    std::string path = Menu::getString("Enter output file [" + defaultPath + "]: ");
+    if (path.empty()) path = defaultPath;
+    
+    // Every non-cancelled booking that ends on the date gets a receipt
+    auto started = std::chrono::steady_clock::now();
+    int day = Booking::dateToDays(date);
+    std::vector<int> bookingIds;
+    std::vector<long long> amounts;
+    bookingService.forEachBookingInRange(day - 1, day + 1, [&](const Booking& booking) {
+        if (booking.getEndDate() == date && !booking.isCancelled()) {
+            bookingIds.push_back(booking.getBookingId());
+            amounts.push_back(PaymentService::toCents(booking.getTotalCost()));
+        }
+    });
+    SettlementResult result = PaymentService::writeSettlement(path, bookingIds, amounts, "On account", date);
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    
+    if (!result.success) {
+        Menu::displayError("Settlement failed: " + result.error);
+    } else {
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Receipts: " << result.receipts << " (written to " << path << ")" << std::endl;
+        std::cout << "Base:     $" << result.baseCents / 100.0 << std::endl;
+        std::cout << "Tax:      $" << result.taxCents / 100.0 << std::endl;
+        std::cout << "Total:    $" << result.totalCents / 100.0 << std::endl;
+        std::cout << "Time:     " << elapsedMs << " ms" << std::endl;
+    }
+    
+    Menu::pause();
+}
+
+void ReportUI::displayUtilization(const std::string& keyTitle, const std::vector<UtilizationRow>& rows) {
+    std::cout << std::left << std::setw(30) << keyTitle
+              << std::setw(14) << "Rented Days"
+              << std::setw(14) << "Car-Days"
+              << std::setw(12) << "Utilization" << std::endl;
+    std::cout << std::string(70, '-') << std::endl;
+    
+    for (const auto& row : rows) {
+        std::cout << std::left << std::setw(30) << row.label
+                  << std::setw(14) << row.rentedDays
+                  << std::setw(14) << row.availableDays
+                  << std::fixed << std::setprecision(1) << row.getUtilization() << "%" << std::endl;
+    }
+}
+
+void ReportUI::displayTotals(const std::string& keyTitle, const std::vector<std::pair<std::string, RevenueTotal>>& rows) {
+    if (rows.empty()) {
+        Menu::displayInfo("No revenue recorded for this selection.");
+        return;
+    }
+    
+    std::cout << std::left << std::setw(30) << keyTitle
+              << std::setw(10) << "Bookings"
+              << std::setw(15) << "Revenue" << std::endl;
+    std::cout << std::string(55, '-') << std::endl;
+    
+    for (const auto& row : rows) {
+        std::cout << std::left << std::setw(30) << row.first
+                  << std::setw(10) << row.second.bookings
+                  << std::setw(15) << std::fixed << std::setprecision(2) << row.second.getRevenue()
+                  << std::endl;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef REPORT_UI_H
+#define REPORT_UI_H
+
+#include "../services/BookingService.h"
+#include "../services/CarService.h"
+#include "../services/CustomerService.h"
+#include "../services/ReportService.h"
+#include "../services/AnalyticsService.h"
+#include "../services/UtilizationService.h"
+#include "Menu.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+class ReportUI {
+private:
+    BookingService& bookingService;
+    CarService& carService;
+    CustomerService& customerService;
+    ReportService reportService;
+    AnalyticsService analyticsService;
+    UtilizationService utilizationService;
+
+public:
+    ReportUI(BookingService& bookingService, CarService& carService, CustomerService& customerService);
+    
+    void showMainMenu();
+    void viewRevenueSummary();
+    void viewRevenueByMonth();
+    void viewRevenueByDay();
+    void viewTopCars();
+    void viewTopCustomers();
+    void viewRevenueByMake();
+    void runBookingAnalytics();
+    void viewFleetUtilization();
+    void runDailySettlement();
+    
+private:
+    void displayUtilization(const std::string& keyTitle, const std::vector<UtilizationRow>& rows);
+    void displayTotals(const std::string& keyTitle, const std::vector<std::pair<std::string, RevenueTotal>>& rows);
+};
+
+#endif // REPORT_UI_H
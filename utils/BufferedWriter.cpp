@@ -0,0 +1,99 @@
+#include "BufferedWriter.h"
+#include <cstring>
+
+BufferedWriter::BufferedWriter(const std::string& path, size_t bufferSize)
+    : file(std::fopen(path.c_str(), "wb")), buffer(bufferSize), used(0), failed(false) {
+    if (!file) failed = true;
+}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+bool BufferedWriter::isOpen() const {
+    return file != nullptr;
+}
+
+bool BufferedWriter::good() const {
+    return !failed;
+}
+
+void BufferedWriter::write(const char* data, size_t size) {
+    if (size > buffer.size() - used) {
+        flush();
+        if (size > buffer.size()) {
+            // Larger than the whole buffer: hand it to the OS directly
+            if (file && std::fwrite(data, 1, size, file) != size) failed = true;
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + used, data, size);
+    used += size;
+}
+
+void BufferedWriter::write(const std::string& text) {
+    write(text.data(), text.size());
+}
+
+void BufferedWriter::writeChar(char c) {
+    if (used == buffer.size()) flush();
+    buffer[used++] = c;
+}
+
+void BufferedWriter::writeInt(long long value) {
+    char digits[24];
+    int length = 0;
+    unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                             : static_cast<unsigned long long>(value);
+    do {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[length++] = '-';
+
+    char text[24];
+    for (int i = 0; i < length; i++) {
+        text[i] = digits[length - 1 - i];
+    }
+    write(text, length);
+}
+
+void BufferedWriter::writeFixed(double value, int decimals) {
+    long long scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+
+    bool negative = value < 0;
+    long long scaled = static_cast<long long>((negative ? -value : value) * scale + 0.5);
+    if (negative && scaled != 0) writeChar('-');
+    writeInt(scaled / scale);
+    if (decimals > 0) {
+        writeChar('.');
+        long long fraction = scaled % scale;
+        for (long long digit = scale / 10; digit > 0; digit /= 10) {
+            writeChar(static_cast<char>('0' + (fraction / digit) % 10));
+        }
+    }
+}
+
+// Without a file (not opened, or closed) the buffered bytes are dropped, so
+// later writes still fit in the buffer and the writer reports the failure
+bool BufferedWriter::flush() {
+    if (!file) {
+        failed = true;
+        used = 0;
+        return false;
+    }
+    if (used > 0) {
+        if (std::fwrite(buffer.data(), 1, used, file) != used) failed = true;
+        used = 0;
+    }
+    return !failed;
+}
+
+bool BufferedWriter::close() {
+    if (!file) return !failed;
+    flush();
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    return !failed;
+}
@@ -0,0 +1,40 @@
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Output file with a large user-space buffer. Formatting helpers append
+// straight into the buffer, so no per-row std::string or stream is created.
+class BufferedWriter {
+private:
+    std::FILE* file;
+    std::vector<char> buffer;
+    size_t used;
+    bool failed;
+
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit BufferedWriter(const std::string& path, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool isOpen() const;
+    bool good() const;
+
+    void write(const char* data, size_t size);
+    void write(const std::string& text);
+    void writeChar(char c);
+    void writeInt(long long value);
+    // Fixed-point with the given number of decimals, e.g. 250.00
+    void writeFixed(double value, int decimals = 2);
+
+    bool flush();
+    bool close();
+};
+
+#endif // BUFFEREDWRITER_H
@@ -0,0 +1,79 @@
+#include "Checksum.h"
+#include <cstring>
+
+namespace {
+
+struct CrcTable {
+    uint32_t entries[256];
+
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            entries[i] = value;
+        }
+    }
+};
+
+const CrcTable crcTable;
+
+uint64_t mix(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+void appendHex(std::string& out, uint64_t value, int digits) {
+    static const char hex[] = "0123456789abcdef";
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out += hex[(value >> shift) & 0xF];
+    }
+}
+
+} // namespace
+
+namespace Checksum {
+
+uint32_t crc32(const char* data, size_t size, uint32_t crc) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = crcTable.entries[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// Two independent 64-bit lanes over 8-byte words, finalized with the length
+std::string contentHash(const char* data, size_t size) {
+    uint64_t a = 0x9E3779B97F4A7C15ull;
+    uint64_t b = 0x632BE59BD9B4E019ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        a = (a ^ mix(word)) * 0x100000001B3ull;
+        b = ((b ^ word) * 0xFF51AFD7ED558CCDull) + (b >> 29);
+    }
+    uint64_t last = 0;
+    std::memcpy(&last, data + i, size - i);
+    a = mix(a ^ mix(last) ^ size);
+    b = mix(b ^ last ^ (static_cast<uint64_t>(size) << 32) ^ a);
+
+    std::string out;
+    out.reserve(32);
+    appendHex(out, a, 16);
+    appendHex(out, b, 16);
+    return out;
+}
+
+std::string toHex(uint32_t value) {
+    std::string out;
+    appendHex(out, value, 8);
+    return out;
+}
+
+}
@@ -0,0 +1,21 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Checksum {
+
+// CRC-32 (IEEE); pass the previous result as crc to continue over more data
+uint32_t crc32(const char* data, size_t size, uint32_t crc = 0);
+
+// 128-bit content hash as 32 hex digits, used to name stored chunks. Fast and
+// well mixed, but not cryptographic.
+std::string contentHash(const char* data, size_t size);
+
+std::string toHex(uint32_t value);
+
+}
+
+#endif // CHECKSUM_H
@@ -0,0 +1,22 @@
+#include "CsvUtils.h"
+
+namespace CsvUtils {
+
+void splitLine(const std::string& line, std::vector<std::string>& fields) {
+    fields.clear();
+    size_t end = line.size();
+    if (end > 0 && line[end - 1] == '\r') end--;
+
+    size_t start = 0;
+    while (true) {
+        size_t comma = line.find(',', start);
+        if (comma == std::string::npos || comma >= end) {
+            fields.emplace_back(line, start, end - start);
+            return;
+        }
+        fields.emplace_back(line, start, comma - start);
+        start = comma + 1;
+    }
+}
+
+}
@@ -0,0 +1,15 @@
+#ifndef CSVUTILS_H
+#define CSVUTILS_H
+
+#include <string>
+#include <vector>
+
+namespace CsvUtils {
+
+// Split a data file line on commas into the reusable fields vector.
+// A trailing '\r' (Windows line ending) is ignored.
+void splitLine(const std::string& line, std::vector<std::string>& fields);
+
+}
+
+#endif // CSVUTILS_H
@@ -0,0 +1,611 @@
+#include "HttpServer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t MAX_HEADER_BYTES = 16 * 1024;
+const size_t MAX_BODY_BYTES = 1024 * 1024;
+const int IDLE_TIMEOUT_SECONDS = 30;
+const int MAX_EVENTS = 256;
+const size_t READ_CHUNK = 16 * 1024;
+
+enum class ParseResult {
+    COMPLETE,
+    INCOMPLETE,
+    FAILED      // status holds the error to answer with before closing
+};
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string::npos) return "";
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+void parseQuery(const std::string& text, std::map<std::string, std::string>& query) {
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find('&', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string pair = text.substr(pos, end - pos);
+        if (!pair.empty()) {
+            size_t equals = pair.find('=');
+            if (equals == std::string::npos) {
+                query[HttpServer::percentDecode(pair)] = "";
+            } else {
+                query[HttpServer::percentDecode(pair.substr(0, equals))] =
+                    HttpServer::percentDecode(pair.substr(equals + 1));
+            }
+        }
+        pos = end + 1;
+    }
+}
+
+// Takes one complete request off the front of input
+ParseResult parseRequest(std::string& input, HttpRequest& request, int& status) {
+    size_t headerEnd = input.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) {
+        if (input.size() > MAX_HEADER_BYTES) {
+            status = 431;
+            return ParseResult::FAILED;
+        }
+        return ParseResult::INCOMPLETE;
+    }
+
+    size_t lineEnd = input.find("\r\n");
+    std::string requestLine = input.substr(0, lineEnd);
+    size_t firstSpace = requestLine.find(' ');
+    size_t lastSpace = requestLine.rfind(' ');
+    if (firstSpace == std::string::npos || lastSpace == firstSpace) {
+        status = 400;
+        return ParseResult::FAILED;
+    }
+    request = HttpRequest();
+    request.method = requestLine.substr(0, firstSpace);
+    std::string target = requestLine.substr(firstSpace + 1, lastSpace - firstSpace - 1);
+    std::string version = requestLine.substr(lastSpace + 1);
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        status = 505;
+        return ParseResult::FAILED;
+    }
+    request.keepAlive = version == "HTTP/1.1";
+
+    size_t contentLength = 0;
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd) {
+        size_t end = input.find("\r\n", pos);
+        std::string line = input.substr(pos, end - pos);
+        pos = end + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            status = 400;
+            return ParseResult::FAILED;
+        }
+        std::string name = toLower(trim(line.substr(0, colon)));
+        std::string value = trim(line.substr(colon + 1));
+        if (name == "content-length") {
+            char* endPtr = nullptr;
+            unsigned long long length = std::strtoull(value.c_str(), &endPtr, 10);
+            if (value.empty() || *endPtr != '\0') {
+                status = 400;
+                return ParseResult::FAILED;
+            }
+            if (length > MAX_BODY_BYTES) {
+                status = 413;
+                return ParseResult::FAILED;
+            }
+            contentLength = static_cast<size_t>(length);
+        } else if (name == "transfer-encoding" && toLower(value) != "identity") {
+            status = 501;
+            return ParseResult::FAILED;
+        } else if (name == "connection") {
+            std::string lower = toLower(value);
+            if (lower == "close") request.keepAlive = false;
+            if (lower == "keep-alive") request.keepAlive = true;
+        }
+    }
+
+    size_t total = headerEnd + 4 + contentLength;
+    if (input.size() < total) {
+        return ParseResult::INCOMPLETE;
+    }
+    request.body = input.substr(headerEnd + 4, contentLength);
+    input.erase(0, total);
+
+    HttpServer::parseTarget(target, request);
+    return ParseResult::COMPLETE;
+}
+
+} // namespace
+
+std::string HttpRequest::getQuery(const std::string& name, const std::string& fallback) const {
+    auto found = query.find(name);
+    return found == query.end() ? fallback : found->second;
+}
+
+HttpServer::HttpServer(Handler handler, size_t workerCount)
+    : handler(std::move(handler)), workerCount(workerCount), listenFd(-1), epollFd(-1), wakeFd(-1), port(0),
+      stopping(false), nextConnectionId(1), openConnections(0), acceptedConnections(0), requestsServed(0) {
+}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+const char* HttpServer::statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 422: return "Unprocessable Entity";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+    }
+}
+
+std::string HttpServer::percentDecode(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '+') {
+            out += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            out += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+void HttpServer::parseTarget(const std::string& target, HttpRequest& request) {
+    size_t question = target.find('?');
+    request.path = percentDecode(target.substr(0, question));
+    request.query.clear();
+    if (question != std::string::npos) {
+        parseQuery(target.substr(question + 1), request.query);
+    }
+}
+
+void HttpServer::appendResponse(std::string& out, const HttpResponse& response, bool keepAlive) {
+    out += "HTTP/1.1 ";
+    out += std::to_string(response.status);
+    out += ' ';
+    out += statusText(response.status);
+    out += "\r\nContent-Type: ";
+    out += response.contentType;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(response.body.size());
+    out += keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    out += response.body;
+}
+
+bool HttpServer::isRunning() const {
+    return loopThread.joinable();
+}
+
+int HttpServer::getPort() const {
+    return port;
+}
+
+size_t HttpServer::getOpenConnections() const {
+    return openConnections;
+}
+
+uint64_t HttpServer::getAcceptedConnections() const {
+    return acceptedConnections;
+}
+
+uint64_t HttpServer::getRequestsServed() const {
+    return requestsServed;
+}
+
+std::string HttpServer::getLastError() const {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    return lastError;
+}
+
+#ifdef _WIN32
+
+bool HttpServer::start(const std::string&, int) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    lastError = "The HTTP server is not supported on this platform.";
+    return false;
+}
+
+void HttpServer::stop() {
+}
+
+void HttpServer::eventLoop() {
+}
+
+void HttpServer::acceptConnections() {
+}
+
+void HttpServer::readFrom(Connection&) {
+}
+
+bool HttpServer::dispatchNext(Connection&) {
+    return false;
+}
+
+bool HttpServer::writeTo(Connection&) {
+    return false;
+}
+
+void HttpServer::watch(Connection&) {
+}
+
+void HttpServer::closeConnection(int) {
+}
+
+void HttpServer::deliverCompleted() {
+}
+
+void HttpServer::closeIdle() {
+}
+
+void HttpServer::wake() {
+}
+
+#else
+
+bool HttpServer::start(const std::string& host, int requestedPort) {
+    if (isRunning()) {
+        return true;
+    }
+    auto fail = [this](const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = message + ": " + std::strerror(errno);
+        for (int* fd : {&listenFd, &epollFd, &wakeFd}) {
+            if (*fd >= 0) ::close(*fd);
+            *fd = -1;
+        }
+        return false;
+    };
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(requestedPort));
+    if (::inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError = "\"" + host + "\" is not an IPv4 address.";
+        return false;
+    }
+    listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        return fail("Cannot create a socket");
+    }
+    int yes = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        return fail("Cannot listen on " + host + ":" + std::to_string(requestedPort));
+    }
+    socklen_t length = sizeof(address);
+    ::getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || wakeFd < 0) {
+        return fail("Cannot create the event loop");
+    }
+    for (int fd : {listenFd, wakeFd}) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            return fail("Cannot create the event loop");
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        lastError.clear();
+    }
+    workers = std::make_unique<ThreadPool>(workerCount);
+    stopping = false;
+    loopThread = std::thread(&HttpServer::eventLoop, this);
+    return true;
+}
+
+void HttpServer::stop() {
+    if (!loopThread.joinable()) {
+        return;
+    }
+    stopping = true;
+    wake();
+    loopThread.join();
+    // Lets the requests already queued finish; their answers have nowhere to go
+    workers.reset();
+    for (auto& entry : connections) {
+        ::close(entry.first);
+    }
+    connections.clear();
+    openConnections = 0;
+    completed.clear();
+    for (int* fd : {&listenFd, &epollFd, &wakeFd}) {
+        ::close(*fd);
+        *fd = -1;
+    }
+}
+
+void HttpServer::wake() {
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;  // The counter only fails when it is already non-zero, which wakes the loop as well
+}
+
+void HttpServer::eventLoop() {
+    epoll_event events[MAX_EVENTS];
+    auto lastIdleCheck = std::chrono::steady_clock::now();
+    while (!stopping) {
+        int count = ::epoll_wait(epollFd, events, MAX_EVENTS, 1000);
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptConnections();
+                continue;
+            }
+            if (fd == wakeFd) {
+                uint64_t value;
+                while (::read(wakeFd, &value, sizeof(value)) > 0) {
+                }
+                deliverCompleted();
+                continue;
+            }
+            auto found = connections.find(fd);
+            if (found == connections.end()) {
+                continue;
+            }
+            Connection& connection = found->second;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !writeTo(connection)) {
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                readFrom(connection);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastIdleCheck >= std::chrono::seconds(1)) {
+            closeIdle();
+            lastIdleCheck = now;
+        }
+    }
+}
+
+void HttpServer::acceptConnections() {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;     // EAGAIN once the backlog is empty; anything else is retried on the next wakeup
+        }
+        int yes = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        Connection& connection = connections[fd];
+        connection.fd = fd;
+        connection.id = nextConnectionId++;
+        connection.outputSent = 0;
+        connection.busy = false;
+        connection.closeAfterWrite = false;
+        connection.inputClosed = false;
+        connection.lastActive = std::chrono::steady_clock::now();
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        openConnections++;
+        acceptedConnections++;
+    }
+}
+
+void HttpServer::readFrom(Connection& connection) {
+    char buffer[READ_CHUNK];
+    while (true) {
+        ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received > 0) {
+            connection.input.append(buffer, static_cast<size_t>(received));
+            if (connection.input.size() > MAX_HEADER_BYTES + MAX_BODY_BYTES) {
+                break;      // Parsing rejects it below
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received == 0) {
+            // A half-closed client still gets the responses to what it sent
+            connection.inputClosed = true;
+            break;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            closeConnection(connection.fd);
+            return;
+        }
+        break;
+    }
+    connection.lastActive = std::chrono::steady_clock::now();
+    if (!connection.busy && connection.output.empty()) {
+        dispatchNext(connection);
+    }
+}
+
+bool HttpServer::dispatchNext(Connection& connection) {
+    HttpRequest request;
+    int status = 400;
+    ParseResult result = parseRequest(connection.input, request, status);
+    if (result == ParseResult::INCOMPLETE) {
+        if (connection.inputClosed) {
+            closeConnection(connection.fd);     // Nothing more will arrive
+            return false;
+        }
+        watch(connection);
+        return true;
+    }
+    if (result == ParseResult::FAILED) {
+        HttpResponse response;
+        response.status = status;
+        response.body = std::string("{\"error\":\"") + statusText(status) + "\"}";
+        appendResponse(connection.output, response, false);
+        connection.input.clear();
+        connection.closeAfterWrite = true;
+        return writeTo(connection);
+    }
+
+    connection.busy = true;
+    watch(connection);
+    int fd = connection.fd;
+    uint64_t id = connection.id;
+    workers->submit([this, fd, id, request]() {
+        HttpResponse response;
+        try {
+            handler(request, response);
+        } catch (...) {
+            response = HttpResponse();
+            response.status = 500;
+            response.body = "{\"error\":\"Internal error\"}";
+        }
+        Completion done;
+        done.fd = fd;
+        done.id = id;
+        done.keepAlive = request.keepAlive;
+        appendResponse(done.bytes, response, request.keepAlive);
+        {
+            std::lock_guard<std::mutex> lock(completedMutex);
+            completed.push_back(std::move(done));
+        }
+        wake();
+    });
+    return true;
+}
+
+void HttpServer::deliverCompleted() {
+    std::vector<Completion> ready;
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        ready.swap(completed);
+    }
+    for (auto& done : ready) {
+        requestsServed++;
+        auto found = connections.find(done.fd);
+        if (found == connections.end() || found->second.id != done.id) {
+            continue;   // The client went away while the request was being handled
+        }
+        Connection& connection = found->second;
+        connection.busy = false;
+        if (!done.keepAlive) {
+            connection.closeAfterWrite = true;
+        }
+        if (connection.output.empty()) {
+            connection.output.swap(done.bytes);
+        } else {
+            connection.output += done.bytes;
+        }
+        writeTo(connection);
+    }
+}
+
+// Sends what it can; once everything is out, moves on to the next request. False when the connection was closed
+bool HttpServer::writeTo(Connection& connection) {
+    while (connection.outputSent < connection.output.size()) {
+        ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent,
+                              connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.outputSent += static_cast<size_t>(sent);
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watch(connection);
+            return true;
+        }
+        closeConnection(connection.fd);
+        return false;
+    }
+    connection.output.clear();
+    connection.outputSent = 0;
+    connection.lastActive = std::chrono::steady_clock::now();
+    if (connection.closeAfterWrite) {
+        closeConnection(connection.fd);
+        return false;
+    }
+    if (!connection.busy) {
+        return dispatchNext(connection);
+    }
+    return true;
+}
+
+// Waits for room to write while output is pending, for input while idle, and
+// for nothing while busy or once the client has stopped sending
+void HttpServer::watch(Connection& connection) {
+    epoll_event event;
+    event.events = 0;
+    if (!connection.output.empty()) {
+        event.events = EPOLLOUT;
+    } else if (!connection.busy && !connection.inputClosed) {
+        event.events = EPOLLIN;
+    }
+    event.data.fd = connection.fd;
+    ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void HttpServer::closeConnection(int fd) {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(fd);
+    openConnections--;
+}
+
+void HttpServer::closeIdle() {
+    auto cutoff = std::chrono::steady_clock::now() - std::chrono::seconds(IDLE_TIMEOUT_SECONDS);
+    std::vector<int> idle;
+    for (const auto& entry : connections) {
+        const Connection& connection = entry.second;
+        if (!connection.busy && connection.output.empty() && connection.lastActive < cutoff) {
+            idle.push_back(entry.first);
+        }
+    }
+    for (int fd : idle) {
+        closeConnection(fd);
+    }
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;                           // Percent-decoded, without the query string
+    std::map<std::string, std::string> query;   // Percent-decoded query parameters
+    std::string body;
+    bool keepAlive;
+
+    HttpRequest() : keepAlive(true) {}
+
+    std::string getQuery(const std::string& name, const std::string& fallback = "") const;
+};
+
+struct HttpResponse {
+    int status;
+    std::string contentType;
+    std::string body;
+
+    HttpResponse() : status(200), contentType("application/json") {}
+};
+
+// Small HTTP/1.1 server for local clients. One thread runs a non-blocking
+// epoll loop that accepts connections, reads and parses requests and writes
+// responses; the handler runs on a worker pool, so slow requests never hold
+// up reading and writing on other connections. Connections are kept alive
+// between requests (HTTP/1.1 default) and closed after 30 idle seconds.
+// Requests on one connection are answered in order, one at a time; pipelined
+// requests wait in the connection's buffer. Chunked request bodies are not
+// supported. Not available on Windows, where start() fails.
+class HttpServer {
+public:
+    using Handler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+private:
+    struct Connection {
+        int fd;
+        uint64_t id;                // Tells a reused descriptor apart from the one a response was meant for
+        std::string input;
+        std::string output;
+        size_t outputSent;
+        bool busy;                  // A request is with the workers
+        bool closeAfterWrite;
+        bool inputClosed;           // The client shut down its side; answer what it sent, then close
+        std::chrono::steady_clock::time_point lastActive;
+    };
+
+    struct Completion {
+        int fd;
+        uint64_t id;
+        std::string bytes;
+        bool keepAlive;
+    };
+
+    Handler handler;
+    size_t workerCount;
+    std::unique_ptr<ThreadPool> workers;
+    int listenFd;
+    int epollFd;
+    int wakeFd;
+    int port;
+    std::atomic<bool> stopping;
+    std::thread loopThread;
+    std::unordered_map<int, Connection> connections;   // Only touched by the loop thread
+    uint64_t nextConnectionId;
+
+    std::mutex completedMutex;
+    std::vector<Completion> completed;
+
+    std::atomic<size_t> openConnections;
+    std::atomic<uint64_t> acceptedConnections;
+    std::atomic<uint64_t> requestsServed;
+    mutable std::mutex errorMutex;
+    std::string lastError;
+
+    void eventLoop();
+    void acceptConnections();
+    void readFrom(Connection& connection);
+    // Starts the next buffered request, if any; false when the connection was closed
+    bool dispatchNext(Connection& connection);
+    bool writeTo(Connection& connection);
+    void watch(Connection& connection);
+    void closeConnection(int fd);
+    void deliverCompleted();
+    void closeIdle();
+    void wake();
+
+public:
+    // A worker count of 0 uses the number of hardware threads
+    explicit HttpServer(Handler handler, size_t workerCount = 0);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    // Listens on host:port; port 0 picks a free port, see getPort()
+    bool start(const std::string& host, int port);
+    // Closes every connection once the requests already with the workers are answered
+    void stop();
+    bool isRunning() const;
+    int getPort() const;
+    size_t getOpenConnections() const;
+    uint64_t getAcceptedConnections() const;
+    uint64_t getRequestsServed() const;
+    std::string getLastError() const;
+
+    static const char* statusText(int status);
+    static std::string percentDecode(const std::string& text);
+    // Splits a request target such as /cars?q=ford into the request's path and query
+    static void parseTarget(const std::string& target, HttpRequest& request);
+    // Appends the status line, headers and body of a response
+    static void appendResponse(std::string& out, const HttpResponse& response, bool keepAlive);
+};
+
+#endif // HTTPSERVER_H
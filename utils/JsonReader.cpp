@@ -0,0 +1,135 @@
+#include "JsonReader.h"
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+
+void skipSpace(const std::string& text, size_t& pos) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+}
+
+void appendUtf8(std::string& out, unsigned long code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+bool readString(const std::string& text, size_t& pos, std::string& out) {
+    if (pos >= text.size() || text[pos] != '"') return false;
+    pos++;
+    out.clear();
+    while (pos < text.size()) {
+        char c = text[pos++];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (pos >= text.size()) return false;
+        char escaped = text[pos++];
+        switch (escaped) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                if (pos + 4 > text.size()) return false;
+                std::string hex = text.substr(pos, 4);
+                char* end = nullptr;
+                unsigned long code = std::strtoul(hex.c_str(), &end, 16);
+                if (end != hex.c_str() + 4) return false;
+                appendUtf8(out, code);
+                pos += 4;
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+// A number, true, false or null, kept as written
+bool readLiteral(const std::string& text, size_t& pos, std::string& out) {
+    size_t start = pos;
+    while (pos < text.size() && (std::isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '-' ||
+                                 text[pos] == '+' || text[pos] == '.')) {
+        pos++;
+    }
+    out = text.substr(start, pos - start);
+    return !out.empty();
+}
+
+} // namespace
+
+bool JsonReader::parseObject(const std::string& text, std::map<std::string, std::string>& fields,
+                             std::string& error) {
+    fields.clear();
+    size_t pos = 0;
+    skipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != '{') {
+        error = "Expected a JSON object.";
+        return false;
+    }
+    pos++;
+    skipSpace(text, pos);
+    if (pos < text.size() && text[pos] == '}') {
+        pos++;
+    } else {
+        while (true) {
+            std::string name;
+            std::string value;
+            skipSpace(text, pos);
+            if (!readString(text, pos, name)) {
+                error = "Expected a quoted field name at offset " + std::to_string(pos) + ".";
+                return false;
+            }
+            skipSpace(text, pos);
+            if (pos >= text.size() || text[pos] != ':') {
+                error = "Expected ':' after \"" + name + "\".";
+                return false;
+            }
+            pos++;
+            skipSpace(text, pos);
+            if (pos < text.size() && (text[pos] == '{' || text[pos] == '[')) {
+                error = "Field \"" + name + "\" must be a string, number or boolean.";
+                return false;
+            }
+            bool ok = pos < text.size() && text[pos] == '"' ? readString(text, pos, value)
+                                                            : readLiteral(text, pos, value);
+            if (!ok) {
+                error = "Malformed value for \"" + name + "\".";
+                return false;
+            }
+            fields[name] = value;
+            skipSpace(text, pos);
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+                continue;
+            }
+            if (pos < text.size() && text[pos] == '}') {
+                pos++;
+                break;
+            }
+            error = "Expected ',' or '}' after \"" + name + "\".";
+            return false;
+        }
+    }
+    skipSpace(text, pos);
+    if (pos != text.size()) {
+        error = "Unexpected text after the JSON object.";
+        return false;
+    }
+    return true;
+}
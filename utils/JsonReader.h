@@ -0,0 +1,16 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <map>
+#include <string>
+
+// Reads a flat JSON object such as {"carId": 7, "notes": "late pickup"} into
+// key/value text. Strings are unescaped; numbers, true, false and null are
+// kept as written. Nested objects and arrays are rejected.
+class JsonReader {
+public:
+    static bool parseObject(const std::string& text, std::map<std::string, std::string>& fields,
+                            std::string& error);
+};
+
+#endif // JSONREADER_H
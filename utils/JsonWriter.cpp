@@ -0,0 +1,112 @@
+#include "JsonWriter.h"
+#include <cstdio>
+
+JsonWriter::JsonWriter(std::string& out) : out(out), afterKey(false) {
+}
+
+void JsonWriter::separator() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (!firstInScope.empty()) {
+        if (!firstInScope.back()) out += ',';
+        firstInScope.back() = false;
+    }
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separator();
+    out += '{';
+    firstInScope.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out += '}';
+    firstInScope.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separator();
+    out += '[';
+    firstInScope.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    out += ']';
+    firstInScope.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name) {
+    separator();
+    appendEscaped(out, name);
+    out += ':';
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& text) {
+    separator();
+    appendEscaped(out, text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text) {
+    return value(std::string(text));
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separator();
+    out += std::to_string(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int number) {
+    return value(static_cast<long long>(number));
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    separator();
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.2f", number);
+    out.append(text, length);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separator();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separator();
+    out += "null";
+    return *this;
+}
+
+void JsonWriter::appendEscaped(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
@@ -0,0 +1,39 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <string>
+#include <vector>
+
+// Minimal streaming JSON writer. Output is appended to a caller-owned string,
+// which the caller may drain (write out and clear) between values to keep
+// memory constant for arbitrarily long arrays.
+class JsonWriter {
+private:
+    std::string& out;
+    std::vector<bool> firstInScope;
+    bool afterKey;
+
+public:
+    explicit JsonWriter(std::string& out);
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(const std::string& name);
+    JsonWriter& value(const std::string& text);
+    JsonWriter& value(const char* text);
+    JsonWriter& value(long long number);
+    JsonWriter& value(int number);
+    JsonWriter& value(double number);
+    JsonWriter& value(bool flag);
+    JsonWriter& null();
+
+    static void appendEscaped(std::string& out, const std::string& text);
+
+private:
+    void separator();
+};
+
+#endif // JSONWRITER_H
@@ -0,0 +1,164 @@
+#include "LocalSocket.h"
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace LocalSocket {
+
+#ifdef _WIN32
+
+int listenAt(const std::string&, std::string& error) {
+    error = "Local sockets are not supported on this platform.";
+    return -1;
+}
+
+int connectTo(const std::string&, std::string& error) {
+    error = "Local sockets are not supported on this platform.";
+    return -1;
+}
+
+int acceptFrom(int, int) {
+    return -1;
+}
+
+bool sendAll(int, const std::string&) {
+    return false;
+}
+
+void shutdown(int) {
+}
+
+void close(int) {
+}
+
+LineReader::LineReader(int fd) : fd(fd), start(0) {
+}
+
+ReadStatus LineReader::readLine(std::string&, int) {
+    return ReadStatus::CLOSED;
+}
+
+#else
+
+namespace {
+
+bool makeAddress(const std::string& path, sockaddr_un& address, std::string& error) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        error = "Socket path \"" + path + "\" is empty or too long.";
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+} // namespace
+
+int listenAt(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    if (!makeAddress(path, address, error)) {
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = "Cannot create a socket: " + std::string(std::strerror(errno));
+        return -1;
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 16) != 0) {
+        error = "Cannot listen on " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectTo(const std::string& path, std::string& error) {
+    sockaddr_un address;
+    if (!makeAddress(path, address, error)) {
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = "Cannot create a socket: " + std::string(std::strerror(errno));
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        error = "Cannot connect to " + path + ": " + std::strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int acceptFrom(int listenFd, int timeoutMs) {
+    pollfd waiting = {listenFd, POLLIN, 0};
+    if (::poll(&waiting, 1, timeoutMs) <= 0 || !(waiting.revents & POLLIN)) {
+        return -1;
+    }
+    return ::accept(listenFd, nullptr, nullptr);
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t count = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return false;
+        sent += static_cast<size_t>(count);
+    }
+    return true;
+}
+
+void shutdown(int fd) {
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+}
+
+void close(int fd) {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+LineReader::LineReader(int fd) : fd(fd), start(0) {
+}
+
+ReadStatus LineReader::readLine(std::string& line, int timeoutMs) {
+    while (true) {
+        size_t newline = buffer.find('\n', start);
+        if (newline != std::string::npos) {
+            line.assign(buffer, start, newline - start);
+            start = newline + 1;
+            return ReadStatus::LINE;
+        }
+        // Drop consumed lines before reading more
+        buffer.erase(0, start);
+        start = 0;
+
+        pollfd waiting = {fd, POLLIN, 0};
+        int ready = ::poll(&waiting, 1, timeoutMs);
+        if (ready == 0) return ReadStatus::TIMEOUT;
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return ReadStatus::CLOSED;
+        }
+        char chunk[65536];
+        ssize_t count = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) return ReadStatus::CLOSED;
+        buffer.append(chunk, static_cast<size_t>(count));
+    }
+}
+
+#endif
+
+}
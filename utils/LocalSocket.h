@@ -0,0 +1,43 @@
+#ifndef LOCALSOCKET_H
+#define LOCALSOCKET_H
+
+#include <string>
+
+// Unix domain stream sockets for talking to other processes on the same
+// machine. Descriptors are plain ints; -1 means failure. Not available on
+// Windows, where every call fails.
+namespace LocalSocket {
+
+// Listens on path, replacing a socket file left behind by an earlier run
+int listenAt(const std::string& path, std::string& error);
+int connectTo(const std::string& path, std::string& error);
+// Waits up to timeoutMs for a connection; -1 when none arrived
+int acceptFrom(int listenFd, int timeoutMs);
+// Writes everything or fails; a peer that went away is a failure, not a signal
+bool sendAll(int fd, const std::string& data);
+// Wakes any thread blocked on the socket; it stays open for that thread to close
+void shutdown(int fd);
+void close(int fd);
+
+enum class ReadStatus {
+    LINE,
+    TIMEOUT,
+    CLOSED
+};
+
+// Splits what arrives on a socket into lines
+class LineReader {
+private:
+    int fd;
+    std::string buffer;
+    size_t start;
+
+public:
+    explicit LineReader(int fd);
+    // Waits up to timeoutMs for the next line, without its newline
+    ReadStatus readLine(std::string& line, int timeoutMs);
+};
+
+}
+
+#endif // LOCALSOCKET_H
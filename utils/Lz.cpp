@@ -0,0 +1,124 @@
+#include "Lz.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+const int HASH_BITS = 16;
+
+// Matches never start in the last bytes of the block, which always end as literals
+const size_t END_LITERALS = 12;
+
+uint32_t read32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+void writeLength(std::string& out, size_t length) {
+    while (length >= 255) {
+        out += static_cast<char>(255);
+        length -= 255;
+    }
+    out += static_cast<char>(length);
+}
+
+void emit(std::string& out, const char* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength > 0 ? matchLength - MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>(((literalLength < 15 ? literalLength : 15) << 4) |
+                                                     (matchCode < 15 ? matchCode : 15));
+    out += static_cast<char>(token);
+    if (literalLength >= 15) writeLength(out, literalLength - 15);
+    out.append(literals, literalLength);
+    if (matchLength == 0) return; // Final literals
+    out += static_cast<char>(offset & 0xFF);
+    out += static_cast<char>(offset >> 8);
+    if (matchCode >= 15) writeLength(out, matchCode - 15);
+}
+
+bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (in == end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+} // namespace
+
+namespace Lz {
+
+std::string compress(const char* data, size_t size) {
+    std::string out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // Position + 1 of the last 4-byte sequence seen
+
+    size_t anchor = 0;
+    size_t position = 0;
+    size_t limit = size > END_LITERALS ? size - END_LITERALS : 0;
+    while (position < limit) {
+        uint32_t sequence = read32(data + position);
+        uint32_t slot = (sequence * 2654435761u) >> (32 - HASH_BITS);
+        size_t candidate = table[slot];
+        table[slot] = static_cast<uint32_t>(position + 1);
+
+        if (candidate == 0 || position - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != sequence) {
+            position++;
+            continue;
+        }
+
+        size_t reference = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (position + length < limit && data[reference + length] == data[position + length]) {
+            length++;
+        }
+        emit(out, data + anchor, position - anchor, position - reference, length);
+        position += length;
+        anchor = position;
+    }
+    emit(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool decompress(const char* data, size_t size, size_t rawSize, std::string& out) {
+    out.clear();
+    out.reserve(rawSize);
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = in + size;
+
+    while (in < end) {
+        unsigned char token = *in++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(in, end, literalLength)) return false;
+        if (static_cast<size_t>(end - in) < literalLength || out.size() + literalLength > rawSize) return false;
+        out.append(reinterpret_cast<const char*>(in), literalLength);
+        in += literalLength;
+        if (in == end) break; // Final literals
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(in, end, matchLength)) return false;
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > out.size() || out.size() + matchLength > rawSize) return false;
+
+        size_t from = out.size() - offset;
+        if (offset >= matchLength) {
+            out.append(out, from, matchLength);
+        } else {
+            // The match overlaps the bytes it produces, so copy byte by byte
+            for (size_t i = 0; i < matchLength; i++) {
+                out += out[from + i];
+            }
+        }
+    }
+    return out.size() == rawSize;
+}
+
+}
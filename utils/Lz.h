@@ -0,0 +1,19 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <cstddef>
+#include <string>
+
+// Byte-oriented LZ77 block compression in the style of LZ4: each sequence is
+// a token (literal and match lengths), the literals, and a 16-bit back
+// reference. Fast to decode and good on repetitive text such as CSV rows.
+namespace Lz {
+
+std::string compress(const char* data, size_t size);
+
+// Fails on malformed input or if the output is not exactly rawSize bytes
+bool decompress(const char* data, size_t size, size_t rawSize, std::string& out);
+
+}
+
+#endif // LZ_H
@@ -0,0 +1,188 @@
+#include "ScanKernels.h"
+#include <cstring>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ScanKernels {
+
+void fillMask(uint8_t* mask, size_t count) {
+    std::memset(mask, 1, count);
+}
+
+#ifdef __AVX2__
+namespace {
+
+// spreadBits[b] has byte k set to bit k of b, turning a compare movemask into mask bytes
+struct SpreadTable {
+    uint64_t bytes[256];
+    SpreadTable() {
+        for (int bits = 0; bits < 256; bits++) {
+            bytes[bits] = 0;
+            for (int lane = 0; lane < 8; lane++) {
+                bytes[bits] |= static_cast<uint64_t>((bits >> lane) & 1) << (lane * 8);
+            }
+        }
+    }
+};
+const SpreadTable spreadBits;
+
+}
+#endif
+
+void filterRange(const int32_t* column, size_t count, int32_t lo, int32_t hi, uint8_t* mask) {
+    size_t i = 0;
+#ifdef __AVX2__
+    // Eight rows per step: two signed compares, movemask, then AND eight mask bytes at once
+    if (lo > std::numeric_limits<int32_t>::min() && hi < std::numeric_limits<int32_t>::max()) {
+        const __m256i low = _mm256_set1_epi32(lo - 1);
+        const __m256i high = _mm256_set1_epi32(hi + 1);
+        for (; i + 8 <= count; i += 8) {
+            __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+            __m256i inRange = _mm256_and_si256(_mm256_cmpgt_epi32(values, low), _mm256_cmpgt_epi32(high, values));
+            int bits = _mm256_movemask_ps(_mm256_castsi256_ps(inRange));
+            uint64_t maskBytes;
+            std::memcpy(&maskBytes, mask + i, sizeof(maskBytes));
+            maskBytes &= spreadBits.bytes[bits];
+            std::memcpy(mask + i, &maskBytes, sizeof(maskBytes));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        mask[i] &= static_cast<uint8_t>((column[i] >= lo) & (column[i] <= hi));
+    }
+}
+
+void filterDifference(const int32_t* start, const int32_t* end, size_t count, int32_t lo, int32_t hi, uint8_t* mask) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t difference = end[i] - start[i];
+        mask[i] &= static_cast<uint8_t>((difference >= lo) & (difference <= hi));
+    }
+}
+
+void filterInSet(const uint8_t* column, size_t count, uint32_t bits, uint8_t* mask) {
+    for (size_t i = 0; i < count; i++) {
+        mask[i] &= static_cast<uint8_t>((bits >> (column[i] & 31)) & 1);
+    }
+}
+
+void filterLookup(const int32_t* keys, size_t count, const uint8_t* table, size_t tableSize, uint8_t* mask) {
+    for (size_t i = 0; i < count; i++) {
+        size_t key = static_cast<uint32_t>(keys[i]);
+        mask[i] &= key < tableSize ? table[key] : 0;
+    }
+}
+
+void gatherBytes(const int32_t* keys, size_t count, const uint8_t* table, size_t tableSize, uint8_t fallback,
+                 uint8_t* out) {
+    for (size_t i = 0; i < count; i++) {
+        size_t key = static_cast<uint32_t>(keys[i]);
+        out[i] = key < tableSize ? table[key] : fallback;
+    }
+}
+
+size_t countMasked(const uint8_t* mask, size_t count) {
+    // Byte sums in 32-bit lanes vectorize cleanly; flush before they could overflow
+    size_t total = 0;
+    size_t i = 0;
+    while (i < count) {
+        size_t blockEnd = count - i > (1u << 24) ? i + (1u << 24) : count;
+        uint32_t block = 0;
+        for (; i < blockEnd; i++) {
+            block += mask[i];
+        }
+        total += block;
+    }
+    return total;
+}
+
+int64_t sumMasked(const int64_t* values, const uint8_t* mask, size_t count) {
+    size_t i = 0;
+    int64_t total = 0;
+#ifdef __AVX2__
+    // Widen four mask bytes to 64-bit lanes, negate to all-ones, and AND with the values
+    __m256i sum = _mm256_setzero_si256();
+    for (; i + 4 <= count; i += 4) {
+        int32_t maskBytes;
+        std::memcpy(&maskBytes, mask + i, sizeof(maskBytes));
+        __m256i lanes = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(maskBytes));
+        __m256i selected = _mm256_sub_epi64(_mm256_setzero_si256(), lanes);
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        sum = _mm256_add_epi64(sum, _mm256_and_si256(v, selected));
+    }
+    alignas(32) int64_t partial[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(partial), sum);
+    total = partial[0] + partial[1] + partial[2] + partial[3];
+#endif
+    for (; i < count; i++) {
+        total += values[i] & -static_cast<int64_t>(mask[i]);
+    }
+    return total;
+}
+
+bool minMasked(const int64_t* values, const uint8_t* mask, size_t count, int64_t& result) {
+    int64_t best = std::numeric_limits<int64_t>::max();
+    uint8_t any = 0;
+    for (size_t i = 0; i < count; i++) {
+        int64_t candidate = mask[i] ? values[i] : std::numeric_limits<int64_t>::max();
+        best = candidate < best ? candidate : best;
+        any |= mask[i];
+    }
+    if (!any) return false;
+    result = best;
+    return true;
+}
+
+bool maxMasked(const int64_t* values, const uint8_t* mask, size_t count, int64_t& result) {
+    int64_t best = std::numeric_limits<int64_t>::min();
+    uint8_t any = 0;
+    for (size_t i = 0; i < count; i++) {
+        int64_t candidate = mask[i] ? values[i] : std::numeric_limits<int64_t>::min();
+        best = candidate > best ? candidate : best;
+        any |= mask[i];
+    }
+    if (!any) return false;
+    result = best;
+    return true;
+}
+
+void groupSum(const uint8_t* keys, const int64_t* values, const uint8_t* mask, size_t count,
+              int64_t* sums, int64_t* counts, size_t groupCount) {
+    // Keys are small, so accumulate into a fixed 256-slot table and fold at the end
+    int64_t localSums[256] = {};
+    int64_t localCounts[256] = {};
+    for (size_t i = 0; i < count; i++) {
+        int64_t selected = mask[i];
+        localSums[keys[i]] += values[i] & -selected;
+        localCounts[keys[i]] += selected;
+    }
+    for (size_t key = 0; key < groupCount && key < 256; key++) {
+        sums[key] += localSums[key];
+        counts[key] += localCounts[key];
+    }
+}
+
+void scaleByKey(const int64_t* values, const uint8_t* keys, size_t count, const int64_t* factors,
+                size_t factorCount, int64_t divisor, int64_t* out) {
+    // A full 256-entry table turns the factor lookup into an unchecked gather
+    int64_t table[256] = {};
+    for (size_t key = 0; key < factorCount && key < 256; key++) {
+        table[key] = factors[key];
+    }
+    const int64_t half = divisor / 2;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (values[i] * table[keys[i]] + half) / divisor;
+    }
+}
+
+const char* instructionSet() {
+#ifdef __AVX2__
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef SCANKERNELS_H
+#define SCANKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Filter and aggregate kernels over plain column arrays.
+//
+// A selection is a byte mask with one entry per row (1 = selected, 0 = not).
+// Filters narrow an existing mask in place, so several filters can be chained
+// after fillMask. The loops are branch-free so the compiler can vectorize them;
+// the hottest kernels also have an AVX2 path when built with -mavx2.
+namespace ScanKernels {
+
+void fillMask(uint8_t* mask, size_t count);
+
+// mask[i] &= lo <= column[i] <= hi
+void filterRange(const int32_t* column, size_t count, int32_t lo, int32_t hi, uint8_t* mask);
+// mask[i] &= lo <= (end[i] - start[i]) <= hi
+void filterDifference(const int32_t* start, const int32_t* end, size_t count, int32_t lo, int32_t hi, uint8_t* mask);
+// mask[i] &= (bits >> column[i]) & 1, for byte columns with values below 32
+void filterInSet(const uint8_t* column, size_t count, uint32_t bits, uint8_t* mask);
+// mask[i] &= table[keys[i]], keys outside [0, tableSize) are dropped
+void filterLookup(const int32_t* keys, size_t count, const uint8_t* table, size_t tableSize, uint8_t* mask);
+
+// out[i] = table[keys[i]], or fallback for keys outside the table
+void gatherBytes(const int32_t* keys, size_t count, const uint8_t* table, size_t tableSize, uint8_t fallback,
+                 uint8_t* out);
+
+size_t countMasked(const uint8_t* mask, size_t count);
+int64_t sumMasked(const int64_t* values, const uint8_t* mask, size_t count);
+// Return false (and leave result untouched) when no row is selected
+bool minMasked(const int64_t* values, const uint8_t* mask, size_t count, int64_t& result);
+bool maxMasked(const int64_t* values, const uint8_t* mask, size_t count, int64_t& result);
+
+// sums[k] / counts[k] += values / rows with key k, for byte keys below groupCount.
+// Rows whose key is out of range are ignored.
+void groupSum(const uint8_t* keys, const int64_t* values, const uint8_t* mask, size_t count,
+              int64_t* sums, int64_t* counts, size_t groupCount);
+
+// out[i] = (values[i] * factors[keys[i]] + divisor / 2) / divisor, for non-negative
+// values and factors; keys at or above factorCount scale by zero
+void scaleByKey(const int64_t* values, const uint8_t* keys, size_t count, const int64_t* factors,
+                size_t factorCount, int64_t divisor, int64_t* out);
+
+// Name of the code path the kernels were compiled with, for benchmarks
+const char* instructionSet();
+
+}
+
+#endif // SCANKERNELS_H
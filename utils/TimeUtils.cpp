@@ -0,0 +1,24 @@
+#include "TimeUtils.h"
+#include <cstdio>
+
+namespace TimeUtils {
+
+bool localTime(time_t time, std::tm& result) {
+#ifdef _WIN32
+    return localtime_s(&result, &time) == 0;
+#else
+    return localtime_r(&time, &result) != nullptr;
+#endif
+}
+
+std::string currentTimestamp() {
+    std::tm timeinfo{};
+    localTime(time(nullptr), timeinfo);
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d",
+             1900 + timeinfo.tm_year, 1 + timeinfo.tm_mon, timeinfo.tm_mday,
+             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    return buffer;
+}
+
+}
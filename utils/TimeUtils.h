@@ -0,0 +1,18 @@
+#ifndef TIMEUTILS_H
+#define TIMEUTILS_H
+
+#include <ctime>
+#include <string>
+
+namespace TimeUtils {
+
+// Thread-safe localtime: fills result instead of sharing a static buffer, so
+// it may run on pool and writer threads. Returns false if the time is out of range.
+bool localTime(time_t time, std::tm& result);
+
+// Current local time as YYYY-MM-DD HH:MM:SS
+std::string currentTimestamp();
+
+}
+
+#endif // TIMEUTILS_H